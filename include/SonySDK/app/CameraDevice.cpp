@@ -734,6 +734,43 @@ void CameraDevice::get_live_view()
     }
 }
 
+SDK::CrError CameraDevice::get_live_view_image(std::vector<CrInt8u>& image, CrInt32u& frame_no)
+{
+    SDK::CrImageInfo inf;
+    auto err = SDK::GetLiveViewImageInfo(m_device_handle, &inf);
+    if (CR_FAILED(err)) {
+        return err;
+    }
+
+    CrInt32u bufSize = inf.GetBufferSize();
+    if (bufSize < 1) {
+        return SDK::CrError_Generic_Unknown;
+    }
+
+    // Keep the receive buffer between calls, the live view size rarely changes
+    if (m_lv_buffer.size() < bufSize) {
+        m_lv_buffer.resize(bufSize);
+    }
+
+    SDK::CrImageDataBlock image_data;
+    image_data.SetSize(bufSize);
+    image_data.SetData(m_lv_buffer.data());
+
+    err = SDK::GetLiveViewImage(m_device_handle, &image_data);
+    if (CR_FAILED(err)) {
+        return err;
+    }
+
+    if (image_data.GetImageSize() < 1) {
+        return SDK::CrError_Generic_Unknown;
+    }
+
+    image.assign(image_data.GetImageData(), image_data.GetImageData() + image_data.GetImageSize());
+    frame_no = image_data.GetFrameNo();
+
+    return SDK::CrError_None;
+}
+
 void CameraDevice::get_live_view_image_quality()
 {
     load_properties();
@@ -4713,6 +4750,7 @@ void CameraDevice::OnDisconnected(CrInt32u error)
 void CameraDevice::OnPropertyChanged()
 {
     // tout << "Property changed.\n";
+    notify_property_change(std::vector<CrInt32u>());
 }
 
 void CameraDevice::OnLvPropertyChanged()
@@ -4730,6 +4768,7 @@ void CameraDevice::OnCompleteDownload(CrChar* filename, CrInt32u type )
         break;
     case SCRSDK::CrDownloadSettingFileType_Setup:
         tout << "Complete download. Camera Setting File: " << file.data() << '\n';
+        finish_setting_file(true, file);
         break;
     default:
         break;
@@ -4738,6 +4777,21 @@ void CameraDevice::OnCompleteDownload(CrChar* filename, CrInt32u type )
 
 void CameraDevice::OnNotifyContentsTransfer(CrInt32u notify, SDK::CrContentHandle contentHandle, CrChar* filename)
 {
+    std::vector<ContentsTransferListener> listeners;
+    {
+        std::lock_guard<std::mutex> lock(m_contents_listener_mutex);
+        for (auto& item : m_contents_listeners) {
+            listeners.push_back(item.second);
+        }
+    }
+    text notified_file;
+    if (filename) {
+        notified_file = text(filename);
+    }
+    for (auto& listener : listeners) {
+        listener(notify, contentHandle, notified_file);
+    }
+
     // Start
     if (SDK::CrNotify_ContentsTransfer_Start == notify)
     {
@@ -4783,12 +4837,15 @@ void CameraDevice::OnWarning(CrInt32u warning)
         break;
     case SDK::CrWarning_CameraSettings_Read_Result_OK:
         tout << "\nConfiguration file read successfully.\n\n";
+        finish_setting_file(true, text());
         break;
     case SDK::CrWarning_CameraSettings_Read_Result_NG:
         tout << "\nFailed to load configuration file\n\n";
+        finish_setting_file(false, text());
         break;
     case SDK::CrWarning_CameraSettings_Save_Result_NG:
         tout << "\nConfiguration file save request failed.\n\n";
+        finish_setting_file(false, text());
         break;
     case SDK::CrWarning_RequestDisplayStringList_Success:
         tout << "\nRequest for DisplayStringList  successfully\n\n";        
@@ -4865,6 +4922,8 @@ void CameraDevice::OnWarningExt(CrInt32u warning, CrInt32 param1, CrInt32 param2
 
 void CameraDevice::OnPropertyChangedCodes(CrInt32u num, CrInt32u* codes)
 {
+    notify_property_change(codes ? std::vector<CrInt32u>(codes, codes + num) : std::vector<CrInt32u>());
+
     //tout << "Property changed.  num = " << std::dec << num;
     //tout << std::hex;
     //for (std::int32_t i = 0; i < num; ++i)
@@ -5713,6 +5772,251 @@ bool CameraDevice::set_property(SDK::CrDeviceProperty& prop) const
     return false;
 }
 
+bool CameraDevice::is_contents_transfer_enabled()
+{
+    std::int32_t nprop = 0;
+    SDK::CrDeviceProperty* prop_list = nullptr;
+    CrInt32u getCode = SDK::CrDevicePropertyCode::CrDeviceProperty_ContentsTransferStatus;
+    SDK::CrError res = SDK::GetSelectDeviceProperties(m_device_handle, 1, &getCode, &prop_list, &nprop);
+    bool enabled = false;
+    if (CR_SUCCEEDED(res) && (1 == nprop)) {
+        enabled = (getCode == prop_list[0].GetCode()) && (SDK::CrContentsTransfer_ON == prop_list[0].GetCurrentValue());
+        SDK::ReleaseDeviceProperties(m_device_handle, prop_list);
+    }
+    return enabled;
+}
+
+SDK::CrError CameraDevice::get_date_folders(std::vector<ContentsFolder>& folders)
+{
+    folders.clear();
+
+    CrInt32u f_nums = 0;
+    SDK::CrMtpFolderInfo* f_list = nullptr;
+    SDK::CrError err = SDK::GetDateFolderList(m_device_handle, &f_list, &f_nums);
+    if (CR_FAILED(err)) {
+        return err;
+    }
+
+    if (f_list) {
+        folders.reserve(f_nums);
+        for (CrInt32u i = 0; i < f_nums; ++i) {
+            ContentsFolder folder;
+            folder.handle = f_list[i].handle;
+            if (f_list[i].folderName) {
+                folder.name = text(f_list[i].folderName);
+            }
+            folders.push_back(folder);
+        }
+        SDK::ReleaseDateFolderList(m_device_handle, f_list);
+    }
+    return SDK::CrError_None;
+}
+
+SDK::CrError CameraDevice::get_contents_handles(SDK::CrFolderHandle folder, std::vector<SDK::CrContentHandle>& handles)
+{
+    handles.clear();
+
+    CrInt32u c_nums = 0;
+    SDK::CrContentHandle* c_list = nullptr;
+    SDK::CrError err = SDK::GetContentsHandleList(m_device_handle, folder, &c_list, &c_nums);
+    if (CR_FAILED(err)) {
+        return err;
+    }
+
+    if (c_list) {
+        handles.assign(c_list, c_list + c_nums);
+        SDK::ReleaseContentsHandleList(m_device_handle, c_list);
+    }
+    return SDK::CrError_None;
+}
+
+SDK::CrError CameraDevice::get_contents_detail(SDK::CrContentHandle handle, SDK::CrMtpContentsInfo& info)
+{
+    return SDK::GetContentsDetailInfo(m_device_handle, handle, &info);
+}
+
+SDK::CrError CameraDevice::pull_contents_file(SDK::CrContentHandle handle, const text& path)
+{
+    // Completion is reported through OnNotifyContentsTransfer
+    return SDK::PullContentsFile(m_device_handle, handle, SDK::CrPropertyStillImageTransSize_Original, const_cast<text_char*>(path.data()));
+}
+
+SDK::CrError CameraDevice::get_contents_thumbnail(SDK::CrContentHandle handle, CrInt8u* buffer, CrInt32u capacity, CrInt8u*& data, CrInt32u& size, SDK::CrFileType& type)
+{
+    // The caller owns the buffer, nothing is written to disk
+    SDK::CrImageDataBlock image_data;
+    image_data.SetSize(capacity);
+    image_data.SetData(buffer);
+
+    type = SDK::CrFileType_None;
+    SDK::CrError err = SDK::GetContentsThumbnailImage(m_device_handle, handle, &image_data, &type);
+    if (CR_FAILED(err)) {
+        return err;
+    }
+
+    if (image_data.GetImageSize() < 1 || type == SDK::CrFileType_None) {
+        return SDK::CrError_Generic_Unknown;
+    }
+
+    data = image_data.GetImageData();
+    size = image_data.GetImageSize();
+    return SDK::CrError_None;
+}
+
+int CameraDevice::add_contents_transfer_listener(ContentsTransferListener listener)
+{
+    std::lock_guard<std::mutex> lock(m_contents_listener_mutex);
+    int id = ++m_contents_listener_id;
+    m_contents_listeners[id] = listener;
+    return id;
+}
+
+void CameraDevice::remove_contents_transfer_listener(int id)
+{
+    std::lock_guard<std::mutex> lock(m_contents_listener_mutex);
+    m_contents_listeners.erase(id);
+}
+
+int CameraDevice::add_property_change_listener(PropertyChangeListener listener)
+{
+    std::lock_guard<std::mutex> lock(m_property_listener_mutex);
+    int id = ++m_property_listener_id;
+    m_property_listeners[id] = listener;
+    return id;
+}
+
+void CameraDevice::remove_property_change_listener(int id)
+{
+    std::lock_guard<std::mutex> lock(m_property_listener_mutex);
+    m_property_listeners.erase(id);
+}
+
+void CameraDevice::notify_property_change(const std::vector<CrInt32u>& codes)
+{
+    // Called without the lock, a listener may remove itself
+    std::vector<PropertyChangeListener> listeners;
+    {
+        std::lock_guard<std::mutex> lock(m_property_listener_mutex);
+        for (auto& item : m_property_listeners) {
+            listeners.push_back(item.second);
+        }
+    }
+    for (auto& listener : listeners) {
+        listener(codes);
+    }
+}
+
+SDK::CrError CameraDevice::get_settings_fingerprint(std::uint64_t& fingerprint)
+{
+    std::int32_t nprop = 0;
+    SDK::CrDeviceProperty* prop_list = nullptr;
+    SDK::CrError err = SDK::GetDeviceProperties(m_device_handle, &prop_list, &nprop);
+    if (CR_FAILED(err)) {
+        return err;
+    }
+
+    // FNV-1a over the settable properties, status values (battery, remaining shots...) are read-only
+    fingerprint = 14695981039346656037ULL;
+    auto mix = [&fingerprint](std::uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            fingerprint ^= (value >> (i * 8)) & 0xFF;
+            fingerprint *= 1099511628211ULL;
+        }
+    };
+    if (prop_list) {
+        for (std::int32_t i = 0; i < nprop; ++i) {
+            if (!prop_list[i].IsSetEnableCurrentValue()) {
+                continue;
+            }
+            mix(prop_list[i].GetCode());
+            mix(prop_list[i].GetCurrentValue());
+        }
+        SDK::ReleaseDeviceProperties(m_device_handle, prop_list);
+    }
+    return SDK::CrError_None;
+}
+
+SDK::CrError CameraDevice::download_setting_file(const text& directory, const text& name, CrInt32u timeout_ms, text& written_file)
+{
+    if (false == get_camera_setting_saveread_state()) {
+        return SDK::CrError_Adaptor_DeviceBusy;
+    }
+    if (SDK::CrCameraSettingSaveOperation::CrCameraSettingSaveOperation_Enable != m_prop.camera_setting_save_operation.current) {
+        spdlog::error("Unable to download Camera-Setting file.");
+        return SDK::CrError_Generic_NotSupported;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_setting_file_mutex);
+        m_setting_file_state = SettingFileState::Pending;
+        m_setting_file_name.clear();
+    }
+
+    // Completion is reported through OnCompleteDownload, a failure through OnWarning
+    SDK::CrError err = SDK::DownloadSettingFile(m_device_handle, SDK::CrDownloadSettingFileType::CrDownloadSettingFileType_Setup,
+                                                const_cast<text_char*>(directory.c_str()), const_cast<text_char*>(name.c_str()));
+    if (CR_FAILED(err)) {
+        finish_setting_file(false, text());
+        return err;
+    }
+    return wait_setting_file(timeout_ms, written_file);
+}
+
+SDK::CrError CameraDevice::upload_setting_file(const text& path, CrInt32u timeout_ms)
+{
+    if (false == get_camera_setting_saveread_state()) {
+        return SDK::CrError_Adaptor_DeviceBusy;
+    }
+    if (SDK::CrCameraSettingReadOperation::CrCameraSettingReadOperation_Enable != m_prop.camera_setting_read_operation.current) {
+        spdlog::error("Unable to upload Camera-Setting file.");
+        return SDK::CrError_Generic_NotSupported;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_setting_file_mutex);
+        m_setting_file_state = SettingFileState::Pending;
+        m_setting_file_name.clear();
+    }
+
+    // The camera reports the result of reading the file through OnWarning
+    SDK::CrError err = SDK::UploadSettingFile(m_device_handle, SDK::CrUploadSettingFileType::CrUploadSettingFileType_Setup, const_cast<text_char*>(path.c_str()));
+    if (CR_FAILED(err)) {
+        finish_setting_file(false, text());
+        return err;
+    }
+    text unused;
+    return wait_setting_file(timeout_ms, unused);
+}
+
+SDK::CrError CameraDevice::wait_setting_file(CrInt32u timeout_ms, text& file)
+{
+    std::unique_lock<std::mutex> lock(m_setting_file_mutex);
+    bool done = m_setting_file_cond.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]() {
+        return m_setting_file_state != SettingFileState::Pending;
+    });
+    if (!done) {
+        m_setting_file_state = SettingFileState::Idle;
+        return SDK::CrError_Generic_Abort;
+    }
+
+    file = m_setting_file_name;
+    bool succeeded = (m_setting_file_state == SettingFileState::Succeeded);
+    m_setting_file_state = SettingFileState::Idle;
+    return succeeded ? SDK::CrError_None : SDK::CrError_Generic_Unknown;
+}
+
+void CameraDevice::finish_setting_file(bool succeeded, const text& file)
+{
+    std::lock_guard<std::mutex> lock(m_setting_file_mutex);
+    if (m_setting_file_state != SettingFileState::Pending) {
+        // Not started by download_setting_file (interactive menu)
+        return;
+    }
+    m_setting_file_state = succeeded ? SettingFileState::Succeeded : SettingFileState::Failed;
+    m_setting_file_name = file;
+    m_setting_file_cond.notify_all();
+}
+
 void CameraDevice::getContentsList()
 {
     // check status
@@ -6782,6 +7086,54 @@ void CameraDevice::stopMonitoring()
     }
 }
 
+SDK::CrError CameraDevice::set_monitoring_delivery(const std::string& host_ip, CrInt32u port, CrInt32u down_time)
+{
+    SDK::CrMonitoringDeliverySetting* setting = new SDK::CrMonitoringDeliverySetting[1];
+    CrInt32u ipLen = (CrInt32u)host_ip.length();
+    setting->type = SDK::CrMonitoringDeliveryType_Jpeg;
+    setting->ipAddress = new CrInt8u[ipLen + sizeof(CrInt16u) + 1]; // sizeof(CrInt16u) = The first 2bytes are String length, +1 = Null-terminate.
+    CrInt16u* strLen = (CrInt16u*)setting->ipAddress;
+    *strLen = ipLen + 1; // String length, include Null-terminate
+    for (CrInt32u i = 0; i < ipLen; i++) {
+        setting->ipAddress[sizeof(CrInt16u) + i] = (CrInt8u)host_ip[i];
+    }
+    setting->ipAddress[ipLen + sizeof(CrInt16u)] = '\0';
+    setting->downTime = down_time;
+    setting->videoPort = port;
+
+    SDK::CrError err = SDK::SetMonitoringDeliverySetting(m_device_handle, setting, 1);
+    delete[] setting->ipAddress;
+    if (setting) delete[] setting;
+
+    return err;
+}
+
+SDK::CrError CameraDevice::control_monitoring(bool start)
+{
+    return SDK::ControlMonitoring(m_device_handle, start ? SDK::CrMonitoringOpertation_Start : SDK::CrMonitoringOpertation_Stop);
+}
+
+bool CameraDevice::is_monitoring_delivering()
+{
+    std::int32_t nprop = 0;
+    SDK::CrDeviceProperty* prop_list = nullptr;
+    CrInt32u getCode = SDK::CrDevicePropertyCode::CrDeviceProperty_MonitoringIsDelivering;
+    auto status = SDK::GetSelectDeviceProperties(m_device_handle, 1, &getCode, &prop_list, &nprop);
+    if (CR_FAILED(status)) {
+        return false;
+    }
+
+    bool delivering = false;
+    if (prop_list && 0 < nprop) {
+        auto prop = prop_list[0];
+        if (getCode == prop.GetCode()) {
+            delivering = (prop.GetCurrentValue() == SDK::CrMonitoringIsDelivering_True);
+        }
+        SDK::ReleaseDeviceProperties(m_device_handle, prop_list);
+    }
+    return delivering;
+}
+
 }
 // namespace cli
 
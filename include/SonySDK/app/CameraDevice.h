@@ -25,6 +25,11 @@ typedef int errno_t;
 #include <iomanip>  // For formatted output
 #include <stdexcept>  // For exception handling
 #include <future>
+#include <functional>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
 
 namespace cli
 {
@@ -52,6 +57,28 @@ typedef std::vector<CRFolderInfos*> MtpFolderList;
 typedef std::vector<SCRSDK::CrMtpContentsInfo*> MtpContentsList;
 typedef std::vector<SCRSDK::CrMediaProfileInfo*> MediaProfileList;
 
+// Date folder of the memory card, as listed by GetDateFolderList
+struct ContentsFolder
+{
+    SCRSDK::CrFolderHandle handle;
+    text name;
+};
+
+// Called from OnNotifyContentsTransfer (SDK callback thread), filename is empty unless completed
+typedef std::function<void(CrInt32u notify, SCRSDK::CrContentHandle handle, const text& filename)> ContentsTransferListener;
+
+// Called from OnPropertyChanged/OnPropertyChangedCodes (SDK callback thread), codes is empty for OnPropertyChanged
+typedef std::function<void(const std::vector<CrInt32u>& codes)> PropertyChangeListener;
+
+// Progress of a camera-setting file download or upload, completed by the SDK callbacks
+enum class SettingFileState
+{
+    Idle,
+    Pending,
+    Succeeded,
+    Failed
+};
+
 class CameraDevice : public SCRSDK::IDeviceCallback
 {
 public:
@@ -94,6 +121,7 @@ public:
     void get_focus_mode();
     void get_focus_area();
     void get_live_view();
+    SCRSDK::CrError get_live_view_image(std::vector<CrInt8u>& image, CrInt32u& frame_no);
     void get_live_view_image_quality();
     void get_af_area_position();
     bool get_af_area_position_bool();
@@ -235,6 +263,25 @@ public:
     void getScreennail(SCRSDK::CrContentHandle content);
     void getThumbnail(SCRSDK::CrContentHandle content);
 
+    // Non-interactive contents access used by the server
+    bool is_contents_transfer_enabled();
+    SCRSDK::CrError get_date_folders(std::vector<ContentsFolder>& folders);
+    SCRSDK::CrError get_contents_handles(SCRSDK::CrFolderHandle folder, std::vector<SCRSDK::CrContentHandle>& handles);
+    SCRSDK::CrError get_contents_detail(SCRSDK::CrContentHandle handle, SCRSDK::CrMtpContentsInfo& info);
+    SCRSDK::CrError pull_contents_file(SCRSDK::CrContentHandle handle, const text& path);
+    SCRSDK::CrError get_contents_thumbnail(SCRSDK::CrContentHandle handle, CrInt8u* buffer, CrInt32u capacity, CrInt8u*& data, CrInt32u& size, SCRSDK::CrFileType& type);
+    int add_contents_transfer_listener(ContentsTransferListener listener);
+    void remove_contents_transfer_listener(int id);
+
+    // Property changes reported by the camera, for the server waiting on state transitions
+    int add_property_change_listener(PropertyChangeListener listener);
+    void remove_property_change_listener(int id);
+
+    // Non-interactive camera-setting file access used by the server
+    SCRSDK::CrError get_settings_fingerprint(std::uint64_t& fingerprint);
+    SCRSDK::CrError download_setting_file(const text& directory, const text& name, CrInt32u timeout_ms, text& written_file);
+    SCRSDK::CrError upload_setting_file(const text& path, CrInt32u timeout_ms);
+
     SCRSDK::CrSdkControlMode get_sdkmode();
 
     CrInt32u get_sshsupport();
@@ -245,6 +292,10 @@ public:
     void setMonitoringDeriverySetting();
     void startMonitoring();
     void stopMonitoring();
+    // Non-interactive variants used by the server
+    SCRSDK::CrError set_monitoring_delivery(const std::string& host_ip, CrInt32u port, CrInt32u down_time);
+    SCRSDK::CrError control_monitoring(bool start);
+    bool is_monitoring_delivering();
 
 public:
     // Inherited via IDeviceCallback
@@ -268,6 +319,9 @@ private:
     text format_dispstrlist(SCRSDK::CrDisplayStringListInfo list);
     text format_display_string_type(SCRSDK::CrDisplayStringType type);
     void check_monitoringstatus();
+    SCRSDK::CrError wait_setting_file(CrInt32u timeout_ms, text& file);
+    void finish_setting_file(bool succeeded, const text& file);
+    void notify_property_change(const std::vector<CrInt32u>& codes);
 
 private:
     std::int32_t m_number;
@@ -279,6 +333,7 @@ private:
     UsbInfo m_usb_info;
     PropertyValueTable m_prop;
     bool m_lvEnbSet;
+    std::vector<CrInt8u> m_lv_buffer; // Reused receive buffer for get_live_view_image
     SCRSDK::CrSdkControlMode m_modeSDK;
     MtpFolderList   m_foldList;
     MtpContentsList m_contentList;
@@ -288,6 +343,16 @@ private:
     MediaProfileList m_mediaprofileList;
     std::string m_fingerprint;
     std::string m_userPassword;
+    std::map<int, ContentsTransferListener> m_contents_listeners;
+    int m_contents_listener_id = 0;
+    std::mutex m_contents_listener_mutex;
+    std::map<int, PropertyChangeListener> m_property_listeners;
+    int m_property_listener_id = 0;
+    std::mutex m_property_listener_mutex;
+    SettingFileState m_setting_file_state = SettingFileState::Idle;
+    text m_setting_file_name; // File reported by OnCompleteDownload
+    std::mutex m_setting_file_mutex;
+    std::condition_variable m_setting_file_cond;
 };
 } // namespace cli
 
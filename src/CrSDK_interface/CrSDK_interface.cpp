@@ -255,7 +255,7 @@ bool CrSDKInterface::connectToCameras()
     }
 }
 
-bool CrSDKInterface::switchToMMode(int cameraNumber)
+bool CrSDKInterface::switchToMMode(int cameraNumber, const Deadline &deadline)
 {
     try
     {
@@ -263,17 +263,16 @@ bool CrSDKInterface::switchToMMode(int cameraNumber)
         cameraList[cameraNumber]->set_exposure_program_M_mode(cameraModes[cameraNumber]);
 
         // Introduce a small delay to allow the camera to process the mode change
-        std::this_thread::sleep_for(std::chrono::milliseconds(2000));
-
-        // Create a promise and future pair
-        std::promise<void> prom;
-        std::future<void> fut = prom.get_future();
-
-        // Call the asynchronous function to update the variable that holds the mode of the camera and pass the promise
-        cameraList[cameraNumber]->get_exposure_program_mode(prom, cameraModes[cameraNumber]);
+        if (!deadline.sleep(std::chrono::milliseconds(2000)))
+        {
+            return deadlineExpired(cameraNumber);
+        }
 
-        // Wait for the asynchronous function to complete
-        fut.wait();
+        // Update the variable that holds the mode of the camera
+        if (!readCameraMode(cameraNumber, deadline))
+        {
+            return deadlineExpired(cameraNumber);
+        }
 
         // Log the current mode for debugging
         spdlog::info("Current camera {} mode: {}", cameraNumber, cameraModes[cameraNumber]);
@@ -289,25 +288,37 @@ bool CrSDKInterface::switchToMMode(int cameraNumber)
 
             // Set the Shutter Speed value to 1/4 by default or to the user's previous choice if he has already chosen before        
             spdlog::info("Change the value of the shutter speed...");
-            std::future<bool> setManualShutterSpeedSuccessFuture = std::async(std::launch::async, [=]() 
+            std::future<bool> setManualShutterSpeedSuccessFuture = launchCall<bool>([=]() 
             {
                 return cameraList[cameraNumber]->set_manual_shutter_speed_bool(CONVERT_BRIGHTNESS_TO_SHUTTER_SPEED(this->BrightnessValue));
-            });
+            }, deadline);
 
             // Wait for the asynchronous function to complete and get the result
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-            setShutterSpeedSuccess = setManualShutterSpeedSuccessFuture.get();
+            if (!deadline.sleep(std::chrono::milliseconds(500)))
+            {
+                return deadlineExpired(cameraNumber);
+            }
+            if (!deadline.wait(setManualShutterSpeedSuccessFuture, setShutterSpeedSuccess))
+            {
+                return deadlineExpired(cameraNumber);
+            }
 
             // Set the ISO value to 12,800 by default or to the user's previous choice if he has already chosen before        
             spdlog::info("Change the value of the ISO...");
-            std::future<bool> setManualIsoSuccessFuture = std::async(std::launch::async, [=]() 
+            std::future<bool> setManualIsoSuccessFuture = launchCall<bool>([=]() 
             {
                 return cameraList[cameraNumber]->set_manual_iso_bool(CONVERT_BRIGHTNESS_TO_ISO(this->BrightnessValue)); 
-            });
+            }, deadline);
 
             // Wait for the asynchronous function to complete and get the result
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-            setIsoSuccess = setManualIsoSuccessFuture.get();
+            if (!deadline.sleep(std::chrono::milliseconds(500)))
+            {
+                return deadlineExpired(cameraNumber);
+            }
+            if (!deadline.wait(setManualIsoSuccessFuture, setIsoSuccess))
+            {
+                return deadlineExpired(cameraNumber);
+            }
 
             // Checking whether changing the ISO succeeded or failed
             if(!setIsoSuccess)
@@ -338,7 +349,7 @@ bool CrSDKInterface::switchToMMode(int cameraNumber)
     }
 }
 
-bool CrSDKInterface::switchToPMode(int cameraNumber)
+bool CrSDKInterface::switchToPMode(int cameraNumber, const Deadline &deadline)
 {
     try
     {
@@ -346,17 +357,16 @@ bool CrSDKInterface::switchToPMode(int cameraNumber)
         cameraList[cameraNumber]->set_exposure_program_P_mode(cameraModes[cameraNumber]);
 
         // Introduce a small delay to allow the camera to process the mode change
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-
-        // Create a promise and future pair
-        std::promise<void> prom;
-        std::future<void> fut = prom.get_future();
-
-        // Call the asynchronous function to update the variable that holds the mode of the camera and pass the promise
-        cameraList[cameraNumber]->get_exposure_program_mode(prom, cameraModes[cameraNumber]);
+        if (!deadline.sleep(std::chrono::milliseconds(1000)))
+        {
+            return deadlineExpired(cameraNumber);
+        }
 
-        // Wait for the asynchronous function to complete
-        fut.wait();
+        // Update the variable that holds the mode of the camera
+        if (!readCameraMode(cameraNumber, deadline))
+        {
+            return deadlineExpired(cameraNumber);
+        }
 
         // Log the current mode for debugging
         spdlog::info("Current camera {} mode: {}", cameraNumber, cameraModes[cameraNumber]);
@@ -382,7 +392,7 @@ bool CrSDKInterface::switchToPMode(int cameraNumber)
             }
 
             // Load Zoom and Focus Position Enable Preset.
-            bool loadZoomAndFocusPositionSuccess = loadZoomAndFocusPosition(cameraNumber);
+            bool loadZoomAndFocusPositionSuccess = loadZoomAndFocusPosition(cameraNumber, deadline);
             if (loadZoomAndFocusPositionSuccess)
             {
                 spdlog::info("Load Zoom and Focus Position Enable Preset was successful");
@@ -405,7 +415,7 @@ bool CrSDKInterface::switchToPMode(int cameraNumber)
     }
 }
 
-bool CrSDKInterface::changeBrightness(int cameraNumber, int userBrightnessInput)
+bool CrSDKInterface::changeBrightness(int cameraNumber, int userBrightnessInput, const Deadline &deadline)
 {
     try
     {
@@ -433,54 +443,78 @@ bool CrSDKInterface::changeBrightness(int cameraNumber, int userBrightnessInput)
         if (userBrightnessInput <= 33)
         {
             spdlog::info("Change the value of the shutter speed...");
-            std::future<bool> setManualShutterSpeedSuccessFuture = std::async(std::launch::async, [=]() 
+            std::future<bool> setManualShutterSpeedSuccessFuture = launchCall<bool>([=]() 
             {
                 return cameraList[cameraNumber]->set_manual_shutter_speed_bool(CONVERT_BRIGHTNESS_TO_SHUTTER_SPEED(userBrightnessInput));
-            });
+            }, deadline);
 
             // Wait for the asynchronous function to complete and get the result
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-            setManualShutterSpeedSuccess = setManualShutterSpeedSuccessFuture.get();
+            if (!deadline.sleep(std::chrono::milliseconds(500)))
+            {
+                return deadlineExpired(cameraNumber);
+            }
+            if (!deadline.wait(setManualShutterSpeedSuccessFuture, setManualShutterSpeedSuccess))
+            {
+                return deadlineExpired(cameraNumber);
+            }
 
             // Checking whether the ISO value that the user selected is different from the current value
             if(isoValue != CONVERT_BRIGHTNESS_TO_ISO(DEFAULT_BRIGHTNESS_VALUE))
             {
                 spdlog::info("Change the value of the ISO...");
-                std::future<bool> setManualIsoSuccessFuture = std::async(std::launch::async, [=]() 
+                std::future<bool> setManualIsoSuccessFuture = launchCall<bool>([=]() 
                 {
                     return cameraList[cameraNumber]->set_manual_iso_bool(CONVERT_BRIGHTNESS_TO_ISO(DEFAULT_BRIGHTNESS_VALUE)); 
-                });
+                }, deadline);
 
                 // Wait for the asynchronous function to complete and get the result
-                std::this_thread::sleep_for(std::chrono::milliseconds(500));
-                setManualIsoSuccess = setManualIsoSuccessFuture.get();
+                if (!deadline.sleep(std::chrono::milliseconds(500)))
+                {
+                    return deadlineExpired(cameraNumber);
+                }
+                if (!deadline.wait(setManualIsoSuccessFuture, setManualIsoSuccess))
+                {
+                    return deadlineExpired(cameraNumber);
+                }
             }
         }
         else
         {
             // Set fixed shutter speed (33) and ISO (23-38)
             spdlog::info("Change the value of the ISO...");
-            std::future<bool> setManualIsoSuccessFuture = std::async(std::launch::async, [=]() 
+            std::future<bool> setManualIsoSuccessFuture = launchCall<bool>([=]() 
             {
                 return cameraList[cameraNumber]->set_manual_iso_bool(CONVERT_BRIGHTNESS_TO_ISO(userBrightnessInput));
-            });
+            }, deadline);
 
             // Wait for the asynchronous function to complete and get the result
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-            setManualIsoSuccess = setManualIsoSuccessFuture.get();
+            if (!deadline.sleep(std::chrono::milliseconds(500)))
+            {
+                return deadlineExpired(cameraNumber);
+            }
+            if (!deadline.wait(setManualIsoSuccessFuture, setManualIsoSuccess))
+            {
+                return deadlineExpired(cameraNumber);
+            }
 
             // Checking whether the shutter speed value that the user selected is different from the current value
             if(ShutterSpeedValue != CONVERT_BRIGHTNESS_TO_SHUTTER_SPEED(DEFAULT_BRIGHTNESS_VALUE))
             {
                 spdlog::info("Change the value of the shutter speed...");
-                std::future<bool> setManualShutterSpeedSuccessFuture = std::async(std::launch::async, [=]() 
+                std::future<bool> setManualShutterSpeedSuccessFuture = launchCall<bool>([=]() 
                 {
                     return cameraList[cameraNumber]->set_manual_shutter_speed_bool(CONVERT_BRIGHTNESS_TO_SHUTTER_SPEED(DEFAULT_BRIGHTNESS_VALUE));
-                });
+                }, deadline);
 
                 // Wait for the asynchronous function to complete and get the result
-                std::this_thread::sleep_for(std::chrono::milliseconds(500));
-                setManualShutterSpeedSuccess = setManualShutterSpeedSuccessFuture.get();
+                if (!deadline.sleep(std::chrono::milliseconds(500)))
+                {
+                    return deadlineExpired(cameraNumber);
+                }
+                if (!deadline.wait(setManualShutterSpeedSuccessFuture, setManualShutterSpeedSuccess))
+                {
+                    return deadlineExpired(cameraNumber);
+                }
             }
         }
 
@@ -509,7 +543,7 @@ bool CrSDKInterface::changeBrightness(int cameraNumber, int userBrightnessInput)
     }
 }
 
-bool CrSDKInterface::changeAFAreaPosition(int cameraNumber, int x, int y)
+bool CrSDKInterface::changeAFAreaPosition(int cameraNumber, int x, int y, const Deadline &deadline)
 {
     try
     {
@@ -538,13 +572,17 @@ bool CrSDKInterface::changeAFAreaPosition(int cameraNumber, int x, int y)
         spdlog::info("change the camera {} AF area position...", cameraNumber);
 
         // Attempt to set the AF area position
-        std::future<bool> setAFPositionFuture = std::async(std::launch::async, [=]() 
+        std::future<bool> setAFPositionFuture = launchCall<bool>([=]() 
         {
             return cameraList[cameraNumber]->set_manual_af_area_position(x_y);
-        });
+        }, deadline);
 
         // Wait for the asynchronous function to complete and get the result
-        bool setAFPositionStatus = setAFPositionFuture.get();
+        bool setAFPositionStatus = false;
+        if (!deadline.wait(setAFPositionFuture, setAFPositionStatus))
+        {
+            return deadlineExpired(cameraNumber);
+        }
 
         if (setAFPositionStatus)
         {
@@ -555,13 +593,17 @@ bool CrSDKInterface::changeAFAreaPosition(int cameraNumber, int x, int y)
         spdlog::error("Failed to set the camera {} AF area position. Trying one more time...", cameraNumber);
 
         // Create a future to run the asynchronous function to change to P_Auto mode
-        std::future<bool> changeToPModeFuture = std::async(std::launch::async, [=]() 
+        std::future<bool> changeToPModeFuture = launchCall<bool>([=]() 
         {
             return cameraList[cameraNumber]->set_exposure_program_P_Auto_mode(cameraModes[cameraNumber]);
-        });
+        }, deadline);
 
         // Wait for the asynchronous function to complete and get the result
-        bool changeModeStatus = changeToPModeFuture.get();
+        bool changeModeStatus = false;
+        if (!deadline.wait(changeToPModeFuture, changeModeStatus))
+        {
+            return deadlineExpired(cameraNumber);
+        }
 
         if (!changeModeStatus) 
         {
@@ -572,18 +614,25 @@ bool CrSDKInterface::changeAFAreaPosition(int cameraNumber, int x, int y)
         spdlog::info("change the camera {} mode to P_Auto mode succeeded", cameraNumber);
 
         // Introduce a small delay to allow the camera to process the mode change
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        if (!deadline.sleep(std::chrono::milliseconds(500)))
+        {
+            return deadlineExpired(cameraNumber);
+        }
 
         bool setAFAreeaPositionSuccess = true;
 
         // Attempt to set the AF area position
-        std::future<bool> setAFPositionFutureSecondTime = std::async(std::launch::async, [=]() 
+        std::future<bool> setAFPositionFutureSecondTime = launchCall<bool>([=]() 
         {
             return cameraList[cameraNumber]->set_manual_af_area_position(x_y);
-        });
+        }, deadline);
 
         // Wait for the asynchronous function to complete and get the result
-        bool setAFPositionStatusSecondTime = setAFPositionFutureSecondTime.get();
+        bool setAFPositionStatusSecondTime = false;
+        if (!deadline.wait(setAFPositionFutureSecondTime, setAFPositionStatusSecondTime))
+        {
+            return deadlineExpired(cameraNumber);
+        }
 
         if (!setAFPositionStatusSecondTime)
         {
@@ -592,13 +641,16 @@ bool CrSDKInterface::changeAFAreaPosition(int cameraNumber, int x, int y)
         }
 
         // Create a future to run the asynchronous function to change to Movie_P mode
-        std::future<bool> changeToMovieModeFuture = std::async(std::launch::async, [=]() 
+        std::future<bool> changeToMovieModeFuture = launchCall<bool>([=]() 
         {
             return cameraList[cameraNumber]->set_exposure_program_P_mode(cameraModes[cameraNumber]);
-        });
+        }, deadline);
 
         // Wait for the asynchronous function to complete and get the result
-        changeModeStatus = changeToMovieModeFuture.get();
+        if (!deadline.wait(changeToMovieModeFuture, changeModeStatus))
+        {
+            return deadlineExpired(cameraNumber);
+        }
 
         if (!changeModeStatus) 
         {
@@ -609,7 +661,10 @@ bool CrSDKInterface::changeAFAreaPosition(int cameraNumber, int x, int y)
         spdlog::info("change the camera {} mode back to Movie_P mode succeeded", cameraNumber);
 
         // Introduce a small delay to allow the camera to process the mode change
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        if (!deadline.sleep(std::chrono::milliseconds(500)))
+        {
+            return deadlineExpired(cameraNumber);
+        }
 
         if(setAFAreeaPositionSuccess)
         {
@@ -698,19 +753,15 @@ int CrSDKInterface::getCameraBrightness(int cameraNumber)
     }
 }
 
-bool CrSDKInterface::getCameraMode(int cameraNumber)
+bool CrSDKInterface::getCameraMode(int cameraNumber, const Deadline &deadline)
 {
     try
     {
-        // Create a promise and future pair
-        std::promise<void> prom;
-        std::future<void> fut = prom.get_future();
-
-        // Call the asynchronous function to get information about a specific camera mode and pass the promise
-        cameraList[cameraNumber]->get_exposure_program_mode(prom, cameraModes[cameraNumber]);
-
-        // Wait for the asynchronous function to complete
-        fut.wait();
+        // Update the variable that holds the mode of the camera
+        if (!readCameraMode(cameraNumber, deadline))
+        {
+            return deadlineExpired(cameraNumber);
+        }
 
         // Check if the camera mode is either "p" (program mode) or "m" (manual mode)
         return (cameraModes[cameraNumber] == "p" || cameraModes[cameraNumber] == "m");
@@ -722,6 +773,66 @@ bool CrSDKInterface::getCameraMode(int cameraNumber)
     }
 }
 
+bool CrSDKInterface::readCameraMode(int cameraNumber, const Deadline &deadline)
+{
+    // The mode is read into a copy, an abandoned read must not write the shared variable
+    std::future<cli::text> modeFuture = launchCall<cli::text>([this, cameraNumber]()
+    {
+        std::promise<void> prom;
+        std::future<void> fut = prom.get_future();
+        cli::text mode;
+        cameraList[cameraNumber]->get_exposure_program_mode(prom, mode);
+        fut.wait();
+        return mode;
+    }, deadline);
+
+    cli::text mode;
+    if (!deadline.wait(modeFuture, mode))
+    {
+        return false;
+    }
+
+    cameraModes[cameraNumber] = mode;
+    return true;
+}
+
+bool CrSDKInterface::readCameraBrightness(int cameraNumber, const Deadline &deadline, int &brightness)
+{
+    // The settings of this camera, another camera may have been set since
+    std::future<std::pair<cli::text, cli::text>> settingsFuture = launchCall<std::pair<cli::text, cli::text>>([this, cameraNumber]()
+    {
+        cli::text iso = cameraList[cameraNumber]->get_iso_text();
+        cli::text shutterSpeed = cameraList[cameraNumber]->get_shutter_speed_text();
+        return std::make_pair(iso, shutterSpeed);
+    }, deadline);
+
+    std::pair<cli::text, cli::text> settings;
+    if (!deadline.wait(settingsFuture, settings))
+    {
+        return false;
+    }
+
+    // The inverse of changeBrightness: the shutter speed below 33, the ISO above
+    int isoValue = iso_converter.isoStringToValue(settings.first);
+    int ShutterSpeedValue = shutter_speed_converter.shutterStringToValue(settings.second);
+    brightness = -1;
+    if (ShutterSpeedValue > 0 && isoValue == CONVERT_BRIGHTNESS_TO_ISO(0))
+    {
+        brightness = DEFAULT_BRIGHTNESS_VALUE - ShutterSpeedValue;
+    }
+    else if (ShutterSpeedValue == 0 && isoValue >= CONVERT_BRIGHTNESS_TO_ISO(DEFAULT_BRIGHTNESS_VALUE) && isoValue <= CONVERT_BRIGHTNESS_TO_ISO(48))
+    {
+        brightness = isoValue + 10;
+    }
+    return true;
+}
+
+bool CrSDKInterface::deadlineExpired(int cameraNumber) const
+{
+    spdlog::warn("The request deadline expired while waiting for camera {}, the call was abandoned", cameraNumber);
+    return false;
+}
+
 cli::text CrSDKInterface::getCameraModeStr(int cameraNumber) const
 {
     if (cameraNumber >= 0 && cameraNumber < cameraList.size())
@@ -909,24 +1020,28 @@ bool CrSDKInterface::releaseCameraRemoteSDK()
     }
 }
 
-bool CrSDKInterface::loadZoomAndFocusPosition(int cameraNumber)
+bool CrSDKInterface::loadZoomAndFocusPosition(int cameraNumber, const Deadline &deadline)
 {
     try
     {
         // Execute preset focus.
-        std::promise<bool> executePresetFocusPromise;
-        std::future<bool> executePresetFocusFuture = executePresetFocusPromise.get_future();
-
-        std::async([this, cameraNumber, &executePresetFocusPromise]()
+        std::future<bool> executePresetFocusFuture = launchCall<bool>([this, cameraNumber]()
         {
-            executePresetFocusPromise.set_value(this->cameraList[cameraNumber]->execute_preset_focus_bool()); // Set the value for the promise
-        });
+            return this->cameraList[cameraNumber]->execute_preset_focus_bool();
+        }, deadline);
 
         // Wait for the asynchronous task to complete
-        bool executePresetFocusSuccess = executePresetFocusFuture.get(); 
+        bool executePresetFocusSuccess = false;
+        if (!deadline.wait(executePresetFocusFuture, executePresetFocusSuccess))
+        {
+            return deadlineExpired(cameraNumber);
+        }
         
         // Introduce a small delay to allow the camera to process the set focus position setting
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        if (!deadline.sleep(std::chrono::milliseconds(500)))
+        {
+            return deadlineExpired(cameraNumber);
+        }
        
         if(executePresetFocusSuccess)
         {
@@ -946,22 +1061,29 @@ bool CrSDKInterface::loadZoomAndFocusPosition(int cameraNumber)
     }
 }
 
-cli::text CrSDKInterface::getFnumber(int cameraNumber) 
+cli::text CrSDKInterface::getFnumber(int cameraNumber, const Deadline &deadline)
 {
     try 
     {
         spdlog::info("Getting F-number of camera {}...", cameraNumber);
 
         // Get both F-number and its string representation concurrently
-        auto fnumberFuture = std::async(std::launch::async, [this, cameraNumber] 
+        auto fnumberFuture = launchCall<std::pair<bool, cli::text>>([this, cameraNumber] 
         {
             return std::make_pair(
                 cameraList[cameraNumber]->get_manual_aperture(),
                 cameraList[cameraNumber]->get_manual_aperture_str()
             );
-        });
+        }, deadline);
+
+        std::pair<bool, cli::text> fnumber;
+        if (!deadline.wait(fnumberFuture, fnumber))
+        {
+            deadlineExpired(cameraNumber);
+            return "";
+        }
 
-        auto [getFnumberStatus, fnumberStr] = fnumberFuture.get();
+        auto [getFnumberStatus, fnumberStr] = fnumber;
 
         if (getFnumberStatus && !fnumberStr.empty()) 
         {
@@ -982,7 +1104,7 @@ cli::text CrSDKInterface::getFnumber(int cameraNumber)
     }
 }
 
-bool CrSDKInterface::setFnumber(int cameraNumber, int FnumberValue) 
+bool CrSDKInterface::setFnumber(int cameraNumber, int FnumberValue, const Deadline &deadline)
 {
     try 
     {
@@ -998,16 +1120,17 @@ bool CrSDKInterface::setFnumber(int cameraNumber, int FnumberValue)
         spdlog::info("Getting F-number of camera {}...", cameraNumber);
 
         // Getting the F-number: Simplified, no need for async here
-        std::promise<bool> getAperturePromise;
-        std::future<bool> getApertureFuture = getAperturePromise.get_future();
-
-        std::async([this, cameraNumber, &getAperturePromise]()
+        std::future<bool> getApertureFuture = launchCall<bool>([this, cameraNumber]()
         {
-            getAperturePromise.set_value(this->cameraList[cameraNumber]->get_manual_aperture()); // Set the value for the promise
-        });
+            return this->cameraList[cameraNumber]->get_manual_aperture();
+        }, deadline);
 
         // Wait for the asynchronous task to complete
-        bool getApertureSuccess = getApertureFuture.get(); 
+        bool getApertureSuccess = false;
+        if (!deadline.wait(getApertureFuture, getApertureSuccess))
+        {
+            return deadlineExpired(cameraNumber);
+        }
         
         if (!getApertureSuccess) 
         {
@@ -1018,16 +1141,17 @@ bool CrSDKInterface::setFnumber(int cameraNumber, int FnumberValue)
         spdlog::info("Setting F-number of camera {}...", cameraNumber);
 
         // Setting the F-number: Removed unnecessary async and variable
-        std::promise<bool> setAperturePromise;
-        std::future<bool> setApertureFuture = setAperturePromise.get_future();
-
-        std::async([this, cameraNumber, FnumberValue, &setAperturePromise]()
+        std::future<bool> setApertureFuture = launchCall<bool>([this, cameraNumber, FnumberValue]()
         {
-            setAperturePromise.set_value(this->cameraList[cameraNumber]->set_manual_aperture(FnumberValue)); // Set the value for the promise
-        });
+            return this->cameraList[cameraNumber]->set_manual_aperture(FnumberValue);
+        }, deadline);
 
         // Wait for the asynchronous task to complete
-        bool setApertureSuccess = setApertureFuture.get(); 
+        bool setApertureSuccess = false;
+        if (!deadline.wait(setApertureFuture, setApertureSuccess))
+        {
+            return deadlineExpired(cameraNumber);
+        }
 
         // Logging and returning result: Simplified ternary
         if (setApertureSuccess) 
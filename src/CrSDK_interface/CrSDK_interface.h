@@ -18,6 +18,7 @@
 #include "SonySDK/app/Text.h"
 #include "../Converters/iso_converter/iso_converter.h"
 #include "../Converters/shutter_speed_converter/shutter_speed_converter.h"
+#include "../deadline/deadline.h"
 
 #define LIVEVIEW_ENB
 #define MSEARCH_ENB
@@ -124,33 +125,37 @@ public:
     /**
      * @brief Switching the camera mode to P (auto).
      * @param cameraNumber The number of the camera that the user wants to change its mode to P mode.
+     * @param deadline The time by which the request must be answered.
      * @return True if switching the camera mode was successful, false otherwise.
      */
-    bool switchToPMode(int cameraNumber);
+    bool switchToPMode(int cameraNumber, const Deadline &deadline = Deadline());
 
     /**
      * @brief Switching the camera mode to M (manual).
      * @param cameraNumber The number of the camera that the user wants to change its mode to P mode.
+     * @param deadline The time by which the request must be answered.
      * @return True if switching the camera mode was successful, false otherwise.
      */
-    bool switchToMMode(int cameraNumber);
+    bool switchToMMode(int cameraNumber, const Deadline &deadline = Deadline());
 
     /**
      * @brief Change the brightness of the camera.
      * @param cameraNumber The number of the camera that the user wants to change the brightness of the camera.
      * @param userBrightnessInput The brightness index selected by the user
+     * @param deadline The time by which the request must be answered.
      * @return True if change the brightness was successful, false otherwise.
      */
-    bool changeBrightness(int cameraNumber, int userBrightnessInput);
+    bool changeBrightness(int cameraNumber, int userBrightnessInput, const Deadline &deadline = Deadline());
 
     /**
      * @brief Change the AF area position of the camera.
      * @param cameraNumber The number of the camera that the user wants to change the AF area Position of the camera.
      * @param x position.
      * @param y position.
+     * @param deadline The time by which the request must be answered.
      * @return True if change the AF area Position was successful, false otherwise.
      */
-    bool changeAFAreaPosition(int cameraNumber, int x, int y);
+    bool changeAFAreaPosition(int cameraNumber, int x, int y, const Deadline &deadline = Deadline());
 
     /**
      * @brief Get information about all cameras mode(auto or manual).
@@ -168,9 +173,10 @@ public:
     /**
      * @brief Get information about a specific camera mode (auto or manual).
      * @param cameraNumber The number of the camera that the user wants to get the camera mode.
+     * @param deadline The time by which the request must be answered.
      * @return True if get the camera mode was successful, false otherwise.
      */
-    bool getCameraMode(int cameraNumber);
+    bool getCameraMode(int cameraNumber, const Deadline &deadline = Deadline());
 
     /**
      * @brief Retrieves the camera mode string for a given camera number.
@@ -197,24 +203,51 @@ public:
     /**
      * @brief Change the camera's focus settings.
      * @param cameraNumber The number of the camera that the user wants to change the camera's focus settings.
+     * @param deadline The time by which the request must be answered.
      * @return True if change the camera's focus settings was successful, false otherwise.
     */
-    bool loadZoomAndFocusPosition(int cameraNumber);
+    bool loadZoomAndFocusPosition(int cameraNumber, const Deadline &deadline = Deadline());
 
     /**
      * @brief Get the camera's F-number settings.
      * @param cameraNumber The number of the camera that the user wants to get the camera's F-number settings.
+     * @param deadline The time by which the request must be answered.
      * @return The camera F-number string (if successful).
     */
-    cli::text getFnumber(int cameraNumber);
+    cli::text getFnumber(int cameraNumber, const Deadline &deadline = Deadline());
     
     /**
      * @brief Set the camera's F-number settings.
      * @param cameraNumber The number of the camera that the user wants to set the camera's F-number settings.
      * @param FnumberValue The F-number value selected by the user
+     * @param deadline The time by which the request must be answered.
      * @return True if et the camera's F-number settings was successful, false otherwise.
     */
-    bool setFnumber(int cameraNumber, int FnumberValue);
+    bool setFnumber(int cameraNumber, int FnumberValue, const Deadline &deadline = Deadline());
+
+    /**
+     * @brief Reads the mode of a camera into cameraModes.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param deadline The time by which the request must be answered.
+     * @return False if the deadline expired first, the mode is then left unchanged.
+    */
+    bool readCameraMode(int cameraNumber, const Deadline &deadline);
+
+    /**
+     * @brief Reads the brightness of a camera from its current ISO and shutter speed.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param deadline The time by which the request must be answered.
+     * @param brightness Receives the brightness index (0 to 48), -1 if the settings are not on the brightness scale.
+     * @return False if the deadline expired first.
+    */
+    bool readCameraBrightness(int cameraNumber, const Deadline &deadline, int &brightness);
+
+    /**
+     * @brief Logs a camera call abandoned at the request deadline.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @return False, the result of the abandoned operation.
+    */
+    bool deadlineExpired(int cameraNumber) const;
 
 // private:
     std::vector<cli::text> cameraModes; // No size argument here
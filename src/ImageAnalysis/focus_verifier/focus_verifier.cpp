@@ -0,0 +1,139 @@
+#include "focus_verifier.h"
+
+#include <algorithm>
+
+FocusVerifier::FocusVerifier(LiveView *liveView, EventStream *eventStream)
+    : liveView_(liveView), eventStream_(eventStream)
+{
+    if (liveView_ != nullptr)
+    {
+        lastChecks_.resize(liveView_->getCameraCount());
+    }
+}
+
+FocusCheck FocusVerifier::verify(int cameraNumber, const std::string &trigger, double centerX, double centerY)
+{
+    FocusCheck check;
+    check.trigger = trigger;
+
+    if (liveView_ == nullptr || cameraNumber < 0 || cameraNumber >= static_cast<int>(lastChecks_.size()))
+    {
+        return check;
+    }
+
+    // Make sure the live view is pulling, it may have been idle
+    liveView_->requestFrames(cameraNumber);
+
+    // Frames received before the lens settled still show the move
+    auto settleTime = std::chrono::system_clock::now() + std::chrono::milliseconds(FOCUS_VERIFY_SETTLE_MS);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(FOCUS_VERIFY_TIMEOUT_MS);
+
+    LiveViewFramePtr frame = liveView_->getLatestFrame(cameraNumber);
+    std::uint64_t sequence = frame ? frame->sequence : 0;
+    frame.reset();
+
+    while (!frame || frame->timestamp < settleTime)
+    {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0)
+        {
+            spdlog::warn("No settled live-view frame of camera {} to verify the focus ({})", cameraNumber, trigger);
+            return check;
+        }
+
+        frame = liveView_->waitForFrame(cameraNumber, sequence, remaining);
+        if (!frame)
+        {
+            spdlog::warn("No live-view frame of camera {} to verify the focus ({})", cameraNumber, trigger);
+            return check;
+        }
+        sequence = frame->sequence;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(decodeMutex_);
+
+        // Downscaling would remove the fine detail the score depends on
+        if (!jpegCodec_.decodeLuma(frame->jpeg.data(), frame->jpeg.size(), lumaImage_, 1))
+        {
+            spdlog::warn("Failed to decode live-view frame {} of camera {}", frame->sequence, cameraNumber);
+            return check;
+        }
+
+        centerX = std::max(0.0, std::min(1.0, centerX));
+        centerY = std::max(0.0, std::min(1.0, centerY));
+
+        check.frameWidth = lumaImage_.width;
+        check.frameHeight = lumaImage_.height;
+        check.region.width = std::max(3, static_cast<int>(lumaImage_.width * FOCUS_REGION_FRACTION));
+        check.region.height = std::max(3, static_cast<int>(lumaImage_.height * FOCUS_REGION_FRACTION));
+        check.region.x = std::max(0, std::min(lumaImage_.width - check.region.width, static_cast<int>(centerX * lumaImage_.width) - check.region.width / 2));
+        check.region.y = std::max(0, std::min(lumaImage_.height - check.region.height, static_cast<int>(centerY * lumaImage_.height) - check.region.height / 2));
+
+        check.score = sharpnessMeter_.compute(lumaImage_, check.region);
+    }
+
+    check.analysisMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    check.valid = check.score >= 0.0;
+    check.inFocus = check.score >= FOCUS_SHARPNESS_MIN_SCORE;
+    check.sequence = frame->sequence;
+    check.timestamp = frame->timestamp;
+
+    if (!check.valid)
+    {
+        return check;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        check.previousScore = lastChecks_[cameraNumber].score;
+        lastChecks_[cameraNumber] = check;
+    }
+
+    if (check.inFocus)
+    {
+        spdlog::info("Focus check of camera {} ({}): sharpness {:.1f}", cameraNumber, trigger, check.score);
+    }
+    else
+    {
+        spdlog::warn("Focus check of camera {} ({}): sharpness {:.1f} is below {:.1f}, the image may be soft", cameraNumber, trigger, check.score, FOCUS_SHARPNESS_MIN_SCORE);
+    }
+
+    if (eventStream_ != nullptr)
+    {
+        json data = toJson(check);
+        data["camera_id"] = REVERSE_INDEX(cameraNumber);
+        eventStream_->publish("sharpness", data);
+    }
+
+    return check;
+}
+
+FocusCheck FocusVerifier::getLastCheck(int cameraNumber) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(lastChecks_.size()))
+    {
+        return FocusCheck();
+    }
+
+    return lastChecks_[cameraNumber];
+}
+
+json FocusVerifier::toJson(const FocusCheck &check)
+{
+    json result;
+    result["trigger"] = check.trigger;
+    result["score"] = check.score;
+    result["previous_score"] = check.previousScore;
+    result["in_focus"] = check.inFocus;
+    result["min_score"] = FOCUS_SHARPNESS_MIN_SCORE;
+    result["sequence"] = check.sequence;
+    result["timestamp_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(check.timestamp.time_since_epoch()).count();
+    result["region"] = {{"x", check.region.x}, {"y", check.region.y}, {"width", check.region.width}, {"height", check.region.height}};
+    result["frame_width"] = check.frameWidth;
+    result["frame_height"] = check.frameHeight;
+    result["analysis_ms"] = check.analysisMs;
+    return result;
+}
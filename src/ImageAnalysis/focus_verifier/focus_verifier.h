@@ -0,0 +1,96 @@
+#ifndef FOCUS_VERIFIER_H
+#define FOCUS_VERIFIER_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+#include "../../live_view/live_view.h"
+#include "../../event_stream/event_stream.h"
+#include "../jpeg_codec/jpeg_codec.h"
+#include "../sharpness/sharpness.h"
+
+#define FOCUS_VERIFY_SETTLE_MS 300
+#define FOCUS_VERIFY_TIMEOUT_MS 2000
+#define FOCUS_REGION_FRACTION 0.25
+#define FOCUS_SHARPNESS_MIN_SCORE 100.0
+
+/**
+ * @brief Result of a focus verification of a camera.
+ */
+struct FocusCheck
+{
+    bool valid = false;                                     ///< False if no frame could be measured
+    std::string trigger;                                    ///< What moved the lens ("preset", "af_area", ...)
+    double score = -1.0;                                    ///< Laplacian variance of the region
+    double previousScore = -1.0;                            ///< Score of the previous check of the camera, -1 if none
+    bool inFocus = false;                                   ///< True if score >= FOCUS_SHARPNESS_MIN_SCORE
+    std::uint64_t sequence = 0;                             ///< Live-view sequence number of the measured frame
+    std::chrono::system_clock::time_point timestamp;        ///< Time the measured frame was received
+    PixelRegion region;                                     ///< Measured region of the frame
+    int frameWidth = 0;                                     ///< Width of the measured frame
+    int frameHeight = 0;                                    ///< Height of the measured frame
+    double analysisMs = 0.0;                                ///< Decode + measurement time
+};
+
+/**
+ * @brief The FocusVerifier class checks that the lens ended up sharp after a focus move.
+ *
+ * After a preset recall or an AF area change the verifier waits for the first live-view frame
+ * captured once the lens had time to settle, decodes it at full resolution and scores the
+ * sharpness of a region around the focus point. The result is returned to the caller, kept
+ * per camera and published as a "sharpness" event.
+ */
+class FocusVerifier
+{
+public:
+    /**
+     * @brief Constructs a FocusVerifier object.
+     * @param liveView instance of LiveView class providing the frames.
+     * @param eventStream The event stream receiving the "sharpness" events (optional).
+     */
+    FocusVerifier(LiveView *liveView, EventStream *eventStream = nullptr);
+
+    /**
+     * @brief Measures the sharpness of the next settled frame of a camera.
+     *
+     * Blocks the caller for at least FOCUS_VERIFY_SETTLE_MS and at most FOCUS_VERIFY_TIMEOUT_MS.
+     *
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param trigger What moved the lens, reported in the result.
+     * @param centerX Horizontal center of the measured region (0-1 of the frame width).
+     * @param centerY Vertical center of the measured region (0-1 of the frame height).
+     * @return The result, with valid == false if no frame arrived in time.
+     */
+    FocusCheck verify(int cameraNumber, const std::string &trigger, double centerX = 0.5, double centerY = 0.5);
+
+    /**
+     * @brief Returns the last focus check of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @return The last result, with valid == false if the camera was never checked.
+     */
+    FocusCheck getLastCheck(int cameraNumber) const;
+
+    /**
+     * @brief Converts a focus check into the JSON representation used by the routes and the events.
+     * @param check The focus check to convert.
+     * @return The JSON object.
+     */
+    static json toJson(const FocusCheck &check);
+
+private:
+    LiveView *liveView_;                            ///< Source of the live-view frames
+    EventStream *eventStream_;                      ///< Receiver of the "sharpness" events
+    std::vector<FocusCheck> lastChecks_;            ///< Last result per camera
+    mutable std::mutex mutex_;                      ///< Protects lastChecks_
+    std::mutex decodeMutex_;                        ///< Serializes the decoder between request threads
+    JpegCodec jpegCodec_;                           ///< Full resolution decoder
+    LumaImage lumaImage_;                           ///< Decoded frame, reused between checks
+    SharpnessMeter sharpnessMeter_;                 ///< Laplacian variance kernel
+};
+
+#endif // FOCUS_VERIFIER_H
@@ -0,0 +1,232 @@
+#include "frame_analyzer.h"
+
+FrameAnalyzer::FrameAnalyzer(LiveView *liveView, EventStream *eventStream)
+    : liveView_(liveView), eventStream_(eventStream), running_(false)
+{
+    if (liveView_ != nullptr)
+    {
+        cameras_.resize(liveView_->getCameraCount());
+    }
+}
+
+FrameAnalyzer::~FrameAnalyzer()
+{
+    stop();
+}
+
+void FrameAnalyzer::start()
+{
+    if (liveView_ == nullptr)
+    {
+        spdlog::error("Frame analyzer cannot start without a live view.");
+        return;
+    }
+
+    if (running_.exchange(true))
+    {
+        return;
+    }
+
+    // The listener stays registered for the lifetime of the live view, it is idle while stopped
+    if (!listenerRegistered_)
+    {
+        liveView_->addFrameListener([this](int cameraNumber, const LiveViewFramePtr &frame)
+        {
+            onFrame(cameraNumber, frame);
+        });
+        listenerRegistered_ = true;
+    }
+
+    analysisThread_ = std::thread([this]()
+    {
+        analysisLoop();
+    });
+
+    spdlog::info("Frame analyzer started ({} histogram path).", LumaHistogram::getSimdPath());
+}
+
+void FrameAnalyzer::stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        frameReady_.notify_all();
+    }
+
+    if (analysisThread_.joinable())
+    {
+        analysisThread_.join();
+    }
+
+    spdlog::info("Frame analyzer stopped.");
+}
+
+LumaStatistics FrameAnalyzer::getStatistics(int cameraNumber) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        return LumaStatistics();
+    }
+
+    return cameras_[cameraNumber].statistics;
+}
+
+void FrameAnalyzer::requestAnalysis(int cameraNumber)
+{
+    if (liveView_ != nullptr)
+    {
+        liveView_->requestFrames(cameraNumber);
+    }
+}
+
+json FrameAnalyzer::toJson(const LumaStatistics &statistics, bool includeBins)
+{
+    json result;
+    result["sequence"] = statistics.sequence;
+    result["frame_no"] = statistics.frameNo;
+    result["timestamp_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(statistics.timestamp.time_since_epoch()).count();
+    result["age_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - statistics.timestamp).count();
+    result["width"] = statistics.width;
+    result["height"] = statistics.height;
+    result["mean"] = statistics.mean;
+    result["shadow_clip_percent"] = statistics.shadowClipPercent;
+    result["highlight_clip_percent"] = statistics.highlightClipPercent;
+    result["shadow_clip_count"] = statistics.shadowClipCount;
+    result["highlight_clip_count"] = statistics.highlightClipCount;
+    result["pixel_count"] = statistics.pixelCount;
+    result["analysis_ms"] = statistics.analysisMs;
+
+    if (includeBins)
+    {
+        result["bins"] = statistics.bins;
+    }
+
+    return result;
+}
+
+void FrameAnalyzer::onFrame(int cameraNumber, const LiveViewFramePtr &frame)
+{
+    if (!running_.load())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        return;
+    }
+
+    // Replace any frame not analysed yet, only the newest one matters
+    cameras_[cameraNumber].pending = frame;
+    frameReady_.notify_one();
+}
+
+void FrameAnalyzer::analysisLoop()
+{
+    while (running_.load())
+    {
+        std::vector<std::pair<int, LiveViewFramePtr>> work;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            frameReady_.wait(lock, [this]()
+            {
+                if (!running_.load())
+                {
+                    return true;
+                }
+
+                for (const CameraAnalysis &camera : cameras_)
+                {
+                    if (camera.pending)
+                    {
+                        return true;
+                    }
+                }
+
+                return false;
+            });
+
+            for (int i = 0; i < static_cast<int>(cameras_.size()); ++i)
+            {
+                if (cameras_[i].pending)
+                {
+                    work.emplace_back(i, std::move(cameras_[i].pending));
+                    cameras_[i].pending.reset();
+                }
+            }
+        }
+
+        for (const auto &item : work)
+        {
+            if (!running_.load())
+            {
+                break;
+            }
+
+            try
+            {
+                analyseFrame(item.first, item.second);
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::error("Error while analysing a frame of camera {}: {}", item.first, e.what());
+            }
+        }
+    }
+}
+
+void FrameAnalyzer::analyseFrame(int cameraNumber, const LiveViewFramePtr &frame)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    if (!jpegCodec_.decodeLuma(frame->jpeg.data(), frame->jpeg.size(), lumaImage_, FRAME_ANALYSIS_SCALE))
+    {
+        spdlog::warn("Failed to decode live-view frame {} of camera {}", frame->sequence, cameraNumber);
+        return;
+    }
+    histogram_.compute(lumaImage_);
+
+    LumaStatistics statistics;
+    statistics.valid = true;
+    statistics.sequence = frame->sequence;
+    statistics.frameNo = frame->frameNo;
+    statistics.timestamp = frame->timestamp;
+    statistics.width = lumaImage_.width;
+    statistics.height = lumaImage_.height;
+    statistics.mean = histogram_.getMean();
+    statistics.bins = histogram_.getBins();
+    statistics.pixelCount = histogram_.getPixelCount();
+    statistics.shadowClipCount = histogram_.getShadowClipCount();
+    statistics.highlightClipCount = histogram_.getHighlightClipCount();
+    statistics.shadowClipPercent = histogram_.getShadowClipPercent();
+    statistics.highlightClipPercent = histogram_.getHighlightClipPercent();
+    statistics.analysisMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+    bool publishEvent = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        CameraAnalysis &camera = cameras_[cameraNumber];
+        camera.statistics = statistics;
+
+        // Throttle the events, the live view is much faster than any client needs
+        auto now = std::chrono::steady_clock::now();
+        if (eventStream_ != nullptr && now - camera.lastEvent >= std::chrono::milliseconds(FRAME_ANALYSIS_EVENT_INTERVAL_MS))
+        {
+            camera.lastEvent = now;
+            publishEvent = true;
+        }
+    }
+
+    if (publishEvent)
+    {
+        json data = toJson(statistics);
+        data["camera_id"] = REVERSE_INDEX(cameraNumber);
+        eventStream_->publish("histogram", data);
+    }
+}
@@ -0,0 +1,145 @@
+#ifndef FRAME_ANALYZER_H
+#define FRAME_ANALYZER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+#include "../../live_view/live_view.h"
+#include "../../event_stream/event_stream.h"
+#include "../jpeg_codec/jpeg_codec.h"
+#include "../luma_histogram/luma_histogram.h"
+
+#define FRAME_ANALYSIS_SCALE 2
+#define FRAME_ANALYSIS_EVENT_INTERVAL_MS 500
+
+/**
+ * @brief Luminance statistics of the last analysed live-view frame of a camera.
+ */
+struct LumaStatistics
+{
+    bool valid = false;                                     ///< False until the first frame was analysed
+    std::uint64_t sequence = 0;                             ///< Live-view sequence number of the frame
+    CrInt32u frameNo = 0;                                   ///< Frame number reported by the camera
+    std::chrono::system_clock::time_point timestamp;        ///< Time the frame was received
+    int width = 0;                                          ///< Width of the analysed (downscaled) image
+    int height = 0;                                         ///< Height of the analysed (downscaled) image
+    double mean = 0.0;                                      ///< Mean luminance (0-255)
+    std::array<std::uint32_t, LUMA_HISTOGRAM_BINS> bins{};  ///< Luminance histogram
+    std::uint64_t pixelCount = 0;                           ///< Number of analysed pixels
+    std::uint64_t shadowClipCount = 0;                      ///< Pixels at or below LUMA_SHADOW_CLIP_LEVEL
+    std::uint64_t highlightClipCount = 0;                   ///< Pixels at or above LUMA_HIGHLIGHT_CLIP_LEVEL
+    double shadowClipPercent = 0.0;                         ///< Crushed shadows in percent
+    double highlightClipPercent = 0.0;                      ///< Clipped highlights in percent
+    double analysisMs = 0.0;                                ///< Decode + histogram time of the frame
+};
+
+/**
+ * @brief The FrameAnalyzer class decodes the live-view frames once and computes their luminance statistics.
+ *
+ * Frames are handed over by a LiveView listener and analysed on a dedicated thread so the
+ * producers never wait for the decoder. Only the most recent frame of every camera is kept:
+ * when the analysis is slower than the live view, intermediate frames are skipped.
+ * Statistics are published as throttled "histogram" events when an EventStream is attached.
+ */
+class FrameAnalyzer
+{
+public:
+    /**
+     * @brief Constructs a FrameAnalyzer object.
+     * @param liveView instance of LiveView class providing the frames.
+     * @param eventStream The event stream receiving the "histogram" events (optional).
+     */
+    FrameAnalyzer(LiveView *liveView, EventStream *eventStream = nullptr);
+
+    /**
+     * @brief Stops the analysis thread.
+     */
+    ~FrameAnalyzer();
+
+    /**
+     * @brief Registers the frame listener and starts the analysis thread.
+     */
+    void start();
+
+    /**
+     * @brief Stops the analysis thread.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the statistics of the last analysed frame of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @return The statistics, with valid == false if no frame was analysed yet.
+     */
+    LumaStatistics getStatistics(int cameraNumber) const;
+
+    /**
+     * @brief Keeps the live-view frames of a camera flowing so its statistics stay current.
+     *
+     * The live view only pulls frames on demand; consumers of the statistics call this
+     * every time they read them.
+     *
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    void requestAnalysis(int cameraNumber);
+
+    /**
+     * @brief Converts statistics into the JSON representation used by the routes and the events.
+     * @param statistics The statistics to convert.
+     * @param includeBins True to include the 256 histogram bins.
+     * @return The JSON object.
+     */
+    static json toJson(const LumaStatistics &statistics, bool includeBins = true);
+
+private:
+    /**
+     * @brief Per camera analysis state.
+     */
+    struct CameraAnalysis
+    {
+        LiveViewFramePtr pending;                               ///< Latest frame waiting for analysis
+        LumaStatistics statistics;                              ///< Statistics of the last analysed frame
+        std::chrono::steady_clock::time_point lastEvent;        ///< Time the last event was published
+    };
+
+    /**
+     * @brief Called on the live-view producer thread for every new frame.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param frame The new frame.
+     */
+    void onFrame(int cameraNumber, const LiveViewFramePtr &frame);
+
+    /**
+     * @brief Loop of the analysis thread.
+     */
+    void analysisLoop();
+
+    /**
+     * @brief Decodes and analyses a frame of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param frame The frame to analyse.
+     */
+    void analyseFrame(int cameraNumber, const LiveViewFramePtr &frame);
+
+    LiveView *liveView_;                            ///< Source of the live-view frames
+    EventStream *eventStream_;                      ///< Receiver of the "histogram" events
+    std::vector<CameraAnalysis> cameras_;           ///< Per camera state
+    mutable std::mutex mutex_;                      ///< Protects cameras_
+    std::condition_variable frameReady_;            ///< Signaled when a frame is pending
+    std::thread analysisThread_;                    ///< Analysis thread
+    std::atomic<bool> running_;                     ///< True while the analysis thread runs
+    bool listenerRegistered_ = false;               ///< True once the frame listener was added
+    JpegCodec jpegCodec_;                           ///< Decoder, used by the analysis thread only
+    LumaImage lumaImage_;                           ///< Decoded frame, reused between frames
+    LumaHistogram histogram_;                       ///< Histogram of the decoded frame
+};
+
+#endif // FRAME_ANALYZER_H
@@ -0,0 +1,87 @@
+#include "image_scaler.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define IMAGE_SCALER_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define IMAGE_SCALER_NEON
+#endif
+
+const char *ImageScaler::getSimdPath()
+{
+#if defined(IMAGE_SCALER_SSE2)
+    return "sse2";
+#elif defined(IMAGE_SCALER_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+bool ImageScaler::halve(const RgbxImage &source, RgbxImage &destination)
+{
+    if (source.width < 2 || source.height < 2 || source.pixels.size() < static_cast<std::size_t>(source.width) * source.height * 4)
+    {
+        return false;
+    }
+
+    destination.width = source.width / 2;
+    destination.height = source.height / 2;
+    destination.pixels.resize(static_cast<std::size_t>(destination.width) * destination.height * 4);
+
+    const std::size_t sourceStride = static_cast<std::size_t>(source.width) * 4;
+    const std::size_t destinationStride = static_cast<std::size_t>(destination.width) * 4;
+
+    for (int y = 0; y < destination.height; ++y)
+    {
+        const std::uint8_t *row0 = source.pixels.data() + (2 * y) * sourceStride;
+        const std::uint8_t *row1 = row0 + sourceStride;
+        std::uint8_t *output = destination.pixels.data() + y * destinationStride;
+        int x = 0;
+
+#if defined(IMAGE_SCALER_SSE2)
+        // 8 input pixels -> 4 output pixels per iteration
+        for (; x + 4 <= destination.width; x += 4)
+        {
+            __m128i a = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 8)), _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 8)));
+            __m128i b = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 8 + 16)), _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 8 + 16)));
+
+            // Split the vertically averaged pixels into even and odd columns
+            __m128i even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(2, 0, 2, 0)));
+            __m128i odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(3, 1, 3, 1)));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(output + x * 4), _mm_avg_epu8(even, odd));
+        }
+#elif defined(IMAGE_SCALER_NEON)
+        for (; x + 4 <= destination.width; x += 4)
+        {
+            // vld2q_u32 de-interleaves the even and odd pixels of 8 input pixels
+            uint32x4x2_t top = vld2q_u32(reinterpret_cast<const std::uint32_t *>(row0 + x * 8));
+            uint32x4x2_t bottom = vld2q_u32(reinterpret_cast<const std::uint32_t *>(row1 + x * 8));
+
+            uint8x16_t topAverage = vrhaddq_u8(vreinterpretq_u8_u32(top.val[0]), vreinterpretq_u8_u32(top.val[1]));
+            uint8x16_t bottomAverage = vrhaddq_u8(vreinterpretq_u8_u32(bottom.val[0]), vreinterpretq_u8_u32(bottom.val[1]));
+
+            vst1q_u8(output + x * 4, vrhaddq_u8(topAverage, bottomAverage));
+        }
+#endif
+
+        // Remaining pixels of the row (or the whole row without SIMD)
+        halveRowScalar(row0 + x * 8, row1 + x * 8, output + x * 4, destination.width - x);
+    }
+
+    return true;
+}
+
+void ImageScaler::halveRowScalar(const std::uint8_t *row0, const std::uint8_t *row1, std::uint8_t *output, int count)
+{
+    for (int x = 0; x < count; ++x)
+    {
+        for (int channel = 0; channel < 4; ++channel)
+        {
+            int sum = row0[x * 8 + channel] + row0[x * 8 + 4 + channel] + row1[x * 8 + channel] + row1[x * 8 + 4 + channel];
+            output[x * 4 + channel] = static_cast<std::uint8_t>((sum + 2) >> 2);
+        }
+    }
+}
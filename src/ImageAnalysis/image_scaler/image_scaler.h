@@ -0,0 +1,47 @@
+#ifndef IMAGE_SCALER_H
+#define IMAGE_SCALER_H
+
+#include <cstdint>
+#include <cstddef>
+
+#include "../jpeg_codec/jpeg_codec.h"
+
+/**
+ * @brief The ImageScaler class halves RGBX images with a 2x2 box filter.
+ *
+ * At an exact 1/2 ratio the box filter is the bilinear filter sampled at the output pixel
+ * centers, so cascading it gives the 1/2, 1/4 and 1/8 preview rungs. The rows are averaged
+ * 16 bytes (4 pixels) at a time with SSE2 (x86) or NEON (Jetson / ARM) rounding averages,
+ * with a scalar fallback.
+ */
+class ImageScaler
+{
+public:
+    /**
+     * @brief Scales an image to half its width and height.
+     *
+     * An odd last column or row is dropped.
+     *
+     * @param source The image to scale.
+     * @param destination Receives the scaled image (the pixel buffer is reused when large enough).
+     * @return True if the image was scaled, false if the source is smaller than 2x2 pixels.
+     */
+    static bool halve(const RgbxImage &source, RgbxImage &destination);
+
+    /**
+     * @brief Returns the name of the compiled instruction set path ("sse2", "neon" or "scalar").
+     */
+    static const char *getSimdPath();
+
+private:
+    /**
+     * @brief Averages 2x2 blocks of a row pair.
+     * @param row0 Pointer to the first input pixel of the upper row.
+     * @param row1 Pointer to the first input pixel of the lower row.
+     * @param output Pointer to the first output pixel.
+     * @param count Number of output pixels.
+     */
+    static void halveRowScalar(const std::uint8_t *row0, const std::uint8_t *row1, std::uint8_t *output, int count);
+};
+
+#endif // IMAGE_SCALER_H
@@ -0,0 +1,217 @@
+#include "jpeg_codec.h"
+
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <jpeglib.h>
+
+namespace
+{
+    // libjpeg calls exit() on errors by default, jump back to the caller instead
+    struct JpegErrorManager
+    {
+        jpeg_error_mgr pub;
+        std::jmp_buf setjmpBuffer;
+    };
+
+    void jpegErrorExit(j_common_ptr cinfo)
+    {
+        JpegErrorManager *err = reinterpret_cast<JpegErrorManager *>(cinfo->err);
+        std::longjmp(err->setjmpBuffer, 1);
+    }
+
+    // Silence libjpeg warnings about corrupt data, truncated live-view frames are common
+    void jpegOutputMessage(j_common_ptr)
+    {
+    }
+}
+
+bool JpegCodec::decodeLuma(const std::uint8_t *jpeg, std::size_t size, LumaImage &image, int scaleDenom)
+{
+    if (jpeg == nullptr || size < 4)
+    {
+        spdlog::error("Invalid JPEG buffer");
+        return false;
+    }
+
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager jerr;
+
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = jpegErrorExit;
+    jerr.pub.output_message = jpegOutputMessage;
+
+    if (setjmp(jerr.setjmpBuffer))
+    {
+        jpeg_destroy_decompress(&cinfo);
+        spdlog::error("Failed to decode JPEG image");
+        return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, const_cast<unsigned char *>(jpeg), static_cast<unsigned long>(size));
+    jpeg_read_header(&cinfo, TRUE);
+
+    // Luma only: libjpeg skips the chroma components entirely for YCbCr input
+    cinfo.out_color_space = JCS_GRAYSCALE;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = scaleDenom;
+    cinfo.dct_method = JDCT_IFAST;
+    cinfo.do_fancy_upsampling = FALSE;
+
+    jpeg_start_decompress(&cinfo);
+
+    image.width = static_cast<int>(cinfo.output_width);
+    image.height = static_cast<int>(cinfo.output_height);
+    image.pixels.resize(static_cast<std::size_t>(image.width) * image.height);
+
+    while (cinfo.output_scanline < cinfo.output_height)
+    {
+        JSAMPROW row = image.pixels.data() + static_cast<std::size_t>(cinfo.output_scanline) * image.width;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+
+    return true;
+}
+
+bool JpegCodec::decodeRgbx(const std::uint8_t *jpeg, std::size_t size, RgbxImage &image)
+{
+    if (jpeg == nullptr || size < 4)
+    {
+        spdlog::error("Invalid JPEG buffer");
+        return false;
+    }
+
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager jerr;
+
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = jpegErrorExit;
+    jerr.pub.output_message = jpegOutputMessage;
+
+    if (setjmp(jerr.setjmpBuffer))
+    {
+        jpeg_destroy_decompress(&cinfo);
+        spdlog::error("Failed to decode JPEG image");
+        return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, const_cast<unsigned char *>(jpeg), static_cast<unsigned long>(size));
+    jpeg_read_header(&cinfo, TRUE);
+
+#ifdef JCS_EXTENSIONS
+    // libjpeg-turbo writes the padded pixels directly
+    cinfo.out_color_space = JCS_EXT_RGBX;
+#else
+    cinfo.out_color_space = JCS_RGB;
+#endif
+    cinfo.dct_method = JDCT_IFAST;
+
+    jpeg_start_decompress(&cinfo);
+
+    image.width = static_cast<int>(cinfo.output_width);
+    image.height = static_cast<int>(cinfo.output_height);
+    image.pixels.resize(static_cast<std::size_t>(image.width) * image.height * 4);
+
+    while (cinfo.output_scanline < cinfo.output_height)
+    {
+        std::uint8_t *pixels = image.pixels.data() + static_cast<std::size_t>(cinfo.output_scanline) * image.width * 4;
+
+#ifdef JCS_EXTENSIONS
+        JSAMPROW row = pixels;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+#else
+        rowBuffer_.resize(static_cast<std::size_t>(image.width) * 3);
+        JSAMPROW row = rowBuffer_.data();
+        jpeg_read_scanlines(&cinfo, &row, 1);
+
+        for (int x = 0; x < image.width; ++x)
+        {
+            pixels[x * 4] = rowBuffer_[x * 3];
+            pixels[x * 4 + 1] = rowBuffer_[x * 3 + 1];
+            pixels[x * 4 + 2] = rowBuffer_[x * 3 + 2];
+            pixels[x * 4 + 3] = 0xFF;
+        }
+#endif
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+
+    return true;
+}
+
+bool JpegCodec::encodeRgbx(const RgbxImage &image, int quality, std::vector<std::uint8_t> &jpeg)
+{
+    if (image.width <= 0 || image.height <= 0 || image.pixels.size() < static_cast<std::size_t>(image.width) * image.height * 4)
+    {
+        spdlog::error("Invalid image to encode");
+        return false;
+    }
+
+    jpeg_compress_struct cinfo;
+    JpegErrorManager jerr;
+    unsigned char *buffer = nullptr;
+    unsigned long bufferSize = 0;
+
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = jpegErrorExit;
+    jerr.pub.output_message = jpegOutputMessage;
+
+    if (setjmp(jerr.setjmpBuffer))
+    {
+        jpeg_destroy_compress(&cinfo);
+        std::free(buffer);
+        spdlog::error("Failed to encode JPEG image");
+        return false;
+    }
+
+    jpeg_create_compress(&cinfo);
+    jpeg_mem_dest(&cinfo, &buffer, &bufferSize);
+
+    cinfo.image_width = static_cast<JDIMENSION>(image.width);
+    cinfo.image_height = static_cast<JDIMENSION>(image.height);
+#ifdef JCS_EXTENSIONS
+    cinfo.input_components = 4;
+    cinfo.in_color_space = JCS_EXT_RGBX;
+#else
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+#endif
+
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, quality, TRUE);
+    cinfo.dct_method = JDCT_IFAST;
+
+    jpeg_start_compress(&cinfo, TRUE);
+
+    while (cinfo.next_scanline < cinfo.image_height)
+    {
+        const std::uint8_t *pixels = image.pixels.data() + static_cast<std::size_t>(cinfo.next_scanline) * image.width * 4;
+
+#ifdef JCS_EXTENSIONS
+        JSAMPROW row = const_cast<JSAMPROW>(pixels);
+#else
+        rowBuffer_.resize(static_cast<std::size_t>(image.width) * 3);
+        for (int x = 0; x < image.width; ++x)
+        {
+            rowBuffer_[x * 3] = pixels[x * 4];
+            rowBuffer_[x * 3 + 1] = pixels[x * 4 + 1];
+            rowBuffer_[x * 3 + 2] = pixels[x * 4 + 2];
+        }
+        JSAMPROW row = rowBuffer_.data();
+#endif
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+
+    jpeg_finish_compress(&cinfo);
+    jpeg.assign(buffer, buffer + bufferSize);
+    jpeg_destroy_compress(&cinfo);
+    std::free(buffer);
+
+    return true;
+}
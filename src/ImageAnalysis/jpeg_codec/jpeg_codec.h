@@ -0,0 +1,78 @@
+#ifndef JPEG_CODEC_H
+#define JPEG_CODEC_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+/**
+ * @brief An 8-bit single channel (luma) image.
+ */
+struct LumaImage
+{
+    int width = 0;                      ///< Image width in pixels
+    int height = 0;                     ///< Image height in pixels
+    std::vector<std::uint8_t> pixels;   ///< Row-major pixels, width * height bytes
+};
+
+/**
+ * @brief An 8-bit color image with 4 bytes per pixel (R, G, B, unused).
+ *
+ * The padding byte keeps every pixel 32-bit aligned so vector kernels can move whole pixels.
+ */
+struct RgbxImage
+{
+    int width = 0;                      ///< Image width in pixels
+    int height = 0;                     ///< Image height in pixels
+    std::vector<std::uint8_t> pixels;   ///< Row-major pixels, width * height * 4 bytes
+};
+
+/**
+ * @brief The JpegCodec class decodes the live-view JPEG frames delivered by the cameras and re-encodes previews (libjpeg).
+ */
+class JpegCodec
+{
+public:
+    // Constructor
+    JpegCodec() = default;
+
+    /**
+     * @brief Decodes only the luma (Y) channel of a JPEG image.
+     *
+     * The chroma planes are never upsampled or converted, which makes this considerably
+     * cheaper than a full color decode. The decoder can also scale the image down in the
+     * DCT domain (1/1, 1/2, 1/4 or 1/8) when full resolution is not needed.
+     *
+     * @param jpeg Pointer to the compressed JPEG data.
+     * @param size Size of the compressed data in bytes.
+     * @param image The decoded luma image (the pixel buffer is reused when large enough).
+     * @param scaleDenom The scale denominator (1, 2, 4 or 8).
+     * @return True if the image was decoded successfully, false otherwise.
+     */
+    bool decodeLuma(const std::uint8_t *jpeg, std::size_t size, LumaImage &image, int scaleDenom = 1);
+
+    /**
+     * @brief Decodes a JPEG image into an RGBX image.
+     * @param jpeg Pointer to the compressed JPEG data.
+     * @param size Size of the compressed data in bytes.
+     * @param image The decoded image (the pixel buffer is reused when large enough).
+     * @return True if the image was decoded successfully, false otherwise.
+     */
+    bool decodeRgbx(const std::uint8_t *jpeg, std::size_t size, RgbxImage &image);
+
+    /**
+     * @brief Encodes an RGBX image as a baseline JPEG.
+     * @param image The image to encode.
+     * @param quality The JPEG quality (1-100).
+     * @param jpeg Receives the compressed data.
+     * @return True if the image was encoded successfully, false otherwise.
+     */
+    bool encodeRgbx(const RgbxImage &image, int quality, std::vector<std::uint8_t> &jpeg);
+
+private:
+    std::vector<std::uint8_t> rowBuffer_;   ///< RGB row for libjpeg builds without the RGBX extension
+};
+
+#endif // JPEG_CODEC_H
@@ -0,0 +1,223 @@
+#include "luma_histogram.h"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define LUMA_HISTOGRAM_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LUMA_HISTOGRAM_NEON
+#endif
+
+// 8-bit lane counters are flushed before they can overflow
+#define LUMA_COUNTER_FLUSH_BLOCKS 255
+// NEON pairwise 16-bit sums grow by up to 2 * 255 per block
+#define LUMA_NEON_SUM_FLUSH_BLOCKS 128
+
+LumaHistogram::LumaHistogram()
+    : pixelCount(0), lumaSum(0), shadowClipCount(0), highlightClipCount(0),
+      shadowLevel(LUMA_SHADOW_CLIP_LEVEL), highlightLevel(LUMA_HIGHLIGHT_CLIP_LEVEL)
+{
+    bins.fill(0);
+}
+
+void LumaHistogram::setClipLevels(std::uint8_t shadowLevel, std::uint8_t highlightLevel)
+{
+    this->shadowLevel = shadowLevel;
+    this->highlightLevel = highlightLevel;
+}
+
+const char *LumaHistogram::getSimdPath()
+{
+#if defined(LUMA_HISTOGRAM_SSE2)
+    return "sse2";
+#elif defined(LUMA_HISTOGRAM_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+void LumaHistogram::compute(const LumaImage &image)
+{
+    const std::uint8_t *pixels = image.pixels.data();
+    const std::size_t count = image.pixels.size();
+
+    std::uint32_t subBins[4][LUMA_HISTOGRAM_BINS];
+    std::memset(subBins, 0, sizeof(subBins));
+
+    lumaSum = 0;
+    shadowClipCount = 0;
+    highlightClipCount = 0;
+    pixelCount = count;
+
+    std::size_t i = 0;
+
+#if defined(LUMA_HISTOGRAM_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i shadowVec = _mm_set1_epi8(static_cast<char>(shadowLevel));
+    const __m128i highlightVec = _mm_set1_epi8(static_cast<char>(highlightLevel));
+    __m128i sumAcc = _mm_setzero_si128();
+    __m128i shadowAcc = _mm_setzero_si128();
+    __m128i highlightAcc = _mm_setzero_si128();
+    alignas(16) std::uint8_t lanes[16];
+
+    while (i + 16 <= count)
+    {
+        __m128i shadowCnt = _mm_setzero_si128();
+        __m128i highlightCnt = _mm_setzero_si128();
+
+        for (int block = 0; block < LUMA_COUNTER_FLUSH_BLOCKS && i + 16 <= count; ++block, i += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + i));
+
+            // Sum of absolute differences against zero = horizontal byte sum per 64-bit half
+            sumAcc = _mm_add_epi64(sumAcc, _mm_sad_epu8(v, zero));
+
+            // Unsigned compares: v <= s <=> min(v, s) == v, v >= h <=> max(v, h) == v (mask lanes are -1)
+            shadowCnt = _mm_sub_epi8(shadowCnt, _mm_cmpeq_epi8(_mm_min_epu8(v, shadowVec), v));
+            highlightCnt = _mm_sub_epi8(highlightCnt, _mm_cmpeq_epi8(_mm_max_epu8(v, highlightVec), v));
+
+            _mm_store_si128(reinterpret_cast<__m128i *>(lanes), v);
+            for (int lane = 0; lane < 16; lane += 4)
+            {
+                subBins[0][lanes[lane]]++;
+                subBins[1][lanes[lane + 1]]++;
+                subBins[2][lanes[lane + 2]]++;
+                subBins[3][lanes[lane + 3]]++;
+            }
+        }
+
+        shadowAcc = _mm_add_epi64(shadowAcc, _mm_sad_epu8(shadowCnt, zero));
+        highlightAcc = _mm_add_epi64(highlightAcc, _mm_sad_epu8(highlightCnt, zero));
+    }
+
+    alignas(16) std::uint64_t sums[2];
+    _mm_store_si128(reinterpret_cast<__m128i *>(sums), sumAcc);
+    lumaSum = sums[0] + sums[1];
+    _mm_store_si128(reinterpret_cast<__m128i *>(sums), shadowAcc);
+    shadowClipCount = sums[0] + sums[1];
+    _mm_store_si128(reinterpret_cast<__m128i *>(sums), highlightAcc);
+    highlightClipCount = sums[0] + sums[1];
+
+#elif defined(LUMA_HISTOGRAM_NEON)
+    const uint8x16_t shadowVec = vdupq_n_u8(shadowLevel);
+    const uint8x16_t highlightVec = vdupq_n_u8(highlightLevel);
+    uint32x4_t sumAcc = vdupq_n_u32(0);
+    uint32x4_t shadowAcc = vdupq_n_u32(0);
+    uint32x4_t highlightAcc = vdupq_n_u32(0);
+    std::uint8_t lanes[16];
+
+    while (i + 16 <= count)
+    {
+        uint8x16_t shadowCnt = vdupq_n_u8(0);
+        uint8x16_t highlightCnt = vdupq_n_u8(0);
+        uint16x8_t blockSum = vdupq_n_u16(0);
+
+        for (int block = 0; block < LUMA_NEON_SUM_FLUSH_BLOCKS && i + 16 <= count; ++block, i += 16)
+        {
+            uint8x16_t v = vld1q_u8(pixels + i);
+
+            blockSum = vpadalq_u8(blockSum, v);
+
+            // Compare masks are 0xFF, subtracting them adds one per matching lane
+            shadowCnt = vsubq_u8(shadowCnt, vcleq_u8(v, shadowVec));
+            highlightCnt = vsubq_u8(highlightCnt, vcgeq_u8(v, highlightVec));
+
+            vst1q_u8(lanes, v);
+            for (int lane = 0; lane < 16; lane += 4)
+            {
+                subBins[0][lanes[lane]]++;
+                subBins[1][lanes[lane + 1]]++;
+                subBins[2][lanes[lane + 2]]++;
+                subBins[3][lanes[lane + 3]]++;
+            }
+        }
+
+        sumAcc = vpadalq_u16(sumAcc, blockSum);
+        shadowAcc = vpadalq_u16(shadowAcc, vpaddlq_u8(shadowCnt));
+        highlightAcc = vpadalq_u16(highlightAcc, vpaddlq_u8(highlightCnt));
+
+        // Move the 32-bit lanes into the 64-bit totals so very large frames cannot overflow
+        std::uint32_t sums[4];
+        vst1q_u32(sums, sumAcc);
+        lumaSum += static_cast<std::uint64_t>(sums[0]) + sums[1] + sums[2] + sums[3];
+        vst1q_u32(sums, shadowAcc);
+        shadowClipCount += static_cast<std::uint64_t>(sums[0]) + sums[1] + sums[2] + sums[3];
+        vst1q_u32(sums, highlightAcc);
+        highlightClipCount += static_cast<std::uint64_t>(sums[0]) + sums[1] + sums[2] + sums[3];
+        sumAcc = vdupq_n_u32(0);
+        shadowAcc = vdupq_n_u32(0);
+        highlightAcc = vdupq_n_u32(0);
+    }
+#endif
+
+    // Scalar path for the remaining pixels (or the whole image without SIMD)
+    computeScalar(pixels + i, count - i, subBins);
+
+    for (int bin = 0; bin < LUMA_HISTOGRAM_BINS; ++bin)
+    {
+        bins[bin] = subBins[0][bin] + subBins[1][bin] + subBins[2][bin] + subBins[3][bin];
+    }
+}
+
+void LumaHistogram::computeScalar(const std::uint8_t *pixels, std::size_t count, std::uint32_t (*subBins)[LUMA_HISTOGRAM_BINS])
+{
+    std::size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        std::uint8_t p0 = pixels[i];
+        std::uint8_t p1 = pixels[i + 1];
+        std::uint8_t p2 = pixels[i + 2];
+        std::uint8_t p3 = pixels[i + 3];
+
+        subBins[0][p0]++;
+        subBins[1][p1]++;
+        subBins[2][p2]++;
+        subBins[3][p3]++;
+
+        lumaSum += static_cast<std::uint32_t>(p0) + p1 + p2 + p3;
+        shadowClipCount += (p0 <= shadowLevel) + (p1 <= shadowLevel) + (p2 <= shadowLevel) + (p3 <= shadowLevel);
+        highlightClipCount += (p0 >= highlightLevel) + (p1 >= highlightLevel) + (p2 >= highlightLevel) + (p3 >= highlightLevel);
+    }
+
+    for (; i < count; ++i)
+    {
+        subBins[0][pixels[i]]++;
+        lumaSum += pixels[i];
+        shadowClipCount += (pixels[i] <= shadowLevel);
+        highlightClipCount += (pixels[i] >= highlightLevel);
+    }
+}
+
+double LumaHistogram::getMean() const
+{
+    if (pixelCount == 0)
+    {
+        return 0.0;
+    }
+
+    return static_cast<double>(lumaSum) / static_cast<double>(pixelCount);
+}
+
+double LumaHistogram::getShadowClipPercent() const
+{
+    if (pixelCount == 0)
+    {
+        return 0.0;
+    }
+
+    return 100.0 * static_cast<double>(shadowClipCount) / static_cast<double>(pixelCount);
+}
+
+double LumaHistogram::getHighlightClipPercent() const
+{
+    if (pixelCount == 0)
+    {
+        return 0.0;
+    }
+
+    return 100.0 * static_cast<double>(highlightClipCount) / static_cast<double>(pixelCount);
+}
@@ -0,0 +1,96 @@
+#ifndef LUMA_HISTOGRAM_H
+#define LUMA_HISTOGRAM_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+#include "../jpeg_codec/jpeg_codec.h"
+
+#define LUMA_HISTOGRAM_BINS 256
+#define LUMA_SHADOW_CLIP_LEVEL 2
+#define LUMA_HIGHLIGHT_CLIP_LEVEL 253
+
+/**
+ * @brief The LumaHistogram class computes a 256-bin luminance histogram and clipping statistics of a decoded frame.
+ *
+ * The pixel data is loaded 16 bytes at a time with SSE2 (x86) or NEON (Jetson / ARM). The sum and
+ * the clipped shadow / highlight counters are computed with vector instructions, the bins are
+ * scattered into four interleaved sub-histograms to avoid store-to-load stalls on repeated values.
+ * A scalar path is used when neither instruction set is available.
+ */
+class LumaHistogram
+{
+public:
+    // Constructor
+    LumaHistogram();
+
+    /**
+     * @brief Sets the levels at which pixels are counted as clipped.
+     * @param shadowLevel Pixels at or below this value are crushed shadows.
+     * @param highlightLevel Pixels at or above this value are clipped highlights.
+     */
+    void setClipLevels(std::uint8_t shadowLevel, std::uint8_t highlightLevel);
+
+    /**
+     * @brief Computes the histogram, the mean luminance and the clip counters of a luma image.
+     * @param image The decoded luma image.
+     */
+    void compute(const LumaImage &image);
+
+    /**
+     * @brief Returns the histogram bins (index = luma value 0-255).
+     */
+    const std::array<std::uint32_t, LUMA_HISTOGRAM_BINS> &getBins() const { return bins; }
+
+    /**
+     * @brief Returns the mean luminance (0-255) of the last computed image.
+     */
+    double getMean() const;
+
+    /**
+     * @brief Returns the number of pixels counted in the histogram.
+     */
+    std::uint64_t getPixelCount() const { return pixelCount; }
+
+    /**
+     * @brief Returns the number of pixels at or below the shadow clip level.
+     */
+    std::uint64_t getShadowClipCount() const { return shadowClipCount; }
+
+    /**
+     * @brief Returns the number of pixels at or above the highlight clip level.
+     */
+    std::uint64_t getHighlightClipCount() const { return highlightClipCount; }
+
+    /**
+     * @brief Returns the percentage (0-100) of crushed shadow pixels.
+     */
+    double getShadowClipPercent() const;
+
+    /**
+     * @brief Returns the percentage (0-100) of clipped highlight pixels.
+     */
+    double getHighlightClipPercent() const;
+
+    /**
+     * @brief Returns the name of the compiled instruction set path ("sse2", "neon" or "scalar").
+     */
+    static const char *getSimdPath();
+
+private:
+    /**
+     * @brief Portable implementation, also used for the tail of the vector path.
+     */
+    void computeScalar(const std::uint8_t *pixels, std::size_t count, std::uint32_t (*subBins)[LUMA_HISTOGRAM_BINS]);
+
+    std::array<std::uint32_t, LUMA_HISTOGRAM_BINS> bins;   ///< Histogram bins
+    std::uint64_t pixelCount;                               ///< Number of pixels counted
+    std::uint64_t lumaSum;                                  ///< Sum of all luma values
+    std::uint64_t shadowClipCount;                          ///< Number of crushed shadow pixels
+    std::uint64_t highlightClipCount;                       ///< Number of clipped highlight pixels
+    std::uint8_t shadowLevel;                               ///< Shadow clip level
+    std::uint8_t highlightLevel;                            ///< Highlight clip level
+};
+
+#endif // LUMA_HISTOGRAM_H
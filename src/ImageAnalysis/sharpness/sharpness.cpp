@@ -0,0 +1,127 @@
+#include "sharpness.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SHARPNESS_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SHARPNESS_NEON
+#endif
+
+// Longest row segment whose squared sums fit the 32-bit lane accumulators
+#define SHARPNESS_MAX_VECTOR_ROW 4000
+
+const char *SharpnessMeter::getSimdPath()
+{
+#if defined(SHARPNESS_SSE2)
+    return "sse2";
+#elif defined(SHARPNESS_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+double SharpnessMeter::compute(const LumaImage &image, const PixelRegion &region) const
+{
+    // Clip to the image and keep one pixel for the neighbours
+    int left = std::max(region.x, 1);
+    int top = std::max(region.y, 1);
+    int right = std::min(region.x + region.width, image.width - 1);
+    int bottom = std::min(region.y + region.height, image.height - 1);
+
+    if (right - left < 1 || bottom - top < 1 || static_cast<std::size_t>(image.width) * image.height > image.pixels.size())
+    {
+        return -1.0;
+    }
+
+    const int width = right - left;
+    const int vectorWidth = width <= SHARPNESS_MAX_VECTOR_ROW ? width : 0;
+    const std::uint8_t *pixels = image.pixels.data();
+
+    std::int64_t sum = 0;
+    std::uint64_t squaredSum = 0;
+
+    for (int y = top; y < bottom; ++y)
+    {
+        const std::uint8_t *row = pixels + static_cast<std::size_t>(y) * image.width + left;
+        const std::uint8_t *above = row - image.width;
+        const std::uint8_t *below = row + image.width;
+        int x = 0;
+
+#if defined(SHARPNESS_SSE2)
+        // |L| <= 1020 fits 16-bit lanes, madd adds pairs of squares into 32-bit lanes
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i ones = _mm_set1_epi16(1);
+        __m128i rowSum = _mm_setzero_si128();
+        __m128i rowSquared = _mm_setzero_si128();
+
+        for (; x + 8 <= vectorWidth; x += 8)
+        {
+            __m128i c = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + x)), zero);
+            __m128i n = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(above + x)), zero);
+            __m128i s = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(below + x)), zero);
+            __m128i w = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + x - 1)), zero);
+            __m128i e = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + x + 1)), zero);
+
+            __m128i laplacian = _mm_sub_epi16(_mm_slli_epi16(c, 2), _mm_add_epi16(_mm_add_epi16(n, s), _mm_add_epi16(w, e)));
+
+            rowSum = _mm_add_epi32(rowSum, _mm_madd_epi16(laplacian, ones));
+            rowSquared = _mm_add_epi32(rowSquared, _mm_madd_epi16(laplacian, laplacian));
+        }
+
+        alignas(16) std::int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), rowSum);
+        sum += static_cast<std::int64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), rowSquared);
+        squaredSum += static_cast<std::uint64_t>(static_cast<std::uint32_t>(lanes[0])) + static_cast<std::uint32_t>(lanes[1]) + static_cast<std::uint32_t>(lanes[2]) + static_cast<std::uint32_t>(lanes[3]);
+
+#elif defined(SHARPNESS_NEON)
+        int32x4_t rowSum = vdupq_n_s32(0);
+        uint32x4_t rowSquared = vdupq_n_u32(0);
+
+        for (; x + 8 <= vectorWidth; x += 8)
+        {
+            int16x8_t c = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(row + x)));
+            int16x8_t n = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(above + x)));
+            int16x8_t s = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(below + x)));
+            int16x8_t w = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(row + x - 1)));
+            int16x8_t e = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(row + x + 1)));
+
+            int16x8_t laplacian = vsubq_s16(vshlq_n_s16(c, 2), vaddq_s16(vaddq_s16(n, s), vaddq_s16(w, e)));
+
+            rowSum = vpadalq_s16(rowSum, laplacian);
+            int32x4_t squaredLow = vmull_s16(vget_low_s16(laplacian), vget_low_s16(laplacian));
+            int32x4_t squaredHigh = vmull_s16(vget_high_s16(laplacian), vget_high_s16(laplacian));
+            rowSquared = vaddq_u32(rowSquared, vaddq_u32(vreinterpretq_u32_s32(squaredLow), vreinterpretq_u32_s32(squaredHigh)));
+        }
+
+        std::int32_t sums[4];
+        std::uint32_t squares[4];
+        vst1q_s32(sums, rowSum);
+        vst1q_u32(squares, rowSquared);
+        sum += static_cast<std::int64_t>(sums[0]) + sums[1] + sums[2] + sums[3];
+        squaredSum += static_cast<std::uint64_t>(squares[0]) + squares[1] + squares[2] + squares[3];
+#endif
+
+        // Remaining pixels of the row (or the whole row without SIMD)
+        accumulateScalar(above + x, row + x, below + x, width - x, sum, squaredSum);
+    }
+
+    const double count = static_cast<double>(width) * (bottom - top);
+    const double mean = static_cast<double>(sum) / count;
+
+    return static_cast<double>(squaredSum) / count - mean * mean;
+}
+
+void SharpnessMeter::accumulateScalar(const std::uint8_t *above, const std::uint8_t *row, const std::uint8_t *below, int count, std::int64_t &sum, std::uint64_t &squaredSum)
+{
+    for (int x = 0; x < count; ++x)
+    {
+        int laplacian = 4 * row[x] - above[x] - below[x] - row[x - 1] - row[x + 1];
+        sum += laplacian;
+        squaredSum += static_cast<std::uint64_t>(laplacian * laplacian);
+    }
+}
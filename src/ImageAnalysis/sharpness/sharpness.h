@@ -0,0 +1,61 @@
+#ifndef SHARPNESS_H
+#define SHARPNESS_H
+
+#include <cstdint>
+#include <cstddef>
+
+#include "../jpeg_codec/jpeg_codec.h"
+
+/**
+ * @brief Rectangle of an image in pixels.
+ */
+struct PixelRegion
+{
+    int x = 0;          ///< Left column
+    int y = 0;          ///< Top row
+    int width = 0;      ///< Width in pixels
+    int height = 0;     ///< Height in pixels
+};
+
+/**
+ * @brief The SharpnessMeter class scores the focus quality of a luma image region.
+ *
+ * The score is the variance of the 4-neighbour Laplacian (4c - n - s - w - e): an in-focus
+ * image has strong edges and a high variance, a soft image a low one. The kernel is
+ * computed on 16-bit lanes, 8 pixels at a time with SSE2 (x86) or NEON (Jetson / ARM),
+ * with a scalar fallback. The score only compares frames of the same scene and scale.
+ */
+class SharpnessMeter
+{
+public:
+    /**
+     * @brief Computes the Laplacian variance of a region.
+     *
+     * The region is clipped to the image; the one pixel border is excluded because the
+     * kernel needs all four neighbours.
+     *
+     * @param image The decoded luma image.
+     * @param region The region to measure.
+     * @return The Laplacian variance, or -1 if the region is smaller than 3x3 pixels.
+     */
+    double compute(const LumaImage &image, const PixelRegion &region) const;
+
+    /**
+     * @brief Returns the name of the compiled instruction set path ("sse2", "neon" or "scalar").
+     */
+    static const char *getSimdPath();
+
+private:
+    /**
+     * @brief Accumulates the Laplacian sum and squared sum of a row segment.
+     * @param above Pointer to the first pixel of the row above.
+     * @param row Pointer to the first pixel of the row.
+     * @param below Pointer to the first pixel of the row below.
+     * @param count The number of pixels of the segment.
+     * @param sum Receives the sum of the Laplacian values.
+     * @param squaredSum Receives the sum of the squared Laplacian values.
+     */
+    static void accumulateScalar(const std::uint8_t *above, const std::uint8_t *row, const std::uint8_t *below, int count, std::int64_t &sum, std::uint64_t &squaredSum);
+};
+
+#endif // SHARPNESS_H
@@ -0,0 +1,291 @@
+#include "auto_brightness.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Each brightness index is a 1/3 EV step and the live view is roughly gamma 2.2 encoded
+#define BRIGHTNESS_STEPS_PER_EV 3.0
+#define LIVE_VIEW_GAMMA 2.2
+#define AUTO_BRIGHTNESS_SETTLE_MS 500
+
+AutoBrightnessController::AutoBrightnessController(CrSDKInterface *crsdkInterface, FrameAnalyzer *frameAnalyzer)
+    : crsdkInterface_(crsdkInterface), frameAnalyzer_(frameAnalyzer), running_(false)
+{
+    if (crsdkInterface_ != nullptr)
+    {
+        cameras_.resize(crsdkInterface_->cameraList.size());
+    }
+}
+
+AutoBrightnessController::~AutoBrightnessController()
+{
+    stop();
+}
+
+void AutoBrightnessController::setCameraScheduler(CameraScheduler *cameraScheduler)
+{
+    this->cameraScheduler_ = cameraScheduler;
+}
+
+void AutoBrightnessController::start()
+{
+    if (crsdkInterface_ == nullptr || frameAnalyzer_ == nullptr)
+    {
+        spdlog::error("Auto brightness cannot start without a camera interface and a frame analyzer.");
+        return;
+    }
+
+    if (running_.exchange(true))
+    {
+        return;
+    }
+
+    controlThread_ = std::thread([this]()
+    {
+        controlLoop();
+    });
+
+    spdlog::info("Auto brightness controller started.");
+}
+
+void AutoBrightnessController::stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+
+    if (controlThread_.joinable())
+    {
+        controlThread_.join();
+    }
+
+    spdlog::info("Auto brightness controller stopped.");
+}
+
+bool AutoBrightnessController::configure(int cameraNumber, const AutoBrightnessSettings &settings)
+{
+    if (settings.targetMean < 1.0 || settings.targetMean > 254.0)
+    {
+        spdlog::error("The auto brightness target {} is out of range.", settings.targetMean);
+        return false;
+    }
+
+    if (settings.exitBand <= 0.0 || settings.exitBand > settings.enterBand)
+    {
+        spdlog::error("The auto brightness hysteresis band is invalid ({} / {}).", settings.exitBand, settings.enterBand);
+        return false;
+    }
+
+    if (settings.maxStep < 1 || settings.maxStep > MAX_BRIGHTNESS_VALUE)
+    {
+        spdlog::error("The auto brightness step {} is out of range.", settings.maxStep);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        return false;
+    }
+
+    CameraControl &camera = cameras_[cameraNumber];
+    camera.status.settings = settings;
+    camera.status.adjusting = false;
+    camera.status.measuredMean = -1.0;
+    camera.status.state = settings.enabled ? "measuring" : "disabled";
+
+    spdlog::info("Auto brightness for camera {} {} (target {}).", cameraNumber, settings.enabled ? "enabled" : "disabled", settings.targetMean);
+    return true;
+}
+
+AutoBrightnessStatus AutoBrightnessController::getStatus(int cameraNumber) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        return AutoBrightnessStatus();
+    }
+
+    return cameras_[cameraNumber].status;
+}
+
+void AutoBrightnessController::controlLoop()
+{
+    while (running_.load())
+    {
+        for (int i = 0; i < static_cast<int>(cameras_.size()) && running_.load(); ++i)
+        {
+            try
+            {
+                controlCamera(i);
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::error("Error in the auto brightness controller of camera {}: {}", i, e.what());
+            }
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(AUTO_BRIGHTNESS_LOOP_INTERVAL_MS));
+    }
+}
+
+void AutoBrightnessController::controlCamera(int cameraNumber)
+{
+    AutoBrightnessSettings settings;
+    std::uint64_t lastSequence = 0;
+    std::chrono::system_clock::time_point settleUntil;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        settings = cameras_[cameraNumber].status.settings;
+        lastSequence = cameras_[cameraNumber].lastSequence;
+        settleUntil = cameras_[cameraNumber].settleUntil;
+    }
+
+    if (!settings.enabled)
+    {
+        return;
+    }
+
+    // The brightness index only exists in M mode
+    if (crsdkInterface_->getCameraModeStr(cameraNumber) != "m")
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cameras_[cameraNumber].status.state = "waiting for M mode";
+        cameras_[cameraNumber].status.adjusting = false;
+        return;
+    }
+
+    // The live view only pulls frames while someone needs them
+    frameAnalyzer_->requestAnalysis(cameraNumber);
+
+    LumaStatistics statistics = frameAnalyzer_->getStatistics(cameraNumber);
+    if (!statistics.valid || statistics.sequence == lastSequence)
+    {
+        return;
+    }
+
+    // Frames exposed before the last change are not representative
+    if (statistics.timestamp < settleUntil)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cameras_[cameraNumber].lastSequence = statistics.sequence;
+        return;
+    }
+
+    int step = 0;
+    double measuredMean = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        CameraControl &camera = cameras_[cameraNumber];
+        camera.lastSequence = statistics.sequence;
+
+        // Light smoothing so a single odd frame does not trigger a change
+        measuredMean = camera.status.measuredMean < 0.0 ? statistics.mean : 0.5 * camera.status.measuredMean + 0.5 * statistics.mean;
+        camera.status.measuredMean = measuredMean;
+
+        double error = settings.targetMean - measuredMean;
+
+        // Hysteresis: start outside the wide band, stop once inside the narrow band
+        if (!camera.status.adjusting && std::fabs(error) > settings.enterBand)
+        {
+            camera.status.adjusting = true;
+        }
+        else if (camera.status.adjusting && std::fabs(error) < settings.exitBand)
+        {
+            camera.status.adjusting = false;
+        }
+
+        if (!camera.status.adjusting)
+        {
+            camera.status.state = "converged";
+            return;
+        }
+
+        if (std::chrono::steady_clock::now() - camera.lastAdjustment < settings.minInterval)
+        {
+            camera.status.state = "adjusting (rate limited)";
+            return;
+        }
+
+        step = computeStep(measuredMean, settings.targetMean, settings.maxStep);
+        camera.lastAdjustment = std::chrono::steady_clock::now();
+    }
+
+    // Takes its turn with the requests of the camera, a mode change never overlaps it
+    Deadline deadline = Deadline::after(std::chrono::milliseconds(AUTO_BRIGHTNESS_COMMAND_DEADLINE_MS));
+    CameraCommandPtr command;
+    if (cameraScheduler_ != nullptr)
+    {
+        std::chrono::milliseconds retryAfter;
+        command = cameraScheduler_->admit(cameraNumber, "auto_brightness", CommandPriority::Exposure, std::chrono::milliseconds(AUTO_BRIGHTNESS_COMMAND_DEADLINE_MS), retryAfter);
+        if (!command || !command->wait(deadline))
+        {
+            // Tried again after the minimum interval
+            std::lock_guard<std::mutex> lock(mutex_);
+            cameras_[cameraNumber].status.state = "camera busy";
+            return;
+        }
+        deadline = deadline.holding(command);
+    }
+
+    // Stepped from the settings of this camera, the shared value may come from another camera
+    // or a manual change
+    int currentBrightness = -1;
+    if (!crsdkInterface_->readCameraBrightness(cameraNumber, deadline, currentBrightness) || currentBrightness < 0)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cameras_[cameraNumber].status.brightness = -1;
+        cameras_[cameraNumber].status.state = "brightness unknown";
+        return;
+    }
+
+    int nextBrightness = std::max(MIN_BRIGHTNESS_VALUE, std::min(MAX_BRIGHTNESS_VALUE, currentBrightness + step));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        CameraControl &camera = cameras_[cameraNumber];
+        camera.status.brightness = currentBrightness;
+        if (nextBrightness == currentBrightness)
+        {
+            camera.status.state = "at brightness limit";
+            return;
+        }
+        camera.status.state = "adjusting";
+    }
+
+    spdlog::info("Auto brightness camera {}: mean {:.1f}, target {:.1f}, brightness {} -> {}", cameraNumber, measuredMean, settings.targetMean, currentBrightness, nextBrightness);
+
+    bool success = crsdkInterface_->changeBrightness(cameraNumber, nextBrightness, deadline);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    CameraControl &camera = cameras_[cameraNumber];
+    camera.lastAdjustment = std::chrono::steady_clock::now();
+    camera.settleUntil = std::chrono::system_clock::now() + std::chrono::milliseconds(AUTO_BRIGHTNESS_SETTLE_MS);
+    camera.status.measuredMean = -1.0;
+
+    if (success)
+    {
+        camera.status.adjustments++;
+        camera.status.brightness = nextBrightness;
+    }
+    else
+    {
+        spdlog::error("Auto brightness failed to change the brightness of camera {}", cameraNumber);
+        camera.status.state = "camera rejected the change";
+    }
+}
+
+int AutoBrightnessController::computeStep(double measuredMean, double targetMean, int maxStep)
+{
+    // Exposure is linear, the luminance is gamma encoded: EV = gamma * log2(target / measured)
+    double ev = LIVE_VIEW_GAMMA * std::log2(targetMean / std::max(1.0, measuredMean));
+    int step = static_cast<int>(std::lround(ev * BRIGHTNESS_STEPS_PER_EV));
+
+    // Always move at least one step in the right direction
+    if (step == 0)
+    {
+        step = targetMean > measuredMean ? 1 : -1;
+    }
+
+    return std::max(-maxStep, std::min(maxStep, step));
+}
@@ -0,0 +1,144 @@
+#ifndef AUTO_BRIGHTNESS_H
+#define AUTO_BRIGHTNESS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+#include "../CrSDK_interface/CrSDK_interface.h"
+#include "../ImageAnalysis/frame_analyzer/frame_analyzer.h"
+#include "../camera_scheduler/camera_scheduler.h"
+
+#define MIN_BRIGHTNESS_VALUE 0
+#define MAX_BRIGHTNESS_VALUE 48
+#define AUTO_BRIGHTNESS_DEFAULT_TARGET 118.0
+#define AUTO_BRIGHTNESS_LOOP_INTERVAL_MS 250
+#define AUTO_BRIGHTNESS_COMMAND_DEADLINE_MS 10000  // Deadline of a brightness change in the camera queue
+
+/**
+ * @brief Tuning of the auto-brightness controller of a single camera.
+ */
+struct AutoBrightnessSettings
+{
+    bool enabled = false;                                   ///< True if the controller drives the camera
+    double targetMean = AUTO_BRIGHTNESS_DEFAULT_TARGET;     ///< Target mean luminance (0-255)
+    double enterBand = 16.0;                                ///< Start adjusting when |mean - target| exceeds this
+    double exitBand = 6.0;                                  ///< Stop adjusting when |mean - target| drops below this
+    int maxStep = 4;                                        ///< Largest brightness index change per adjustment
+    std::chrono::milliseconds minInterval{3000};            ///< Minimum time between two adjustments
+};
+
+/**
+ * @brief Snapshot of the auto-brightness controller state of a single camera.
+ */
+struct AutoBrightnessStatus
+{
+    AutoBrightnessSettings settings;                        ///< Current settings
+    bool adjusting = false;                                 ///< True while outside the hysteresis band
+    double measuredMean = -1.0;                             ///< Last measured (smoothed) mean luminance, -1 if none
+    int brightness = -1;                                    ///< Last brightness index known to the controller
+    std::uint64_t adjustments = 0;                          ///< Number of brightness changes sent to the camera
+    std::string state = "disabled";                         ///< Human readable controller state
+};
+
+/**
+ * @brief The AutoBrightnessController class closes the loop between the live-view luminance and the brightness index in M mode.
+ *
+ * The controller reads the mean luminance of the live-view frames from the FrameAnalyzer and moves the brightness
+ * index (which changeBrightness maps to shutter speed and ISO) toward a target mean. A hysteresis
+ * band keeps it quiet once converged and adjustments are rate limited so the camera is never
+ * flooded with property changes.
+ */
+class AutoBrightnessController
+{
+public:
+    /**
+     * @brief Constructs an AutoBrightnessController object.
+     * @param crsdkInterface instance of CrSDKInterface class.
+     * @param frameAnalyzer instance of FrameAnalyzer class providing the luminance statistics.
+     */
+    AutoBrightnessController(CrSDKInterface *crsdkInterface, FrameAnalyzer *frameAnalyzer);
+
+    /**
+     * @brief Stops the control thread.
+     */
+    ~AutoBrightnessController();
+
+    /**
+     * @brief Sets the queue of the camera commands, the brightness changes run in it at exposure priority.
+     * @param cameraScheduler A pointer to the CameraScheduler object.
+     */
+    void setCameraScheduler(CameraScheduler *cameraScheduler);
+
+    /**
+     * @brief Starts the control thread.
+     */
+    void start();
+
+    /**
+     * @brief Stops the control thread.
+     */
+    void stop();
+
+    /**
+     * @brief Changes the settings of the controller of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param settings The new settings.
+     * @return True if the settings are valid and were applied, false otherwise.
+     */
+    bool configure(int cameraNumber, const AutoBrightnessSettings &settings);
+
+    /**
+     * @brief Returns the controller state of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @return The controller state.
+     */
+    AutoBrightnessStatus getStatus(int cameraNumber) const;
+
+private:
+    /**
+     * @brief Per camera controller state.
+     */
+    struct CameraControl
+    {
+        AutoBrightnessStatus status;                                ///< Settings and published state
+        std::uint64_t lastSequence = 0;                             ///< Last analysed frame
+        std::chrono::steady_clock::time_point lastAdjustment;       ///< Time of the last brightness change
+        std::chrono::system_clock::time_point settleUntil;          ///< Frames captured before this are ignored
+    };
+
+    /**
+     * @brief Control loop of the controller thread.
+     */
+    void controlLoop();
+
+    /**
+     * @brief Runs one control step for a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    void controlCamera(int cameraNumber);
+
+    /**
+     * @brief Converts a luminance error into a brightness index step.
+     * @param measuredMean The measured mean luminance.
+     * @param targetMean The target mean luminance.
+     * @param maxStep The largest allowed step.
+     * @return The signed number of brightness steps.
+     */
+    static int computeStep(double measuredMean, double targetMean, int maxStep);
+
+    CrSDKInterface *crsdkInterface_;            ///< Instance of CrSDKInterface
+    FrameAnalyzer *frameAnalyzer_;              ///< Source of the luminance statistics
+    CameraScheduler *cameraScheduler_ = nullptr; ///< Queue of the camera commands
+    std::vector<CameraControl> cameras_;        ///< Per camera state
+    mutable std::mutex mutex_;                  ///< Protects cameras_
+    std::thread controlThread_;                 ///< Controller thread
+    std::atomic<bool> running_;                 ///< True while the controller thread runs
+};
+
+#endif // AUTO_BRIGHTNESS_H
@@ -0,0 +1,13 @@
+#ifndef CAMERA_INDEX_H
+#define CAMERA_INDEX_H
+
+// Mapping between the camera IDs of the clients and the indexes of the camera list,
+// shared by the routes, the responses and the events
+
+// Macro to reverse the index
+#define REVERSE_INDEX(index) ((index) == 0 ? 1 : 0)
+
+// Macro to keep the index the same
+#define NORMAL_INDEX(index) (index)
+
+#endif // CAMERA_INDEX_H
@@ -0,0 +1,255 @@
+#include "camera_scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+CameraCommand::CameraCommand(CameraScheduler *scheduler, int cameraNumber, std::uint64_t id, const std::string &kind, CommandPriority priority, std::chrono::milliseconds predicted)
+    : scheduler_(scheduler), cameraNumber_(cameraNumber), id_(id), kind_(kind), priority_(priority), ranAt_(priority), predicted_(predicted)
+{
+}
+
+CameraCommand::~CameraCommand()
+{
+    scheduler_->finish(*this);
+}
+
+bool CameraCommand::wait(const Deadline &deadline)
+{
+    return scheduler_->begin(*this, deadline);
+}
+
+CameraScheduler::CameraScheduler(std::size_t cameraCount)
+    : cameras_(cameraCount)
+{
+}
+
+const char *CameraScheduler::priorityName(CommandPriority priority)
+{
+    switch (priority)
+    {
+    case CommandPriority::Interactive:
+        return "interactive";
+    case CommandPriority::Exposure:
+        return "exposure";
+    case CommandPriority::Status:
+        return "status";
+    case CommandPriority::Bulk:
+        return "bulk";
+    default:
+        return "unknown";
+    }
+}
+
+CommandPriority CameraScheduler::agedPriority(const Pending &pending, std::chrono::steady_clock::time_point now)
+{
+    auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(now - pending.admittedAt).count();
+    long level = static_cast<long>(pending.priority) - static_cast<long>(waited / CAMERA_COMMAND_AGING_MS);
+    return static_cast<CommandPriority>(std::max(level, 0L));
+}
+
+bool CameraScheduler::nextCommand(const CameraQueue &camera, std::chrono::steady_clock::time_point now, std::uint64_t &id)
+{
+    // The highest priority after aging, the oldest among equals (the queue is in admission order)
+    bool found = false;
+    CommandPriority best = CommandPriority::Count;
+    for (const Pending &pending : camera.queue)
+    {
+        if (camera.running && pending.id == camera.runningId)
+        {
+            continue;
+        }
+
+        CommandPriority priority = agedPriority(pending, now);
+        if (priority < best)
+        {
+            best = priority;
+            id = pending.id;
+            found = true;
+        }
+    }
+    return found;
+}
+
+void CameraScheduler::chooseNext(CameraQueue &camera, std::chrono::steady_clock::time_point now)
+{
+    camera.hasNext = !camera.running && nextCommand(camera, now, camera.nextId);
+}
+
+double CameraScheduler::backlogMs(const CameraQueue &camera, std::chrono::steady_clock::time_point now, CommandPriority priority)
+{
+    double backlog = 0.0;
+    for (const Pending &pending : camera.queue)
+    {
+        if (camera.running && pending.id == camera.runningId)
+        {
+            // Only what is left of the running command, at least nothing
+            double elapsed = std::chrono::duration<double, std::milli>(now - camera.startedAt).count();
+            backlog += std::max(pending.expectedMs - elapsed, 0.0);
+        }
+        else if (agedPriority(pending, now) <= priority)
+        {
+            backlog += pending.expectedMs;
+        }
+    }
+    return backlog;
+}
+
+CameraCommandPtr CameraScheduler::admit(int cameraNumber, const std::string &kind, CommandPriority priority, std::chrono::milliseconds deadline, std::chrono::milliseconds &retryAfter)
+{
+    retryAfter = std::chrono::milliseconds(0);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        return nullptr;
+    }
+
+    CameraQueue &camera = cameras_[cameraNumber];
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    auto average = camera.averageMs.find(kind);
+    double expected = average != camera.averageMs.end() ? average->second : CAMERA_COMMAND_INITIAL_MS;
+    double predicted = backlogMs(camera, now, priority) + expected;
+
+    if (predicted > static_cast<double>(deadline.count()))
+    {
+        // Fits once the queue ahead has shrunk by the excess
+        retryAfter = std::chrono::milliseconds(static_cast<std::int64_t>(std::ceil(predicted - deadline.count())));
+        camera.refused++;
+        return nullptr;
+    }
+
+    std::uint64_t id = nextId_++;
+    camera.queue.push_back(Pending{id, expected, priority, now});
+    camera.admitted++;
+
+    // A free camera may start the new command rather than the one chosen before
+    if (!camera.running)
+    {
+        chooseNext(camera, now);
+        turn_.notify_all();
+    }
+    return CameraCommandPtr(new CameraCommand(this, cameraNumber, id, kind, priority, std::chrono::milliseconds(static_cast<std::int64_t>(predicted))));
+}
+
+bool CameraScheduler::hasPending(int cameraNumber, CommandPriority priority) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        return false;
+    }
+
+    const std::vector<Pending> &queue = cameras_[cameraNumber].queue;
+    return std::any_of(queue.begin(), queue.end(), [priority](const Pending &pending)
+    {
+        return pending.priority < priority;
+    });
+}
+
+bool CameraScheduler::begin(CameraCommand &command, const Deadline &deadline)
+{
+    if (command.started_)
+    {
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    CameraQueue &camera = cameras_[command.cameraNumber_];
+    auto turn = [&camera, &command]()
+    {
+        return !camera.running && camera.hasNext && camera.nextId == command.id_;
+    };
+
+    if (!deadline.isSet())
+    {
+        turn_.wait(lock, turn);
+    }
+    else if (!turn_.wait_until(lock, deadline.time(), turn))
+    {
+        // Left in the queue until destroyed, the commands behind move up then
+        camera.expired++;
+        return false;
+    }
+
+    camera.running = true;
+    camera.hasNext = false;
+    camera.runningId = command.id_;
+    camera.startedAt = std::chrono::steady_clock::now();
+    command.started_ = true;
+    command.startedAt_ = camera.startedAt;
+    command.deadline_ = deadline.holding(nullptr);
+
+    auto position = std::find_if(camera.queue.begin(), camera.queue.end(), [&command](const Pending &pending)
+    {
+        return pending.id == command.id_;
+    });
+    command.ranAt_ = agedPriority(*position, camera.startedAt);
+    if (command.ranAt_ < command.priority_)
+    {
+        camera.promoted++;
+    }
+    return true;
+}
+
+void CameraScheduler::finish(CameraCommand &command)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    CameraQueue &camera = cameras_[command.cameraNumber_];
+
+    auto position = std::find_if(camera.queue.begin(), camera.queue.end(), [&command](const Pending &pending)
+    {
+        return pending.id == command.id_;
+    });
+    if (position != camera.queue.end())
+    {
+        camera.queue.erase(position);
+    }
+
+    if (command.started_)
+    {
+        camera.running = false;
+        camera.completed++;
+
+        // A request answered at its deadline measures less than the command took, such a
+        // duration is a lower bound and only raises the average
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        bool cutShort = command.deadline_.isSet() && command.deadline_.time() <= now;
+        double duration = std::chrono::duration<double, std::milli>(now - command.startedAt_).count();
+        auto average = camera.averageMs.find(command.kind_);
+        if (average == camera.averageMs.end())
+        {
+            camera.averageMs[command.kind_] = duration;
+        }
+        else if (!cutShort || duration > average->second)
+        {
+            average->second = CAMERA_COMMAND_EWMA_ALPHA * duration + (1.0 - CAMERA_COMMAND_EWMA_ALPHA) * average->second;
+        }
+    }
+
+    chooseNext(camera, std::chrono::steady_clock::now());
+    turn_.notify_all();
+}
+
+std::vector<CameraSchedulerStats> CameraScheduler::getStats() const
+{
+    std::vector<CameraSchedulerStats> stats;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t i = 0; i < cameras_.size(); ++i)
+    {
+        const CameraQueue &camera = cameras_[i];
+        CameraSchedulerStats cameraStats;
+        cameraStats.cameraNumber = static_cast<int>(i);
+        cameraStats.pending = camera.queue.size();
+        cameraStats.running = camera.running;
+        cameraStats.backlogMs = backlogMs(camera, now, CommandPriority::Bulk);
+        cameraStats.admitted = camera.admitted;
+        cameraStats.refused = camera.refused;
+        cameraStats.expired = camera.expired;
+        cameraStats.promoted = camera.promoted;
+        cameraStats.completed = camera.completed;
+        stats.push_back(cameraStats);
+    }
+    return stats;
+}
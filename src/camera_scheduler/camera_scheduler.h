@@ -0,0 +1,234 @@
+#ifndef CAMERA_SCHEDULER_H
+#define CAMERA_SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "../deadline/deadline.h"
+
+#define CAMERA_COMMAND_EWMA_ALPHA 0.2           // Weight of the latest duration in the average
+#define CAMERA_COMMAND_INITIAL_MS 1000.0        // Expected duration of a command never measured
+#define CAMERA_COMMAND_AGING_MS 2000            // Wait after which a queued command rises one priority level
+
+class CameraScheduler;
+
+/**
+ * @brief Priority of a camera command, highest first.
+ */
+enum class CommandPriority
+{
+    Interactive,        ///< Control an operator is waiting on (mode, AF area)
+    Exposure,           ///< Exposure settings (brightness, F-number)
+    Status,             ///< Setting reads
+    Bulk,               ///< Settings files and content transfers
+    Count
+};
+
+/**
+ * @brief Counters of the command queue of a camera.
+ */
+struct CameraSchedulerStats
+{
+    int cameraNumber = 0;                       ///< The camera ID (0-based indexing)
+    std::size_t pending = 0;                    ///< Commands admitted and not finished (running included)
+    bool running = false;                       ///< True while a command runs
+    double backlogMs = 0.0;                     ///< Expected time until the queue is empty
+    std::uint64_t admitted = 0;                 ///< Commands admitted
+    std::uint64_t refused = 0;                  ///< Commands refused for their deadline
+    std::uint64_t expired = 0;                  ///< Commands whose deadline passed in the queue
+    std::uint64_t promoted = 0;                 ///< Commands run above their priority after aging
+    std::uint64_t completed = 0;                ///< Commands run
+};
+
+/**
+ * @brief A command admitted to the queue of a camera.
+ *
+ * The command leaves the queue when the last reference is dropped; if it ran, its duration
+ * is added to the average of its kind. A camera call abandoned at the deadline holds a
+ * reference (see Deadline::holding), so the camera stays reserved until the call returns.
+ */
+class CameraCommand
+{
+public:
+    ~CameraCommand();
+
+    CameraCommand(const CameraCommand &) = delete;
+    CameraCommand &operator=(const CameraCommand &) = delete;
+
+    /**
+     * @brief Waits until the commands admitted before this one have finished.
+     * @param deadline The time by which the request must be answered.
+     * @return false if the deadline expired first; the command then never runs.
+     */
+    bool wait(const Deadline &deadline = Deadline());
+
+    /**
+     * @brief Returns the completion time predicted on admission, from admission.
+     */
+    std::chrono::milliseconds getPredicted() const { return predicted_; }
+
+    /**
+     * @brief Returns the priority the command ran at, its own until it starts.
+     */
+    CommandPriority getPriority() const { return ranAt_; }
+
+private:
+    friend class CameraScheduler;
+
+    CameraCommand(CameraScheduler *scheduler, int cameraNumber, std::uint64_t id, const std::string &kind, CommandPriority priority, std::chrono::milliseconds predicted);
+
+    CameraScheduler *scheduler_;                        ///< Owner of the queue
+    int cameraNumber_;                                  ///< The camera ID (0-based indexing)
+    std::uint64_t id_;                                  ///< Position key in the queue
+    std::string kind_;                                  ///< Kind of command, keys the averages
+    CommandPriority priority_;                          ///< Priority on admission
+    CommandPriority ranAt_;                             ///< Priority on start, raised by aging
+    std::chrono::milliseconds predicted_;               ///< Predicted completion on admission
+    bool started_ = false;                              ///< True once the command got its turn
+    std::chrono::steady_clock::time_point startedAt_;   ///< Start of the command
+    Deadline deadline_;                                 ///< Deadline the command ran under
+};
+
+typedef std::shared_ptr<CameraCommand> CameraCommandPtr;
+
+/**
+ * @brief The CameraScheduler class runs the commands of each camera one at a time.
+ *
+ * A camera handles one command at a time; when it is free, the scheduler starts the queued
+ * command of the highest priority, the oldest first. A running command is never interrupted,
+ * a more urgent one overtakes the queued ones at the next command boundary. Every
+ * CAMERA_COMMAND_AGING_MS spent waiting raises a command one level, so bulk work still runs
+ * under a steady stream of interactive commands.
+ *
+ * The completion of a new command is predicted from the commands that would run before it
+ * and an exponentially weighted average of the durations of each kind of command. A command
+ * predicted to complete after its deadline is refused instead of queued, with the time after
+ * which it would fit.
+ */
+class CameraScheduler
+{
+public:
+    /**
+     * @brief Constructs a CameraScheduler object.
+     * @param cameraCount The number of cameras.
+     */
+    explicit CameraScheduler(std::size_t cameraCount);
+
+    /**
+     * @brief Admits a command to the queue of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param kind The kind of command (the route), keys the duration averages.
+     * @param priority The priority of the command.
+     * @param deadline The time from now by which the command must complete.
+     * @param retryAfter Receives the time after which the command would fit, if refused.
+     * @return The admitted command, or nullptr if it would miss its deadline.
+     */
+    CameraCommandPtr admit(int cameraNumber, const std::string &kind, CommandPriority priority, std::chrono::milliseconds deadline, std::chrono::milliseconds &retryAfter);
+
+    /**
+     * @brief Returns true if commands above a priority are admitted to a camera.
+     *
+     * Work run outside the queue, such as the content pulls, checks it before each step and
+     * leaves the camera to the commands.
+     *
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param priority The priority of the caller.
+     */
+    bool hasPending(int cameraNumber, CommandPriority priority) const;
+
+    /**
+     * @brief Returns the name of a priority, as reported in the responses.
+     */
+    static const char *priorityName(CommandPriority priority);
+
+    /**
+     * @brief Returns the counters of every camera.
+     */
+    std::vector<CameraSchedulerStats> getStats() const;
+
+private:
+    friend class CameraCommand;
+
+    /**
+     * @brief An admitted command waiting or running.
+     */
+    struct Pending
+    {
+        std::uint64_t id;                                       ///< Command key
+        double expectedMs;                                      ///< Expected duration
+        CommandPriority priority;                               ///< Priority on admission
+        std::chrono::steady_clock::time_point admittedAt;       ///< Start of the wait, for the aging
+    };
+
+    /**
+     * @brief The queue of a camera.
+     */
+    struct CameraQueue
+    {
+        std::vector<Pending> queue;                             ///< Admitted commands in admission order, the running one included
+        bool running = false;                                   ///< True while a command runs
+        std::uint64_t runningId = 0;                            ///< Key of the running command
+        bool hasNext = false;                                   ///< True if a command is chosen to start
+        std::uint64_t nextId = 0;                               ///< Key of the command chosen to start next
+        std::chrono::steady_clock::time_point startedAt;        ///< Start of the running command
+        std::unordered_map<std::string, double> averageMs;      ///< Duration average by kind
+        std::uint64_t admitted = 0;                             ///< Commands admitted
+        std::uint64_t refused = 0;                              ///< Commands refused
+        std::uint64_t expired = 0;                              ///< Commands expired in the queue
+        std::uint64_t promoted = 0;                             ///< Commands run above their priority
+        std::uint64_t completed = 0;                            ///< Commands run
+    };
+
+    /**
+     * @brief Returns the priority of a queued command after aging.
+     */
+    static CommandPriority agedPriority(const Pending &pending, std::chrono::steady_clock::time_point now);
+
+    /**
+     * @brief Returns the key of the queued command to start next, if the camera is free.
+     * @return false if no command is waiting.
+     */
+    static bool nextCommand(const CameraQueue &camera, std::chrono::steady_clock::time_point now, std::uint64_t &id);
+
+    /**
+     * @brief Chooses the command to start next on a free camera.
+     *
+     * The choice is made once, under the lock, whenever the queue changes, so every waiter
+     * compares itself with the same command even when aging reorders the queue between their
+     * wake-ups.
+     */
+    static void chooseNext(CameraQueue &camera, std::chrono::steady_clock::time_point now);
+
+    /**
+     * @brief Returns the expected time until a command of a priority would start.
+     *
+     * The running command and the queued ones of the same or a higher priority (after aging)
+     * run first; CommandPriority::Bulk gives the time until the queue is empty.
+     */
+    static double backlogMs(const CameraQueue &camera, std::chrono::steady_clock::time_point now, CommandPriority priority);
+
+    /**
+     * @brief Waits for the turn of a command.
+     * @return false if the deadline expired first.
+     */
+    bool begin(CameraCommand &command, const Deadline &deadline);
+
+    /**
+     * @brief Removes a command from its queue.
+     */
+    void finish(CameraCommand &command);
+
+    std::vector<CameraQueue> cameras_;                  ///< Queue of each camera
+    std::uint64_t nextId_ = 0;                          ///< Key of the next command
+    mutable std::mutex mutex_;                          ///< Protects the queues
+    std::condition_variable turn_;                      ///< Signaled when a command finishes
+};
+
+#endif // CAMERA_SCHEDULER_H
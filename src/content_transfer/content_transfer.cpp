@@ -0,0 +1,746 @@
+#include "content_transfer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Returns the size of a file, or -1 if it does not exist.
+ */
+static long long fileSize(const std::string &path)
+{
+    struct stat fileStat;
+    if (stat(path.c_str(), &fileStat) != 0)
+    {
+        return -1;
+    }
+    return static_cast<long long>(fileStat.st_size);
+}
+
+ContentTransfer::ContentTransfer(CrSDKInterface *crsdkInterface, ContentsCatalog *contentsCatalog,
+                                 const std::string &directory, int cameraConcurrency)
+    : crsdkInterface_(crsdkInterface), contentsCatalog_(contentsCatalog), directory_(directory),
+      cameraConcurrency_(std::max(1, cameraConcurrency)), running_(false)
+{
+    cameras_.resize(crsdkInterface_ ? crsdkInterface_->cameraList.size() : 0);
+}
+
+ContentTransfer::~ContentTransfer()
+{
+    stop();
+}
+
+std::string ContentTransfer::getCameraDirectory(int cameraNumber) const
+{
+    return fmt::format("{}/camera_{}", directory_, cameraNumber);
+}
+
+std::string ContentTransfer::getItemDirectory(const TransferItem &item) const
+{
+    return item.folderName.empty() ? getCameraDirectory(item.cameraNumber) : getCameraDirectory(item.cameraNumber) + "/" + item.folderName;
+}
+
+TransferItem &ContentTransfer::itemOf(const QueueKey &key)
+{
+    return batches_.at(std::get<1>(key)).items.at(std::get<2>(key));
+}
+
+void ContentTransfer::setCameraScheduler(CameraScheduler *cameraScheduler)
+{
+    this->cameraScheduler_ = cameraScheduler;
+}
+
+bool ContentTransfer::start()
+{
+    if (running_.load())
+    {
+        return true;
+    }
+
+    try
+    {
+        for (std::size_t i = 0; i < cameras_.size(); ++i)
+        {
+            fs::create_directories(getCameraDirectory(static_cast<int>(i)));
+        }
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::error("Failed to prepare the contents directory {}: {}", directory_, e.what());
+        return false;
+    }
+
+    if (!loadJournal())
+    {
+        return false;
+    }
+
+    running_.store(true);
+    schedulerThread_ = std::thread(&ContentTransfer::scheduleLoop, this);
+
+    spdlog::info("Content transfer started in {} ({} batch(es) resumed).", directory_, batches_.size());
+    return true;
+}
+
+void ContentTransfer::stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wakeUp_.notify_all();
+    }
+
+    if (schedulerThread_.joinable())
+    {
+        schedulerThread_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t i = 0; i < cameras_.size(); ++i)
+    {
+        CameraQueue &camera = cameras_[i];
+        if (camera.listenerDevice != nullptr && i < crsdkInterface_->cameraList.size() &&
+            crsdkInterface_->cameraList[i].get() == camera.listenerDevice)
+        {
+            camera.listenerDevice->remove_contents_transfer_listener(camera.listenerId);
+        }
+        camera.listenerDevice = nullptr;
+    }
+
+    if (journal_ != nullptr)
+    {
+        std::fclose(journal_);
+        journal_ = nullptr;
+    }
+}
+
+void ContentTransfer::registerListener(int cameraNumber)
+{
+    CameraQueue &camera = cameras_[cameraNumber];
+    if (cameraNumber >= static_cast<int>(crsdkInterface_->cameraList.size()))
+    {
+        camera.listenerDevice = nullptr;
+        return;
+    }
+
+    CameraDevicePtr device = crsdkInterface_->cameraList[cameraNumber];
+    if (!device || device.get() == camera.listenerDevice)
+    {
+        return;
+    }
+
+    camera.listenerId = device->add_contents_transfer_listener([this, cameraNumber](CrInt32u notify, SCRSDK::CrContentHandle handle, const cli::text &filename)
+    {
+        onTransfer(cameraNumber, notify, handle, filename);
+    });
+    camera.listenerDevice = device.get();
+
+    // Pulls started on the previous device will never complete
+    std::vector<QueueKey> lost;
+    for (const auto &pull : camera.running)
+    {
+        lost.push_back(pull.second);
+    }
+    camera.running.clear();
+    for (const auto &key : lost)
+    {
+        failAttempt(cameraNumber, key, "Camera reconnected");
+    }
+}
+
+std::string ContentTransfer::createBatch(const ContentSelection &selection, std::uint64_t &batchId)
+{
+    batchId = 0;
+    if (contentsCatalog_ == nullptr)
+    {
+        return "Contents catalog is not active";
+    }
+
+    if (selection.cameraNumber >= static_cast<int>(cameras_.size()) || (selection.hasFolder && selection.cameraNumber < 0))
+    {
+        return "Invalid selection";
+    }
+
+    Batch batch;
+    batch.priority = selection.priority;
+
+    int first = selection.cameraNumber < 0 ? 0 : selection.cameraNumber;
+    int last = selection.cameraNumber < 0 ? static_cast<int>(cameras_.size()) - 1 : selection.cameraNumber;
+    for (int cameraNumber = first; cameraNumber <= last; ++cameraNumber)
+    {
+        CatalogSnapshotPtr snapshot = contentsCatalog_->getSnapshot(cameraNumber);
+        if (!snapshot)
+        {
+            return fmt::format("Contents catalog of camera {} is not ready", cameraNumber);
+        }
+
+        auto add = [&](const ContentEntry &entry)
+        {
+            // "to" is a prefix, so to=20240610 includes the whole day
+            if ((!selection.from.empty() && entry.captureTime < selection.from) ||
+                (!selection.to.empty() && entry.captureTime.compare(0, selection.to.size(), selection.to) > 0))
+            {
+                return;
+            }
+
+            TransferItem item;
+            item.cameraNumber = cameraNumber;
+            item.handle = entry.handle;
+            item.folderName = entry.folderName;
+            item.fileName = entry.fileName;
+            item.size = entry.size;
+            batch.items.push_back(item);
+        };
+
+        if (selection.hasFolder)
+        {
+            auto folder = snapshot->byFolder.find(selection.folder);
+            if (folder != snapshot->byFolder.end())
+            {
+                for (std::uint32_t position : folder->second)
+                {
+                    add(snapshot->entries[position]);
+                }
+            }
+        }
+        else
+        {
+            for (const auto &entry : snapshot->entries)
+            {
+                add(entry);
+            }
+        }
+    }
+
+    if (batch.items.empty())
+    {
+        return "No contents match the selection";
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch.id = nextBatchId_++;
+    journalBatch(batch);
+    for (std::size_t i = 0; i < batch.items.size(); ++i)
+    {
+        cameras_[batch.items[i].cameraNumber].queue.insert(QueueKey(-batch.priority, batch.id, i));
+    }
+
+    spdlog::info("Content transfer batch {} queued: {} content(s), priority {}", batch.id, batch.items.size(), batch.priority);
+    batchId = batch.id;
+    batches_[batch.id] = std::move(batch);
+    wakeUp_.notify_all();
+    return "";
+}
+
+bool ContentTransfer::cancelBatch(std::uint64_t batchId)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = batches_.find(batchId);
+    if (it == batches_.end())
+    {
+        return false;
+    }
+
+    Batch &batch = it->second;
+    for (std::size_t i = 0; i < batch.items.size(); ++i)
+    {
+        TransferItem &item = batch.items[i];
+        if (item.state == TransferState::Queued)
+        {
+            item.state = TransferState::Canceled;
+            cameras_[item.cameraNumber].queue.erase(QueueKey(-batch.priority, batch.id, i));
+        }
+    }
+
+    appendJournal({{"canceled", batch.id}});
+    return true;
+}
+
+std::vector<TransferBatchStatus> ContentTransfer::getStatus() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<TransferBatchStatus> statuses;
+    auto now = std::chrono::steady_clock::now();
+
+    for (const auto &item : batches_)
+    {
+        const Batch &batch = item.second;
+        TransferBatchStatus status;
+        status.id = batch.id;
+        status.priority = batch.priority;
+        status.resumed = batch.resumed;
+        status.items = batch.items.size();
+
+        for (const auto &content : batch.items)
+        {
+            status.bytes += content.size;
+            switch (content.state)
+            {
+            case TransferState::Queued:
+                status.queued++;
+                break;
+            case TransferState::Running:
+            {
+                status.running++;
+
+                // The file grows while the camera sends it
+                long long partial = fileSize(getItemDirectory(content) + "/" + content.fileName);
+                status.doneBytes += partial > 0 ? std::min<std::uint64_t>(static_cast<std::uint64_t>(partial), content.size) : 0;
+                break;
+            }
+            case TransferState::Done:
+                status.done++;
+                status.doneBytes += content.size;
+                break;
+            case TransferState::Failed:
+                status.failed++;
+                break;
+            case TransferState::Canceled:
+                status.canceled++;
+                break;
+            }
+        }
+
+        double seconds = std::chrono::duration<double>(now - batch.firstPull).count();
+        if (batch.pulling && seconds > 0.0)
+        {
+            status.bytesPerSecond = static_cast<double>(status.doneBytes) / seconds;
+        }
+        statuses.push_back(status);
+    }
+
+    return statuses;
+}
+
+std::vector<int> ContentTransfer::getRunning() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<int> running;
+    for (const auto &camera : cameras_)
+    {
+        running.push_back(static_cast<int>(camera.running.size()));
+    }
+    return running;
+}
+
+void ContentTransfer::scheduleLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_)
+    {
+        checkTimeouts();
+
+        std::vector<PendingPull> pulls;
+        for (std::size_t i = 0; i < cameras_.size(); ++i)
+        {
+            collectPulls(static_cast<int>(i), pulls);
+        }
+
+        if (pulls.empty())
+        {
+            wakeUp_.wait_for(lock, std::chrono::milliseconds(CONTENT_TRANSFER_TICK_MS));
+            continue;
+        }
+
+        // The SDK may notify from inside the call, so the lock is released
+        lock.unlock();
+        for (auto &pull : pulls)
+        {
+            pull.error = pull.device->pull_contents_file(pull.handle, pull.directory);
+        }
+        lock.lock();
+
+        for (const auto &pull : pulls)
+        {
+            if (CR_FAILED(pull.error))
+            {
+                CameraQueue &camera = cameras_[pull.cameraNumber];
+                auto running = camera.running.find(pull.handle);
+                if (running != camera.running.end() && running->second == pull.key)
+                {
+                    camera.running.erase(running);
+                    failAttempt(pull.cameraNumber, pull.key, fmt::format("PullContentsFile failed (0x{:X})", static_cast<unsigned>(pull.error)));
+                }
+            }
+        }
+    }
+}
+
+void ContentTransfer::collectPulls(int cameraNumber, std::vector<PendingPull> &pulls)
+{
+    CameraQueue &camera = cameras_[cameraNumber];
+    if (camera.queue.empty())
+    {
+        return;
+    }
+
+    registerListener(cameraNumber);
+    if (camera.listenerDevice == nullptr || !crsdkInterface_->cameraList[cameraNumber]->is_connected())
+    {
+        return;
+    }
+
+    // Pulls are the lowest priority: commands waiting for the camera go first, at the next file
+    // boundary, unless the pulls have been held back long enough
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (cameraScheduler_ != nullptr && cameraScheduler_->hasPending(cameraNumber, CommandPriority::Bulk))
+    {
+        if (!camera.yielding)
+        {
+            camera.yielding = true;
+            camera.yieldingSince = now;
+        }
+        if (now - camera.yieldingSince < std::chrono::milliseconds(CONTENT_TRANSFER_MAX_YIELD_MS))
+        {
+            return;
+        }
+    }
+    camera.yielding = false;
+
+    while (static_cast<int>(camera.running.size()) < cameraConcurrency_ && !camera.queue.empty())
+    {
+        QueueKey key = *camera.queue.begin();
+        camera.queue.erase(camera.queue.begin());
+
+        Batch &batch = batches_.at(std::get<1>(key));
+        TransferItem &item = batch.items.at(std::get<2>(key));
+        if (item.state != TransferState::Queued)
+        {
+            continue;
+        }
+
+        SCRSDK::CrContentHandle handle = 0;
+        if (!resolveHandle(item, handle))
+        {
+            item.state = TransferState::Failed;
+            item.error = "Content is no longer on the card";
+            appendJournal({{"failed", batch.id}, {"item", std::get<2>(key)}, {"error", item.error}});
+            continue;
+        }
+
+        if (camera.running.count(handle) != 0)
+        {
+            // The same content is being pulled by another batch, try again after it
+            camera.queue.insert(key);
+            break;
+        }
+
+        std::string directory = getItemDirectory(item);
+        std::string path = directory + "/" + item.fileName;
+
+        // Pulled by an earlier batch or before a restart
+        if (item.size > 0 && fileSize(path) == static_cast<long long>(item.size))
+        {
+            item.state = TransferState::Done;
+            item.path = path;
+            appendJournal({{"done", batch.id}, {"item", std::get<2>(key)}, {"path", path}});
+            continue;
+        }
+
+        try
+        {
+            fs::create_directories(directory);
+            if (fileSize(path) >= 0)
+            {
+                // A partial file of an interrupted pull, the camera would write a renamed copy
+                fs::remove(path);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            item.state = TransferState::Failed;
+            item.error = e.what();
+            appendJournal({{"failed", batch.id}, {"item", std::get<2>(key)}, {"error", item.error}});
+            continue;
+        }
+
+        item.state = TransferState::Running;
+        item.attempts++;
+        item.startedAt = std::chrono::steady_clock::now();
+        if (!batch.pulling)
+        {
+            batch.pulling = true;
+            batch.firstPull = item.startedAt;
+        }
+        camera.running[handle] = key;
+
+        PendingPull pull;
+        pull.cameraNumber = cameraNumber;
+        pull.key = key;
+        pull.device = crsdkInterface_->cameraList[cameraNumber];
+        pull.handle = handle;
+        pull.directory = directory;
+        pulls.push_back(pull);
+    }
+}
+
+bool ContentTransfer::resolveHandle(const TransferItem &item, SCRSDK::CrContentHandle &handle) const
+{
+    CatalogSnapshotPtr snapshot = contentsCatalog_->getSnapshot(item.cameraNumber);
+    if (!snapshot)
+    {
+        return false;
+    }
+
+    auto position = snapshot->byHandle.find(item.handle);
+    if (position != snapshot->byHandle.end())
+    {
+        const ContentEntry &entry = snapshot->entries[position->second];
+        if (entry.fileName == item.fileName && entry.folderName == item.folderName)
+        {
+            handle = item.handle;
+            return true;
+        }
+    }
+
+    // The handles were reassigned, find the content by name
+    for (const auto &entry : snapshot->entries)
+    {
+        if (entry.fileName == item.fileName && entry.folderName == item.folderName)
+        {
+            handle = entry.handle;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ContentTransfer::checkTimeouts()
+{
+    auto now = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < cameras_.size(); ++i)
+    {
+        CameraQueue &camera = cameras_[i];
+        std::vector<QueueKey> expired;
+        for (auto it = camera.running.begin(); it != camera.running.end();)
+        {
+            const TransferItem &item = itemOf(it->second);
+            auto timeout = std::chrono::milliseconds(CONTENT_TRANSFER_BASE_TIMEOUT_MS + item.size * 1000 / CONTENT_TRANSFER_MIN_RATE);
+            if (now - item.startedAt > timeout)
+            {
+                expired.push_back(it->second);
+                it = camera.running.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        for (const auto &key : expired)
+        {
+            failAttempt(static_cast<int>(i), key, "Transfer timed out");
+        }
+    }
+}
+
+void ContentTransfer::onTransfer(int cameraNumber, CrInt32u notify, SCRSDK::CrContentHandle handle, const std::string &filename)
+{
+    if (notify == SCRSDK::CrNotify_ContentsTransfer_Start)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    CameraQueue &camera = cameras_[cameraNumber];
+    auto running = camera.running.find(handle);
+    if (running == camera.running.end())
+    {
+        // Not pulled by this manager
+        return;
+    }
+
+    QueueKey key = running->second;
+    camera.running.erase(running);
+
+    if (notify == SCRSDK::CrNotify_ContentsTransfer_Complete)
+    {
+        TransferItem &item = itemOf(key);
+        fs::path path(filename);
+        item.state = TransferState::Done;
+        item.path = path.is_absolute() ? filename : getItemDirectory(item) + "/" + (filename.empty() ? item.fileName : filename);
+        item.error.clear();
+        appendJournal({{"done", std::get<1>(key)}, {"item", std::get<2>(key)}, {"path", item.path}});
+    }
+    else
+    {
+        failAttempt(cameraNumber, key, fmt::format("Transfer failed (0x{:X})", notify));
+    }
+
+    wakeUp_.notify_all();
+}
+
+void ContentTransfer::failAttempt(int cameraNumber, const QueueKey &key, const std::string &error)
+{
+    TransferItem &item = itemOf(key);
+    item.error = error;
+
+    if (item.attempts < CONTENT_TRANSFER_MAX_ATTEMPTS)
+    {
+        item.state = TransferState::Queued;
+        cameras_[cameraNumber].queue.insert(key);
+        spdlog::warn("Pull of {} from camera {} failed ({}), retrying", item.fileName, cameraNumber + 1, error);
+        return;
+    }
+
+    item.state = TransferState::Failed;
+    appendJournal({{"failed", std::get<1>(key)}, {"item", std::get<2>(key)}, {"error", error}});
+    spdlog::error("Pull of {} from camera {} failed after {} attempts: {}", item.fileName, cameraNumber + 1, item.attempts, error);
+}
+
+void ContentTransfer::appendJournal(const nlohmann::json &record)
+{
+    if (journal_ == nullptr)
+    {
+        return;
+    }
+
+    std::string line = record.dump() + "\n";
+    if (std::fwrite(line.data(), 1, line.size(), journal_) != line.size() || std::fflush(journal_) != 0)
+    {
+        spdlog::error("Failed to write the content transfer journal: {}", std::strerror(errno));
+        return;
+    }
+    fdatasync(fileno(journal_));
+}
+
+void ContentTransfer::journalBatch(const Batch &batch)
+{
+    nlohmann::json items = nlohmann::json::array();
+    for (const auto &item : batch.items)
+    {
+        items.push_back({{"camera", item.cameraNumber}, {"handle", item.handle}, {"folder", item.folderName},
+                         {"file", item.fileName}, {"size", item.size}});
+    }
+    appendJournal({{"batch", batch.id}, {"priority", batch.priority}, {"items", items}});
+
+    for (std::size_t i = 0; i < batch.items.size(); ++i)
+    {
+        if (batch.items[i].state == TransferState::Done)
+        {
+            appendJournal({{"done", batch.id}, {"item", i}, {"path", batch.items[i].path}});
+        }
+    }
+}
+
+bool ContentTransfer::loadJournal()
+{
+    std::string path = directory_ + "/transfers.journal";
+    std::map<std::uint64_t, Batch> batches;
+    std::set<std::uint64_t> canceled;
+
+    std::ifstream input(path);
+    std::string line;
+    while (std::getline(input, line))
+    {
+        // A torn last line of a crash is skipped
+        nlohmann::json record = nlohmann::json::parse(line, nullptr, false);
+        if (record.is_discarded() || !record.is_object())
+        {
+            continue;
+        }
+
+        try
+        {
+            if (record.contains("batch"))
+            {
+                Batch batch;
+                batch.id = record["batch"].get<std::uint64_t>();
+                batch.priority = record["priority"].get<int>();
+                batch.resumed = true;
+                for (const auto &entry : record["items"])
+                {
+                    TransferItem item;
+                    item.cameraNumber = entry["camera"].get<int>();
+                    item.handle = entry["handle"].get<SCRSDK::CrContentHandle>();
+                    item.folderName = entry["folder"].get<std::string>();
+                    item.fileName = entry["file"].get<std::string>();
+                    item.size = entry["size"].get<std::uint64_t>();
+                    batch.items.push_back(item);
+                }
+                nextBatchId_ = std::max(nextBatchId_, batch.id + 1);
+                batches[batch.id] = std::move(batch);
+            }
+            else if (record.contains("done"))
+            {
+                TransferItem &item = batches.at(record["done"].get<std::uint64_t>()).items.at(record["item"].get<std::size_t>());
+                item.state = TransferState::Done;
+                item.path = record["path"].get<std::string>();
+            }
+            else if (record.contains("canceled"))
+            {
+                canceled.insert(record["canceled"].get<std::uint64_t>());
+            }
+            // Failed contents are tried again after a restart
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Skipping a content transfer journal record: {}", e.what());
+        }
+    }
+    input.close();
+
+    // Keep the batches with contents left to pull
+    for (auto it = batches.begin(); it != batches.end();)
+    {
+        bool unfinished = canceled.count(it->first) == 0 && std::any_of(it->second.items.begin(), it->second.items.end(), [&](const TransferItem &item)
+        {
+            return item.state != TransferState::Done && item.cameraNumber >= 0 && item.cameraNumber < static_cast<int>(cameras_.size());
+        });
+        it = unfinished ? std::next(it) : batches.erase(it);
+    }
+
+    // Rewrite the journal with the unfinished batches only
+    std::string temporary = path + ".tmp";
+    std::lock_guard<std::mutex> lock(mutex_);
+    journal_ = std::fopen(temporary.c_str(), "w");
+    if (journal_ == nullptr)
+    {
+        spdlog::error("Failed to open the content transfer journal {}: {}", temporary, std::strerror(errno));
+        return false;
+    }
+
+    for (auto &item : batches)
+    {
+        Batch &batch = item.second;
+        journalBatch(batch);
+        for (std::size_t i = 0; i < batch.items.size(); ++i)
+        {
+            TransferItem &content = batch.items[i];
+            if (content.state != TransferState::Done && content.cameraNumber >= 0 && content.cameraNumber < static_cast<int>(cameras_.size()))
+            {
+                cameras_[content.cameraNumber].queue.insert(QueueKey(-batch.priority, batch.id, i));
+            }
+            else if (content.state != TransferState::Done)
+            {
+                content.state = TransferState::Failed;
+                content.error = "Camera not available";
+            }
+        }
+    }
+
+    std::fclose(journal_);
+    journal_ = nullptr;
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        spdlog::error("Failed to replace the content transfer journal {}: {}", path, std::strerror(errno));
+        return false;
+    }
+
+    journal_ = std::fopen(path.c_str(), "a");
+    if (journal_ == nullptr)
+    {
+        spdlog::error("Failed to open the content transfer journal {}: {}", path, std::strerror(errno));
+        return false;
+    }
+
+    batches_ = std::move(batches);
+    return true;
+}
@@ -0,0 +1,312 @@
+#ifndef CONTENT_TRANSFER_H
+#define CONTENT_TRANSFER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+#include <nholman_json/json.hpp>
+
+#include "../CrSDK_interface/CrSDK_interface.h"
+#include "../contents_catalog/contents_catalog.h"
+#include "../camera_scheduler/camera_scheduler.h"
+
+#define CONTENT_TRANSFER_DIRECTORY "/lld_sw_v1.0.0/contents"
+#define CONTENT_TRANSFER_CAMERA_CONCURRENCY 1       // Pulls in flight per camera
+#define CONTENT_TRANSFER_MAX_ATTEMPTS 3
+#define CONTENT_TRANSFER_BASE_TIMEOUT_MS 30000      // Plus the time the file needs at CONTENT_TRANSFER_MIN_RATE
+#define CONTENT_TRANSFER_MIN_RATE (2u * 1024u * 1024u)
+#define CONTENT_TRANSFER_TICK_MS 1000
+#define CONTENT_TRANSFER_MAX_YIELD_MS (3 * CAMERA_COMMAND_AGING_MS)  // Longest a camera holds its pulls back for commands
+
+/**
+ * @brief Contents to pull.
+ */
+struct ContentSelection
+{
+    int cameraNumber = -1;                      ///< Camera (0-based indexing), -1 for all cameras
+    std::string from;                           ///< First capture time, empty for no limit
+    std::string to;                             ///< Last capture time (prefix match), empty for no limit
+    bool hasFolder = false;                     ///< True to select a single date folder
+    SCRSDK::CrFolderHandle folder = 0;          ///< The date folder
+    int priority = 0;                           ///< Higher priorities are pulled first
+};
+
+/**
+ * @brief State of a content in a batch.
+ */
+enum class TransferState
+{
+    Queued,
+    Running,
+    Done,
+    Failed,
+    Canceled
+};
+
+/**
+ * @brief A content of a batch.
+ */
+struct TransferItem
+{
+    int cameraNumber = 0;                                   ///< Camera (0-based indexing)
+    SCRSDK::CrContentHandle handle = 0;                     ///< Content handle when the batch was created
+    std::string folderName;                                 ///< Date folder on the card
+    std::string fileName;                                   ///< File name on the card
+    std::uint64_t size = 0;                                 ///< File size in bytes
+    TransferState state = TransferState::Queued;            ///< Current state
+    int attempts = 0;                                       ///< Pulls started
+    std::string path;                                       ///< Local file once done
+    std::string error;                                      ///< Last error
+    std::chrono::steady_clock::time_point startedAt;        ///< Start of the running pull
+};
+
+/**
+ * @brief Progress of a batch.
+ */
+struct TransferBatchStatus
+{
+    std::uint64_t id = 0;                       ///< Batch ID
+    int priority = 0;                           ///< Batch priority
+    bool resumed = false;                       ///< True if restored from the journal
+    std::size_t items = 0;                      ///< Contents in the batch
+    std::size_t queued = 0;                     ///< Waiting contents
+    std::size_t running = 0;                    ///< Contents being pulled
+    std::size_t done = 0;                       ///< Pulled contents
+    std::size_t failed = 0;                     ///< Contents that failed every attempt
+    std::size_t canceled = 0;                   ///< Canceled contents
+    std::uint64_t bytes = 0;                    ///< Bytes of the batch
+    std::uint64_t doneBytes = 0;                ///< Bytes pulled, including the running files
+    double bytesPerSecond = 0.0;                ///< Rate since the first pull of the batch
+};
+
+/**
+ * @brief The ContentTransfer class pulls batches of contents from the cameras.
+ *
+ * A batch is a selection of the contents catalog (time range or folder, one or all
+ * cameras). Contents are queued per camera by batch priority, then batch age, then capture
+ * time, and every camera has up to a fixed number of pulls in flight, so a rig-wide offload
+ * runs on all camera links at once. PullContentsFile returns immediately; completion and
+ * failures arrive through OnNotifyContentsTransfer. Failed and timed-out pulls are retried.
+ *
+ * Batches and finished contents are appended to a journal. After a restart the unfinished
+ * batches are queued again without the contents that were already pulled.
+ */
+class ContentTransfer
+{
+public:
+    /**
+     * @brief Constructs a ContentTransfer object.
+     * @param crsdkInterface instance of CrSDKInterface class.
+     * @param contentsCatalog instance of ContentsCatalog class used to select the contents.
+     * @param directory The directory receiving the contents.
+     * @param cameraConcurrency The number of pulls in flight per camera.
+     */
+    ContentTransfer(CrSDKInterface *crsdkInterface, ContentsCatalog *contentsCatalog,
+                    const std::string &directory = CONTENT_TRANSFER_DIRECTORY, int cameraConcurrency = CONTENT_TRANSFER_CAMERA_CONCURRENCY);
+
+    /**
+     * @brief Stops the scheduler.
+     */
+    ~ContentTransfer();
+
+    /**
+     * @brief Sets the queue of the camera commands, pulls are not started while commands wait.
+     *
+     * Must be called before start().
+     *
+     * @param cameraScheduler A pointer to the CameraScheduler object.
+     */
+    void setCameraScheduler(CameraScheduler *cameraScheduler);
+
+    /**
+     * @brief Restores the unfinished batches from the journal and starts the scheduler.
+     * @return true on success, false if the directory or the journal cannot be written.
+     */
+    bool start();
+
+    /**
+     * @brief Stops the scheduler, the running pulls are resumed on the next start.
+     */
+    void stop();
+
+    /**
+     * @brief Queues the contents of a selection.
+     * @param selection The contents to pull.
+     * @param batchId Receives the ID of the new batch.
+     * @return An error message, or an empty string on success.
+     */
+    std::string createBatch(const ContentSelection &selection, std::uint64_t &batchId);
+
+    /**
+     * @brief Cancels the queued contents of a batch, running pulls complete.
+     * @param batchId The batch ID.
+     * @return false if the batch does not exist.
+     */
+    bool cancelBatch(std::uint64_t batchId);
+
+    /**
+     * @brief Returns the progress of the batches.
+     */
+    std::vector<TransferBatchStatus> getStatus() const;
+
+    /**
+     * @brief Returns the number of pulls in flight per camera.
+     */
+    std::vector<int> getRunning() const;
+
+    /**
+     * @brief Returns the local directory of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    std::string getCameraDirectory(int cameraNumber) const;
+
+private:
+    /**
+     * @brief A batch of contents.
+     */
+    struct Batch
+    {
+        std::uint64_t id = 0;                                   ///< Batch ID
+        int priority = 0;                                       ///< Batch priority
+        bool resumed = false;                                   ///< Restored from the journal
+        std::vector<TransferItem> items;                        ///< Contents in capture time order
+        std::chrono::steady_clock::time_point firstPull;        ///< Start of the first pull
+        bool pulling = false;                                   ///< True once a pull started
+    };
+
+    /**
+     * @brief Queue position of a content: priority (negated), batch ID, item index.
+     */
+    typedef std::tuple<int, std::uint64_t, std::size_t> QueueKey;
+
+    /**
+     * @brief Pull state of a camera.
+     */
+    struct CameraQueue
+    {
+        std::set<QueueKey> queue;                               ///< Waiting contents
+        std::map<SCRSDK::CrContentHandle, QueueKey> running;    ///< Pulls in flight by handle
+        cli::CameraDevice *listenerDevice = nullptr;            ///< Device the listener is registered on
+        int listenerId = 0;                                     ///< Id of the registered listener
+        bool yielding = false;                                  ///< True while pulls wait for commands
+        std::chrono::steady_clock::time_point yieldingSince;    ///< Start of the wait
+    };
+
+    /**
+     * @brief A pull to start outside of the lock.
+     */
+    struct PendingPull
+    {
+        int cameraNumber = 0;                                   ///< Camera (0-based indexing)
+        QueueKey key;                                           ///< Queue position of the content
+        CameraDevicePtr device;                                 ///< The camera
+        SCRSDK::CrContentHandle handle = 0;                     ///< Current handle of the content
+        std::string directory;                                  ///< Destination directory
+        SCRSDK::CrError error = SCRSDK::CrError_None;           ///< Result of PullContentsFile
+    };
+
+    /**
+     * @brief Loop of the scheduler thread.
+     */
+    void scheduleLoop();
+
+    /**
+     * @brief Takes queued contents of a camera up to its concurrency and marks them running (mutex_ held).
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param pulls Receives the pulls to start.
+     */
+    void collectPulls(int cameraNumber, std::vector<PendingPull> &pulls);
+
+    /**
+     * @brief Fails the pulls that exceeded their timeout (mutex_ held).
+     */
+    void checkTimeouts();
+
+    /**
+     * @brief Handles a transfer notification of a camera (SDK callback thread).
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param notify The notification code.
+     * @param handle The content handle.
+     * @param filename The pulled file, on completion.
+     */
+    void onTransfer(int cameraNumber, CrInt32u notify, SCRSDK::CrContentHandle handle, const std::string &filename);
+
+    /**
+     * @brief Ends an attempt of a pull that is no longer running and requeues or fails it (mutex_ held).
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param key The queue position of the content.
+     * @param error The reason of the failure.
+     */
+    void failAttempt(int cameraNumber, const QueueKey &key, const std::string &error);
+
+    /**
+     * @brief Registers the transfer listener on the current device of a camera (mutex_ held).
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    void registerListener(int cameraNumber);
+
+    /**
+     * @brief Finds the current handle of a content, handles can change when the camera reconnects.
+     * @param item The content.
+     * @param handle Receives the handle.
+     * @return false if the content is no longer on the card.
+     */
+    bool resolveHandle(const TransferItem &item, SCRSDK::CrContentHandle &handle) const;
+
+    /**
+     * @brief Appends a record to the journal (mutex_ held).
+     * @param record The record.
+     */
+    void appendJournal(const nlohmann::json &record);
+
+    /**
+     * @brief Restores the unfinished batches and rewrites the journal with them.
+     * @return false if the journal cannot be written.
+     */
+    bool loadJournal();
+
+    /**
+     * @brief Writes the batch record of a batch (mutex_ held).
+     * @param batch The batch.
+     */
+    void journalBatch(const Batch &batch);
+
+    /**
+     * @brief Returns the item of a queue position (mutex_ held).
+     */
+    TransferItem &itemOf(const QueueKey &key);
+
+    /**
+     * @brief Returns the local directory of a content.
+     * @param item The content.
+     */
+    std::string getItemDirectory(const TransferItem &item) const;
+
+    CrSDKInterface *crsdkInterface_;                            ///< Access to the cameras
+    ContentsCatalog *contentsCatalog_;                          ///< Contents selection
+    CameraScheduler *cameraScheduler_ = nullptr;                ///< Commands that go before the pulls
+    std::string directory_;                                     ///< Destination directory
+    int cameraConcurrency_;                                     ///< Pulls in flight per camera
+    std::vector<CameraQueue> cameras_;                          ///< Per camera queues
+    std::map<std::uint64_t, Batch> batches_;                    ///< Batches by ID
+    std::uint64_t nextBatchId_ = 1;                             ///< ID of the next batch
+    std::FILE *journal_ = nullptr;                              ///< Journal file
+    mutable std::mutex mutex_;                                  ///< Protects the batches and queues
+    std::condition_variable wakeUp_;                            ///< Signaled on new work or completions
+    std::thread schedulerThread_;                               ///< Scheduler thread
+    std::atomic<bool> running_;                                 ///< True while the scheduler runs
+};
+
+#endif // CONTENT_TRANSFER_H
@@ -0,0 +1,333 @@
+#include "contents_catalog.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
+ContentsCatalog::ContentsCatalog(CrSDKInterface *crsdkInterface)
+    : crsdkInterface_(crsdkInterface), running_(false)
+{
+    std::size_t count = crsdkInterface_ ? crsdkInterface_->cameraList.size() : 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        cameras_.emplace_back(new CameraCatalog());
+    }
+}
+
+ContentsCatalog::~ContentsCatalog()
+{
+    stop();
+}
+
+void ContentsCatalog::start()
+{
+    if (running_.exchange(true))
+    {
+        return;
+    }
+
+    // Build the catalogs up front so the first listing does not wait for the card walk
+    for (std::size_t i = 0; i < cameras_.size(); ++i)
+    {
+        registerListener(static_cast<int>(i));
+        requestSync(static_cast<int>(i));
+    }
+
+    syncThread_ = std::thread(&ContentsCatalog::syncLoop, this);
+    spdlog::info("Contents catalog started for {} camera(s)", cameras_.size());
+}
+
+void ContentsCatalog::stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        syncRequested_.notify_all();
+    }
+
+    if (syncThread_.joinable())
+    {
+        syncThread_.join();
+    }
+
+    // The listeners capture this object
+    for (std::size_t i = 0; i < cameras_.size(); ++i)
+    {
+        if (cameras_[i]->listenerDevice != nullptr && i < crsdkInterface_->cameraList.size() &&
+            crsdkInterface_->cameraList[i].get() == cameras_[i]->listenerDevice)
+        {
+            cameras_[i]->listenerDevice->remove_contents_transfer_listener(cameras_[i]->listenerId);
+        }
+        cameras_[i]->listenerDevice = nullptr;
+    }
+}
+
+void ContentsCatalog::registerListener(int cameraNumber)
+{
+    CameraCatalog &camera = *cameras_[cameraNumber];
+    if (cameraNumber >= static_cast<int>(crsdkInterface_->cameraList.size()))
+    {
+        camera.listenerDevice = nullptr;
+        return;
+    }
+
+    CameraDevicePtr device = crsdkInterface_->cameraList[cameraNumber];
+    if (!device || device.get() == camera.listenerDevice)
+    {
+        return;
+    }
+
+    camera.listenerId = device->add_contents_transfer_listener([this, cameraNumber](CrInt32u notify, SCRSDK::CrContentHandle, const cli::text &)
+    {
+        // A content was written to the card: refresh once the burst is over
+        if (notify == SCRSDK::CrNotify_ContentsTransfer_Complete || notify == SCRSDK::CrNotify_ContentsTransfer_Start)
+        {
+            requestSync(cameraNumber, std::chrono::milliseconds(CONTENTS_CATALOG_DEBOUNCE_MS));
+        }
+    });
+    camera.listenerDevice = device.get();
+}
+
+void ContentsCatalog::requestSync(int cameraNumber, std::chrono::milliseconds delay)
+{
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    CameraCatalog &camera = *cameras_[cameraNumber];
+    auto now = std::chrono::steady_clock::now();
+    auto due = now + delay;
+
+    // Notifications keep pushing a debounced sync back, an overdue or immediate one is kept
+    if (!camera.pending || due < camera.due || camera.due > now)
+    {
+        camera.due = due;
+    }
+    camera.pending = true;
+    syncRequested_.notify_all();
+}
+
+CatalogSnapshotPtr ContentsCatalog::getSnapshot(int cameraNumber) const
+{
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cameras_[cameraNumber]->snapshot;
+}
+
+CatalogStatus ContentsCatalog::getStatus(int cameraNumber) const
+{
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        return CatalogStatus();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cameras_[cameraNumber]->status;
+}
+
+void ContentsCatalog::syncLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_)
+    {
+        // Find the camera whose sync is due first
+        int next = -1;
+        auto now = std::chrono::steady_clock::now();
+        auto wakeUp = now + std::chrono::hours(1);
+        for (std::size_t i = 0; i < cameras_.size(); ++i)
+        {
+            const CameraCatalog &camera = *cameras_[i];
+            if (!camera.pending)
+            {
+                continue;
+            }
+            if (camera.due <= now)
+            {
+                next = static_cast<int>(i);
+                break;
+            }
+            wakeUp = std::min(wakeUp, camera.due);
+        }
+
+        if (next < 0)
+        {
+            syncRequested_.wait_until(lock, wakeUp);
+            continue;
+        }
+
+        CameraCatalog &camera = *cameras_[next];
+        camera.pending = false;
+        camera.status.syncing = true;
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        std::string error = sync(next);
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if (!error.empty())
+        {
+            spdlog::warn("Contents catalog sync of camera {} failed: {}", next + 1, error);
+        }
+        else
+        {
+            spdlog::debug("Contents catalog of camera {} synced in {:.1f} ms", next + 1, elapsedMs);
+        }
+
+        lock.lock();
+        camera.status.syncing = false;
+        camera.status.lastSyncMs = elapsedMs;
+        camera.status.lastError = error;
+        if (error.empty())
+        {
+            camera.status.synced = true;
+            camera.status.syncs++;
+            camera.status.syncedAt = std::chrono::system_clock::now();
+        }
+    }
+}
+
+std::string ContentsCatalog::sync(int cameraNumber)
+{
+    CameraCatalog &camera = *cameras_[cameraNumber];
+
+    // The camera objects are recreated on reconnection
+    registerListener(cameraNumber);
+
+    if (cameraNumber >= static_cast<int>(crsdkInterface_->cameraList.size()))
+    {
+        return "Camera not available";
+    }
+
+    CameraDevicePtr device = crsdkInterface_->cameraList[cameraNumber];
+    if (!device || !device->is_connected())
+    {
+        return "Camera not connected";
+    }
+
+    if (!device->is_contents_transfer_enabled())
+    {
+        return "Contents transfer is disabled on the camera";
+    }
+
+    std::vector<cli::ContentsFolder> folders;
+    SCRSDK::CrError err = device->get_date_folders(folders);
+    if (CR_FAILED(err))
+    {
+        return fmt::format("GetDateFolderList failed (0x{:X})", static_cast<unsigned>(err));
+    }
+
+    std::unordered_set<SCRSDK::CrContentHandle> present;
+    std::uint64_t detailCalls = 0;
+    std::vector<SCRSDK::CrContentHandle> handles;
+
+    for (const auto &folder : folders)
+    {
+        err = device->get_contents_handles(folder.handle, handles);
+        if (CR_FAILED(err))
+        {
+            return fmt::format("GetContentsHandleList failed (0x{:X})", static_cast<unsigned>(err));
+        }
+
+        for (SCRSDK::CrContentHandle handle : handles)
+        {
+            present.insert(handle);
+            if (camera.entries.count(handle) != 0)
+            {
+                continue;
+            }
+
+            // Only new contents cost a detail request
+            SCRSDK::CrMtpContentsInfo info;
+            err = device->get_contents_detail(handle, info);
+            detailCalls++;
+            if (CR_FAILED(err))
+            {
+                return fmt::format("GetContentsDetailInfo failed (0x{:X})", static_cast<unsigned>(err));
+            }
+
+            ContentEntry entry;
+            entry.handle = handle;
+            entry.folder = folder.handle;
+            entry.folderName = folder.name;
+            if (info.fileName != nullptr)
+            {
+                entry.fileName = info.fileName;
+            }
+            entry.captureTime.assign(info.dateChar, strnlen(info.dateChar, sizeof(info.dateChar)));
+            entry.size = info.contentSize;
+            entry.width = info.width;
+            entry.height = info.height;
+            camera.entries[handle] = entry;
+            camera.unpublished = true;
+        }
+    }
+
+    // Deleted contents and folders
+    for (auto it = camera.entries.begin(); it != camera.entries.end();)
+    {
+        if (present.count(it->first) == 0)
+        {
+            it = camera.entries.erase(it);
+            camera.unpublished = true;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        camera.status.detailCalls += detailCalls;
+    }
+
+    // Unchanged contents keep the published snapshot (and its generation)
+    if (camera.unpublished || !getSnapshot(cameraNumber))
+    {
+        publishSnapshot(cameraNumber);
+    }
+
+    return "";
+}
+
+void ContentsCatalog::publishSnapshot(int cameraNumber)
+{
+    CameraCatalog &camera = *cameras_[cameraNumber];
+    std::shared_ptr<CatalogSnapshot> snapshot(new CatalogSnapshot());
+
+    snapshot->entries.reserve(camera.entries.size());
+    for (const auto &item : camera.entries)
+    {
+        snapshot->entries.push_back(item.second);
+    }
+
+    std::sort(snapshot->entries.begin(), snapshot->entries.end(), [](const ContentEntry &a, const ContentEntry &b)
+    {
+        int order = a.captureTime.compare(b.captureTime);
+        return order != 0 ? order < 0 : a.handle < b.handle;
+    });
+
+    snapshot->byHandle.reserve(snapshot->entries.size());
+    for (std::uint32_t i = 0; i < snapshot->entries.size(); ++i)
+    {
+        const ContentEntry &entry = snapshot->entries[i];
+        snapshot->byFolder[entry.folder].push_back(i);
+        snapshot->byHandle[entry.handle] = i;
+    }
+
+    camera.unpublished = false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    snapshot->generation = camera.snapshot ? camera.snapshot->generation + 1 : 1;
+    camera.snapshot = snapshot;
+}
@@ -0,0 +1,170 @@
+#ifndef CONTENTS_CATALOG_H
+#define CONTENTS_CATALOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+#include "../CrSDK_interface/CrSDK_interface.h"
+
+#define CONTENTS_CATALOG_DEFAULT_PAGE 100
+#define CONTENTS_CATALOG_MAX_PAGE 1000
+#define CONTENTS_CATALOG_DEBOUNCE_MS 500        // Transfers close together trigger one refresh
+
+/**
+ * @brief A content (still image or clip) on the memory card of a camera.
+ */
+struct ContentEntry
+{
+    SCRSDK::CrContentHandle handle = 0;         ///< Content handle
+    SCRSDK::CrFolderHandle folder = 0;          ///< Handle of the date folder
+    std::string folderName;                     ///< Name of the date folder
+    std::string fileName;                       ///< File name on the card
+    std::string captureTime;                    ///< Capture time as reported by the camera (sortable)
+    std::uint64_t size = 0;                     ///< File size in bytes
+    std::uint32_t width = 0;                    ///< Image width
+    std::uint32_t height = 0;                   ///< Image height
+};
+
+/**
+ * @brief Immutable, sorted view of the catalog of a camera.
+ *
+ * A new snapshot is built after every change, so readers page through a consistent view
+ * without holding a lock.
+ */
+struct CatalogSnapshot
+{
+    std::vector<ContentEntry> entries;                                      ///< Sorted by capture time, then handle
+    std::map<SCRSDK::CrFolderHandle, std::vector<std::uint32_t>> byFolder;  ///< Positions in entries per folder
+    std::unordered_map<SCRSDK::CrContentHandle, std::uint32_t> byHandle;    ///< Position in entries per handle
+    std::uint64_t generation = 0;                                           ///< Incremented on every change
+};
+
+typedef std::shared_ptr<const CatalogSnapshot> CatalogSnapshotPtr;
+
+/**
+ * @brief Sync state of the catalog of a camera.
+ */
+struct CatalogStatus
+{
+    bool synced = false;                        ///< True once the first sync completed
+    bool syncing = false;                       ///< True while a sync runs
+    std::uint64_t syncs = 0;                    ///< Completed syncs
+    std::uint64_t detailCalls = 0;              ///< GetContentsDetailInfo calls since the start
+    double lastSyncMs = 0.0;                    ///< Duration of the last sync
+    std::chrono::system_clock::time_point syncedAt;     ///< End of the last successful sync
+    std::string lastError;                      ///< Error of the last sync, empty on success
+};
+
+/**
+ * @brief The ContentsCatalog class keeps a persistent, sorted index of the contents of every camera.
+ *
+ * The first sync walks the date folders and fetches the details of every content. Later syncs
+ * only list the folders and handles and fetch the details of the new handles; removed
+ * handles and folders are dropped. Syncs run on a background thread, triggered by the
+ * contents transfer notifications of the cameras (debounced) or on request, so listing a
+ * page never waits for the camera once the catalog is built.
+ */
+class ContentsCatalog
+{
+public:
+    /**
+     * @brief Constructs a ContentsCatalog object.
+     * @param crsdkInterface instance of CrSDKInterface class.
+     */
+    explicit ContentsCatalog(CrSDKInterface *crsdkInterface);
+
+    /**
+     * @brief Stops the sync thread.
+     */
+    ~ContentsCatalog();
+
+    /**
+     * @brief Registers the transfer listeners and starts the sync thread.
+     */
+    void start();
+
+    /**
+     * @brief Stops the sync thread.
+     */
+    void stop();
+
+    /**
+     * @brief Schedules an incremental sync of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param delay Time to wait for more changes before syncing.
+     */
+    void requestSync(int cameraNumber, std::chrono::milliseconds delay = std::chrono::milliseconds(0));
+
+    /**
+     * @brief Returns the current catalog of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @return The snapshot, or nullptr before the first sync.
+     */
+    CatalogSnapshotPtr getSnapshot(int cameraNumber) const;
+
+    /**
+     * @brief Returns the sync state of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    CatalogStatus getStatus(int cameraNumber) const;
+
+private:
+    /**
+     * @brief Catalog of a camera.
+     */
+    struct CameraCatalog
+    {
+        std::unordered_map<SCRSDK::CrContentHandle, ContentEntry> entries;     ///< Known contents (sync thread)
+        CatalogSnapshotPtr snapshot;                                            ///< Published view (mutex_)
+        CatalogStatus status;                                                   ///< Sync state (mutex_)
+        bool pending = false;                                                   ///< A sync is requested (mutex_)
+        std::chrono::steady_clock::time_point due;                              ///< Earliest time of the requested sync (mutex_)
+        bool unpublished = false;                                               ///< Entries changed since the last snapshot (sync thread)
+        cli::CameraDevice *listenerDevice = nullptr;                            ///< Device the listener is registered on
+        int listenerId = 0;                                                     ///< Id of the registered listener
+    };
+
+    /**
+     * @brief Loop of the sync thread.
+     */
+    void syncLoop();
+
+    /**
+     * @brief Brings the catalog of a camera up to date with its memory card (sync thread).
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @return An error message, or an empty string on success.
+     */
+    std::string sync(int cameraNumber);
+
+    /**
+     * @brief Registers the transfer listener on the current device of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    void registerListener(int cameraNumber);
+
+    /**
+     * @brief Builds and publishes the sorted snapshot of a camera (sync thread).
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    void publishSnapshot(int cameraNumber);
+
+    CrSDKInterface *crsdkInterface_;                            ///< Access to the cameras
+    std::vector<std::unique_ptr<CameraCatalog>> cameras_;       ///< Per camera catalog
+    mutable std::mutex mutex_;                                  ///< Protects the shared camera state
+    std::condition_variable syncRequested_;                     ///< Signaled when a sync is requested
+    std::thread syncThread_;                                    ///< Sync thread
+    std::atomic<bool> running_;                                 ///< True while the sync thread runs
+};
+
+#endif // CONTENTS_CATALOG_H
@@ -0,0 +1,81 @@
+#include "deadline.h"
+
+#include <algorithm>
+
+Deadline::Deadline()
+    : set_(false)
+{
+}
+
+Deadline Deadline::after(std::chrono::milliseconds budget, Clock::time_point start)
+{
+    Deadline deadline;
+    deadline.set_ = true;
+    deadline.time_ = start + budget;
+    return deadline;
+}
+
+Deadline Deadline::holding(std::shared_ptr<void> resource) const
+{
+    Deadline deadline = *this;
+    deadline.held_ = std::move(resource);
+    return deadline;
+}
+
+bool Deadline::expired() const
+{
+    return set_ && Clock::now() >= time_;
+}
+
+std::chrono::milliseconds Deadline::remaining() const
+{
+    if (!set_)
+    {
+        return std::chrono::milliseconds::max();
+    }
+
+    return std::max(std::chrono::duration_cast<std::chrono::milliseconds>(time_ - Clock::now()), std::chrono::milliseconds(0));
+}
+
+bool Deadline::sleep(std::chrono::milliseconds duration) const
+{
+    if (!set_ || duration <= remaining())
+    {
+        std::this_thread::sleep_for(duration);
+        return true;
+    }
+
+    std::this_thread::sleep_until(time_);
+    return false;
+}
+
+std::mutex LaunchedCalls::mutex_;
+std::condition_variable LaunchedCalls::returned_;
+int LaunchedCalls::running_ = 0;
+
+void LaunchedCalls::begin()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_++;
+}
+
+void LaunchedCalls::end()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--running_ == 0)
+    {
+        returned_.notify_all();
+    }
+}
+
+int LaunchedCalls::running()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_;
+}
+
+bool LaunchedCalls::waitAll(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return returned_.wait_for(lock, timeout, []() { return running_ == 0; });
+}
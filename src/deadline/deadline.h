@@ -0,0 +1,175 @@
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#define LAUNCHED_CALLS_SHUTDOWN_MS 10000    // Wait on exit for the camera calls abandoned at a deadline
+
+/**
+ * @brief The point in time by which a request must be answered.
+ *
+ * A default constructed deadline never expires, so calls made outside a request keep
+ * waiting as long as they take.
+ */
+class Deadline
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * @brief Constructs a deadline that never expires.
+     */
+    Deadline();
+
+    /**
+     * @brief Returns a deadline at a time budget from a starting point.
+     * @param budget The time allowed.
+     * @param start The starting point (now by default).
+     */
+    static Deadline after(std::chrono::milliseconds budget, Clock::time_point start = Clock::now());
+
+    /**
+     * @brief Returns true if the deadline can expire.
+     */
+    bool isSet() const { return set_; }
+
+    /**
+     * @brief Returns the deadline (meaningless if not set).
+     */
+    Clock::time_point time() const { return time_; }
+
+    /**
+     * @brief Returns true once the deadline has passed.
+     */
+    bool expired() const;
+
+    /**
+     * @brief Returns the time left, zero once expired (milliseconds::max() if never expiring).
+     */
+    std::chrono::milliseconds remaining() const;
+
+    /**
+     * @brief Returns a copy of the deadline holding a resource for the calls launched under it.
+     *
+     * A call abandoned at the deadline still drives the camera; holding the camera command
+     * keeps the camera reserved until the call has returned (see launchCall).
+     *
+     * @param resource The resource, released with the last call still running.
+     */
+    Deadline holding(std::shared_ptr<void> resource) const;
+
+    /**
+     * @brief Returns the resource held for the launched calls, or nullptr.
+     */
+    const std::shared_ptr<void> &getHeld() const { return held_; }
+
+    /**
+     * @brief Sleeps for a duration, cut short at the deadline.
+     * @param duration The time to sleep.
+     * @return false if the deadline expired before the duration elapsed.
+     */
+    bool sleep(std::chrono::milliseconds duration) const;
+
+    /**
+     * @brief Waits for a result until the deadline.
+     *
+     * An abandoned future does not block: the call producing it must not have been started
+     * with std::async (see launchCall).
+     *
+     * @param future The pending result.
+     * @param result Receives the result if ready in time.
+     * @return false if the deadline expired first.
+     */
+    template <typename Result>
+    bool wait(std::future<Result> &future, Result &result) const
+    {
+        if (set_ && future.wait_until(time_) != std::future_status::ready)
+        {
+            return false;
+        }
+
+        result = future.get();
+        return true;
+    }
+
+private:
+    bool set_;                      ///< False if the deadline never expires
+    Clock::time_point time_;        ///< The deadline
+    std::shared_ptr<void> held_;    ///< Kept by the launched calls until they return
+};
+
+/**
+ * @brief Counts the calls started by launchCall that have not returned.
+ *
+ * An abandoned call keeps using the camera interface and releases its camera command when it
+ * returns, both must outlive it: the program waits for the calls before deleting them.
+ */
+class LaunchedCalls
+{
+public:
+    /**
+     * @brief Counts a call starting.
+     */
+    static void begin();
+
+    /**
+     * @brief Counts a call returned, once it released what it held.
+     */
+    static void end();
+
+    /**
+     * @brief Returns the number of calls that have not returned.
+     */
+    static int running();
+
+    /**
+     * @brief Waits until every call has returned.
+     * @param timeout The longest wait.
+     * @return false if calls were still running at the timeout.
+     */
+    static bool waitAll(std::chrono::milliseconds timeout);
+
+private:
+    static std::mutex mutex_;                   ///< Protects the count
+    static std::condition_variable returned_;   ///< Signaled when the last call returns
+    static int running_;                        ///< Calls that have not returned
+};
+
+/**
+ * @brief Starts a call on a thread of its own.
+ *
+ * Unlike a future of std::async, the returned one can be dropped while the call runs: a
+ * camera call abandoned at a deadline finishes in the background and its result is lost.
+ * The resource held by the deadline is released only once the call has returned, and the
+ * call is counted by LaunchedCalls until then.
+ *
+ * @param call The call; what it captures must outlive it.
+ * @param deadline The deadline of the call, its held resource is kept by the thread.
+ * @return The pending result.
+ */
+template <typename Result>
+std::future<Result> launchCall(std::function<Result()> call, const Deadline &deadline = Deadline())
+{
+    std::packaged_task<Result()> task(std::move(call));
+    std::future<Result> future = task.get_future();
+    std::shared_ptr<void> held = deadline.getHeld();
+    LaunchedCalls::begin();
+    std::thread([task = std::move(task), held]() mutable
+    {
+        task();
+
+        // Released before the call counts as returned, the owners may be deleted after it
+        task = std::packaged_task<Result()>();
+        held.reset();
+        LaunchedCalls::end();
+    }).detach();
+    return future;
+}
+
+#endif // DEADLINE_H
@@ -0,0 +1,120 @@
+#include "event_stream.h"
+
+#include <algorithm>
+
+EventStream::EventStream(std::size_t queueLimit)
+    : queueLimit_(queueLimit > 0 ? queueLimit : 1)
+{
+}
+
+void EventStream::publish(const std::string &type, const json &data)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_ || subscribers_.empty())
+    {
+        return;
+    }
+
+    StreamEvent event;
+    event.id = nextEventId_++;
+    event.type = type;
+    event.data = data;
+
+    for (auto &entry : subscribers_)
+    {
+        Subscriber &subscriber = *entry.second;
+        if (!subscriber.types.empty() && std::find(subscriber.types.begin(), subscriber.types.end(), type) == subscriber.types.end())
+        {
+            continue;
+        }
+
+        // Drop the oldest event rather than blocking the producer
+        if (subscriber.queue.size() >= queueLimit_)
+        {
+            subscriber.queue.pop_front();
+            subscriber.dropped++;
+        }
+        subscriber.queue.push_back(event);
+    }
+
+    eventReady_.notify_all();
+}
+
+int EventStream::subscribe(const std::vector<std::string> &types)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    int subscriberId = nextSubscriberId_++;
+
+    auto subscriber = std::make_shared<Subscriber>();
+    subscriber->types = types;
+    subscribers_[subscriberId] = subscriber;
+
+    spdlog::info("Event stream subscriber {} connected ({} subscribers).", subscriberId, subscribers_.size());
+    return subscriberId;
+}
+
+void EventStream::unsubscribe(int subscriberId)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = subscribers_.find(subscriberId);
+    if (it == subscribers_.end())
+    {
+        return;
+    }
+
+    if (it->second->dropped > 0)
+    {
+        spdlog::warn("Event stream subscriber {} dropped {} events.", subscriberId, it->second->dropped);
+    }
+
+    subscribers_.erase(it);
+    spdlog::info("Event stream subscriber {} disconnected ({} subscribers).", subscriberId, subscribers_.size());
+}
+
+bool EventStream::waitForEvents(int subscriberId, std::vector<StreamEvent> &events, std::chrono::milliseconds timeout)
+{
+    events.clear();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = subscribers_.find(subscriberId);
+    if (it == subscribers_.end())
+    {
+        return false;
+    }
+
+    // Keep the subscriber alive even if it is removed while waiting
+    std::shared_ptr<Subscriber> subscriber = it->second;
+
+    eventReady_.wait_for(lock, timeout, [&]()
+    {
+        return closed_ || !subscriber->queue.empty();
+    });
+
+    if (closed_)
+    {
+        return false;
+    }
+
+    events.assign(std::make_move_iterator(subscriber->queue.begin()), std::make_move_iterator(subscriber->queue.end()));
+    subscriber->queue.clear();
+    return true;
+}
+
+void EventStream::close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    eventReady_.notify_all();
+}
+
+std::size_t EventStream::getSubscriberCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return subscribers_.size();
+}
+
+std::string EventStream::formatSse(const StreamEvent &event)
+{
+    // json::dump() escapes new lines, so the payload always fits in a single data line
+    return fmt::format("id: {}\nevent: {}\ndata: {}\n\n", event.id, event.type, event.data.dump());
+}
@@ -0,0 +1,116 @@
+#ifndef EVENT_STREAM_H
+#define EVENT_STREAM_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+#include <nholman_json/json.hpp>
+
+#include "../camera_index/camera_index.h"
+
+using json = nlohmann::json;
+
+#define EVENT_STREAM_QUEUE_LIMIT 64
+#define EVENT_STREAM_HEARTBEAT_MS 15000
+
+/**
+ * @brief A single event delivered to the event stream subscribers.
+ */
+struct StreamEvent
+{
+    std::uint64_t id = 0;       ///< Monotonic event ID
+    std::string type;           ///< Event type (e.g. "histogram")
+    json data;                  ///< Event payload
+};
+
+/**
+ * @brief The EventStream class fans out server events to the connected /events clients.
+ *
+ * Producers publish events from any thread. Every subscriber owns a bounded queue; when a
+ * client reads slower than events are produced the oldest events are dropped so a stalled
+ * client can never block a producer or grow the memory without limit.
+ */
+class EventStream
+{
+public:
+    /**
+     * @brief Constructs an EventStream object.
+     * @param queueLimit The maximum number of queued events per subscriber.
+     */
+    explicit EventStream(std::size_t queueLimit = EVENT_STREAM_QUEUE_LIMIT);
+
+    /**
+     * @brief Publishes an event to all subscribers interested in its type.
+     * @param type The event type.
+     * @param data The event payload.
+     */
+    void publish(const std::string &type, const json &data);
+
+    /**
+     * @brief Registers a new subscriber.
+     * @param types The event types to receive, all types if empty.
+     * @return The subscriber ID.
+     */
+    int subscribe(const std::vector<std::string> &types);
+
+    /**
+     * @brief Removes a subscriber.
+     * @param subscriberId The subscriber ID returned by subscribe().
+     */
+    void unsubscribe(int subscriberId);
+
+    /**
+     * @brief Waits for the queued events of a subscriber.
+     * @param subscriberId The subscriber ID.
+     * @param events Receives the queued events (cleared first).
+     * @param timeout The maximum time to wait.
+     * @return False if the subscriber does not exist or the stream was closed, true otherwise.
+     */
+    bool waitForEvents(int subscriberId, std::vector<StreamEvent> &events, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Closes the stream and wakes up all waiting subscribers.
+     */
+    void close();
+
+    /**
+     * @brief Returns the number of connected subscribers.
+     */
+    std::size_t getSubscriberCount() const;
+
+    /**
+     * @brief Formats an event as a Server-Sent Events message.
+     * @param event The event to format.
+     * @return The "id/event/data" block terminated by an empty line.
+     */
+    static std::string formatSse(const StreamEvent &event);
+
+private:
+    /**
+     * @brief Queue and filter of a single subscriber.
+     */
+    struct Subscriber
+    {
+        std::vector<std::string> types;             ///< Event types of interest, all if empty
+        std::deque<StreamEvent> queue;              ///< Pending events
+        std::uint64_t dropped = 0;                  ///< Events dropped because the queue was full
+    };
+
+    std::size_t queueLimit_;                                    ///< Maximum queued events per subscriber
+    std::map<int, std::shared_ptr<Subscriber>> subscribers_;    ///< Subscribers by ID
+    mutable std::mutex mutex_;                                  ///< Protects the subscribers
+    std::condition_variable eventReady_;                        ///< Signaled on every published event
+    std::uint64_t nextEventId_ = 1;                             ///< ID of the next event
+    int nextSubscriberId_ = 1;                                  ///< ID of the next subscriber
+    bool closed_ = false;                                       ///< True once close() was called
+};
+
+#endif // EVENT_STREAM_H
@@ -0,0 +1,562 @@
+#include "frame_recorder.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Writes a whole buffer at an offset, retrying partial writes.
+ */
+static bool writeAll(int fd, const void *data, std::size_t size, off_t offset)
+{
+    const std::uint8_t *bytes = static_cast<const std::uint8_t *>(data);
+    while (size > 0)
+    {
+        ssize_t written = pwrite(fd, bytes, size, offset);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+
+        bytes += written;
+        size -= static_cast<std::size_t>(written);
+        offset += written;
+    }
+
+    return true;
+}
+
+FrameRecorder::FrameRecorder(LiveView *liveView, const std::string &directory, std::uint64_t budgetBytes)
+    : liveView_(liveView), directory_(directory), budgetBytes_(budgetBytes), running_(false)
+{
+    if (liveView_ != nullptr)
+    {
+        for (int i = 0; i < liveView_->getCameraCount(); ++i)
+        {
+            cameras_.emplace_back(new CameraRecording());
+        }
+    }
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    stop();
+}
+
+std::string FrameRecorder::getCameraDirectory(int cameraNumber) const
+{
+    return fmt::format("{}/camera_{}", directory_, cameraNumber);
+}
+
+bool FrameRecorder::start()
+{
+    if (liveView_ == nullptr)
+    {
+        spdlog::error("Frame recorder cannot start without a live view.");
+        return false;
+    }
+
+    if (running_.load())
+    {
+        return true;
+    }
+
+    try
+    {
+        for (std::size_t i = 0; i < cameras_.size(); ++i)
+        {
+            fs::create_directories(getCameraDirectory(static_cast<int>(i)));
+            scanSegments(static_cast<int>(i));
+        }
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::error("Failed to prepare the recording directory {}: {}", directory_, e.what());
+        return false;
+    }
+
+    running_.store(true);
+
+    // The listener stays registered for the lifetime of the live view, it is idle while stopped
+    if (!listenerRegistered_)
+    {
+        liveView_->addFrameListener([this](int cameraNumber, const LiveViewFramePtr &frame)
+        {
+            onFrame(cameraNumber, frame);
+        });
+        listenerRegistered_ = true;
+    }
+
+    writerThread_ = std::thread([this]()
+    {
+        writerLoop();
+    });
+
+    spdlog::info("Frame recorder started in {}.", directory_);
+    return true;
+}
+
+void FrameRecorder::stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queueReady_.notify_all();
+    }
+
+    if (writerThread_.joinable())
+    {
+        writerThread_.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &camera : cameras_)
+        {
+            camera->subscription.reset();
+        }
+    }
+
+    spdlog::info("Frame recorder stopped.");
+}
+
+bool FrameRecorder::setRecording(int cameraNumber, bool enabled)
+{
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    CameraRecording &camera = *cameras_[cameraNumber];
+    if (camera.enabled == enabled)
+    {
+        return true;
+    }
+
+    camera.enabled = enabled;
+    camera.counters.enabled = enabled;
+
+    // A recording is a viewer: the live view keeps pulling frames for it
+    if (enabled)
+    {
+        camera.subscription.reset(new LiveViewSubscription(liveView_, cameraNumber));
+    }
+    else
+    {
+        camera.subscription.reset();
+    }
+
+    // The writer closes the segment of a disabled camera
+    queueReady_.notify_all();
+
+    spdlog::info("Recording of camera {} {}.", cameraNumber, enabled ? "enabled" : "disabled");
+    return true;
+}
+
+RecordingStatus FrameRecorder::getStatus(int cameraNumber) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        return RecordingStatus();
+    }
+
+    const CameraRecording &camera = *cameras_[cameraNumber];
+    RecordingStatus status = camera.counters;
+    status.segments = camera.segments.size() + (camera.current.number != 0 ? 1 : 0);
+    status.bytes = camera.bytes + camera.current.bytes;
+    return status;
+}
+
+std::vector<RecordSegment> FrameRecorder::getSegments(int cameraNumber) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<RecordSegment> segments;
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        return segments;
+    }
+
+    const CameraRecording &camera = *cameras_[cameraNumber];
+    segments.assign(camera.segments.begin(), camera.segments.end());
+
+    // The open segment is readable up to its last index entry
+    if (camera.current.number != 0)
+    {
+        segments.push_back(camera.current);
+    }
+
+    return segments;
+}
+
+void FrameRecorder::onFrame(int cameraNumber, const LiveViewFramePtr &frame)
+{
+    if (!running_.load())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()) || !cameras_[cameraNumber]->enabled)
+    {
+        return;
+    }
+
+    // Never block the producer: a full queue drops the new frame
+    if (queue_.size() >= FRAME_RECORDER_QUEUE_LIMIT)
+    {
+        cameras_[cameraNumber]->counters.framesDropped++;
+        return;
+    }
+
+    queue_.emplace_back(cameraNumber, frame);
+    queueReady_.notify_one();
+}
+
+void FrameRecorder::writerLoop()
+{
+    std::deque<std::pair<int, LiveViewFramePtr>> frames;
+    std::vector<bool> enabled(cameras_.size(), false);
+
+    while (true)
+    {
+        bool running;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queueReady_.wait_for(lock, std::chrono::milliseconds(FRAME_RECORDER_FLUSH_INTERVAL_MS), [this]()
+            {
+                return !running_.load() || !queue_.empty();
+            });
+
+            running = running_.load();
+            frames.swap(queue_);
+            for (std::size_t i = 0; i < cameras_.size(); ++i)
+            {
+                enabled[i] = cameras_[i]->enabled;
+            }
+        }
+
+        for (const auto &item : frames)
+        {
+            writeFrame(item.first, item.second);
+        }
+        frames.clear();
+
+        auto now = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < cameras_.size(); ++i)
+        {
+            CameraRecording &camera = *cameras_[i];
+            if (camera.dataFd < 0)
+            {
+                continue;
+            }
+
+            if (!running || !enabled[i])
+            {
+                closeSegment(static_cast<int>(i));
+            }
+            else if (!camera.dataBuffer.empty() && now - camera.lastFlush >= std::chrono::milliseconds(FRAME_RECORDER_FLUSH_INTERVAL_MS))
+            {
+                // Bound the delay before a frame can be replayed
+                flush(static_cast<int>(i));
+            }
+        }
+
+        if (!running)
+        {
+            break;
+        }
+    }
+}
+
+void FrameRecorder::writeFrame(int cameraNumber, const LiveViewFramePtr &frame)
+{
+    CameraRecording &camera = *cameras_[cameraNumber];
+    std::size_t size = frame->jpeg.size();
+
+    if (size == 0 || size > FRAME_RECORDER_SEGMENT_BYTES)
+    {
+        spdlog::warn("Live-view frame {} of camera {} cannot be recorded ({} bytes)", frame->sequence, cameraNumber, size);
+        return;
+    }
+
+    // Start a new segment when the frame does not fit in the current one
+    if (camera.dataFd >= 0 && camera.dataOffset + camera.dataBuffer.size() + size > FRAME_RECORDER_SEGMENT_BYTES)
+    {
+        closeSegment(cameraNumber);
+    }
+
+    if (camera.dataFd < 0 && !openSegment(cameraNumber))
+    {
+        return;
+    }
+
+    if (!camera.dataBuffer.empty() && camera.dataBuffer.size() + size > FRAME_RECORDER_WRITE_BUFFER_BYTES)
+    {
+        if (!flush(cameraNumber))
+        {
+            closeSegment(cameraNumber);
+            return;
+        }
+    }
+
+    RecordIndexEntry entry;
+    entry.timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(frame->timestamp.time_since_epoch()).count();
+    entry.offset = camera.dataOffset + camera.dataBuffer.size();
+    entry.size = static_cast<std::uint32_t>(size);
+    entry.frameNo = frame->frameNo;
+
+    camera.dataBuffer.insert(camera.dataBuffer.end(), frame->jpeg.begin(), frame->jpeg.end());
+    camera.indexBuffer.push_back(entry);
+}
+
+bool FrameRecorder::flush(int cameraNumber)
+{
+    CameraRecording &camera = *cameras_[cameraNumber];
+    camera.lastFlush = std::chrono::steady_clock::now();
+
+    if (camera.dataBuffer.empty())
+    {
+        return true;
+    }
+
+    // Data first: an index entry must never point to data that is not written yet
+    if (!writeAll(camera.dataFd, camera.dataBuffer.data(), camera.dataBuffer.size(), static_cast<off_t>(camera.dataOffset)))
+    {
+        spdlog::error("Failed to write segment {}: {}", camera.current.dataPath, std::strerror(errno));
+        camera.dataBuffer.clear();
+        camera.indexBuffer.clear();
+        return false;
+    }
+
+    if (!writeAll(camera.indexFd, camera.indexBuffer.data(), camera.indexBuffer.size() * sizeof(RecordIndexEntry), lseek(camera.indexFd, 0, SEEK_END)))
+    {
+        spdlog::error("Failed to write index {}: {}", camera.current.indexPath, std::strerror(errno));
+        camera.dataBuffer.clear();
+        camera.indexBuffer.clear();
+        return false;
+    }
+
+    std::size_t frames = camera.indexBuffer.size();
+    std::int64_t lastTimestampMs = camera.indexBuffer.back().timestampMs;
+    camera.dataOffset += camera.dataBuffer.size();
+    camera.dataBuffer.clear();
+    camera.indexBuffer.clear();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    camera.counters.framesWritten += frames;
+    camera.counters.lastTimestampMs = lastTimestampMs;
+    return true;
+}
+
+bool FrameRecorder::openSegment(int cameraNumber)
+{
+    CameraRecording &camera = *cameras_[cameraNumber];
+    std::string base = fmt::format("{}/{:08}", getCameraDirectory(cameraNumber), camera.nextNumber);
+
+    RecordSegment segment;
+    segment.number = camera.nextNumber;
+    segment.dataPath = base + ".seg";
+    segment.indexPath = base + ".idx";
+    segment.bytes = FRAME_RECORDER_SEGMENT_BYTES;
+
+    int dataFd = open(segment.dataPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (dataFd < 0)
+    {
+        spdlog::error("Failed to create segment {}: {}", segment.dataPath, std::strerror(errno));
+        return false;
+    }
+
+    int indexFd = open(segment.indexPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (indexFd < 0)
+    {
+        spdlog::error("Failed to create index {}: {}", segment.indexPath, std::strerror(errno));
+        close(dataFd);
+        unlink(segment.dataPath.c_str());
+        return false;
+    }
+
+    // Reserve the whole segment up front so the writes stay sequential on disk
+    int err = posix_fallocate(dataFd, 0, FRAME_RECORDER_SEGMENT_BYTES);
+    if (err != 0)
+    {
+        spdlog::warn("Failed to pre-allocate segment {}: {}", segment.dataPath, std::strerror(err));
+    }
+
+    camera.dataFd = dataFd;
+    camera.indexFd = indexFd;
+    camera.dataOffset = 0;
+    camera.lastFlush = std::chrono::steady_clock::now();
+    camera.nextNumber++;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        camera.current = segment;
+    }
+
+    enforceBudget(cameraNumber);
+    return true;
+}
+
+void FrameRecorder::closeSegment(int cameraNumber)
+{
+    CameraRecording &camera = *cameras_[cameraNumber];
+    if (camera.dataFd < 0)
+    {
+        return;
+    }
+
+    flush(cameraNumber);
+
+    // Give the unused pre-allocated space back
+    if (ftruncate(camera.dataFd, static_cast<off_t>(camera.dataOffset)) != 0)
+    {
+        spdlog::warn("Failed to trim segment {}: {}", camera.current.dataPath, std::strerror(errno));
+    }
+
+    close(camera.dataFd);
+    close(camera.indexFd);
+    camera.dataFd = -1;
+    camera.indexFd = -1;
+
+    RecordSegment segment;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        segment = camera.current;
+        camera.current = RecordSegment();
+    }
+
+    if (camera.dataOffset == 0)
+    {
+        unlink(segment.dataPath.c_str());
+        unlink(segment.indexPath.c_str());
+        return;
+    }
+
+    struct stat indexStat;
+    segment.bytes = camera.dataOffset + (stat(segment.indexPath.c_str(), &indexStat) == 0 ? static_cast<std::uint64_t>(indexStat.st_size) : 0);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    camera.segments.push_back(segment);
+    camera.bytes += segment.bytes;
+}
+
+void FrameRecorder::enforceBudget(int cameraNumber)
+{
+    CameraRecording &camera = *cameras_[cameraNumber];
+    std::vector<RecordSegment> removed;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!camera.segments.empty() && camera.bytes + camera.current.bytes > budgetBytes_)
+        {
+            removed.push_back(camera.segments.front());
+            camera.bytes -= camera.segments.front().bytes;
+            camera.segments.pop_front();
+        }
+    }
+
+    // Readers that still have a removed segment open keep their data until they close it
+    for (const auto &segment : removed)
+    {
+        unlink(segment.indexPath.c_str());
+        unlink(segment.dataPath.c_str());
+        spdlog::info("Rotated out segment {} of camera {}", segment.number, cameraNumber);
+    }
+}
+
+void FrameRecorder::scanSegments(int cameraNumber)
+{
+    CameraRecording &camera = *cameras_[cameraNumber];
+    std::vector<RecordSegment> segments;
+
+    for (const auto &item : fs::directory_iterator(getCameraDirectory(cameraNumber)))
+    {
+        std::string name = item.path().filename().string();
+        unsigned int number = 0;
+        char extension[4] = {0};
+
+        if (name.size() != 12 || std::sscanf(name.c_str(), "%8u.%3s", &number, extension) != 2 || std::string(extension) != "seg" || number == 0)
+        {
+            continue;
+        }
+
+        RecordSegment segment;
+        segment.number = number;
+        segment.dataPath = item.path().string();
+        segment.indexPath = segment.dataPath.substr(0, segment.dataPath.size() - 3) + "idx";
+
+        struct stat indexStat;
+        if (stat(segment.indexPath.c_str(), &indexStat) != 0)
+        {
+            spdlog::warn("Segment {} has no index, deleting it", segment.dataPath);
+            unlink(segment.dataPath.c_str());
+            continue;
+        }
+
+        // A segment left open by a crash is still pre-allocated: trim it to the last indexed frame
+        std::uint64_t entries = static_cast<std::uint64_t>(indexStat.st_size) / sizeof(RecordIndexEntry);
+        std::uint64_t dataEnd = 0;
+        if (entries > 0)
+        {
+            int indexFd = open(segment.indexPath.c_str(), O_RDONLY | O_CLOEXEC);
+            RecordIndexEntry last;
+            if (indexFd >= 0 && pread(indexFd, &last, sizeof(last), static_cast<off_t>((entries - 1) * sizeof(RecordIndexEntry))) == static_cast<ssize_t>(sizeof(last)))
+            {
+                dataEnd = last.offset + last.size;
+            }
+            if (indexFd >= 0)
+            {
+                close(indexFd);
+            }
+        }
+
+        if (dataEnd == 0)
+        {
+            unlink(segment.dataPath.c_str());
+            unlink(segment.indexPath.c_str());
+            continue;
+        }
+
+        if (truncate(segment.dataPath.c_str(), static_cast<off_t>(dataEnd)) != 0 ||
+            truncate(segment.indexPath.c_str(), static_cast<off_t>(entries * sizeof(RecordIndexEntry))) != 0)
+        {
+            spdlog::warn("Failed to trim segment {}: {}", segment.dataPath, std::strerror(errno));
+        }
+
+        segment.bytes = dataEnd + entries * sizeof(RecordIndexEntry);
+        segments.push_back(segment);
+    }
+
+    std::sort(segments.begin(), segments.end(), [](const RecordSegment &a, const RecordSegment &b)
+    {
+        return a.number < b.number;
+    });
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    camera.segments.assign(segments.begin(), segments.end());
+    camera.bytes = 0;
+    for (const auto &segment : segments)
+    {
+        camera.bytes += segment.bytes;
+    }
+    camera.nextNumber = segments.empty() ? 1 : segments.back().number + 1;
+
+    if (!segments.empty())
+    {
+        spdlog::info("Found {} recorded segments of camera {} ({} MB)", segments.size(), cameraNumber, camera.bytes / (1024 * 1024));
+    }
+}
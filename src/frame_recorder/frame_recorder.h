@@ -0,0 +1,221 @@
+#ifndef FRAME_RECORDER_H
+#define FRAME_RECORDER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+#include "../live_view/live_view.h"
+
+#define FRAME_RECORDER_DIRECTORY "/lld_sw_v1.0.0/recordings"
+#define FRAME_RECORDER_SEGMENT_BYTES (64u * 1024u * 1024u)
+#define FRAME_RECORDER_BUDGET_BYTES (4ull * 1024ull * 1024ull * 1024ull)
+#define FRAME_RECORDER_WRITE_BUFFER_BYTES (1024u * 1024u)
+#define FRAME_RECORDER_FLUSH_INTERVAL_MS 1000
+#define FRAME_RECORDER_QUEUE_LIMIT 64
+
+/**
+ * @brief One entry of a segment index file: where a frame is stored in its segment.
+ *
+ * Index files are flat arrays of these entries in recording order, so the timestamps are
+ * sorted and can be binary searched without parsing.
+ */
+#pragma pack(push, 1)
+struct RecordIndexEntry
+{
+    std::int64_t timestampMs;       ///< Time the frame was received (ms since the epoch)
+    std::uint64_t offset;           ///< Offset of the JPEG data in the segment file
+    std::uint32_t size;             ///< Size of the JPEG data
+    std::uint32_t frameNo;          ///< Frame number reported by the camera
+};
+#pragma pack(pop)
+
+static_assert(sizeof(RecordIndexEntry) == 24, "RecordIndexEntry is an on-disk format");
+
+/**
+ * @brief A recorded segment of a camera.
+ */
+struct RecordSegment
+{
+    std::uint32_t number = 0;       ///< Segment number, increasing with time
+    std::string dataPath;           ///< Segment file with the JPEG data
+    std::string indexPath;          ///< Index file of the segment
+    std::uint64_t bytes = 0;        ///< Disk usage of both files
+};
+
+/**
+ * @brief Recording state of a camera.
+ */
+struct RecordingStatus
+{
+    bool enabled = false;                   ///< True while new frames are recorded
+    std::size_t segments = 0;               ///< Segments on disk
+    std::uint64_t bytes = 0;                ///< Disk usage of the segments
+    std::uint64_t framesWritten = 0;        ///< Frames written since the start
+    std::uint64_t framesDropped = 0;        ///< Frames dropped because the queue was full
+    std::int64_t lastTimestampMs = 0;       ///< Timestamp of the last written frame
+};
+
+/**
+ * @brief The FrameRecorder class records the live-view frames of the cameras to disk.
+ *
+ * Frames are appended to pre-allocated segment files of FRAME_RECORDER_SEGMENT_BYTES and
+ * described by a binary index file per segment (see RecordIndexEntry). Data is collected in
+ * a write buffer and written with large sequential writes; the index entries of the buffered
+ * frames are written once their data is on disk. When the segments of a camera exceed the
+ * byte budget, the oldest segments are deleted.
+ *
+ * The live-view listener only queues the shared frame; all file I/O happens on the writer
+ * thread. When the bounded queue is full, new frames are dropped and counted, so a slow
+ * disk can never stall the live-view producers.
+ */
+class FrameRecorder
+{
+public:
+    /**
+     * @brief Constructs a FrameRecorder object.
+     * @param liveView instance of LiveView class providing the frames.
+     * @param directory The root directory of the recordings (one subdirectory per camera).
+     * @param budgetBytes The maximum disk usage per camera.
+     */
+    FrameRecorder(LiveView *liveView, const std::string &directory = FRAME_RECORDER_DIRECTORY, std::uint64_t budgetBytes = FRAME_RECORDER_BUDGET_BYTES);
+
+    /**
+     * @brief Stops the writer thread.
+     */
+    ~FrameRecorder();
+
+    /**
+     * @brief Scans the existing recordings, registers the frame listener and starts the writer thread.
+     * @return true if the recording directories are usable, false otherwise.
+     */
+    bool start();
+
+    /**
+     * @brief Flushes the queued frames, closes the segments and stops the writer thread.
+     */
+    void stop();
+
+    /**
+     * @brief Enables or disables the recording of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param enabled True to record the frames of the camera.
+     * @return true if the camera exists, false otherwise.
+     */
+    bool setRecording(int cameraNumber, bool enabled);
+
+    /**
+     * @brief Returns the recording state of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    RecordingStatus getStatus(int cameraNumber) const;
+
+    /**
+     * @brief Returns the segments of a camera whose data and index are complete on disk.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @return The segments, oldest first.
+     */
+    std::vector<RecordSegment> getSegments(int cameraNumber) const;
+
+    /**
+     * @brief Returns the recording directory of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    std::string getCameraDirectory(int cameraNumber) const;
+
+private:
+    /**
+     * @brief Recording state of a camera, owned by the writer thread except where noted.
+     */
+    struct CameraRecording
+    {
+        bool enabled = false;                                   ///< Recording switch (mutex_)
+        std::unique_ptr<LiveViewSubscription> subscription;     ///< Keeps the frames flowing while recording (mutex_)
+        std::deque<RecordSegment> segments;                     ///< Closed segments, oldest first (mutex_)
+        std::uint64_t bytes = 0;                                ///< Disk usage of the closed segments (mutex_)
+        RecordingStatus counters;                               ///< Frame counters (mutex_)
+
+        int dataFd = -1;                                        ///< Open segment file
+        int indexFd = -1;                                       ///< Open index file
+        RecordSegment current;                                  ///< Open segment
+        std::uint64_t dataOffset = 0;                           ///< Bytes of the segment on disk
+        std::vector<std::uint8_t> dataBuffer;                   ///< Frames not written yet
+        std::vector<RecordIndexEntry> indexBuffer;              ///< Index entries of the buffered frames
+        std::chrono::steady_clock::time_point lastFlush;        ///< Time of the last write
+        std::uint32_t nextNumber = 1;                           ///< Number of the next segment
+    };
+
+    /**
+     * @brief Called on the live-view producer thread for every new frame.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param frame The new frame.
+     */
+    void onFrame(int cameraNumber, const LiveViewFramePtr &frame);
+
+    /**
+     * @brief Loop of the writer thread.
+     */
+    void writerLoop();
+
+    /**
+     * @brief Appends a frame to the open segment of a camera (writer thread).
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param frame The frame to record.
+     */
+    void writeFrame(int cameraNumber, const LiveViewFramePtr &frame);
+
+    /**
+     * @brief Writes the buffered frames and their index entries (writer thread).
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @return true on success, false otherwise.
+     */
+    bool flush(int cameraNumber);
+
+    /**
+     * @brief Creates and pre-allocates the next segment of a camera (writer thread).
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @return true on success, false otherwise.
+     */
+    bool openSegment(int cameraNumber);
+
+    /**
+     * @brief Flushes, trims and closes the open segment of a camera (writer thread).
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    void closeSegment(int cameraNumber);
+
+    /**
+     * @brief Deletes the oldest segments of a camera until it fits in the budget.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    void enforceBudget(int cameraNumber);
+
+    /**
+     * @brief Loads the segments already on disk for a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    void scanSegments(int cameraNumber);
+
+    LiveView *liveView_;                                        ///< Source of the live-view frames
+    std::string directory_;                                     ///< Root directory of the recordings
+    std::uint64_t budgetBytes_;                                 ///< Maximum disk usage per camera
+    std::vector<std::unique_ptr<CameraRecording>> cameras_;     ///< Per camera state
+    std::deque<std::pair<int, LiveViewFramePtr>> queue_;        ///< Frames waiting for the writer
+    mutable std::mutex mutex_;                                  ///< Protects the queue and the shared camera state
+    std::condition_variable queueReady_;                        ///< Signaled when frames are queued
+    std::thread writerThread_;                                  ///< Writer thread
+    std::atomic<bool> running_;                                 ///< True while the writer thread runs
+    bool listenerRegistered_ = false;                           ///< True once the frame listener was added
+};
+
+#endif // FRAME_RECORDER_H
@@ -0,0 +1,220 @@
+#include "frame_replay.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <set>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::uint8_t *data, std::size_t size)
+    : data_(data), size_(size)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    munmap(const_cast<std::uint8_t *>(data_), size_);
+}
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string &path, bool sequential)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        spdlog::warn("Failed to open {}: {}", path, std::strerror(errno));
+        return nullptr;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    std::size_t size = static_cast<std::size_t>(fileStat.st_size);
+    void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+
+    // The mapping keeps the file alive, even if the recorder deletes it
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        spdlog::warn("Failed to map {}: {}", path, std::strerror(errno));
+        return nullptr;
+    }
+
+    madvise(data, size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+    return std::shared_ptr<MappedFile>(new MappedFile(static_cast<const std::uint8_t *>(data), size));
+}
+
+bool ReplayCursor::next(ReplayFrame &frame)
+{
+    while (range_ < ranges_.size())
+    {
+        Range &range = ranges_[range_];
+        if (position_ < range.begin)
+        {
+            position_ = range.begin;
+        }
+
+        if (position_ < range.end)
+        {
+            const RecordIndexEntry &entry = reinterpret_cast<const RecordIndexEntry *>(range.index->data())[position_++];
+            frame.data = range.data->data() + entry.offset;
+            frame.size = entry.size;
+            frame.timestampMs = entry.timestampMs;
+            frame.frameNo = entry.frameNo;
+            return true;
+        }
+
+        range_++;
+        position_ = 0;
+    }
+
+    return false;
+}
+
+std::size_t ReplayCursor::getFrameCount() const
+{
+    std::size_t count = 0;
+    for (const auto &range : ranges_)
+    {
+        count += range.end - range.begin;
+    }
+    return count;
+}
+
+FrameReplay::FrameReplay(FrameRecorder *frameRecorder)
+    : frameRecorder_(frameRecorder)
+{
+}
+
+std::shared_ptr<MappedFile> FrameReplay::getMapping(const std::string &path, bool sequential)
+{
+    struct stat fileStat;
+    if (stat(path.c_str(), &fileStat) != 0)
+    {
+        return nullptr;
+    }
+
+    std::uint64_t fileSize = static_cast<std::uint64_t>(fileStat.st_size);
+    auto it = mappings_.find(path);
+    if (it != mappings_.end() && it->second.fileSize == fileSize)
+    {
+        return it->second.file;
+    }
+
+    // New file, or the open segment grew (or was trimmed when closed)
+    CachedMapping mapping;
+    mapping.file = MappedFile::open(path, sequential);
+    mapping.fileSize = fileSize;
+    if (!mapping.file)
+    {
+        mappings_.erase(path);
+        return nullptr;
+    }
+
+    mappings_[path] = mapping;
+    return mapping.file;
+}
+
+std::shared_ptr<ReplayCursor> FrameReplay::seek(int cameraNumber, std::int64_t fromMs, std::int64_t toMs)
+{
+    if (frameRecorder_ == nullptr || fromMs > toMs)
+    {
+        return nullptr;
+    }
+
+    std::vector<RecordSegment> segments = frameRecorder_->getSegments(cameraNumber);
+    std::shared_ptr<ReplayCursor> cursor(new ReplayCursor());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Drop the mappings of rotated segments (cursors still using them keep their own reference)
+    std::set<std::string> paths;
+    for (const auto &segment : segments)
+    {
+        paths.insert(segment.dataPath);
+        paths.insert(segment.indexPath);
+    }
+    for (auto it = mappings_.begin(); it != mappings_.end();)
+    {
+        if (paths.count(it->first) == 0)
+        {
+            it = mappings_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    auto entriesOf = [](const std::shared_ptr<MappedFile> &index, std::size_t &count) -> const RecordIndexEntry *
+    {
+        count = index ? index->size() / sizeof(RecordIndexEntry) : 0;
+        return count > 0 ? reinterpret_cast<const RecordIndexEntry *>(index->data()) : nullptr;
+    };
+
+    // Segments are in time order: skip the ones that end before the range
+    auto first = std::partition_point(segments.begin(), segments.end(), [&](const RecordSegment &segment)
+    {
+        std::size_t count = 0;
+        const RecordIndexEntry *entries = entriesOf(getMapping(segment.indexPath, false), count);
+        return entries == nullptr || entries[count - 1].timestampMs < fromMs;
+    });
+
+    for (auto segment = first; segment != segments.end(); ++segment)
+    {
+        ReplayCursor::Range range;
+        range.index = getMapping(segment->indexPath, false);
+
+        std::size_t count = 0;
+        const RecordIndexEntry *entries = entriesOf(range.index, count);
+        if (entries == nullptr)
+        {
+            continue;
+        }
+
+        if (entries[0].timestampMs > toMs)
+        {
+            break;
+        }
+
+        range.begin = std::lower_bound(entries, entries + count, fromMs, [](const RecordIndexEntry &entry, std::int64_t value)
+        {
+            return entry.timestampMs < value;
+        }) - entries;
+        range.end = std::upper_bound(entries, entries + count, toMs, [](std::int64_t value, const RecordIndexEntry &entry)
+        {
+            return value < entry.timestampMs;
+        }) - entries;
+
+        if (range.begin >= range.end)
+        {
+            continue;
+        }
+
+        range.data = getMapping(segment->dataPath, true);
+        if (!range.data)
+        {
+            continue;
+        }
+
+        // Never hand out bytes past the end of the mapping
+        while (range.end > range.begin && entries[range.end - 1].offset + entries[range.end - 1].size > range.data->size())
+        {
+            range.end--;
+        }
+
+        if (range.begin < range.end)
+        {
+            cursor->ranges_.push_back(range);
+        }
+    }
+
+    return cursor;
+}
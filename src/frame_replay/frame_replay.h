@@ -0,0 +1,158 @@
+#ifndef FRAME_REPLAY_H
+#define FRAME_REPLAY_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+#include "../frame_recorder/frame_recorder.h"
+
+#define FRAME_REPLAY_MIN_SPEED 0.1
+#define FRAME_REPLAY_MAX_SPEED 64.0
+#define FRAME_REPLAY_MAX_GAP_MS 1000          // Longer pauses in the recording are shortened to this
+
+/**
+ * @brief A read-only memory mapping of a whole file.
+ */
+class MappedFile
+{
+public:
+    /**
+     * @brief Maps a file.
+     * @param path The file to map.
+     * @param sequential True if the file is read front to back (read-ahead hint).
+     * @return The mapping, or nullptr on error or for an empty file.
+     */
+    static std::shared_ptr<MappedFile> open(const std::string &path, bool sequential);
+
+    /**
+     * @brief Unmaps the file.
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * @brief Returns the mapped bytes.
+     */
+    const std::uint8_t *data() const { return data_; }
+
+    /**
+     * @brief Returns the size of the mapping.
+     */
+    std::size_t size() const { return size_; }
+
+private:
+    MappedFile(const std::uint8_t *data, std::size_t size);
+
+    const std::uint8_t *data_;      ///< Start of the mapping
+    std::size_t size_;              ///< Size of the mapping
+};
+
+/**
+ * @brief A recorded frame, pointing into the mapped segment file.
+ */
+struct ReplayFrame
+{
+    const std::uint8_t *data = nullptr;     ///< JPEG data (valid while the cursor lives)
+    std::size_t size = 0;                   ///< Size of the JPEG data
+    std::int64_t timestampMs = 0;           ///< Time the frame was received (ms since the epoch)
+    std::uint32_t frameNo = 0;              ///< Frame number reported by the camera
+};
+
+/**
+ * @brief Iterates over the recorded frames of a time range.
+ *
+ * The cursor keeps the index and segment mappings it needs alive, so a segment rotated out
+ * during a replay stays readable until the cursor is destroyed.
+ */
+class ReplayCursor
+{
+public:
+    /**
+     * @brief Returns the next frame of the range.
+     * @param frame Receives the frame.
+     * @return false when the range is exhausted.
+     */
+    bool next(ReplayFrame &frame);
+
+    /**
+     * @brief Returns the number of frames in the range.
+     */
+    std::size_t getFrameCount() const;
+
+private:
+    friend class FrameReplay;
+
+    /**
+     * @brief The entries [begin, end) of one segment.
+     */
+    struct Range
+    {
+        std::shared_ptr<MappedFile> index;      ///< Mapped index file
+        std::shared_ptr<MappedFile> data;       ///< Mapped segment file
+        std::size_t begin = 0;                  ///< First entry of the range
+        std::size_t end = 0;                    ///< One past the last entry of the range
+    };
+
+    std::vector<Range> ranges_;                 ///< Ranges in time order
+    std::size_t range_ = 0;                     ///< Current range
+    std::size_t position_ = 0;                  ///< Next entry of the current range
+};
+
+/**
+ * @brief The FrameReplay class locates recorded live-view frames by time.
+ *
+ * Index files are memory-mapped and binary searched on the timestamp, first across the
+ * segments and then within them, so a seek costs a few page touches regardless of the
+ * recorded duration. Frames are read straight from the mapped segment files without copies.
+ * Mappings of closed segments are cached; the open segment is remapped when it grew.
+ */
+class FrameReplay
+{
+public:
+    /**
+     * @brief Constructs a FrameReplay object.
+     * @param frameRecorder instance of FrameRecorder class owning the segments.
+     */
+    explicit FrameReplay(FrameRecorder *frameRecorder);
+
+    /**
+     * @brief Returns a cursor over the recorded frames of a camera in [fromMs, toMs].
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param fromMs Start of the range (ms since the epoch).
+     * @param toMs End of the range (ms since the epoch).
+     * @return The cursor (possibly empty), or nullptr on error.
+     */
+    std::shared_ptr<ReplayCursor> seek(int cameraNumber, std::int64_t fromMs, std::int64_t toMs);
+
+private:
+    /**
+     * @brief A cached mapping and the file size it was made for.
+     */
+    struct CachedMapping
+    {
+        std::shared_ptr<MappedFile> file;       ///< The mapping
+        std::uint64_t fileSize = 0;             ///< File size when mapped
+    };
+
+    /**
+     * @brief Returns the mapping of a file, remapping it if its size changed.
+     * @param path The file to map.
+     * @param sequential True for segment files (read-ahead hint).
+     * @return The mapping, or nullptr on error.
+     */
+    std::shared_ptr<MappedFile> getMapping(const std::string &path, bool sequential);
+
+    FrameRecorder *frameRecorder_;                      ///< Owner of the segments
+    std::map<std::string, CachedMapping> mappings_;     ///< Mappings by path
+    std::mutex mutex_;                                  ///< Protects the mappings
+};
+
+#endif // FRAME_REPLAY_H
@@ -7,6 +7,10 @@
 #include <spdlog/spdlog.h>
 #include <fmt/format.h>
 
+// The camera_id parameter of the camera routes
+static const RouteParamSpec CAMERA_ID_PARAM = {"camera_id", RouteParamType::CameraId, true, 0, 0};
+static const RouteParamSpec PATH_CAMERA_ID_PARAM = {"camera_id", RouteParamType::PathCameraId, true, 0, 0};
+
 std::string exec(const char *cmd)
 {
     std::array<char, 128> buffer;
@@ -78,76 +82,493 @@ bool is_port_available(int port)
 }
 
 Server::Server(const std::string &host, int port, const std::string &cert_file, const std::string &key_file, std::atomic<bool> &stopRequested, CrSDKInterface *crsdkInterface)
-    : server(cert_file.c_str(), key_file.c_str()), host_(host), port_(port), stopRequested(stopRequested), crsdkInterface_(crsdkInterface)
+    : server(cert_file.c_str(), key_file.c_str()), host_(host), port_(port), stopRequested(stopRequested), crsdkInterface_(crsdkInterface), tlsContext_(server.ssl_context())
 {
+    initializeRoutePools();
     setupRoutes();
 
+    // Reconnecting clients resume their TLS session and reuse their connection
+    setTlsSessions(TLS_SESSION_LIFETIME_S);
+    setKeepAlive(HTTP_KEEP_ALIVE_MAX_REQUESTS, HTTP_KEEP_ALIVE_IDLE_S);
+
+    // A replaced certificate applies to the next connections (file change or SIGHUP)
+    tlsContext_.watchCertificate(cert_file, key_file);
+
     // Initialize token bucket with maxTokens and refillRate parameters
     initializeTokenBucket(/* maxTokens */ 3, /* refillRate */ 1, /* refillNumber */ 3); // Adjust these values as needed
 }
 
 Server::Server(const std::string &host, int port, const std::string &cert_file, const std::string &key_file, std::atomic<bool> &stopRequested, GpioPin *gpioP, CrSDKInterface *crsdkInterface)
-    : server(cert_file.c_str(), key_file.c_str()), host_(host), port_(port), stopRequested(stopRequested), gpioPin(gpioP), crsdkInterface_(crsdkInterface)
+    : server(cert_file.c_str(), key_file.c_str()), host_(host), port_(port), stopRequested(stopRequested), gpioPin(gpioP), crsdkInterface_(crsdkInterface), tlsContext_(server.ssl_context())
 {
+    initializeRoutePools();
     setupRoutes();
 
+    // Reconnecting clients resume their TLS session and reuse their connection
+    setTlsSessions(TLS_SESSION_LIFETIME_S);
+    setKeepAlive(HTTP_KEEP_ALIVE_MAX_REQUESTS, HTTP_KEEP_ALIVE_IDLE_S);
+
+    // A replaced certificate applies to the next connections (file change or SIGHUP)
+    tlsContext_.watchCertificate(cert_file, key_file);
+
     // Initialize token bucket with maxTokens and refillRate parameters
     initializeTokenBucket(/* maxTokens */ 3, /* refillRate */ 1, /* refillNumber */ 3); // Adjust these values as needed
 }
 
 void Server::setupRoutes()
 {
-    server.Get("/", [this](const httplib::Request &req, httplib::Response &res)
-               { handleIndicator(req, res); });
+    // Query parameters are parsed and range checked before the handlers run
+    addRoute({"/", RouteClass::Health, {}}, &Server::handleIndicator);
+
+    addRoute({"/switch_to_p_mode", RouteClass::CameraWrite, {CAMERA_ID_PARAM}, ROUTE_COMMAND_DEADLINE_MS, CommandPriority::Interactive}, &Server::handleSwitchToPMode);
+
+    addRoute({"/switch_to_m_mode", RouteClass::CameraWrite, {CAMERA_ID_PARAM}, ROUTE_COMMAND_DEADLINE_MS, CommandPriority::Interactive}, &Server::handleSwitchToMMode);
+
+    addRoute({"/change_brightness", RouteClass::CameraWrite,
+              {CAMERA_ID_PARAM,
+               {"brightness_value", RouteParamType::Integer, true, 0, MAX_BRIGHTNESS_VALUE}},
+              ROUTE_COMMAND_DEADLINE_MS, CommandPriority::Exposure},
+             &Server::handleChangeBrightness);
+
+    addRoute({"/change_af_area_position", RouteClass::CameraWrite,
+              {CAMERA_ID_PARAM,
+               {"x", RouteParamType::Integer, true, 0, 639},
+               {"y", RouteParamType::Integer, true, 0, 479}},
+              ROUTE_COMMAND_DEADLINE_MS, CommandPriority::Interactive},
+             &Server::handleChangeAFAreaPosition);
+
+    // Concurrent identical reads share one camera call (coalesced)
+    addRoute({"/get_camera_mode", RouteClass::Read, {CAMERA_ID_PARAM}, ROUTE_CAMERA_READ_DEADLINE_MS, CommandPriority::Status, RouteTokens::Request, true}, &Server::handleGetCameraMode);
+
+    addRoute({"/get_camera_brightness", RouteClass::Read, {CAMERA_ID_PARAM}, ROUTE_CAMERA_READ_DEADLINE_MS}, &Server::handleGetCameraBrightness);
+
+    addRoute({"/download_camera_setting", RouteClass::Bulk, {CAMERA_ID_PARAM}, ROUTE_SETTINGS_DEADLINE_MS, CommandPriority::Bulk}, &Server::handleDownloadCameraSetting);
+
+    server.Post("/upload_camera_setting", [this](const httplib::Request &req, httplib::Response &res, const httplib::ContentReader &content_reader)
+                { runInPool(RouteClass::Bulk, req, res, [&]() { handleUploadCameraSetting(req, res, content_reader); }); });
+
+    addRoute({"/get_f_number", RouteClass::Read, {CAMERA_ID_PARAM}, ROUTE_CAMERA_READ_DEADLINE_MS, CommandPriority::Status, RouteTokens::Request, true}, &Server::handleGetFnumber);
+
+    addRoute({"/set_f_number", RouteClass::CameraWrite,
+              {CAMERA_ID_PARAM,
+               {"f_number_value", RouteParamType::Integer, true, 0, 21}},
+              ROUTE_COMMAND_DEADLINE_MS, CommandPriority::Exposure},
+             &Server::handleSetFnumber);
+
+    addRoute({"/set_auto_brightness", RouteClass::CameraWrite,
+              {CAMERA_ID_PARAM,
+               {"enable", RouteParamType::Flag, true, 0, 1},
+               {"target", RouteParamType::Number, false, 1, 254},
+               {"max_step", RouteParamType::Integer, false, 1, MAX_BRIGHTNESS_VALUE},
+               {"min_interval_ms", RouteParamType::Integer, false, 500, 3600000}}},
+             &Server::handleSetAutoBrightness);
+
+    addRoute({"/get_auto_brightness", RouteClass::Read, {CAMERA_ID_PARAM}}, &Server::handleGetAutoBrightness);
+
+    // The frames are polled at the frame rate, they draw from a bucket of their own
+    addRoute({R"(/cameras/(\d+)/histogram)", RouteClass::Read,
+              {PATH_CAMERA_ID_PARAM,
+               {"bins", RouteParamType::Flag, false, 0, 1}},
+              0, CommandPriority::Status, RouteTokens::Frame},
+             &Server::handleGetHistogram);
+
+    addRoute({R"(/cameras/(\d+)/sharpness)", RouteClass::Read,
+              {PATH_CAMERA_ID_PARAM,
+               {"measure", RouteParamType::Flag, false, 0, 1}}},
+             &Server::handleGetSharpness);
+
+    addRoute({R"(/cameras/(\d+)/live_view\.jpg)", RouteClass::Read,
+              {PATH_CAMERA_ID_PARAM,
+               {"rung", RouteParamType::Integer, false, 1, LIVE_VIEW_MAX_RUNG},
+               {"quality", RouteParamType::Integer, false, LIVE_VIEW_MIN_QUALITY, LIVE_VIEW_MAX_QUALITY}},
+              0, CommandPriority::Status, RouteTokens::Frame},
+             &Server::handleGetLiveView);
+
+    // The streams hold their connection for their lifetime, outside the pools (ROUTE_STREAM_CONNECTIONS)
+    addRoute({R"(/cameras/(\d+)/live_view\.mjpeg)", RouteClass::Stream,
+              {PATH_CAMERA_ID_PARAM,
+               {"rung", RouteParamType::Integer, false, 1, LIVE_VIEW_MAX_RUNG},
+               {"quality", RouteParamType::Integer, false, LIVE_VIEW_MIN_QUALITY, LIVE_VIEW_MAX_QUALITY}}},
+             &Server::handleLiveViewStream);
+
+    addRoute({R"(/cameras/(\d+)/live_view/stats)", RouteClass::Read, {PATH_CAMERA_ID_PARAM}}, &Server::handleGetLiveViewStats);
+
+    addRoute({R"(/cameras/(\d+)/recording)", RouteClass::Read,
+              {PATH_CAMERA_ID_PARAM,
+               {"enable", RouteParamType::Flag, false, 0, 1}}},
+             &Server::handleRecording);
+
+    // Times in milliseconds since the epoch
+    addRoute({R"(/cameras/(\d+)/replay)", RouteClass::Bulk,
+              {PATH_CAMERA_ID_PARAM,
+               {"from", RouteParamType::Integer, true, 0, ROUTE_MAX_INTEGER},
+               {"to", RouteParamType::Integer, false, 0, ROUTE_MAX_INTEGER},
+               {"speed", RouteParamType::Number, false, FRAME_REPLAY_MIN_SPEED, FRAME_REPLAY_MAX_SPEED}}},
+             &Server::handleReplay);
+
+    addRoute({R"(/cameras/(\d+)/monitoring)", RouteClass::CameraWrite,
+              {PATH_CAMERA_ID_PARAM,
+               {"enable", RouteParamType::Flag, false, 0, 1},
+               {"protocol", RouteParamType::Choice, false, 0, 0, "tcp|udp"},
+               {"loopback", RouteParamType::Flag, false, 0, 1}}},
+             &Server::handleMonitoring);
+
+    // The catalog routes draw from a bucket of their own, a page loads dozens of thumbnails
+    addRoute({R"(/cameras/(\d+)/contents)", RouteClass::Read,
+              {PATH_CAMERA_ID_PARAM,
+               {"offset", RouteParamType::Integer, false, 0, ROUTE_MAX_INTEGER},
+               {"limit", RouteParamType::Integer, false, 1, CONTENTS_CATALOG_MAX_PAGE},
+               {"folder", RouteParamType::Integer, false, 0, ROUTE_MAX_HANDLE},
+               {"order", RouteParamType::Choice, false, 0, 0, "asc|desc"},
+               {"refresh", RouteParamType::Flag, false, 0, 1}},
+              0, CommandPriority::Status, RouteTokens::Catalog},
+             &Server::handleGetContents);
+
+    addRoute({R"(/cameras/(\d+)/contents/(\d+)/thumb\.jpg)", RouteClass::Read,
+              {PATH_CAMERA_ID_PARAM,
+               {"handle", RouteParamType::PathInteger, true, 0, ROUTE_MAX_HANDLE}},
+              0, CommandPriority::Status, RouteTokens::Catalog},
+             &Server::handleGetThumbnail);
+
+    // Without a camera the selection covers the whole rig
+    addRoute({"/contents/pull", RouteClass::Bulk,
+              {{"camera", RouteParamType::CameraId, false, 0, 0},
+               {"priority", RouteParamType::Integer, false, 0, 9},
+               {"folder", RouteParamType::Integer, false, 0, ROUTE_MAX_HANDLE}}},
+             &Server::handlePullContents);
+
+    addRoute({"/contents/transfers", RouteClass::Read,
+              {{"batch", RouteParamType::Integer, false, 1, ROUTE_MAX_INTEGER},
+               {"cancel", RouteParamType::Flag, false, 0, 1}}},
+             &Server::handleGetTransfers);
+
+    addRoute({R"(/cameras/(\d+)/media)", RouteClass::Read, {PATH_CAMERA_ID_PARAM}, 0, CommandPriority::Status, RouteTokens::Catalog}, &Server::handleListMedia);
+
+    // The file path is checked by the media library
+    addRoute({R"(/cameras/(\d+)/media/(.+))", RouteClass::Bulk, {PATH_CAMERA_ID_PARAM}, 0, CommandPriority::Status, RouteTokens::Catalog}, &Server::handleGetMedia);
+
+    // Held until the state is reached or the timeout, in a pool of their own; the pool bounds
+    // the waits, they take no token
+    addRoute({R"(/cameras/(\d+)/wait)", RouteClass::Wait,
+              {PATH_CAMERA_ID_PARAM,
+               {"brightness", RouteParamType::Integer, false, 0, MAX_BRIGHTNESS_VALUE},
+               {"timeout", RouteParamType::Integer, false, 1, STATE_WAIT_MAX_TIMEOUT_MS}},
+              0, CommandPriority::Status, RouteTokens::None},
+             &Server::handleWaitForState);
+
+    server.Get("/events", [this](const httplib::Request &req, httplib::Response &res)
+               { handleEvents(req, res); });
+
+    addRoute({"/start_cameras", RouteClass::Gpio, {}}, &Server::handleStartCameras);
+
+    addRoute({"/stop_cameras", RouteClass::Gpio, {}}, &Server::handleStopCameras);
+
+    addRoute({"/restat_cameras", RouteClass::Gpio, {}}, &Server::handleRestatCameras);
+
+    // Not rate limited, the program must always be stoppable
+    addRoute({"/exit", RouteClass::Health, {}, 0, CommandPriority::Status, RouteTokens::None}, &Server::handleExit);
+
+    // Queue depths of the pools, not rate limited so monitoring always gets through
+    addRoute({"/metrics", RouteClass::Health, {}, 0, CommandPriority::Status, RouteTokens::None}, &Server::handleGetMetrics);
+}
+
+void Server::initializeRoutePools()
+{
+    setRoutePool(RouteClass::Health, ROUTE_POOL_HEALTH_THREADS, ROUTE_POOL_HEALTH_QUEUE);
+    setRoutePool(RouteClass::Read, ROUTE_POOL_READ_THREADS, ROUTE_POOL_READ_QUEUE);
+    setRoutePool(RouteClass::CameraWrite, ROUTE_POOL_CAMERA_WRITE_THREADS, ROUTE_POOL_CAMERA_WRITE_QUEUE);
+    setRoutePool(RouteClass::Gpio, ROUTE_POOL_GPIO_THREADS, ROUTE_POOL_GPIO_QUEUE);
+    setRoutePool(RouteClass::Bulk, ROUTE_POOL_BULK_THREADS, ROUTE_POOL_BULK_QUEUE);
+    setRoutePool(RouteClass::Wait, ROUTE_POOL_WAIT_THREADS, ROUTE_POOL_WAIT_QUEUE);
+}
+
+void Server::setRoutePool(RouteClass routeClass, std::size_t threads, std::size_t queueLimit)
+{
+    std::unique_ptr<WorkerPool> &pool = routePools_[static_cast<std::size_t>(routeClass)];
+    if (pool)
+    {
+        pool->stop();
+    }
+
+    pool.reset(new WorkerPool(RouteTable::className(routeClass), threads, queueLimit));
+    pool->start();
+}
+
+void Server::runInPool(RouteClass routeClass, const httplib::Request &req, httplib::Response &res, const std::function<void()> &handler)
+{
+    WorkerPool *pool = routePools_[static_cast<std::size_t>(routeClass)].get();
+    WorkerPoolResult result = pool != nullptr ? pool->run(handler) : WorkerPoolResult::Refused;
+    if (result == WorkerPoolResult::Completed)
+    {
+        return;
+    }
+
+    if (result == WorkerPoolResult::Failed)
+    {
+        // The handler threw, its partial response is replaced
+        res = httplib::Response();
+        res.set_header("Access-Control-Allow-Origin", "*"); // You might want to restrict this in production
+
+        JsonWriter response_json;
+        response_json.add("error", "Internal server error");
+        res.status = 500; // Internal Server Error
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+        return;
+    }
+
+    // Every worker of the class is busy and its queue is full
+    spdlog::warn("The {} pool is full, refusing {}", RouteTable::className(routeClass), req.path);
+    res.set_header("Access-Control-Allow-Origin", "*"); // You might want to restrict this in production
+
+    JsonWriter response_json;
+    response_json.add("error", "Server busy");
+    res.status = 503; // Service Unavailable
+
+    // Set the response content type to JSON
+    setJsonContent(req, res, response_json);
+}
+
+void Server::addRoute(const RouteSpec &spec, RouteHandler handler)
+{
+    // The parsed parameters point at the declaration, the deque keeps its address
+    routeSpecs_.push_back(spec);
+    const RouteSpec *route = &routeSpecs_.back();
+
+    if (route->routeClass == RouteClass::Stream)
+    {
+        server.Get(route->path, [this, route, handler](const httplib::Request &req, httplib::Response &res)
+                   { dispatchRoute(*route, handler, req, res, Deadline::Clock::now()); });
+        return;
+    }
 
-    server.Get("/switch_to_p_mode", [this](const httplib::Request &req, httplib::Response &res)
-               { handleSwitchToPMode(req, res); });
+    server.Get(route->path, [this, route, handler](const httplib::Request &req, httplib::Response &res)
+               {
+                   // The deadline includes the time spent in the pool queue
+                   Deadline::Clock::time_point received = Deadline::Clock::now();
+                   runInPool(route->routeClass, req, res, [&]() { dispatchRoute(*route, handler, req, res, received); });
+               });
+}
+
+void Server::dispatchRoute(const RouteSpec &spec, RouteHandler handler, const httplib::Request &req, httplib::Response &res, Deadline::Clock::time_point received)
+{
+    // Enable CORS
+    res.set_header("Access-Control-Allow-Origin", "*"); // You might want to restrict this in production
+
+    JsonWriter response_json;
+    RouteParams params;
+    std::string error;
+    std::size_t cameraCount = crsdkInterface_ ? crsdkInterface_->cameraList.size() : 0;
+    if (!RouteTable::parse(spec, req, cameraCount, params, error))
+    {
+        response_json.add("error", error);
+        res.status = 400; // Bad Request
 
-    server.Get("/switch_to_m_mode", [this](const httplib::Request &req, httplib::Response &res)
-               { handleSwitchToMMode(req, res); });
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+        return;
+    }
 
-    server.Get("/change_brightness", [this](const httplib::Request &req, httplib::Response &res)
-               { handleChangeBrightness(req, res); });
+    if (spec.commandDeadlineMs > 0)
+    {
+        // The client may replace the route deadline
+        std::int64_t deadlineMs = spec.commandDeadlineMs;
+        if (req.has_header(ROUTE_DEADLINE_HEADER) &&
+            (!RouteTable::parseInteger(req.get_header_value(ROUTE_DEADLINE_HEADER), deadlineMs) || deadlineMs < 1 || deadlineMs > ROUTE_MAX_DEADLINE_MS))
+        {
+            response_json.add("error", fmt::format("Invalid {} header, expected an integer from 1 to {}.", ROUTE_DEADLINE_HEADER, ROUTE_MAX_DEADLINE_MS));
+            res.status = 400; // Bad Request
 
-    server.Get("/change_af_area_position", [this](const httplib::Request &req, httplib::Response &res)
-               { handleChangeAFAreaPosition(req, res); });
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+        params.deadline = Deadline::after(std::chrono::milliseconds(deadlineMs), received);
+    }
 
-    server.Get("/get_camera_mode", [this](const httplib::Request &req, httplib::Response &res)
-               { handleGetCameraMode(req, res); });
+    if (spec.coalesced)
+    {
+        // Identical reads in flight share one camera call, per negotiated encoding
+        ResponseEncoding encoding = ResponseEncoder::negotiate(req.get_header_value("Accept"));
+        std::string key = fmt::format("{}|{}|{}", spec.path, params.camera_id, static_cast<int>(encoding));
+        if (!coalescer_.run(key, params.deadline, res, [&]() { runCommand(spec, handler, req, res, params); }))
+        {
+            respondIfExpired(req, res, params);
+        }
+        return;
+    }
 
-    server.Get("/get_camera_brightness", [this](const httplib::Request &req, httplib::Response &res)
-               { handleGetCameraBrightness(req, res); });
+    runCommand(spec, handler, req, res, params);
+}
 
-    server.Get("/download_camera_setting", [this](const httplib::Request &req, httplib::Response &res)
-               { handleDownloadCameraSetting(req, res); });
+void Server::runCommand(const RouteSpec &spec, RouteHandler handler, const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    JsonWriter response_json;
+    CameraCommandPtr command;
+    if (params.deadline.isSet() && params.camera_id >= 0 && cameraScheduler_ != nullptr)
+    {
+        // Refused now if the camera queue would make the command miss its deadline
+        std::chrono::milliseconds retryAfter;
+        command = cameraScheduler_->admit(params.camera_id, spec.path, spec.priority, params.deadline.remaining(), retryAfter);
+        if (!command)
+        {
+            std::int64_t retryAfterSeconds = std::max<std::int64_t>(1, (retryAfter.count() + 999) / 1000);
+            res.set_header("Retry-After", std::to_string(retryAfterSeconds));
 
-    server.Get("/upload_camera_setting", [this](const httplib::Request &req, httplib::Response &res)
-               { handleUploadCameraSetting(req, res); });
+            response_json.add("error", "Camera busy");
+            response_json.add("retry_after_ms", static_cast<std::int64_t>(retryAfter.count()));
+            res.status = 503; // Service Unavailable
 
-    server.Get("/get_f_number", [this](const httplib::Request &req, httplib::Response &res)
-               { handleGetFnumber(req, res); });
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+    }
+    else if (!consumeRouteToken(spec.tokens))
+    {
+        response_json.add("error", "Rate limit exceeded");
+        res.status = 429; // HTTP 429 Too Many Requests
 
-    server.Get("/set_f_number", [this](const httplib::Request &req, httplib::Response &res)
-               { handleSetFnumber(req, res); });
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+        return;
+    }
 
-    server.Get("/start_cameras", [this](const httplib::Request &req, httplib::Response &res)
-               { handleStartCameras(req, res); });
+    // The more urgent commands run first; an expired command leaves the queue unrun
+    if (command && !command->wait(params.deadline))
+    {
+        respondIfExpired(req, res, params);
+        return;
+    }
 
-    server.Get("/stop_cameras", [this](const httplib::Request &req, httplib::Response &res)
-               { handleStopCameras(req, res); });
+    if (command)
+    {
+        res.set_header(ROUTE_PRIORITY_HEADER, CameraScheduler::priorityName(command->getPriority()));
 
-    server.Get("/restat_cameras", [this](const httplib::Request &req, httplib::Response &res)
-               { handleRestatCameras(req, res); });
+        // The camera calls abandoned at the deadline keep the camera until they return
+        RouteParams commandParams = params;
+        commandParams.deadline = params.deadline.holding(command);
+        (this->*handler)(req, res, commandParams);
+        return;
+    }
 
-    server.Get("/exit", [this](const httplib::Request &req, httplib::Response &res)
-               { handleExit(req, res); });
+    (this->*handler)(req, res, params);
 }
 
+bool Server::respondIfExpired(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    if (!params.deadline.expired())
+    {
+        return false;
+    }
+
+    JsonWriter response_json;
+    response_json.add("error", "Camera command timed out");
+    res.status = 504; // Gateway Timeout
+
+    // Set the response content type to JSON
+    setJsonContent(req, res, response_json);
+    return true;
+}
 void Server::setGpioPin(GpioPin *gpioPin)
 {
     this->gpioPin = gpioPin;
 }
 
+void Server::setLiveView(LiveView *liveView)
+{
+    this->liveView_ = liveView;
+}
+
+void Server::setAutoBrightnessController(AutoBrightnessController *autoBrightness)
+{
+    this->autoBrightness_ = autoBrightness;
+}
+
+void Server::setEventStream(EventStream *eventStream)
+{
+    this->eventStream_ = eventStream;
+}
+
+void Server::setFrameAnalyzer(FrameAnalyzer *frameAnalyzer)
+{
+    this->frameAnalyzer_ = frameAnalyzer;
+}
+
+void Server::setFocusVerifier(FocusVerifier *focusVerifier)
+{
+    this->focusVerifier_ = focusVerifier;
+}
+
+void Server::setLiveViewScaler(LiveViewScaler *liveViewScaler)
+{
+    this->liveViewScaler_ = liveViewScaler;
+}
+
+void Server::setFrameRecorder(FrameRecorder *frameRecorder)
+{
+    this->frameRecorder_ = frameRecorder;
+}
+
+void Server::setFrameReplay(FrameReplay *frameReplay)
+{
+    this->frameReplay_ = frameReplay;
+}
+
+void Server::setMonitoringReceiver(MonitoringReceiver *monitoringReceiver)
+{
+    this->monitoringReceiver_ = monitoringReceiver;
+}
+
+void Server::setContentsCatalog(ContentsCatalog *contentsCatalog)
+{
+    this->contentsCatalog_ = contentsCatalog;
+}
+
+void Server::setContentTransfer(ContentTransfer *contentTransfer)
+{
+    this->contentTransfer_ = contentTransfer;
+}
+
+void Server::setThumbnailCache(ThumbnailCache *thumbnailCache)
+{
+    this->thumbnailCache_ = thumbnailCache;
+}
+
+void Server::setMediaLibrary(MediaLibrary *mediaLibrary)
+{
+    this->mediaLibrary_ = mediaLibrary;
+}
+
+void Server::setSettingsCache(SettingsCache *settingsCache)
+{
+    this->settingsCache_ = settingsCache;
+}
+
+void Server::setCameraScheduler(CameraScheduler *cameraScheduler)
+{
+    this->cameraScheduler_ = cameraScheduler;
+}
+
+void Server::setStateWaiter(StateWaiter *stateWaiter)
+{
+    this->stateWaiter_ = stateWaiter;
+}
+
+void Server::setTlsSessions(long lifetimeSeconds, bool tickets)
+{
+    tlsContext_.configureSessions(lifetimeSeconds, TLS_SESSION_CACHE_SIZE, tickets);
+}
+
+void Server::setKeepAlive(std::size_t maxRequests, time_t idleSeconds)
+{
+    server.set_keep_alive_max_count(maxRequests);
+    server.set_keep_alive_timeout(idleSeconds);
+    keepAliveMaxRequests_ = maxRequests;
+    keepAliveIdleSeconds_ = idleSeconds;
+}
+
 void Server::run()
 {
     try
@@ -164,6 +585,26 @@ void Server::run()
             }
         }
 
+        // Enough connection threads for every pool worker and queued request, so a full
+        // pool is refused at once instead of starving the other classes. A pooled request
+        // takes two threads: its connection thread waits while the worker runs it, so the
+        // connection threads count once more than the workers. A connection idle between
+        // requests keeps its thread, and httplib queues the connections beyond the threads
+        // without a bound; the short keep-alive timeout and request count give the threads
+        // back within seconds, a reconnection costs a resumed handshake
+        std::size_t connections = ROUTE_STREAM_CONNECTIONS + HTTP_KEEP_ALIVE_CONNECTIONS;
+        for (const std::unique_ptr<WorkerPool> &pool : routePools_)
+        {
+            if (!pool)
+            {
+                continue;
+            }
+            WorkerPoolStats stats = pool->getStats();
+            connections += stats.threads + stats.queueLimit;
+        }
+        server.new_task_queue = [connections]()
+        { return new httplib::ThreadPool(connections); };
+
         // Print a message to the console indicating the server address and port
         spdlog::info("The server runs at address: {}:{}", host_, port_);
         // Start the monitoring thread
@@ -239,12 +680,107 @@ bool Server::consumeToken()
     }
 }
 
+bool Server::consumeFrameToken()
+{
+    std::lock_guard<std::mutex> lock(tokenMutex_);
+    if (frameTokens_ > 0)
+    {
+        frameTokens_--;
+        return true;
+    }
+    return false;
+}
+
+bool Server::openStream(const httplib::Request &req, httplib::Response &res)
+{
+    int open = openStreams_.load();
+    do
+    {
+        if (open >= ROUTE_STREAM_CONNECTIONS)
+        {
+            spdlog::warn("{} streams are open, refusing {}", open, req.path);
+
+            JsonWriter response_json;
+            response_json.add("error", "Server busy");
+            res.status = 503; // Service Unavailable
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return false;
+        }
+    } while (!openStreams_.compare_exchange_weak(open, open + 1));
+    return true;
+}
+
+void Server::closeStream()
+{
+    openStreams_--;
+}
+
+bool Server::consumeCatalogToken()
+{
+    std::lock_guard<std::mutex> lock(tokenMutex_);
+    if (catalogTokens_ > 0)
+    {
+        catalogTokens_--;
+        return true;
+    }
+    return false;
+}
+
+bool Server::consumeRouteToken(RouteTokens tokens)
+{
+    switch (tokens)
+    {
+    case RouteTokens::Request:
+        return consumeToken();
+    case RouteTokens::Frame:
+        return consumeFrameToken();
+    case RouteTokens::Catalog:
+        return consumeCatalogToken();
+    default:
+        return true;
+    }
+}
+
+void Server::setJsonContent(const httplib::Request &req, httplib::Response &res, const json &response_json)
+{
+    ResponseEncoding encoding = ResponseEncoder::negotiate(req.get_header_value("Accept"));
+
+    std::string body;
+    ResponseEncoder::encode(response_json, encoding, body);
+
+    // Caches must not serve one encoding to a client asking for another
+    res.set_header("Vary", "Accept");
+    res.set_content(body, ResponseEncoder::contentType(encoding));
+}
+
+void Server::setJsonContent(const httplib::Request &req, httplib::Response &res, JsonWriter &response_json)
+{
+    res.set_header("Vary", "Accept");
+
+    ResponseEncoding encoding = ResponseEncoder::negotiate(req.get_header_value("Accept"));
+    if (encoding != ResponseEncoding::Json)
+    {
+        // Rare for these routes, go through the DOM
+        std::string body;
+        ResponseEncoder::encode(response_json.toJson(), encoding, body);
+        res.set_content(body, ResponseEncoder::contentType(encoding));
+        return;
+    }
+
+    // The only copy is into the response body
+    res.set_content(response_json.data(), response_json.size(), "application/json");
+}
+
 void Server::refillTokens(int refillNumber) 
 {
     try 
     {
         std::lock_guard<std::mutex> lock(tokenMutex_);
         currentTokens_ = std::min(maxTokens_, currentTokens_ + refillNumber); 
+        frameTokens_ = FRAME_TOKENS_PER_REFILL;
+        catalogTokens_ = CATALOG_TOKENS_PER_REFILL;
     } 
     catch (const std::exception& e) 
     {
@@ -341,120 +877,187 @@ void Server::restartServer()
     spdlog::info("Server initialization succeeded");
 }
 
-void Server::handleIndicator(const httplib::Request &req, httplib::Response &res)
+void Server::handleIndicator(const httplib::Request &req, httplib::Response &res, const RouteParams &)
 {
-    // Create an empty JSON object
-    nlohmann::json response_json = {};
+    // Written in place, the route is polled at a high rate
+    JsonWriter response_json;
 
     try
     {
-        // Enable CORS
-        res.set_header("Access-Control-Allow-Origin", "*"); // Adjust for production
-
-        if (consumeToken())
-        {
-            response_json["message"] = "The server is running";
-            res.status = 200; // OK
-        }
-        else
-        {
-            response_json["error"] = "Rate limit exceeded";
-            res.status = 429; // HTTP 429 Too Many Requests
-        }
+        response_json.add("message", "The server is running");
+        res.status = 200; // OK
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
     catch (const std::exception &e)
     {
+        // Drop the members written before the exception
+        response_json.reset();
+
         spdlog::error("Indicator Route Error: {}", e.what());
 
         // Error message
-        response_json["error"] = "Failed to get indicator";
+        response_json.add("error", "Failed to get indicator");
         res.status = 500; // Internal Server Error
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
 }
 
-void Server::handleSwitchToPMode(const httplib::Request &req, httplib::Response &res)
+void Server::handleGetMetrics(const httplib::Request &req, httplib::Response &res, const RouteParams &)
 {
     // Create a JSON object
-    nlohmann::json response_json = {};
+    json response_json;
+
     try
     {
-        // Enable CORS
-        res.set_header("Access-Control-Allow-Origin", "*"); // You might want to restrict this in production
+        json pools = json::object();
+        for (const std::unique_ptr<WorkerPool> &pool : routePools_)
+        {
+            // The streams have no pool, they are counted apart
+            if (!pool)
+            {
+                continue;
+            }
+            WorkerPoolStats stats = pool->getStats();
+            pools[stats.name] = {
+                {"threads", stats.threads},
+                {"queue_limit", stats.queueLimit},
+                {"queue_depth", stats.queued},
+                {"active", stats.active},
+                {"max_queue_depth", stats.maxQueued},
+                {"completed", stats.completed},
+                {"rejected", stats.rejected}};
+        }
 
-        // Check if the query parameter 'camera_id' is present
-        auto camera_id_param = req.get_param_value("camera_id");
+        response_json["pools"] = pools;
+        response_json["streams"] = {
+            {"open", openStreams_.load()},
+            {"limit", ROUTE_STREAM_CONNECTIONS}};
 
-        if (consumeToken())
+        if (cameraScheduler_ != nullptr)
         {
-            if (camera_id_param.empty())
+            json cameras = json::array();
+            for (const CameraSchedulerStats &stats : cameraScheduler_->getStats())
             {
-                // Handle missing camera_id.
-                response_json["error"] = "Missing camera_id parameter.";
-                res.status = 400; // Bad Request.
-
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
+                cameras.push_back({
+                    {"camera_id", REVERSE_INDEX(stats.cameraNumber)},
+                    {"pending", stats.pending},
+                    {"running", stats.running},
+                    {"backlog_ms", stats.backlogMs},
+                    {"admitted", stats.admitted},
+                    {"refused", stats.refused},
+                    {"expired", stats.expired},
+                    {"promoted", stats.promoted},
+                    {"completed", stats.completed}});
             }
+            response_json["cameras"] = cameras;
+        }
 
-            int camera_id = std::stoi(camera_id_param);
+        RequestCoalescerStats coalescing = coalescer_.getStats();
+        response_json["coalescing"] = {
+            {"in_flight", coalescing.inFlight},
+            {"leaders", coalescing.leaders},
+            {"shared", coalescing.shared},
+            {"expired", coalescing.expired}};
+
+        TlsSessionStats tls = tlsContext_.getStats();
+        response_json["tls"] = {
+            {"handshakes", tls.completed},
+            {"resumed", tls.resumed},
+            {"full", tls.full},
+            {"failed", tls.accepted > tls.completed ? tls.accepted - tls.completed : 0},
+            {"cache_misses", tls.misses},
+            {"expired", tls.timeouts},
+            {"cached_sessions", tls.cached},
+            {"session_lifetime_s", tls.lifetimeSeconds},
+            {"tickets", tls.tickets},
+            {"keep_alive_max_requests", keepAliveMaxRequests_},
+            {"keep_alive_idle_s", keepAliveIdleSeconds_},
+            {"certificate", {
+                {"subject", tls.subject},
+                {"not_after", tls.notAfter},
+                {"reloads", tls.reloads},
+                {"reload_failures", tls.reloadFailures}}}};
+
+        if (stateWaiter_ != nullptr)
+        {
+            StateWaiterStats waits = stateWaiter_->getStats();
+            response_json["state_waits"] = {
+                {"parked", waits.parked},
+                {"matched", waits.matched},
+                {"timed_out", waits.timedOut},
+                {"reads", waits.reads},
+                {"notifications", waits.notifications}};
+        }
+        res.status = 200; // OK
 
-            // Use the macro to get the reversed index
-            camera_id = REVERSE_INDEX(camera_id);
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Get metrics Route Error: {}", e.what());
 
-            if (camera_id < 0 || camera_id >= crsdkInterface_->cameraList.size())
-            {
-                // Handling camera_id out of range
-                response_json["error"] = "Camera_id out of range.";
-                res.status = 400; // Bad Request
+        // Error message
+        response_json["error"] = "Failed to get metrics";
+        res.status = 500; // Internal Server Error
 
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
 
-            // switch to P mode logic...
-            bool success = false;
-            if (crsdkInterface_)
-            {
-                spdlog::info("switch to P mode...");
-                success = crsdkInterface_->switchToPMode(camera_id);
-            }
-            else
-            {
-                spdlog::error("ERROR: crsdkInterface_ is nullptr");
-            }
+void Server::handleSwitchToPMode(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Create a JSON object
+    nlohmann::json response_json = {};
+    try
+    {
+        int camera_id = params.camera_id;
 
-            if (success)
-            {
-                // Success message
-                spdlog::info("Changing the camera {} mode to P mode was successful", camera_id);
-                response_json["message"] = "Successfully switched to P mode";
-                response_json["mode"] = std::string(1, 'a' - 32);
-                res.status = 200; // OK
-            }
-            else
-            {
-                // Error message
-                spdlog::error("Failed to change camera mode to P mode");
-                response_json["error"] = "Failed to switch to P mode";
-                res.status = 500; // Internal Server Error
-            }
+        // switch to P mode logic...
+        bool success = false;
+        if (crsdkInterface_)
+        {
+            spdlog::info("switch to P mode...");
+            success = crsdkInterface_->switchToPMode(camera_id, params.deadline);
         }
         else
         {
-            response_json["error"] = "Rate limit exceeded";
-            res.status = 429; // HTTP 429 Too Many Requests
+            spdlog::error("ERROR: crsdkInterface_ is nullptr");
+        }
+
+        // Abandoned at the request deadline
+        if (!success && respondIfExpired(req, res, params))
+        {
+            return;
+        }
+
+        if (success)
+        {
+            // Success message
+            spdlog::info("Changing the camera {} mode to P mode was successful", camera_id);
+            response_json["message"] = "Successfully switched to P mode";
+            response_json["mode"] = std::string(1, 'a' - 32);
+            res.status = 200; // OK
+
+            // Switching to P mode recalls the focus preset
+            addFocusCheck(req, response_json, camera_id, "preset");
+        }
+        else
+        {
+            // Error message
+            spdlog::error("Failed to change camera mode to P mode");
+            response_json["error"] = "Failed to switch to P mode";
+            res.status = 500; // Internal Server Error
         }
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
     catch (const std::exception &e)
     {
@@ -466,103 +1069,70 @@ void Server::handleSwitchToPMode(const httplib::Request &req, httplib::Response
         res.status = 500; // Internal Server Error
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
 }
 
-void Server::handleSwitchToMMode(const httplib::Request &req, httplib::Response &res)
+void Server::handleSwitchToMMode(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
 {
     // Create a JSON object
     json response_json;
 
     try
     {
-        // Enable CORS
-        res.set_header("Access-Control-Allow-Origin", "*"); // You might want to restrict this in production
+        int camera_id = params.camera_id;
 
-        if (consumeToken())
+        // switch to M mode logic...
+        bool success = false;
+        if (crsdkInterface_)
         {
-            // Check if the query parameter 'camera_id' is present
-            auto camera_id_param = req.get_param_value("camera_id");
-
-            if (camera_id_param.empty())
-            {
-                // Handle missing camera_id.
-                response_json["error"] = "Missing camera_id parameter.";
-                res.status = 400; // Bad Request.
-
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
-
-            int camera_id = std::stoi(camera_id_param);
-
-            // Use the macro to get the reversed index
-            camera_id = REVERSE_INDEX(camera_id);
+            spdlog::info("switch to M mode...");
+            success = crsdkInterface_->switchToMMode(camera_id, params.deadline);
+        }
+        else
+        {
+            spdlog::error("ERROR: crsdkInterface_ is nullptr");
+        }
 
-            if (camera_id < 0 || camera_id >= crsdkInterface_->cameraList.size())
-            {
-                // Handling camera_id out of range
-                response_json["error"] = "Camera_id out of range.";
-                res.status = 400; // Bad Request
+        // Abandoned at the request deadline
+        if (!success && respondIfExpired(req, res, params))
+        {
+            return;
+        }
 
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
+        if (success)
+        {
+            // Success message
+            spdlog::info("Changing the camera {} mode to M mode was successful", camera_id);
+            response_json["message"] = "Successfully switched to M mode";
+            response_json["mode"] = std::string(1, 'm' - 32);
+            res.status = 200; // OK
+        }
+        else
+        {
 
-            // switch to M mode logic...
-            bool success = false;
-            if (crsdkInterface_)
-            {
-                spdlog::info("switch to M mode...");
-                success = crsdkInterface_->switchToMMode(camera_id);
-            }
-            else
-            {
-                spdlog::error("ERROR: crsdkInterface_ is nullptr");
-            }
+            spdlog::error("Failed to change camera mode to M mode");
 
+            spdlog::info("Returns the camera to P mode...");
+            success = crsdkInterface_->switchToPMode(camera_id, params.deadline);
             if (success)
             {
                 // Success message
-                spdlog::info("Changing the camera {} mode to M mode was successful", camera_id);
-                response_json["message"] = "Successfully switched to M mode";
-                response_json["mode"] = std::string(1, 'm' - 32);
+                spdlog::info("Changing the camera {} mode back to P mode was successful", camera_id);
+                response_json["message"] = "Successfully switched back to P mode";
+                response_json["mode"] = std::string(1, 'a' - 32);
                 res.status = 200; // OK
             }
             else
             {
-
-                spdlog::error("Failed to change camera mode to M mode");
-
-                spdlog::info("Returns the camera to P mode...");
-                success = crsdkInterface_->switchToPMode(camera_id);
-                if (success)
-                {
-                    // Success message
-                    spdlog::info("Changing the camera {} mode back to P mode was successful", camera_id);
-                    response_json["message"] = "Successfully switched back to P mode";
-                    response_json["mode"] = std::string(1, 'a' - 32);
-                    res.status = 200; // OK
-                }
-                else
-                {
-                    // Error message
-                    response_json["error"] = "Failed to switch to M mode";
-                    res.status = 500; // Internal Server Error
-                }
+                // Error message
+                response_json["error"] = "Failed to switch to M mode";
+                res.status = 500; // Internal Server Error
             }
         }
-        else
-        {
-            response_json["error"] = "Rate limit exceeded";
-            res.status = 429; // HTTP 429 Too Many Requests
-        }
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
     catch (const std::exception &e)
     {
@@ -574,118 +1144,59 @@ void Server::handleSwitchToMMode(const httplib::Request &req, httplib::Response
         res.status = 500; // Internal Server Error
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");    
+        setJsonContent(req, res, response_json);    
     }
 }
 
-void Server::handleChangeBrightness(const httplib::Request &req, httplib::Response &res)
+void Server::handleChangeBrightness(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
 {
     // Create a JSON object.
     json response_json;
 
     try
     {
-        // Enable CORS.
-        res.set_header("Access-Control-Allow-Origin", "*"); // You might want to restrict this in production.
+        int camera_id = params.camera_id;
 
-        if (consumeToken())
+        // Checking whether the camera is in manual mode
+        if (crsdkInterface_->cameraModes[camera_id] != "m")
         {
-            // Check if the query parameter 'camera_id' is present.
-            auto camera_id_param = req.get_param_value("camera_id");
-
-            if (camera_id_param.empty())
-            {
-                // Handle missing camera_id.
-                response_json["error"] = "Missing camera_id parameter.";
-                res.status = 400; // Bad Request.
-
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
-
-            int camera_id = std::stoi(camera_id_param);
-
-            // Use the macro to get the reversed index
-            camera_id = REVERSE_INDEX(camera_id);
-
-            if (camera_id < 0 || camera_id >= crsdkInterface_->cameraList.size())
-            {
-                // Handling camera_id out of range
-                response_json["error"] = "Camera_id out of range.";
-                res.status = 400; // Bad Request
-
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
-
-            // Checking whether the camera is in manual mode
-            if (crsdkInterface_->cameraModes[camera_id] != "m")
-            {
-                // Handling camera mode is not M.
-                spdlog::error("Changing the camera {} brightness is not possible because the camera is not M(manual) mode", camera_id);
-                response_json["error"] = "Changing the camera brightness is not possible because the camera is not M(manual) mode.";
-                res.status = 405; // Method not allowed.
-
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
-
-            // Check if the query parameters brightness value are present.
-            auto brightness_value_param = req.get_param_value("brightness_value");
+            // Handling camera mode is not M.
+            spdlog::error("Changing the camera {} brightness is not possible because the camera is not M(manual) mode", camera_id);
+            response_json["error"] = "Changing the camera brightness is not possible because the camera is not M(manual) mode.";
+            res.status = 405; // Method not allowed.
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
 
-            if (brightness_value_param.empty())
-            {
-                // Handle missing parameters
-                response_json["error"] = "Missing required parameters.";
-                res.status = 400; // Bad Request
+        // Range checked by the route table (0 to 48)
+        int brightnessValue = static_cast<int>(params.getInt("brightness_value"));
 
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
-            else
-            {
-                // Convert the parameters to numbers.
-                int brightnessValue = std::stoi(brightness_value_param);
+        // change the brightness value logic...
+        bool success = crsdkInterface_->changeBrightness(camera_id, brightnessValue, params.deadline);
 
-                // Treatment in case the brightness value entered is incorrect.
-                if (brightnessValue < 0 || brightnessValue > 48)
-                {
-                    // Error message
-                    response_json["error"] = "the brightness value entered is incorrect.";
-                    res.status = 405; // Method not allowed.
-                }
-                else
-                {
-                    // change the brightness value logic...
-                    bool success = crsdkInterface_->changeBrightness(camera_id, brightnessValue);
+        // Abandoned at the request deadline
+        if (!success && respondIfExpired(req, res, params))
+        {
+            return;
+        }
 
-                    if (success)
-                    {
-                        // Success message
-                        response_json["message"] = "Successfully changed brightness value";
-                        res.status = 200; // OK
-                    }
-                    else
-                    {
-                        // Error message
-                        response_json["error"] = "Failed to change brightness value";
-                        res.status = 500; // Internal Server Error
-                    }
-                }
-            }
+        if (success)
+        {
+            // Success message
+            response_json["message"] = "Successfully changed brightness value";
+            res.status = 200; // OK
         }
         else
         {
-            response_json["error"] = "Rate limit exceeded";
-            res.status = 429; // HTTP 429 Too Many Requests
+            // Error message
+            response_json["error"] = "Failed to change brightness value";
+            res.status = 500; // Internal Server Error
         }
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
     catch (const std::exception &e)
     {
@@ -697,231 +1208,279 @@ void Server::handleChangeBrightness(const httplib::Request &req, httplib::Respon
         res.status = 500; // Internal Server Error
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
 }
 
-void Server::handleChangeAFAreaPosition(const httplib::Request &req, httplib::Response &res)
+void Server::handleChangeAFAreaPosition(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
 {
     // Create a JSON object
     json response_json;
 
     try
     {
-        // Enable CORS
-        res.set_header("Access-Control-Allow-Origin", "*"); // You might want to restrict this in production
+        int camera_id = params.camera_id;
 
-        if (consumeToken())
+        if (crsdkInterface_->cameraModes[camera_id] != "p")
         {
-            // Check if the query parameter 'camera_id' is present
-            auto camera_id_param = req.get_param_value("camera_id");
-
-            if (camera_id_param.empty())
-            {
-                // Handle missing camera_id.
-                response_json["error"] = "Missing camera_id parameter.";
-                res.status = 400; // Bad Request.
-
-                // Set the response content type to JSON.
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
+            // Handling camera mode is not P.
+            spdlog::error("Changing the AF Area Position is not possible because the camera is not P(auto) mode");
+            response_json["error"] = "Changing the AF Area Position is not possible because the camera is not P(auto) mode.";
+            res.status = 405; // Method not allowed.
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
 
-            int camera_id = std::stoi(camera_id_param);
+        // Range checked by the route table (640x480 grid)
+        int x = static_cast<int>(params.getInt("x"));
+        int y = static_cast<int>(params.getInt("y"));
 
-            // Use the macro to get the reversed index
-            camera_id = REVERSE_INDEX(camera_id);
+        // change the AF Area Position logic...
+        bool success = crsdkInterface_->changeAFAreaPosition(camera_id, x, y, params.deadline);
 
-            if (camera_id < 0 || camera_id >= crsdkInterface_->cameraList.size())
-            {
-                // Handling camera_id out of range
-                response_json["error"] = "Camera_id out of range.";
-                res.status = 400; // Bad Request
+        // Abandoned at the request deadline
+        if (!success && respondIfExpired(req, res, params))
+        {
+            return;
+        }
 
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
+        if (success)
+        {
+            // Success message
+            response_json["message"] = "Successfully changed AF Area Position";
+            res.status = 200; // OK
 
-            if (crsdkInterface_->cameraModes[camera_id] != "p")
-            {
-                // Handling camera mode is not P.
-                spdlog::error("Changing the AF Area Position is not possible because the camera is not P(auto) mode");
-                response_json["error"] = "Changing the AF Area Position is not possible because the camera is not P(auto) mode.";
-                res.status = 405; // Method not allowed.
+            // Measure around the new AF point (same 640x480 grid as x and y)
+            addFocusCheck(req, response_json, camera_id, "af_area", x / 639.0, y / 479.0);
+        }
+        else
+        {
+            // Error message
+            response_json["error"] = "Failed to change AF Area Position";
+            res.status = 500; // Internal Server Error
+        }
 
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Change AF Area Position Route Error: {}", e.what());
 
-            // Check if the query parameters 'x', 'y' are present
-            auto x_param = req.get_param_value("x");
-            auto y_param = req.get_param_value("y");
+        // Error message
+        response_json["error"] = "Failed to change AF Area Position";
+        res.status = 500; // Internal Server Error
 
-            if (x_param.empty() || y_param.empty())
-            {
-                // Missing or invalid parameters
-                res.status = 400; // Bad Request.
-                response_json["error"] = "Missing or invalid parameters.";
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
 
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
-            else
-            {
-                // Convert the parameters to numbers
-                int x = std::stoi(x_param);
-                int y = std::stoi(y_param);
+void Server::handleGetCameraMode(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Written in place, the route is polled at a high rate
+    JsonWriter response_json;
 
-                if (x < 0 || x > 639)
-                {
-                    // Error message
-                    spdlog::error("Error: The selected X value is out of range");
-                    response_json["error"] = "The selected X value is out of range.";
-                    res.status = 405; // Method not allowed.
-
-                    // Set the response content type to JSON
-                    res.set_content(response_json.dump(), "application/json");
-                    return;
-                }
+    try
+    {
+        int camera_id = params.camera_id;
 
-                if (y < 0 || y > 479)
-                {
-                    // Error message
-                    spdlog::error("Error: The selected Y value is out of range");
-                    response_json["error"] = "The selected Y value is out of range.";
-                    res.status = 405; // Method not allowed.
-
-                    // Set the response content type to JSON
-                    res.set_content(response_json.dump(), "application/json");
-                    return;
-                }
+        // get camera mode logic...
+        bool success = crsdkInterface_->getCameraMode(camera_id, params.deadline);
 
-                // change the AF Area Position logic...
-                bool success = crsdkInterface_->changeAFAreaPosition(camera_id, x, y);
+        // Abandoned at the request deadline
+        if (!success && respondIfExpired(req, res, params))
+        {
+            return;
+        }
 
-                if (success)
-                {
-                    // Success message
-                    response_json["message"] = "Successfully changed AF Area Position";
-                    res.status = 200; // OK
-                }
-                else
-                {
-                    // Error message
-                    response_json["error"] = "Failed to change AF Area Position";
-                    res.status = 500; // Internal Server Error
-                }
-            }           
+        if (success)
+        {
+            // Success message
+            response_json.add("message", "Successfully retrieved camera mode");
+            response_json.add("mode", crsdkInterface_->getCameraModeStr(camera_id));
+            res.status = 200; // OK
         }
         else
         {
-            response_json["error"] = "Rate limit exceeded";
-            res.status = 429; // HTTP 429 Too Many Requests
+            // Error message
+            response_json.add("error", "Failed to retrieve camera mode");
+            res.status = 500; // Internal Server Error
         }
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
     catch (const std::exception &e)
     {
+        // Drop the members written before the exception
+        response_json.reset();
+
         // Handle the exception and generate an error message
-        spdlog::error("Change AF Area Position Route Error: {}", e.what());
+        spdlog::error("Get camera mode Route Error: {}", e.what());
 
         // Error message
-        response_json["error"] = "Failed to change AF Area Position";
+        response_json.add("error", "Failed to retrieve camera mode");
         res.status = 500; // Internal Server Error
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
 }
 
-void Server::handleGetCameraMode(const httplib::Request &req, httplib::Response &res)
+void Server::handleGetCameraBrightness(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
 {
     // Create a JSON object
     json response_json;
 
     try
     {
-        // Enable CORS
-        res.set_header("Access-Control-Allow-Origin", "*"); // You might want to restrict this in production
+        int camera_id = params.camera_id;
 
-        if (consumeToken())
+        // Checking whether the camera is in manual mode
+        if (crsdkInterface_->cameraModes[camera_id] != "m")
         {
-            // Check if the query parameter 'camera_id' is present
-            auto camera_id_param = req.get_param_value("camera_id");
+            // Handling camera mode is not M.
+            spdlog::error("Geting the camera {} brightness value is not possible because the camera is not M mode", camera_id);
+            response_json["error"] = "Geting the camera brightness value is not possible because the camera is not M mode.";
+            res.status = 405; // Method not allowed.
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
 
-            if (camera_id_param.empty())
-            {
-                // Handle missing camera_id.
-                response_json["error"] = "Missing camera_id parameter.";
-                res.status = 400; // Bad Request.
+        // get camera brightness logic...
+        int brightness = crsdkInterface_->getCameraBrightness(camera_id);
 
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
+        if (brightness != -1)
+        {
+            // Success message
+            response_json["message"] = "Successfully retrieved camera brightness";
+            response_json["brightness value"] =  brightness;
+            res.status = 200; // OK
+        }
+        else
+        {
+            // Error message
+            response_json["error"] = "Failed to retrieve camera brightness";
+            res.status = 500; // Internal Server Error
+        }
 
-            int camera_id = std::stoi(camera_id_param);
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Get camera brightness Route Error: {}", e.what());
 
-            // Use the macro to get the reversed index
-            camera_id = REVERSE_INDEX(camera_id);
+        // Error message
+        response_json["error"] = "Failed to retrieve camera brightness";
+        res.status = 500; // Internal Server Error
 
-            if (camera_id < 0 || camera_id >= crsdkInterface_->cameraList.size())
-            {
-                // Handling camera_id out of range
-                response_json["error"] = "Camera_id out of range.";
-                res.status = 400; // Bad Request
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
 
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
+void Server::handleDownloadCameraSetting(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Create a JSON object
+    json response_json;
 
-            // get camera mode logic...
-            bool success = crsdkInterface_->getCameraMode(camera_id);
+    try
+    {
+        int camera_id = params.camera_id;
 
-            if (success)
-            {
-                // Success message
-                response_json["message"] = "Successfully retrieved camera mode";
-                response_json["mode"] =  crsdkInterface_->getCameraModeStr(camera_id);
-                res.status = 200; // OK
-            }
-            else
-            {
-                // Error message
-                response_json["error"] = "Failed to retrieve camera mode";
-                res.status = 500; // Internal Server Error
-            }           
+        if (settingsCache_ == nullptr)
+        {
+            // Error message
+            response_json["error"] = "Settings cache is not active";
+            res.status = 500; // Internal Server Error
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
         }
-        else
+
+        // Served from the cache when the settings did not change since the last download
+        SettingsBlob blob;
+        std::string error = settingsCache_->download(camera_id, blob, params.deadline);
+        if (!error.empty() && respondIfExpired(req, res, params))
         {
-            response_json["error"] = "Rate limit exceeded";
-            res.status = 429; // HTTP 429 Too Many Requests
+            return;
         }
+        if (!error.empty())
+        {
+            // Error message
+            response_json["error"] = error;
+            res.status = 500; // Internal Server Error
 
-        // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        std::string etag = fmt::format("\"{}\"", blob.hash);
+        res.set_header("ETag", etag);
+        res.set_header("X-Cache", blob.cached ? "hit" : "miss");
+
+        if (req.get_header_value("If-None-Match") == etag)
+        {
+            // The client already has this file
+            res.status = 304; // Not Modified
+            return;
+        }
+
+        std::shared_ptr<MediaReader> reader = MediaReader::open(blob.path);
+        if (!reader)
+        {
+            // Error message
+            response_json["error"] = "Failed to open the camera-settings file";
+            res.status = 500; // Internal Server Error
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        res.set_header("Content-Disposition", fmt::format("attachment; filename=\"camera_{}_settings.DAT\"", params.camera_param));
+        res.status = 200; // OK
+
+        // Streamed from the stored file, with its Content-Length
+        res.set_content_provider(
+            static_cast<std::size_t>(blob.size), "application/octet-stream",
+            [reader](size_t offset, size_t length, httplib::DataSink &sink)
+            {
+                std::size_t count = 0;
+                const char *data = reader->read(offset, std::min<std::size_t>(length, MEDIA_READ_CHUNK_BYTES), count);
+                if (data == nullptr || count == 0)
+                {
+                    return false;
+                }
+
+                return sink.write(data, count);
+            });
     }
     catch (const std::exception &e)
     {
         // Handle the exception and generate an error message
-        spdlog::error("Get camera mode Route Error: {}", e.what());
+        spdlog::error("Download camera setting Route Error: {}", e.what());
 
         // Error message
-        response_json["error"] = "Failed to retrieve camera mode";
+        response_json["error"] = "Failed to download camera setting";
         res.status = 500; // Internal Server Error
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
 }
 
-void Server::handleGetCameraBrightness(const httplib::Request &req, httplib::Response &res)
+void Server::handleUploadCameraSetting(const httplib::Request &req, httplib::Response &res, const httplib::ContentReader &content_reader)
 {
     // Create a JSON object
     json response_json;
@@ -931,336 +1490,1711 @@ void Server::handleGetCameraBrightness(const httplib::Request &req, httplib::Res
         // Enable CORS
         res.set_header("Access-Control-Allow-Origin", "*"); // You might want to restrict this in production
 
-        if (consumeToken())
+        if (!consumeToken())
         {
-            // Check if the query parameter 'camera_id' is present
-            auto camera_id_param = req.get_param_value("camera_id");
+            response_json["error"] = "Rate limit exceeded";
+            res.status = 429; // HTTP 429 Too Many Requests
 
-            if (camera_id_param.empty())
-            {
-                // Handle missing camera_id.
-                response_json["error"] = "Missing camera_id parameter.";
-                res.status = 400; // Bad Request.
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
 
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
+        // The target cameras are "cameras" (comma separated IDs) or a single "camera_id"
+        std::string cameras_param = req.has_param("cameras") ? req.get_param_value("cameras") : req.get_param_value("camera_id");
 
-            int camera_id = std::stoi(camera_id_param);
+        if (cameras_param.empty())
+        {
+            // Handle missing camera_id.
+            response_json["error"] = "Missing camera_id parameter.";
+            res.status = 400; // Bad Request.
 
-            // Use the macro to get the reversed index
-            camera_id = REVERSE_INDEX(camera_id);
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
 
-            if (camera_id < 0 || camera_id >= crsdkInterface_->cameraList.size())
+        std::vector<int> requested_ids;
+        std::vector<int> camera_ids;
+        std::stringstream cameras_stream(cameras_param);
+        std::string item;
+        while (std::getline(cameras_stream, item, ','))
+        {
+            // Checked and mapped as the camera_id of the other routes
+            int camera_id = -1;
+            if (!RouteTable::parseCameraId(item, crsdkInterface_->cameraList.size(), camera_id))
             {
                 // Handling camera_id out of range
                 response_json["error"] = "Camera_id out of range.";
                 res.status = 400; // Bad Request
 
                 // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
+                setJsonContent(req, res, response_json);
                 return;
             }
 
-            // Checking whether the camera is in manual mode
-            if (crsdkInterface_->cameraModes[camera_id] != "m")
+            if (std::find(camera_ids.begin(), camera_ids.end(), camera_id) == camera_ids.end())
             {
-                // Handling camera mode is not M.
-                spdlog::error("Geting the camera {} brightness value is not possible because the camera is not M mode", camera_id);
-                response_json["error"] = "Geting the camera brightness value is not possible because the camera is not M mode.";
-                res.status = 405; // Method not allowed.
-
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
+                requested_ids.push_back(REVERSE_INDEX(camera_id));
+                camera_ids.push_back(camera_id);
             }
+        }
 
-            // get camera brightness logic...
-            int brightness = crsdkInterface_->getCameraBrightness(camera_id);
+        if (settingsCache_ == nullptr)
+        {
+            // Error message
+            response_json["error"] = "Settings cache is not active";
+            res.status = 500; // Internal Server Error
 
-            if (brightness != -1)
-            {
-                // Success message
-                response_json["message"] = "Successfully retrieved camera brightness";
-                response_json["brightness value"] =  brightness;
-                res.status = 200; // OK
-            }
-            else
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        std::unique_ptr<SettingsUpload> upload = settingsCache_->createUpload();
+        if (!upload)
+        {
+            // Error message
+            response_json["error"] = "Failed to store the camera-settings file";
+            res.status = 500; // Internal Server Error
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        // The body goes to the temporary file chunk by chunk as it is received
+        bool received = content_reader([&upload](const char *data, size_t data_length)
+        {
+            return upload->write(data, data_length);
+        });
+        bool stored = upload->finish();
+
+        if (upload->isTooLarge())
+        {
+            // Error message
+            response_json["error"] = fmt::format("Camera-settings file larger than {} bytes.", CAMERA_SETTINGS_MAX_UPLOAD_BYTES);
+            res.status = 413; // Payload Too Large
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        if (!received || !stored || upload->getSize() == 0)
+        {
+            // Handle missing or incomplete body
+            response_json["error"] = "Missing camera-settings file in the request body.";
+            res.status = 400; // Bad Request
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        // All cameras read the file at the same time
+        auto start = std::chrono::steady_clock::now();
+        std::vector<SettingsApplyResult> results = settingsCache_->apply(upload->getPath(), camera_ids);
+        double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::size_t succeeded = 0;
+        json results_json = json::array();
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            json result;
+            result["camera_id"] = requested_ids[i];
+            result["success"] = results[i].succeeded;
+            result["duration_ms"] = results[i].durationMs;
+            result["priority"] = CameraScheduler::priorityName(results[i].priority);
+            if (!results[i].succeeded)
+            {
+                result["error"] = results[i].error;
+            }
+            results_json.push_back(result);
+            succeeded += results[i].succeeded ? 1 : 0;
+        }
+
+        response_json["bytes"] = upload->getSize();
+        response_json["duration_ms"] = total_ms;
+        response_json["results"] = results_json;
+
+        if (succeeded == results.size())
+        {
+            // Success message
+            response_json["message"] = "Successfully upload camera setting";
+            res.status = 200; // OK
+        }
+        else if (succeeded > 0)
+        {
+            // Partial success
+            response_json["error"] = "Failed to upload camera setting to some cameras";
+            res.status = 207; // Multi-Status
+        }
+        else
+        {
+            // Error message
+            response_json["error"] = "Failed to upload camera setting";
+            res.status = 500; // Internal Server Error
+        }
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Upload camera setting Route Error: {}", e.what());
+
+        // Error message
+        response_json["error"] = "Failed to upload camera setting";
+        res.status = 500; // Internal Server Error
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
+
+void Server::handleGetFnumber(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Written in place, the route is polled at a high rate
+    JsonWriter response_json;
+
+    try
+    {
+        int camera_id = params.camera_id;
+
+        // Get F-number setting logic...
+        std::string Fnumber = crsdkInterface_->getFnumber(camera_id, params.deadline);
+
+        // Abandoned at the request deadline
+        if (Fnumber.empty() && respondIfExpired(req, res, params))
+        {
+            return;
+        }
+
+        if (!Fnumber.empty())
+        {
+            // Success message
+            response_json.add("message", "Geting the index of the f-number was successful");
+            response_json.add("f-number", Fnumber);
+            res.status = 200; // OK
+        }
+        else
+        {
+            // Error message
+            response_json.add("error", "Failed to geting the index of the f-number");
+            res.status = 500; // Internal Server Error
+        }
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+    catch (const std::exception &e)
+    {
+        // Drop the members written before the exception
+        response_json.reset();
+
+        // Handle the exception and generate an error message
+        spdlog::error("Get F-number Route Error: {}", e.what());
+
+        // Error message
+        response_json.add("error", "Failed to geting the index of the f-number");
+        res.status = 500; // Internal Server Error
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
+
+void Server::handleSetFnumber(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Create a JSON object
+    json response_json;
+
+    try
+    {
+        int camera_id = params.camera_id;
+
+        // Range checked by the route table (0 to 21)
+        int fNumberValue = static_cast<int>(params.getInt("f_number_value"));
+
+        // change the F-number value logic...
+        bool success = crsdkInterface_->setFnumber(camera_id, fNumberValue, params.deadline);
+
+        // Abandoned at the request deadline
+        if (!success && respondIfExpired(req, res, params))
+        {
+            return;
+        }
+
+        if (success)
+        {
+            // Success message
+            response_json["message"] = "Changing the index of the f-number was successful";
+            res.status = 200; // OK
+        }
+        else
+        {
+            // Error message
+            response_json["error"] = "Failed to change the index of the f-number";
+            res.status = 500; // Internal Server Error
+        }
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Set F-number Route Error: {}", e.what());
+
+        // Error message
+        response_json["error"] = "Failed to seting the index of the f-number";
+        res.status = 500; // Internal Server Error
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
+
+void Server::handleSetAutoBrightness(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Create a JSON object
+    json response_json;
+
+    try
+    {
+        int camera_id = params.camera_id;
+
+        if (autoBrightness_ == nullptr)
+        {
+            response_json["error"] = "Auto brightness is not active";
+            res.status = 500; // Internal Server Error
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        // Start from the current settings, only the given parameters are changed.
+        AutoBrightnessSettings settings = autoBrightness_->getStatus(camera_id).settings;
+        settings.enabled = (params.getInt("enable") != 0);
+
+        if (params.has("target"))
+        {
+            settings.targetMean = params.getNumber("target");
+        }
+
+        if (params.has("max_step"))
+        {
+            settings.maxStep = static_cast<int>(params.getInt("max_step"));
+        }
+
+        if (params.has("min_interval_ms"))
+        {
+            // At least 500 ms, checked by the route table
+            settings.minInterval = std::chrono::milliseconds(params.getInt("min_interval_ms"));
+        }
+
+        if (autoBrightness_->configure(camera_id, settings))
+        {
+            // Success message
+            response_json["message"] = "Successfully configured auto brightness";
+            response_json["enabled"] = settings.enabled;
+            response_json["target"] = settings.targetMean;
+            res.status = 200; // OK
+        }
+        else
+        {
+            // Error message
+            response_json["error"] = "The auto brightness settings are incorrect.";
+            res.status = 400; // Bad Request
+        }
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Set auto brightness Route Error: {}", e.what());
+
+        // Error message
+        response_json["error"] = "Failed to configure auto brightness";
+        res.status = 500; // Internal Server Error
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
+
+void Server::handleGetAutoBrightness(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Create a JSON object
+    json response_json;
+
+    try
+    {
+        int camera_id = params.camera_id;
+
+        if (autoBrightness_ != nullptr)
+        {
+            AutoBrightnessStatus status = autoBrightness_->getStatus(camera_id);
+
+            // Success message
+            response_json["message"] = "Successfully retrieved auto brightness state";
+            response_json["enabled"] = status.settings.enabled;
+            response_json["target"] = status.settings.targetMean;
+            response_json["state"] = status.state;
+            response_json["mean"] = status.measuredMean;
+            response_json["brightness value"] = status.brightness;
+            response_json["adjustments"] = status.adjustments;
+            res.status = 200; // OK
+        }
+        else
+        {
+            // Error message
+            response_json["error"] = "Auto brightness is not active";
+            res.status = 500; // Internal Server Error
+        }
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Get auto brightness Route Error: {}", e.what());
+
+        // Error message
+        response_json["error"] = "Failed to retrieve auto brightness state";
+        res.status = 500; // Internal Server Error
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
+
+void Server::handleGetHistogram(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Create a JSON object
+    json response_json;
+
+    try
+    {
+        int camera_id = params.camera_id;
+
+        if (frameAnalyzer_ == nullptr)
+        {
+            // Error message
+            response_json["error"] = "Frame analysis is not active";
+            res.status = 500; // Internal Server Error
+        }
+        else
+        {
+            // Keep the frames flowing for the clients polling this route
+            frameAnalyzer_->requestAnalysis(camera_id);
+            LumaStatistics statistics = frameAnalyzer_->getStatistics(camera_id);
+
+            if (statistics.valid)
+            {
+                // Success message
+                response_json = FrameAnalyzer::toJson(statistics, !params.has("bins") || params.getInt("bins") == 1);
+                response_json["message"] = "Successfully retrieved histogram";
+                response_json["simd"] = LumaHistogram::getSimdPath();
+                res.status = 200; // OK
+            }
+            else
+            {
+                // No live-view frame was analysed yet
+                response_json["error"] = "No live-view frame available yet";
+                res.status = 503; // Service Unavailable
+            }
+        }
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Get histogram Route Error: {}", e.what());
+
+        // Error message
+        response_json["error"] = "Failed to retrieve histogram";
+        res.status = 500; // Internal Server Error
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
+
+void Server::addFocusCheck(const httplib::Request &req, json &response_json, int camera_id, const std::string &trigger, double centerX, double centerY)
+{
+    if (focusVerifier_ == nullptr || req.get_param_value("verify_focus") == "false")
+    {
+        return;
+    }
+
+    FocusCheck check = focusVerifier_->verify(camera_id, trigger, centerX, centerY);
+
+    if (check.valid)
+    {
+        response_json["sharpness"] = FocusVerifier::toJson(check);
+    }
+    else
+    {
+        // The move itself succeeded, only the verification is missing
+        response_json["sharpness"] = nullptr;
+    }
+}
+
+void Server::handleGetSharpness(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Create a JSON object
+    json response_json;
+
+    try
+    {
+        int camera_id = params.camera_id;
+
+        if (focusVerifier_ == nullptr)
+        {
+            // Error message
+            response_json["error"] = "Focus verification is not active";
+            res.status = 500; // Internal Server Error
+        }
+        else
+        {
+            // "measure=true" scores the next frame, otherwise the last check is returned
+            FocusCheck check = params.getInt("measure") == 1 ? focusVerifier_->verify(camera_id, "request") : focusVerifier_->getLastCheck(camera_id);
+
+            if (check.valid)
+            {
+                // Success message
+                response_json = FocusVerifier::toJson(check);
+                response_json["message"] = "Successfully retrieved sharpness";
+                response_json["simd"] = SharpnessMeter::getSimdPath();
+                res.status = 200; // OK
+            }
+            else
+            {
+                // No frame was measured
+                response_json["error"] = "No sharpness measurement available";
+                res.status = 503; // Service Unavailable
+            }
+        }
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Get sharpness Route Error: {}", e.what());
+
+        // Error message
+        response_json["error"] = "Failed to retrieve sharpness";
+        res.status = 500; // Internal Server Error
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
+
+std::string Server::parseLiveViewParams(const RouteParams &params, int &rung, int &quality)
+{
+    // The route table checked the ranges, only the powers of two are left to check
+    rung = params.has("rung") ? static_cast<int>(params.getInt("rung")) : 1;
+    quality = params.has("quality") ? static_cast<int>(params.getInt("quality")) : LIVE_VIEW_DEFAULT_QUALITY;
+
+    if (!LiveViewScaler::isValidRung(rung))
+    {
+        return "The selected rung is not supported (1, 2, 4 or 8).";
+    }
+
+    return "";
+}
+
+void Server::handleGetLiveView(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Create a JSON object
+    json response_json;
+
+    try
+    {
+        int camera_id = params.camera_id;
+
+        int rung = 1;
+        int quality = LIVE_VIEW_DEFAULT_QUALITY;
+        std::string paramsError = parseLiveViewParams(params, rung, quality);
+
+        if (!paramsError.empty())
+        {
+            // Error message
+            response_json["error"] = paramsError;
+            res.status = 400; // Bad Request
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        if (liveView_ == nullptr || liveViewScaler_ == nullptr)
+        {
+            // Error message
+            response_json["error"] = "Live view is not active";
+            res.status = 500; // Internal Server Error
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        // Pulls a new frame if the live view was idle
+        LiveViewFramePtr frame = liveView_->getFreshFrame(camera_id, std::chrono::milliseconds(2000));
+
+        JpegBufferPtr jpeg = liveViewScaler_->getScaledFrame(camera_id, frame, rung, quality);
+
+        if (jpeg)
+        {
+            res.set_header("Cache-Control", "no-cache");
+            res.set_header("X-Frame-Sequence", std::to_string(frame->sequence));
+            res.status = 200; // OK
+
+            // Set the response content type to JPEG
+            res.set_content(reinterpret_cast<const char *>(jpeg->data()), jpeg->size(), "image/jpeg");
+            return;
+        }
+
+        // Error message
+        response_json["error"] = "No live-view frame available";
+        res.status = 503; // Service Unavailable
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Get live view Route Error: {}", e.what());
+
+        // Error message
+        response_json["error"] = "Failed to retrieve the live view";
+        res.status = 500; // Internal Server Error
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
+
+void Server::handleLiveViewStream(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Create a JSON object
+    json response_json;
+
+    try
+    {
+        int camera_id = params.camera_id;
+
+        int rung = 1;
+        int quality = LIVE_VIEW_DEFAULT_QUALITY;
+        std::string paramsError = parseLiveViewParams(params, rung, quality);
+
+        if (!paramsError.empty())
+        {
+            // Error message
+            response_json["error"] = paramsError;
+            res.status = 400; // Bad Request
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        if (liveView_ == nullptr || liveViewScaler_ == nullptr)
+        {
+            // Error message
+            response_json["error"] = "Live view is not active";
+            res.status = 500; // Internal Server Error
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        if (!openStream(req, res))
+        {
+            return;
+        }
+
+        spdlog::info("Live-view stream of camera {} opened (rung 1/{}, quality {})", camera_id, rung, quality);
+
+        res.set_header("Cache-Control", "no-cache");
+        res.status = 200; // OK
+
+        // The live view keeps pulling frames for as long as the stream is open
+        auto subscription = std::make_shared<LiveViewSubscription>(liveView_, camera_id);
+
+        // Each chunk is one multipart part; a viewer that falls behind skips frames instead of queuing them
+        auto lastSequence = std::make_shared<std::uint64_t>(0);
+        res.set_chunked_content_provider(
+            "multipart/x-mixed-replace; boundary=frame",
+            [this, camera_id, rung, quality, lastSequence, subscription](size_t /*offset*/, httplib::DataSink &sink)
+            {
+                if (stopRequested.load())
+                {
+                    sink.done();
+                    return true;
+                }
+
+                LiveViewFramePtr frame = liveView_->waitForFrame(camera_id, *lastSequence, std::chrono::milliseconds(1000));
+                if (!frame)
+                {
+                    // No new frame yet, check the connection and try again
+                    return sink.is_writable();
+                }
+                *lastSequence = frame->sequence;
+
+                JpegBufferPtr jpeg = liveViewScaler_->getScaledFrame(camera_id, frame, rung, quality);
+                if (!jpeg)
+                {
+                    return sink.is_writable();
+                }
+
+                std::string header = fmt::format("--frame\r\nContent-Type: image/jpeg\r\nContent-Length: {}\r\n\r\n", jpeg->size());
+                return sink.write(header.data(), header.size()) &&
+                       sink.write(reinterpret_cast<const char *>(jpeg->data()), jpeg->size()) &&
+                       sink.write("\r\n", 2);
+            },
+            [this, camera_id, subscription](bool /*success*/) mutable
+            {
+                subscription.reset();
+                closeStream();
+                spdlog::info("Live-view stream of camera {} closed", camera_id);
+            });
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Live view stream Route Error: {}", e.what());
+
+        // Error message
+        response_json["error"] = "Failed to open the live-view stream";
+        res.status = 500; // Internal Server Error
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
+
+void Server::handleGetLiveViewStats(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Create a JSON object
+    json response_json;
+
+    try
+    {
+        int camera_id = params.camera_id;
+
+        if (liveView_ == nullptr)
+        {
+            // Error message
+            response_json["error"] = "Live view is not active";
+            res.status = 500; // Internal Server Error
+        }
+        else
+        {
+            LiveViewStats stats = liveView_->getStats(camera_id);
+
+            // Success message
+            response_json["message"] = "Successfully retrieved live-view statistics";
+            response_json["viewers"] = stats.viewers;
+            response_json["pulling"] = stats.pulling;
+            response_json["pushed"] = stats.pushed;
+            response_json["pulls"] = stats.pulls;
+            response_json["updates"] = stats.updates;
+            response_json["not_updated"] = stats.notUpdated;
+            response_json["errors"] = stats.errors;
+            response_json["frame_interval_ms"] = stats.frameIntervalMs;
+            response_json["hit_rate"] = stats.pulls > 0 ? static_cast<double>(stats.updates) / stats.pulls : 0.0;
+            res.status = 200; // OK
+        }
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Get live-view stats Route Error: {}", e.what());
+
+        // Error message
+        response_json["error"] = "Failed to retrieve live-view statistics";
+        res.status = 500; // Internal Server Error
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
+
+void Server::handleRecording(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Create a JSON object
+    json response_json;
+
+    try
+    {
+        int camera_id = params.camera_id;
+
+        // Optional switch, without it the route only reports the state
+        bool switched = params.has("enable");
+
+        if (frameRecorder_ == nullptr)
+        {
+            // Error message
+            response_json["error"] = "Recording is not active";
+            res.status = 500; // Internal Server Error
+        }
+        else
+        {
+            if (switched)
+            {
+                frameRecorder_->setRecording(camera_id, params.getInt("enable") == 1);
+            }
+
+            RecordingStatus status = frameRecorder_->getStatus(camera_id);
+
+            // Success message
+            response_json["message"] = switched ? "Successfully set recording" : "Successfully retrieved recording state";
+            response_json["enabled"] = status.enabled;
+            response_json["segments"] = status.segments;
+            response_json["bytes"] = status.bytes;
+            response_json["frames_written"] = status.framesWritten;
+            response_json["frames_dropped"] = status.framesDropped;
+            response_json["last_timestamp_ms"] = status.lastTimestampMs;
+            res.status = 200; // OK
+        }
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Recording Route Error: {}", e.what());
+
+        // Error message
+        response_json["error"] = "Failed to handle the recording";
+        res.status = 500; // Internal Server Error
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
+
+void Server::handleReplay(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Create a JSON object
+    json response_json;
+
+    try
+    {
+        int camera_id = params.camera_id;
+
+        // Times are in milliseconds since the epoch, "to" defaults to now
+        std::int64_t from = params.getInt("from");
+        std::int64_t to = params.has("to") ? params.getInt("to") : std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        double speed = params.has("speed") ? params.getNumber("speed") : 1.0;
+
+        if (from > to)
+        {
+            // Handling invalid range
+            response_json["error"] = "Invalid range, expected from <= to.";
+            res.status = 400; // Bad Request
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        if (frameReplay_ == nullptr)
+        {
+            // Error message
+            response_json["error"] = "Replay is not active";
+            res.status = 500; // Internal Server Error
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        auto seekStart = std::chrono::steady_clock::now();
+        std::shared_ptr<ReplayCursor> cursor = frameReplay_->seek(camera_id, from, to);
+        double seekMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - seekStart).count();
+
+        std::size_t frameCount = cursor ? cursor->getFrameCount() : 0;
+        if (frameCount == 0)
+        {
+            // Nothing recorded in the range
+            response_json["error"] = "No recorded frames in the range";
+            res.status = 404; // Not Found
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        if (!openStream(req, res))
+        {
+            return;
+        }
+
+        spdlog::info("Replay of camera {} opened: {} frames, speed {}, seek {:.2f} ms", camera_id, frameCount, speed, seekMs);
+
+        res.set_header("Cache-Control", "no-cache");
+        res.set_header("X-Replay-Frames", std::to_string(frameCount));
+        res.set_header("X-Replay-Seek-Ms", fmt::format("{:.3f}", seekMs));
+        res.status = 200; // OK
+
+        // Pacing state: frames are due at their recorded spacing divided by the speed
+        struct ReplayPace
+        {
+            ReplayFrame frame;
+            bool pending = false;
+            bool started = false;
+            std::int64_t lastTimestampMs = 0;
+            std::chrono::steady_clock::time_point due;
+        };
+        auto pace = std::make_shared<ReplayPace>();
+
+        // Each chunk is one multipart part, the JPEG data is written straight from the mapped segment
+        res.set_chunked_content_provider(
+            "multipart/x-mixed-replace; boundary=frame",
+            [this, cursor, pace, speed](size_t /*offset*/, httplib::DataSink &sink)
+            {
+                if (stopRequested.load())
+                {
+                    sink.done();
+                    return true;
+                }
+
+                if (!pace->pending)
+                {
+                    if (!cursor->next(pace->frame))
+                    {
+                        sink.done();
+                        return true;
+                    }
+
+                    auto now = std::chrono::steady_clock::now();
+                    if (!pace->started)
+                    {
+                        pace->due = now;
+                        pace->started = true;
+                    }
+                    else
+                    {
+                        std::int64_t gap = std::min<std::int64_t>(std::max<std::int64_t>(pace->frame.timestampMs - pace->lastTimestampMs, 0), FRAME_REPLAY_MAX_GAP_MS);
+                        pace->due += std::chrono::microseconds(static_cast<long long>(gap * 1000.0 / speed));
+                    }
+                    pace->lastTimestampMs = pace->frame.timestampMs;
+                    pace->pending = true;
+                }
+
+                // Sleep in short steps so a closed connection or a stop request is noticed
+                auto wait = pace->due - std::chrono::steady_clock::now();
+                if (wait > std::chrono::milliseconds(100))
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                    return sink.is_writable();
+                }
+                if (wait > std::chrono::steady_clock::duration::zero())
+                {
+                    std::this_thread::sleep_for(wait);
+                }
+
+                pace->pending = false;
+                std::string header = fmt::format("--frame\r\nContent-Type: image/jpeg\r\nContent-Length: {}\r\nX-Timestamp: {}\r\n\r\n", pace->frame.size, pace->frame.timestampMs);
+                return sink.write(header.data(), header.size()) &&
+                       sink.write(reinterpret_cast<const char *>(pace->frame.data), pace->frame.size) &&
+                       sink.write("\r\n", 2);
+            },
+            [this, camera_id, cursor](bool /*success*/)
+            {
+                closeStream();
+                spdlog::info("Replay of camera {} closed", camera_id);
+            });
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Replay Route Error: {}", e.what());
+
+        // Error message
+        response_json["error"] = "Failed to open the replay";
+        res.status = 500; // Internal Server Error
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
+
+void Server::handleMonitoring(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Create a JSON object
+    json response_json;
+
+    try
+    {
+        int camera_id = params.camera_id;
+
+        // Optional switch, without it the route only reports the state
+        bool switched = params.has("enable");
+
+        // The camera may only be pointed at this server, never at another host
+        if (req.has_param("host") && !MonitoringReceiver::isLocalAddress(req.get_param_value("host")))
+        {
+            response_json["error"] = "Invalid host, expected an IPv4 address of this server.";
+            res.status = 400; // Bad Request
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        if (monitoringReceiver_ == nullptr)
+        {
+            // Error message
+            response_json["error"] = "Monitoring receiver is not active";
+            res.status = 500; // Internal Server Error
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        std::string error;
+        if (switched && params.getInt("enable") == 1)
+        {
+            // The camera delivers to the address the server listens on, unless told otherwise;
+            // protocol is the index of "tcp|udp"
+            std::string host = req.has_param("host") ? req.get_param_value("host") : host_;
+            error = monitoringReceiver_->enable(camera_id, host, params.getInt("loopback") == 1, params.getInt("protocol") == 1);
+        }
+        else if (switched)
+        {
+            monitoringReceiver_->disable(camera_id);
+        }
+
+        if (!error.empty())
+        {
+            // Error message
+            response_json["error"] = error;
+            res.status = 500; // Internal Server Error
+        }
+        else
+        {
+            MonitoringStatus status = monitoringReceiver_->getStatus(camera_id);
+
+            // Success message
+            response_json["message"] = switched ? "Successfully set monitoring" : "Successfully retrieved monitoring state";
+            response_json["enabled"] = status.enabled;
+            response_json["loopback"] = status.loopback;
+            response_json["receiving"] = status.receiving;
+            response_json["port"] = status.port;
+            response_json["frames"] = status.frames;
+            response_json["bytes"] = status.bytes;
+            response_json["discarded_bytes"] = status.discardedBytes;
+            response_json["tcp_connections"] = status.tcpConnections;
+            response_json["refused"] = status.refused;
+            res.status = 200; // OK
+        }
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Monitoring Route Error: {}", e.what());
+
+        // Error message
+        response_json["error"] = "Failed to handle the monitoring";
+        res.status = 500; // Internal Server Error
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
+
+void Server::handleGetContents(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Create a JSON object
+    json response_json;
+
+    try
+    {
+        int camera_id = params.camera_id;
+
+        long long offset = params.getInt("offset");
+        long long limit = params.has("limit") ? params.getInt("limit") : CONTENTS_CATALOG_DEFAULT_PAGE;
+
+        if (contentsCatalog_ == nullptr)
+        {
+            // Error message
+            response_json["error"] = "Contents catalog is not active";
+            res.status = 500; // Internal Server Error
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        // The page is served from the current snapshot, a requested refresh runs in the background
+        CatalogSnapshotPtr snapshot = contentsCatalog_->getSnapshot(camera_id);
+        if (!snapshot || params.getInt("refresh") == 1)
+        {
+            contentsCatalog_->requestSync(camera_id);
+        }
+        CatalogStatus status = contentsCatalog_->getStatus(camera_id);
+
+        if (!snapshot)
+        {
+            // The first sync walks the whole card
+            response_json["error"] = status.lastError.empty() ? "Contents catalog is being built, retry later" : status.lastError;
+            response_json["syncing"] = true;
+            res.set_header("Retry-After", "1");
+            res.status = 503; // Service Unavailable
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        // Positions of the requested folder, or of the whole catalog
+        const std::vector<std::uint32_t> *positions = nullptr;
+        std::size_t total = snapshot->entries.size();
+        if (params.has("folder"))
+        {
+            auto folder = snapshot->byFolder.find(static_cast<SCRSDK::CrFolderHandle>(params.getInt("folder")));
+            static const std::vector<std::uint32_t> none;
+            positions = folder != snapshot->byFolder.end() ? &folder->second : &none;
+            total = positions->size();
+        }
+
+        // order is the index of "asc|desc"
+        bool descending = params.getInt("order") == 1;
+        json items = json::array();
+        for (std::size_t i = static_cast<std::size_t>(offset); i < total && items.size() < static_cast<std::size_t>(limit); ++i)
+        {
+            std::size_t index = descending ? total - 1 - i : i;
+            const ContentEntry &entry = snapshot->entries[positions ? (*positions)[index] : index];
+
+            json item;
+            item["handle"] = entry.handle;
+            item["folder"] = entry.folder;
+            item["folder_name"] = entry.folderName;
+            item["file_name"] = entry.fileName;
+            item["capture_time"] = entry.captureTime;
+            item["size"] = entry.size;
+            item["width"] = entry.width;
+            item["height"] = entry.height;
+            items.push_back(item);
+        }
+
+        // The next page is likely viewed next, fetch its thumbnails ahead
+        if (thumbnailCache_ != nullptr)
+        {
+            std::vector<SCRSDK::CrContentHandle> next_page;
+            for (std::size_t i = static_cast<std::size_t>(offset + limit); i < total && next_page.size() < static_cast<std::size_t>(limit); ++i)
+            {
+                std::size_t index = descending ? total - 1 - i : i;
+                next_page.push_back(snapshot->entries[positions ? (*positions)[index] : index].handle);
+            }
+            thumbnailCache_->prefetch(camera_id, next_page);
+        }
+
+        // Success message
+        response_json["message"] = "Successfully retrieved contents";
+        response_json["total"] = total;
+        response_json["offset"] = offset;
+        response_json["limit"] = limit;
+        response_json["generation"] = snapshot->generation;
+        response_json["synced_at_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(status.syncedAt.time_since_epoch()).count();
+        response_json["syncing"] = status.syncing;
+        if (!status.lastError.empty())
+        {
+            response_json["sync_error"] = status.lastError;
+        }
+        response_json["items"] = items;
+        res.status = 200; // OK
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Get Contents Route Error: {}", e.what());
+
+        // Error message
+        response_json["error"] = "Failed to get the contents";
+        res.status = 500; // Internal Server Error
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
+
+void Server::handleGetThumbnail(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Create a JSON object
+    json response_json;
+
+    try
+    {
+        // The camera ID and content handle are part of the path: /cameras/{id}/contents/{handle}/thumb.jpg
+        int camera_id = params.camera_id;
+        SCRSDK::CrContentHandle handle = static_cast<SCRSDK::CrContentHandle>(params.getInt("handle"));
+
+        if (thumbnailCache_ == nullptr || contentsCatalog_ == nullptr)
+        {
+            // Error message
+            response_json["error"] = "Thumbnail cache is not active";
+            res.status = 500; // Internal Server Error
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        CatalogSnapshotPtr snapshot = contentsCatalog_->getSnapshot(camera_id);
+        if (!snapshot || snapshot->byHandle.count(handle) == 0)
+        {
+            // Handles are only known through the catalog
+            response_json["error"] = "Unknown content.";
+            res.status = 404; // Not Found
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        ThumbnailPtr thumbnail;
+        bool cached = false;
+        std::string error = thumbnailCache_->get(camera_id, handle, thumbnail, &cached);
+        if (!error.empty() || !thumbnail)
+        {
+            // Error message
+            response_json["error"] = error;
+            res.status = 500; // Internal Server Error
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        // The thumbnail of a content never changes
+        res.set_header("Cache-Control", "private, max-age=3600");
+        res.set_header("X-Cache", cached ? "hit" : "miss");
+        res.set_content(reinterpret_cast<const char *>(thumbnail->data->data()), thumbnail->data->size(), thumbnail->heif ? "image/heif" : "image/jpeg");
+        res.status = 200; // OK
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Get Thumbnail Route Error: {}", e.what());
+
+        // Error message
+        response_json["error"] = "Failed to get the thumbnail";
+        res.status = 500; // Internal Server Error
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
+
+void Server::handlePullContents(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Create a JSON object
+    json response_json;
+
+    try
+    {
+        ContentSelection selection;
+
+        // Without a camera the selection covers the whole rig (camera_id is -1)
+        selection.cameraNumber = params.camera_id;
+        selection.priority = static_cast<int>(params.getInt("priority"));
+        selection.from = req.get_param_value("from");
+        selection.to = req.get_param_value("to");
+        selection.hasFolder = params.has("folder");
+        if (selection.hasFolder)
+        {
+            selection.folder = static_cast<SCRSDK::CrFolderHandle>(params.getInt("folder"));
+        }
+
+        if (selection.hasFolder && selection.cameraNumber < 0)
+        {
+            // Handling invalid selection
+            response_json["error"] = "Invalid parameters, a folder needs a camera.";
+            res.status = 400; // Bad Request
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        if (contentTransfer_ == nullptr || contentsCatalog_ == nullptr)
+        {
+            // Error message
+            response_json["error"] = "Content transfer is not active";
+            res.status = 500; // Internal Server Error
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        // The selection is made from the catalogs, they have to be built first
+        int first = selection.cameraNumber < 0 ? 0 : selection.cameraNumber;
+        int last = selection.cameraNumber < 0 ? static_cast<int>(crsdkInterface_->cameraList.size()) - 1 : selection.cameraNumber;
+        for (int camera = first; camera <= last; ++camera)
+        {
+            if (!contentsCatalog_->getSnapshot(camera))
+            {
+                contentsCatalog_->requestSync(camera);
+                response_json["error"] = "Contents catalog is being built, retry later";
+                res.set_header("Retry-After", "1");
+                res.status = 503; // Service Unavailable
+
+                // Set the response content type to JSON
+                setJsonContent(req, res, response_json);
+                return;
+            }
+        }
+
+        std::uint64_t batch_id = 0;
+        std::string error = contentTransfer_->createBatch(selection, batch_id);
+        if (!error.empty())
+        {
+            // Error message
+            response_json["error"] = error;
+            res.status = 404; // Not Found
+        }
+        else
+        {
+            // Success message
+            response_json["message"] = "Successfully queued the contents";
+            response_json["batch"] = batch_id;
+            for (const auto &status : contentTransfer_->getStatus())
+            {
+                if (status.id == batch_id)
+                {
+                    response_json["items"] = status.items;
+                    response_json["bytes"] = status.bytes;
+                }
+            }
+            res.status = 200; // OK
+        }
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+    catch (const std::exception &e)
+    {
+        // Handle the exception and generate an error message
+        spdlog::error("Pull Contents Route Error: {}", e.what());
+
+        // Error message
+        response_json["error"] = "Failed to pull the contents";
+        res.status = 500; // Internal Server Error
+
+        // Set the response content type to JSON
+        setJsonContent(req, res, response_json);
+    }
+}
+
+void Server::handleGetTransfers(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
+{
+    // Create a JSON object
+    json response_json;
+
+    try
+    {
+        if (contentTransfer_ == nullptr)
+        {
+            // Error message
+            response_json["error"] = "Content transfer is not active";
+            res.status = 500; // Internal Server Error
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        // Batches are numbered from 1, 0 lists them all
+        std::uint64_t batch_id = static_cast<std::uint64_t>(params.getInt("batch"));
+
+        if (params.getInt("cancel") == 1)
+        {
+            if (batch_id == 0 || !contentTransfer_->cancelBatch(batch_id))
             {
-                // Error message
-                response_json["error"] = "Failed to retrieve camera brightness";
-                res.status = 500; // Internal Server Error
-            }           
+                response_json["error"] = "Unknown batch.";
+                res.status = 404; // Not Found
+
+                // Set the response content type to JSON
+                setJsonContent(req, res, response_json);
+                return;
+            }
         }
-        else
+
+        json batches = json::array();
+        for (const auto &status : contentTransfer_->getStatus())
         {
-            response_json["error"] = "Rate limit exceeded";
-            res.status = 429; // HTTP 429 Too Many Requests
+            if (batch_id != 0 && status.id != batch_id)
+            {
+                continue;
+            }
+
+            json batch;
+            batch["batch"] = status.id;
+            batch["priority"] = status.priority;
+            batch["resumed"] = status.resumed;
+            batch["items"] = status.items;
+            batch["queued"] = status.queued;
+            batch["running"] = status.running;
+            batch["done"] = status.done;
+            batch["failed"] = status.failed;
+            batch["canceled"] = status.canceled;
+            batch["bytes"] = status.bytes;
+            batch["done_bytes"] = status.doneBytes;
+            batch["bytes_per_second"] = status.bytesPerSecond;
+            batches.push_back(batch);
         }
 
+        // Success message
+        response_json["message"] = "Successfully retrieved transfers";
+        response_json["batches"] = batches;
+        response_json["running_per_camera"] = contentTransfer_->getRunning();
+        res.status = 200; // OK
+
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
     catch (const std::exception &e)
     {
         // Handle the exception and generate an error message
-        spdlog::error("Get camera brightness Route Error: {}", e.what());
+        spdlog::error("Get Transfers Route Error: {}", e.what());
 
         // Error message
-        response_json["error"] = "Failed to retrieve camera brightness";
+        response_json["error"] = "Failed to get the transfers";
         res.status = 500; // Internal Server Error
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
 }
 
-void Server::handleDownloadCameraSetting(const httplib::Request &req, httplib::Response &res)
+void Server::handleListMedia(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
 {
     // Create a JSON object
     json response_json;
 
     try
     {
-        // Enable CORS
-        res.set_header("Access-Control-Allow-Origin", "*"); // You might want to restrict this in production
+        int camera_id = params.camera_id;
 
-        if (consumeToken())
+        if (mediaLibrary_ == nullptr)
         {
-            // Check if the query parameter 'camera_id' is present
-            auto camera_id_param = req.get_param_value("camera_id");
-
-            if (camera_id_param.empty())
-            {
-                // Handle missing camera_id.
-                response_json["error"] = "Missing camera_id parameter.";
-                res.status = 400; // Bad Request.
-
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
-
-            int camera_id = std::stoi(camera_id_param);
-
-            // Use the macro to get the reversed index
-            camera_id = REVERSE_INDEX(camera_id);
-
-            if (camera_id < 0 || camera_id >= crsdkInterface_->cameraList.size())
-            {
-                // Handling camera_id out of range
-                response_json["error"] = "Camera_id out of range.";
-                res.status = 400; // Bad Request
-
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
+            // Error message
+            response_json["error"] = "Media library is not active";
+            res.status = 500; // Internal Server Error
 
-            // Download camera setting logic...
-            bool success = crsdkInterface_->downloadCameraSetting(camera_id);
-
-            if (success)
-            {
-                // Success message
-                response_json["message"] = "Successfully download camera setting";
-                res.status = 200; // OK
-            }
-            else
-            {
-                // Error message
-                response_json["error"] = "Failed to download camera setting";
-                res.status = 500; // Internal Server Error
-            }            
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
         }
-        else
+
+        json files = json::array();
+        for (const auto &file : mediaLibrary_->list(camera_id))
         {
-            response_json["error"] = "Rate limit exceeded";
-            res.status = 429; // HTTP 429 Too Many Requests
+            json item;
+            item["path"] = file.relativePath;
+            item["size"] = file.size;
+            item["modified"] = static_cast<std::int64_t>(file.modified);
+            files.push_back(item);
         }
 
-        // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        response_json["message"] = "Successfully retrieved media";
+        response_json["files"] = files;
+        setJsonContent(req, res, response_json);
+        res.status = 200; // OK
     }
     catch (const std::exception &e)
     {
         // Handle the exception and generate an error message
-        spdlog::error("Download camera setting Route Error: {}", e.what());
+        spdlog::error("List Media Route Error: {}", e.what());
 
         // Error message
-        response_json["error"] = "Failed to download camera setting";
+        response_json["error"] = "Failed to list the media";
         res.status = 500; // Internal Server Error
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
 }
 
-void Server::handleUploadCameraSetting(const httplib::Request &req, httplib::Response &res)
+void Server::handleGetMedia(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
 {
     // Create a JSON object
     json response_json;
 
     try
     {
-        // Enable CORS
-        res.set_header("Access-Control-Allow-Origin", "*"); // You might want to restrict this in production
+        int camera_id = params.camera_id;
 
-        if (consumeToken())
+        // The file is part of the path: /cameras/{id}/media/{path}
+        std::string relative_path = req.matches[2].str();
+
+        if (mediaLibrary_ == nullptr)
         {
-            // Check if the query parameter 'camera_id' is present
-            auto camera_id_param = req.get_param_value("camera_id");
+            // Error message
+            response_json["error"] = "Media library is not active";
+            res.status = 500; // Internal Server Error
 
-            if (camera_id_param.empty())
-            {
-                // Handle missing camera_id.
-                response_json["error"] = "Missing camera_id parameter.";
-                res.status = 400; // Bad Request.
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
 
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
+        MediaFile file;
+        if (!mediaLibrary_->find(camera_id, relative_path, file))
+        {
+            // Missing, or outside the camera directory
+            response_json["error"] = "Unknown file.";
+            res.status = 404; // Not Found
 
-            int camera_id = std::stoi(camera_id_param);
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
 
-            // Use the macro to get the reversed index
-            camera_id = REVERSE_INDEX(camera_id);
+        // A stale If-Range sends the whole file instead of the range
+        std::uint64_t offset = 0;
+        std::uint64_t length = file.size;
+        MediaRange range = MediaRange::Full;
+        if (req.has_header("Range") && MediaLibrary::matchesIfRange(req.get_header_value("If-Range"), file))
+        {
+            range = MediaLibrary::parseRange(req.get_header_value("Range"), file.size, offset, length);
+        }
 
-            if (camera_id < 0 || camera_id >= crsdkInterface_->cameraList.size())
-            {
-                // Handling camera_id out of range
-                response_json["error"] = "Camera_id out of range.";
-                res.status = 400; // Bad Request
+        res.set_header("Accept-Ranges", "bytes");
+        res.set_header("ETag", file.etag);
+        res.set_header("Last-Modified", file.lastModified);
 
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
+        if (range == MediaRange::Unsatisfiable)
+        {
+            // Error message
+            response_json["error"] = "Range not satisfiable.";
+            res.set_header("Content-Range", fmt::format("bytes */{}", file.size));
+            res.status = 416; // Range Not Satisfiable
+
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
 
-            // upload camera setting logic...
-            bool success = crsdkInterface_->uploadCameraSetting(camera_id);
+        std::shared_ptr<MediaReader> reader = MediaReader::open(file.path);
+        if (!reader)
+        {
+            // Error message
+            response_json["error"] = "Failed to open the file";
+            res.status = 500; // Internal Server Error
 
-            if (success)
-            {
-                // Success message
-                response_json["message"] = "Successfully upload camera setting";
-                res.status = 200; // OK
-            }
-            else
-            {
-                // Error message
-                response_json["error"] = "Failed to upload camera setting";
-                res.status = 500; // Internal Server Error
-            }           
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
+
+        // Nothing below returns before the provider is set, its releaser closes the stream
+        if (!openStream(req, res))
+        {
+            return;
+        }
+
+        if (range == MediaRange::Partial)
+        {
+            res.set_header("Content-Range", fmt::format("bytes {}-{}/{}", offset, offset + length - 1, file.size));
+            res.status = 206; // Partial Content
         }
         else
         {
-            response_json["error"] = "Rate limit exceeded";
-            res.status = 429; // HTTP 429 Too Many Requests
+            res.status = 200; // OK
         }
 
-        // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        std::string extension = fs::path(file.path).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        std::string content_type = "application/octet-stream";
+        if (extension == ".jpg" || extension == ".jpeg")
+        {
+            content_type = "image/jpeg";
+        }
+        else if (extension == ".hif" || extension == ".heif")
+        {
+            content_type = "image/heif";
+        }
+        else if (extension == ".mp4")
+        {
+            content_type = "video/mp4";
+        }
+        else if (extension == ".xml")
+        {
+            content_type = "application/xml";
+        }
+
+        res.set_header("Content-Disposition", fmt::format("inline; filename=\"{}\"", fs::path(file.path).filename().string()));
+
+        // The range is applied here, a chunked provider keeps httplib from applying it again.
+        // One chunk is read at a time into the reader's buffer, whatever the size of the file.
+        std::uint64_t end = offset + length;
+        res.set_chunked_content_provider(
+            content_type,
+            [this, reader, offset, end](size_t sent, httplib::DataSink &sink)
+            {
+                std::uint64_t position = offset + sent;
+                if (stopRequested.load() || position >= end)
+                {
+                    sink.done();
+                    return true;
+                }
+
+                std::size_t size = 0;
+                const char *data = reader->read(position, static_cast<std::size_t>(std::min<std::uint64_t>(end - position, MEDIA_READ_CHUNK_BYTES)), size);
+                if (data == nullptr || size == 0)
+                {
+                    // Truncated or unreadable, drop the connection
+                    return false;
+                }
+
+                return sink.write(data, size);
+            },
+            [this](bool /*success*/)
+            {
+                closeStream();
+            });
     }
     catch (const std::exception &e)
     {
         // Handle the exception and generate an error message
-        spdlog::error("Upload camera setting Route Error: {}", e.what());
+        spdlog::error("Get Media Route Error: {}", e.what());
 
         // Error message
-        response_json["error"] = "Failed to upload camera setting";
+        response_json["error"] = "Failed to get the media";
         res.status = 500; // Internal Server Error
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
 }
 
-void Server::handleGetFnumber(const httplib::Request &req, httplib::Response &res)
+void Server::handleWaitForState(const httplib::Request &req, httplib::Response &res, const RouteParams &params)
 {
     // Create a JSON object
     json response_json;
 
     try
     {
-        // Enable CORS
-        res.set_header("Access-Control-Allow-Origin", "*"); // You might want to restrict this in production
+        int camera_id = params.camera_id;
 
-        if (consumeToken())
+        // The expected state, at least one property; brightness and timeout are range checked by the route table
+        CameraStateTarget target;
+        std::int64_t timeoutMs = params.has("timeout") ? params.getInt("timeout") : STATE_WAIT_DEFAULT_TIMEOUT_MS;
+        std::string error;
+        if (req.has_param("mode"))
         {
-            // Check if the query parameter 'camera_id' is present
-            auto camera_id_param = req.get_param_value("camera_id");
-
-            if (camera_id_param.empty())
+            target.hasMode = true;
+            target.mode = req.get_param_value("mode");
+            std::transform(target.mode.begin(), target.mode.end(), target.mode.begin(), ::tolower);
+            if (target.mode != "p" && target.mode != "m")
             {
-                // Handle missing camera_id.
-                response_json["error"] = "Missing camera_id parameter.";
-                res.status = 400; // Bad Request.
-
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
+                error = "Invalid mode, expected p or m.";
             }
-
-            int camera_id = std::stoi(camera_id_param);
-
-            // Use the macro to get the reversed index
-            camera_id = REVERSE_INDEX(camera_id);
-
-            if (camera_id < 0 || camera_id >= crsdkInterface_->cameraList.size())
+        }
+        if (params.has("brightness"))
+        {
+            target.hasBrightness = true;
+            target.brightness = static_cast<int>(params.getInt("brightness"));
+        }
+        if (req.has_param("f_number"))
+        {
+            target.hasFnumber = true;
+            target.fnumber = StateWaiter::normalizeFnumber(req.get_param_value("f_number"));
+            if (target.fnumber.empty())
             {
-                // Handling camera_id out of range
-                response_json["error"] = "Camera_id out of range.";
-                res.status = 400; // Bad Request
-
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
+                error = "Invalid f_number.";
             }
+        }
+        if (error.empty() && target.empty())
+        {
+            error = "Missing mode, brightness or f_number.";
+        }
 
-            // Get F-number setting logic...
-            std::string Fnumber = crsdkInterface_->getFnumber(camera_id);
-
-            if (!Fnumber.empty())
+        if (!error.empty())
+        {
+            response_json["error"] = error;
+            res.status = 400; // Bad Request
+        }
+        else if (stateWaiter_ == nullptr)
+        {
+            // Error message
+            response_json["error"] = "State waits are not active";
+            res.status = 500; // Internal Server Error
+        }
+        else
+        {
+            // Parked until the camera reports the state or the timeout
+            auto start = std::chrono::steady_clock::now();
+            CameraState state;
+            bool matched = stateWaiter_->wait(camera_id, target, Deadline::after(std::chrono::milliseconds(timeoutMs)), state);
+
+            response_json["matched"] = matched;
+            response_json["waited_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+            if (target.hasMode)
             {
-                // Success message
-                response_json["message"] = "Geting the index of the f-number was successful";
-                response_json["f-number"] = Fnumber;
-                res.status = 200; // OK
+                response_json["mode"] = state.mode;
             }
-            else
+            if (target.hasBrightness)
             {
-                // Error message
-                response_json["error"] = "Failed to geting the index of the f-number";
-                res.status = 500; // Internal Server Error
+                response_json["brightness"] = state.brightness;
             }
+            if (target.hasFnumber)
+            {
+                response_json["f-number"] = state.fnumber;
+            }
+            response_json["message"] = matched ? "The camera reached the state" : "Timed out before the camera reached the state";
+            res.status = 200; // OK
         }
-        else
-        {
-            response_json["error"] = "Rate limit exceeded";
-            res.status = 429; // HTTP 429 Too Many Requests
-        }
-        
+
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
     catch (const std::exception &e)
     {
         // Handle the exception and generate an error message
-        spdlog::error("Get F-number Route Error: {}", e.what());
+        spdlog::error("Wait For State Route Error: {}", e.what());
 
         // Error message
-        response_json["error"] = "Failed to geting the index of the f-number";
+        response_json["error"] = "Failed to wait for the camera state";
         res.status = 500; // Internal Server Error
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
 }
 
-void Server::handleSetFnumber(const httplib::Request &req, httplib::Response &res)
+void Server::handleEvents(const httplib::Request &req, httplib::Response &res)
 {
     // Create a JSON object
     json response_json;
@@ -1270,144 +3204,154 @@ void Server::handleSetFnumber(const httplib::Request &req, httplib::Response &re
         // Enable CORS
         res.set_header("Access-Control-Allow-Origin", "*"); // You might want to restrict this in production
 
-        if (consumeToken())
+        if (eventStream_ == nullptr)
         {
-            // Check if the query parameter 'camera_id' is present
-            auto camera_id_param = req.get_param_value("camera_id");
-
-            if (camera_id_param.empty())
-            {
-                // Handle missing camera_id.
-                response_json["error"] = "Missing camera_id parameter.";
-                res.status = 400; // Bad Request.
+            // Error message
+            response_json["error"] = "Event stream is not active";
+            res.status = 500; // Internal Server Error
 
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
-            }
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
 
-            int camera_id = std::stoi(camera_id_param);
+        if (!consumeToken())
+        {
+            response_json["error"] = "Rate limit exceeded";
+            res.status = 429; // HTTP 429 Too Many Requests
 
-            // Use the macro to get the reversed index
-            camera_id = REVERSE_INDEX(camera_id);
+            // Set the response content type to JSON
+            setJsonContent(req, res, response_json);
+            return;
+        }
 
-            if (camera_id < 0 || camera_id >= crsdkInterface_->cameraList.size())
+        // Optional comma separated filter, e.g. /events?types=histogram
+        std::vector<std::string> types;
+        std::stringstream typesStream(req.get_param_value("types"));
+        std::string type;
+        while (std::getline(typesStream, type, ','))
+        {
+            if (!type.empty())
             {
-                // Handling camera_id out of range
-                response_json["error"] = "Camera_id out of range.";
-                res.status = 400; // Bad Request
-
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
+                types.push_back(type);
             }
+        }
 
-            // Check if the query parameters F-number value are present.
-            auto f_number_value_param = req.get_param_value("f_number_value");
+        if (!openStream(req, res))
+        {
+            return;
+        }
 
-            if (f_number_value_param.empty())
-            {
-                // Handle missing parameters
-                response_json["error"] = "Missing required parameters.";
-                res.status = 400; // Bad Request
+        int subscriberId = eventStream_->subscribe(types);
 
-                // Set the response content type to JSON
-                res.set_content(response_json.dump(), "application/json");
-                return;
+        // Histogram events need live-view frames, keep them flowing while the stream is open
+        auto subscriptions = std::make_shared<std::vector<std::unique_ptr<LiveViewSubscription>>>();
+        if (liveView_ != nullptr && (types.empty() || std::find(types.begin(), types.end(), "histogram") != types.end()))
+        {
+            for (int i = 0; i < liveView_->getCameraCount(); ++i)
+            {
+                subscriptions->emplace_back(new LiveViewSubscription(liveView_, i));
             }
+        }
 
-            // Convert the parameters to numbers.
-            int fNumberValue = std::stoi(f_number_value_param);
+        // Binary clients get a sequence of {"id", "event", "data"} documents instead of SSE
+        ResponseEncoding encoding = ResponseEncoder::negotiate(req.get_header_value("Accept"));
 
-            // Treatment in case the F-number value entered is incorrect.
-            if (fNumberValue < 0 || fNumberValue > 21)
-            {
-                // Error message
-                response_json["error"] = "the F-number value entered is incorrect.";
-                res.status = 405; // Method not allowed.
-            }
-            else
+        res.set_header("Cache-Control", "no-cache");
+        res.set_header("Vary", "Accept");
+        res.status = 200; // OK
+
+        // The connection stays open, every chunk carries the events queued since the last one
+        res.set_chunked_content_provider(
+            encoding == ResponseEncoding::Json ? "text/event-stream" : ResponseEncoder::sequenceContentType(encoding),
+            [this, subscriberId, encoding](size_t /*offset*/, httplib::DataSink &sink)
             {
-                // change the F-number value logic...
-                bool success = crsdkInterface_->setFnumber(camera_id, fNumberValue);
+                std::vector<StreamEvent> events;
+                if (stopRequested.load() || !eventStream_->waitForEvents(subscriberId, events, std::chrono::milliseconds(EVENT_STREAM_HEARTBEAT_MS)))
+                {
+                    sink.done();
+                    return true;
+                }
 
-                if (success)
+                std::string chunk;
+                if (encoding != ResponseEncoding::Json)
+                {
+                    if (events.empty())
+                    {
+                        // Keeps proxies and idle timeouts from closing the stream
+                        ResponseEncoder::encode(json{{"event", "heartbeat"}}, encoding, chunk);
+                    }
+                    for (const StreamEvent &event : events)
+                    {
+                        ResponseEncoder::encode(json{{"id", event.id}, {"event", event.type}, {"data", event.data}}, encoding, chunk);
+                    }
+                }
+                else if (events.empty())
                 {
-                    // Success message
-                    response_json["message"] = "Changing the index of the f-number was successful";
-                    res.status = 200; // OK
+                    // SSE comment line, keeps proxies and idle timeouts from closing the stream
+                    chunk = ": heartbeat\n\n";
                 }
                 else
                 {
-                    // Error message
-                    response_json["error"] = "Failed to change the index of the f-number";
-                    res.status = 500; // Internal Server Error
+                    for (const StreamEvent &event : events)
+                    {
+                        chunk += EventStream::formatSse(event);
+                    }
                 }
-            }           
-        }
-        else
-        {
-            response_json["error"] = "Rate limit exceeded";
-            res.status = 429; // HTTP 429 Too Many Requests
-        }
 
-        // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+                // Returning false closes the connection when the client went away
+                return sink.is_writable() && sink.write(chunk.data(), chunk.size());
+            },
+            [this, subscriberId, subscriptions](bool /*success*/)
+            {
+                subscriptions->clear();
+                eventStream_->unsubscribe(subscriberId);
+                closeStream();
+            });
     }
     catch (const std::exception &e)
     {
         // Handle the exception and generate an error message
-        spdlog::error("Set F-number Route Error: {}", e.what());
+        spdlog::error("Events Route Error: {}", e.what());
 
         // Error message
-        response_json["error"] = "Failed to seting the index of the f-number";
+        response_json["error"] = "Failed to open the event stream";
         res.status = 500; // Internal Server Error
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
 }
 
-void Server::handleStartCameras(const httplib::Request &req, httplib::Response &res)
+void Server::handleStartCameras(const httplib::Request &req, httplib::Response &res, const RouteParams &)
 {
     // Create a JSON object
     json response_json;
 
     try
     {
-        // Enable CORS
-        res.set_header("Access-Control-Allow-Origin", "*"); // You might want to restrict this in production
-
-        if (consumeToken())
+        if (gpioPin != nullptr)
         {
-            if (gpioPin != nullptr)
+            bool success = gpioPin->pinOff();
+            if (success)
             {
-                bool success = gpioPin->pinOff();
-                if (success)
-                {
-                    response_json["message"] = "The cameras started successfully";
-                    res.status = 200; // OK
-                }
-                else
-                {
-                    response_json["error"] = "Failed to start cameras";
-                    res.status = 500; // Internal Server Error
-                }
+                response_json["message"] = "The cameras started successfully";
+                res.status = 200; // OK
             }
             else
             {
-                response_json["error"] = "Failed to start cameras, gpio is not active";
+                response_json["error"] = "Failed to start cameras";
                 res.status = 500; // Internal Server Error
-            }            
+            }
         }
         else
         {
-            response_json["error"] = "Rate limit exceeded";
-            res.status = 429; // HTTP 429 Too Many Requests
+            response_json["error"] = "Failed to start cameras, gpio is not active";
+            res.status = 500; // Internal Server Error
         }
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
     catch (const std::exception &e)
     {
@@ -1419,50 +3363,39 @@ void Server::handleStartCameras(const httplib::Request &req, httplib::Response &
         res.status = 500; // Internal Server Error
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
 }
 
-void Server::handleStopCameras(const httplib::Request &req, httplib::Response &res)
+void Server::handleStopCameras(const httplib::Request &req, httplib::Response &res, const RouteParams &)
 {
     // Create a JSON object
     json response_json;
 
     try
     {
-        // Enable CORS
-        res.set_header("Access-Control-Allow-Origin", "*"); // You might want to restrict this in production
-
-        if (consumeToken())
+        if (gpioPin != nullptr)
         {
-            if (gpioPin != nullptr)
+            bool success = gpioPin->pinOn();
+            if (success)
             {
-                bool success = gpioPin->pinOn();
-                if (success)
-                {
-                    response_json["message"] = "Stopping the cameras was successful.";
-                    res.status = 200; // OK
-                }
-                else
-                {
-                    response_json["error"] = "Stopping the cameras failed.";
-                    res.status = 500; // Internal Server Error
-                }
+                response_json["message"] = "Stopping the cameras was successful.";
+                res.status = 200; // OK
             }
             else
             {
-                response_json["error"] = "Stopping the cameras failed, gpio is not active";
+                response_json["error"] = "Stopping the cameras failed.";
                 res.status = 500; // Internal Server Error
-            }            
+            }
         }
         else
         {
-            response_json["error"] = "Rate limit exceeded";
-            res.status = 429; // HTTP 429 Too Many Requests
+            response_json["error"] = "Stopping the cameras failed, gpio is not active";
+            res.status = 500; // Internal Server Error
         }
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
     catch (const std::exception &e)
     {
@@ -1474,50 +3407,39 @@ void Server::handleStopCameras(const httplib::Request &req, httplib::Response &r
         res.status = 500; // Internal Server Error
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
 }
 
-void Server::handleRestatCameras(const httplib::Request &req, httplib::Response &res)
+void Server::handleRestatCameras(const httplib::Request &req, httplib::Response &res, const RouteParams &)
 {
     // Create a JSON object
     json response_json;
 
     try
     {
-        // Enable CORS
-        res.set_header("Access-Control-Allow-Origin", "*"); // You might want to restrict this in production
-
-        if (consumeToken())
+        if (gpioPin != nullptr)
         {
-            if (gpioPin != nullptr)
+            bool success = gpioPin->restat();
+            if (success)
             {
-                bool success = gpioPin->restat();
-                if (success)
-                {
-                    response_json["message"] = "Restarting the cameras was successful.";
-                    res.status = 200; // OK
-                }
-                else
-                {
-                    response_json["error"] = "Restarting the cameras failed.";
-                    res.status = 500; // Internal Server Error
-                }
+                response_json["message"] = "Restarting the cameras was successful.";
+                res.status = 200; // OK
             }
             else
             {
-                response_json["error"] = "Restarting the cameras failed, gpio is not active.";
+                response_json["error"] = "Restarting the cameras failed.";
                 res.status = 500; // Internal Server Error
-            }           
+            }
         }
         else
         {
-            response_json["error"] = "Rate limit exceeded";
-            res.status = 429; // HTTP 429 Too Many Requests
+            response_json["error"] = "Restarting the cameras failed, gpio is not active.";
+            res.status = 500; // Internal Server Error
         }
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
     catch (const std::exception &e)
     {
@@ -1529,20 +3451,17 @@ void Server::handleRestatCameras(const httplib::Request &req, httplib::Response
         res.status = 500; // Internal Server Error
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
 }
 
-void Server::handleExit(const httplib::Request &req, httplib::Response &res)
+void Server::handleExit(const httplib::Request &req, httplib::Response &res, const RouteParams &)
 {
     // Create a JSON object
     json response_json;
 
     try
     {
-        // Enable CORS
-        res.set_header("Access-Control-Allow-Origin", "*"); // You might want to restrict this in production
-
         spdlog::info("Program stopped...");
         stopRequested.store(true);
 
@@ -1551,7 +3470,7 @@ void Server::handleExit(const httplib::Request &req, httplib::Response &res)
         res.status = 200; // OK
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
     catch (const std::exception &e)
     {
@@ -1563,6 +3482,6 @@ void Server::handleExit(const httplib::Request &req, httplib::Response &res)
         res.status = 500; // Internal Server Error
 
         // Set the response content type to JSON
-        res.set_content(response_json.dump(), "application/json");
+        setJsonContent(req, res, response_json);
     }
 }
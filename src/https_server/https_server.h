@@ -16,6 +16,8 @@
 #include <mutex>
 #include <sstream>
 #include <vector>
+#include <deque>
+#include <functional>
 #include <unistd.h>
 #include <thread>
 #include <atomic>
@@ -29,17 +31,37 @@
 #include <cstring>
 
 #include "../CrSDK_interface/CrSDK_interface.h"
+#include "../camera_index/camera_index.h"
 #include "../gpioPin/gpioPin.h"
+#include "../live_view/live_view.h"
+#include "../auto_brightness/auto_brightness.h"
+#include "../event_stream/event_stream.h"
+#include "../ImageAnalysis/frame_analyzer/frame_analyzer.h"
+#include "../ImageAnalysis/focus_verifier/focus_verifier.h"
+#include "../live_view_scaler/live_view_scaler.h"
+#include "../frame_recorder/frame_recorder.h"
+#include "../frame_replay/frame_replay.h"
+#include "../monitoring_receiver/monitoring_receiver.h"
+#include "../contents_catalog/contents_catalog.h"
+#include "../content_transfer/content_transfer.h"
+#include "../thumbnail_cache/thumbnail_cache.h"
+#include "../media_library/media_library.h"
+#include "../settings_cache/settings_cache.h"
+#include "../response_encoding/response_encoding.h"
+#include "../response_encoding/json_writer.h"
+#include "../route_table/route_table.h"
+#include "../worker_pool/worker_pool.h"
+#include "../camera_scheduler/camera_scheduler.h"
+#include "../request_coalescer/request_coalescer.h"
+#include "../state_waiter/state_waiter.h"
+#include "../tls_context/tls_context.h"
 
 using json = nlohmann::json;
 
 #define BLACK_THRESHOLD 10.0
 
-// Macro to reverse the index
-#define REVERSE_INDEX(index) ((index) == 0 ? 1 : 0)
-
-// Macro to keep the index the same
-#define NORMAL_INDEX(index) (index)
+#define FRAME_TOKENS_PER_REFILL 30      // Live-view frames and histograms served per refill (1 s), all clients together
+#define CATALOG_TOKENS_PER_REFILL 120   // Contents pages, thumbnails and media reads served per refill (1 s), all clients together
 
 /**
  * @class Server
@@ -83,6 +105,116 @@ public:
     */
     void setGpioPin(GpioPin *gpioPin);
 
+    /**
+     * Sets the LiveView object associated with the server.
+     * @param liveView A pointer to the LiveView object providing the live-view frames.
+    */
+    void setLiveView(LiveView *liveView);
+
+    /**
+     * Sets the AutoBrightnessController object associated with the server.
+     * @param autoBrightness A pointer to the AutoBrightnessController object.
+    */
+    void setAutoBrightnessController(AutoBrightnessController *autoBrightness);
+
+    /**
+     * Sets the EventStream object served on the "/events" route.
+     * @param eventStream A pointer to the EventStream object.
+    */
+    void setEventStream(EventStream *eventStream);
+
+    /**
+     * Sets the FrameAnalyzer object providing the live-view luminance statistics.
+     * @param frameAnalyzer A pointer to the FrameAnalyzer object.
+    */
+    void setFrameAnalyzer(FrameAnalyzer *frameAnalyzer);
+
+    /**
+     * Sets the FocusVerifier object scoring the sharpness after focus moves.
+     * @param focusVerifier A pointer to the FocusVerifier object.
+    */
+    void setFocusVerifier(FocusVerifier *focusVerifier);
+
+    /**
+     * Sets the LiveViewScaler object serving the reduced size live-view rungs.
+     * @param liveViewScaler A pointer to the LiveViewScaler object.
+    */
+    void setLiveViewScaler(LiveViewScaler *liveViewScaler);
+
+    /**
+     * Sets the FrameRecorder object recording the live-view frames to disk.
+     * @param frameRecorder A pointer to the FrameRecorder object.
+    */
+    void setFrameRecorder(FrameRecorder *frameRecorder);
+
+    /**
+     * Sets the FrameReplay object serving the recorded live-view frames.
+     * @param frameReplay A pointer to the FrameReplay object.
+    */
+    void setFrameReplay(FrameReplay *frameReplay);
+
+    /**
+     * Sets the MonitoringReceiver object receiving the frames pushed by the cameras.
+     * @param monitoringReceiver A pointer to the MonitoringReceiver object.
+    */
+    void setMonitoringReceiver(MonitoringReceiver *monitoringReceiver);
+
+    /**
+     * Sets the ContentsCatalog object indexing the contents of the cameras.
+     * @param contentsCatalog A pointer to the ContentsCatalog object.
+    */
+    void setContentsCatalog(ContentsCatalog *contentsCatalog);
+
+    /**
+     * Sets the ContentTransfer object pulling the contents of the cameras.
+     * @param contentTransfer A pointer to the ContentTransfer object.
+    */
+    void setContentTransfer(ContentTransfer *contentTransfer);
+
+    /**
+     * Sets the ThumbnailCache object serving the thumbnails of the contents.
+     * @param thumbnailCache A pointer to the ThumbnailCache object.
+    */
+    void setThumbnailCache(ThumbnailCache *thumbnailCache);
+
+    /**
+     * Sets the MediaLibrary object serving the pulled contents.
+     * @param mediaLibrary A pointer to the MediaLibrary object.
+    */
+    void setMediaLibrary(MediaLibrary *mediaLibrary);
+
+    /**
+     * Sets the SettingsCache object keeping the camera-settings files.
+     * @param settingsCache A pointer to the SettingsCache object.
+    */
+    void setSettingsCache(SettingsCache *settingsCache);
+
+    /**
+     * Sets the CameraScheduler object queuing the commands of each camera.
+     * @param cameraScheduler A pointer to the CameraScheduler object.
+    */
+    void setCameraScheduler(CameraScheduler *cameraScheduler);
+
+    /**
+     * Sets the StateWaiter object answering the requests waiting for a camera state.
+     * @param stateWaiter A pointer to the StateWaiter object.
+    */
+    void setStateWaiter(StateWaiter *stateWaiter);
+
+    /**
+     * Sets the time a client may resume its TLS session instead of a full handshake.
+     * @param lifetimeSeconds The lifetime of the sessions and tickets.
+     * @param tickets True to issue session tickets as well as caching the sessions.
+    */
+    void setTlsSessions(long lifetimeSeconds, bool tickets = true);
+
+    /**
+     * Sets how long connections are kept open between requests.
+     * @param maxRequests The requests served on a connection before it is closed.
+     * @param idleSeconds The idle time after which a connection is closed.
+    */
+    void setKeepAlive(std::size_t maxRequests, time_t idleSeconds);
+
     /**
      * @brief Start the HTTP server to listen for incoming requests.
      */
@@ -96,12 +228,85 @@ public:
      */
     void initializeTokenBucket(int maxTokens, int refillRate, int refillNumber);
 
+    /**
+     * @brief Sets the worker pool of a route class, replacing the default one.
+     *
+     * Must be called before run(), the connection threads are sized from the pools.
+     *
+     * @param routeClass The route class.
+     * @param threads The number of worker threads.
+     * @param queueLimit The number of requests that may wait for a worker; more are answered with 503.
+     */
+    void setRoutePool(RouteClass routeClass, std::size_t threads, std::size_t queueLimit);
+
     /**
      * @brief Consumes a token from the token bucket.
      * @return True if a token was successfully consumed, false otherwise.
      */
     bool consumeToken();
 
+    /**
+     * @brief Consumes a token of the frame routes (live_view.jpg, histogram).
+     *
+     * The frames are polled at the frame rate and served from memory; they have a bucket
+     * of their own so they neither run out at 3 requests per second nor starve the commands.
+     *
+     * @return True if a token was successfully consumed, false otherwise.
+     */
+    bool consumeFrameToken();
+
+    /**
+     * @brief Consumes a token of the catalog routes (contents, thumbnails, media).
+     *
+     * A catalog page loads dozens of thumbnails at once, mostly from the cache, and a media
+     * player re-requests ranges; they are budgeted apart from the camera commands.
+     *
+     * @return True if a token was successfully consumed, false otherwise.
+     */
+    bool consumeCatalogToken();
+
+    /**
+     * @brief Consumes a token of the bucket a route draws from.
+     * @param tokens The bucket (RouteTokens::None always succeeds).
+     * @return True if a token was successfully consumed, false otherwise.
+     */
+    bool consumeRouteToken(RouteTokens tokens);
+
+    /**
+     * @brief Counts a stream opening, or refuses it with 503 once ROUTE_STREAM_CONNECTIONS are open.
+     *
+     * A stream (events, live-view, replay, media) keeps its connection thread until it closes;
+     * the connection threads reserved for them would otherwise run out and starve the pools.
+     * The content provider releaser of the stream must call closeStream().
+     *
+     * @return True if the stream may open.
+     */
+    bool openStream(const httplib::Request &req, httplib::Response &res);
+
+    /**
+     * @brief Counts a stream closed.
+     */
+    void closeStream();
+
+    /**
+     * @brief Sets a response document as the body, in the encoding the client accepts.
+     *
+     * The Accept header selects JSON (default), MessagePack or CBOR.
+     *
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param response_json The response document.
+     */
+    void setJsonContent(const httplib::Request &req, httplib::Response &res, const json &response_json);
+
+    /**
+     * @brief Sets a document written in place as the body, in the encoding the client accepts.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param response_json The response document.
+     */
+    void setJsonContent(const httplib::Request &req, httplib::Response &res, JsonWriter &response_json);
+
     /**
      * @brief Refills tokens in the token bucket based on the elapsed time.
      * @param refillNumber The number of the tokens to refill.
@@ -128,18 +333,48 @@ public:
 
 private:
 
+    /**
+     * @brief Handler of a declared route.
+     */
+    typedef void (Server::*RouteHandler)(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
     httplib::SSLServer server;                                  ///< HTTPS server instance.
     std::string host_;                                          ///< Host address on which the server will listen.
     int port_;                                                  ///< Port on which the server will listen.
     CrSDKInterface *crsdkInterface_;                            ///< Add an instance of CrSDKInterface
     std::thread monitoringThread;                               ///< Thread object for monitoring
     std::atomic<bool> &stopRequested;                           ///< A flag for stopping the server thread
+    std::atomic<int> openStreams_{0};                           ///< Streams holding a connection thread
     GpioPin *gpioPin;                                           ///< Declaration of GpioPin instance
+    LiveView *liveView_ = nullptr;                              ///< Live-view frame source
+    AutoBrightnessController *autoBrightness_ = nullptr;        ///< Closed-loop brightness controller
+    EventStream *eventStream_ = nullptr;                        ///< Server-Sent Events fan-out
+    FrameAnalyzer *frameAnalyzer_ = nullptr;                    ///< Live-view luminance statistics
+    FocusVerifier *focusVerifier_ = nullptr;                    ///< Sharpness check after focus moves
+    LiveViewScaler *liveViewScaler_ = nullptr;                  ///< Reduced size live-view rungs
+    FrameRecorder *frameRecorder_ = nullptr;                    ///< On-disk live-view recording
+    FrameReplay *frameReplay_ = nullptr;                        ///< Time-indexed access to the recording
+    MonitoringReceiver *monitoringReceiver_ = nullptr;          ///< Frames pushed by the cameras
+    ContentsCatalog *contentsCatalog_ = nullptr;                ///< Index of the contents on the cards
+    ContentTransfer *contentTransfer_ = nullptr;                ///< Bulk pulls of the contents
+    ThumbnailCache *thumbnailCache_ = nullptr;                  ///< Thumbnails of the contents
+    MediaLibrary *mediaLibrary_ = nullptr;                      ///< Pulled contents on the local disk
+    SettingsCache *settingsCache_ = nullptr;                    ///< Camera-settings files by content
+    CameraScheduler *cameraScheduler_ = nullptr;                ///< Command queue and admission of each camera
+    StateWaiter *stateWaiter_ = nullptr;                        ///< Waits for camera state transitions
+    std::deque<RouteSpec> routeSpecs_;                          ///< Declared routes (stable addresses for the handlers)
+    std::unique_ptr<WorkerPool> routePools_[static_cast<std::size_t>(RouteClass::Count)];  ///< Worker pool of each route class
+    RequestCoalescer coalescer_;                                ///< Shares the responses of identical concurrent reads
+    TlsContext tlsContext_;                                     ///< Session resumption of the server context
+    std::size_t keepAliveMaxRequests_ = 0;                      ///< Requests per connection
+    time_t keepAliveIdleSeconds_ = 0;                           ///< Idle timeout of the connections
 
     // Token bucket parameters
     int maxTokens_;                                             ///< Maximum number of tokens in the bucket
     int currentTokens_;                                         ///< Current number of tokens in the bucket
     std::chrono::steady_clock::time_point lastTokenTime_;       ///< Last time tokens were added
+    int frameTokens_ = FRAME_TOKENS_PER_REFILL;                 ///< Tokens of the frame routes, refilled with the bucket
+    int catalogTokens_ = CATALOG_TOKENS_PER_REFILL;             ///< Tokens of the catalog routes, refilled with the bucket
     std::mutex tokenMutex_;                                     ///< Mutex for thread safety
 
     /**
@@ -147,110 +382,351 @@ private:
      */
     void setupRoutes();
 
+    /**
+     * @brief Creates the worker pools of the route classes with their default sizes.
+     */
+    void initializeRoutePools();
+
+    /**
+     * @brief Runs a handler on the pool of a route class, or answers 503 if the pool is full.
+     * @param routeClass The route class.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param handler The handler to run.
+     */
+    void runInPool(RouteClass routeClass, const httplib::Request &req, httplib::Response &res, const std::function<void()> &handler);
+
+    /**
+     * @brief Registers a GET route declared with its query parameters.
+     *
+     * The rate limit and the parameters are checked before the handler runs; a missing or
+     * invalid parameter is answered with 400 and the handler is not called. Stream routes are
+     * served on their connection thread, the others by the pool of their class.
+     *
+     * @param spec The route declaration.
+     * @param handler The handler receiving the parsed parameters.
+     */
+    void addRoute(const RouteSpec &spec, RouteHandler handler);
+
+    /**
+     * @brief Checks a request against its route declaration and calls the handler.
+     * @param spec The route declaration.
+     * @param handler The handler of the route.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param received Time the request was received, start of its deadline.
+     */
+    void dispatchRoute(const RouteSpec &spec, RouteHandler handler, const httplib::Request &req, httplib::Response &res, Deadline::Clock::time_point received);
+
+    /**
+     * @brief Admits the camera command of a request to its queue and calls the handler.
+     * @param spec The route declaration.
+     * @param handler The handler of the route.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params The parsed parameters.
+     */
+    void runCommand(const RouteSpec &spec, RouteHandler handler, const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief Answers 504 if the deadline of a request has expired.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params The parsed parameters holding the deadline.
+     * @return true if the response was sent.
+     */
+    bool respondIfExpired(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
     /**
      * @brief HTTP handler for the "indicator" route.
      * @param req HTTP request received.
      * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
      */
-    void handleIndicator(const httplib::Request &req, httplib::Response &res);
+    void handleIndicator(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for Receives a request to get the server metrics (worker pool queue depths).
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleGetMetrics(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
 
     /**
      * @brief HTTP handler for Receives a request to switch the camera to P mode.
      * @param req HTTP request received.
      * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
      */
-    void handleSwitchToPMode(const httplib::Request &req, httplib::Response &res);
+    void handleSwitchToPMode(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
 
     /**
      * @brief HTTP handler for Receives a request to switch the camera to M mode.
      * @param req HTTP request received.
      * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
      */
-    void handleSwitchToMMode(const httplib::Request &req, httplib::Response &res);
+    void handleSwitchToMMode(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
 
     /**
      * @brief HTTP handler for Receives a request to change brightness.
      * @param req HTTP request received.
      * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
      */
-    void handleChangeBrightness(const httplib::Request &req, httplib::Response &res);
+    void handleChangeBrightness(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
 
     /**
      * @brief HTTP handler for Receives a request to change AF area position.
      * @param req HTTP request received.
      * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
      */
-    void handleChangeAFAreaPosition(const httplib::Request &req, httplib::Response &res);
+    void handleChangeAFAreaPosition(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
 
     /**
      * @brief HTTP handler for Receives a request to get camera mode.
      * @param req HTTP request received.
      * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
      */
-    void handleGetCameraMode(const httplib::Request &req, httplib::Response &res);
+    void handleGetCameraMode(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
 
     /**
      * @brief HTTP handler for Receives a request to get the brightness value of the camera.
      * @param req HTTP request received.
      * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
      */
-    void handleGetCameraBrightness(const httplib::Request &req, httplib::Response &res);
+    void handleGetCameraBrightness(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
 
 
     /**
      * @brief HTTP handler for download the camera setting file to PC.
      * @param req HTTP request received.
      * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
      */
-    void handleDownloadCameraSetting(const httplib::Request &req, httplib::Response &res);
+    void handleDownloadCameraSetting(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
 
     /**
-     * @brief HTTP handler for Receives a request to upload the camera setting file to Camera.
+     * @brief HTTP handler for Receives a request to upload the camera setting file to one or more cameras.
      * @param req HTTP request received.
      * @param res HTTP response to be sent.
+     * @param content_reader Reads the settings file from the request body.
      */
-    void handleUploadCameraSetting(const httplib::Request &req, httplib::Response &res);
+    void handleUploadCameraSetting(const httplib::Request &req, httplib::Response &res, const httplib::ContentReader &content_reader);
 
     /**
      * @brief HTTP handler for Receives a request to get F-number.
      * @param req HTTP request received.
      * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
      */
-    void handleGetFnumber(const httplib::Request &req, httplib::Response &res);
+    void handleGetFnumber(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
 
     /**
      * @brief HTTP handler for Receives a request to set F-number.
      * @param req HTTP request received.
      * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleSetFnumber(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for Receives a request to configure the auto brightness controller.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleSetAutoBrightness(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for Receives a request to get the auto brightness controller state.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleGetAutoBrightness(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for Receives a request to get the live-view histogram and clipping statistics.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleGetHistogram(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for Receives a request to get (or measure) the live-view sharpness score.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleGetSharpness(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for Receives a request to get the latest live-view frame (optionally downscaled).
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleGetLiveView(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for the MJPEG live-view stream (optionally downscaled).
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleLiveViewStream(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for Receives a request to get the live-view polling statistics.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleGetLiveViewStats(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for Receives a request to get (or enable / disable) the live-view recording.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleRecording(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for the MJPEG replay of a recorded time range.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleReplay(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for Receives a request to get (or enable / disable) the pushed monitoring frames.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleMonitoring(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for Receives a request to list a page of the contents of a camera.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleGetContents(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for Receives a request to pull a selection of contents from one or all cameras.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handlePullContents(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for Receives a request to get the thumbnail of a content.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleGetThumbnail(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for Receives a request to get (or cancel) the content transfer batches.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleGetTransfers(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for Receives a request to list the contents pulled from a camera.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleListMedia(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for Receives a request to download a content pulled from a camera (Range supported).
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleGetMedia(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief HTTP handler for Receives a request waiting until a camera reaches a mode, brightness or F-number.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
+     */
+    void handleWaitForState(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
+
+    /**
+     * @brief Reads the "rung" and "quality" parameters of the live-view routes.
+     * @param params Query parameters parsed by the route table.
+     * @param rung Receives the scale denominator (default 1).
+     * @param quality Receives the JPEG quality (default LIVE_VIEW_DEFAULT_QUALITY).
+     * @return An error message, or an empty string if the rung is supported.
+     */
+    std::string parseLiveViewParams(const RouteParams &params, int &rung, int &quality);
+
+    /**
+     * @brief Adds the sharpness check after a focus move to a response.
+     * @param req HTTP request received ("verify_focus=false" skips the check).
+     * @param response_json The response to extend.
+     * @param camera_id The camera ID (0-based indexing)
+     * @param trigger What moved the lens.
+     * @param centerX Horizontal center of the measured region (0-1).
+     * @param centerY Vertical center of the measured region (0-1).
+     */
+    void addFocusCheck(const httplib::Request &req, json &response_json, int camera_id, const std::string &trigger, double centerX = 0.5, double centerY = 0.5);
+
+    /**
+     * @brief HTTP handler for the Server-Sent Events stream.
+     * @param req HTTP request received.
+     * @param res HTTP response to be sent.
      */
-    void handleSetFnumber(const httplib::Request &req, httplib::Response &res);
+    void handleEvents(const httplib::Request &req, httplib::Response &res);
 
     /**
      * @brief HTTP handler for starting the cameras.
      * @param req HTTP request received.
      * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
      */
-    void handleStartCameras(const httplib::Request &req, httplib::Response &res);
+    void handleStartCameras(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
 
     /**
      * @brief HTTP handler for stopping the cameras.
      * @param req HTTP request received.
      * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
      */
-    void handleStopCameras(const httplib::Request &req, httplib::Response &res);
+    void handleStopCameras(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
 
      /**
      * @brief HTTP handler for restat the cameras.
      * @param req HTTP request received.
      * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
      */
-    void handleRestatCameras(const httplib::Request &req, httplib::Response &res);
+    void handleRestatCameras(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
 
      /**
      * @brief HTTP handler for Receives a request to exit the program.
      * @param req HTTP request received.
      * @param res HTTP response to be sent.
+     * @param params Query parameters parsed by the route table.
      */
-    void handleExit(const httplib::Request &req, httplib::Response &res);
+    void handleExit(const httplib::Request &req, httplib::Response &res, const RouteParams &params);
 
 };    
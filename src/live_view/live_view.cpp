@@ -0,0 +1,406 @@
+#include "live_view.h"
+
+#include <algorithm>
+
+// Weight of a new frame interval sample in the running estimate
+#define LIVE_VIEW_INTERVAL_SMOOTHING 0.2
+// The next pull is scheduled this fraction of the interval after the last frame, retries catch the rest
+#define LIVE_VIEW_EARLY_PULL_FACTOR 0.85
+
+LiveView::LiveView(CrSDKInterface *crsdkInterface, std::size_t ringSize)
+    : crsdkInterface_(crsdkInterface), ringSize_(ringSize), running_(false)
+{
+    if (ringSize_ == 0)
+    {
+        ringSize_ = 1;
+    }
+}
+
+LiveView::~LiveView()
+{
+    stop();
+}
+
+bool LiveView::start()
+{
+    try
+    {
+        if (crsdkInterface_ == nullptr)
+        {
+            spdlog::error("ERROR: crsdkInterface_ is nullptr");
+            return false;
+        }
+
+        if (running_.exchange(true))
+        {
+            spdlog::warn("The live view is already running.");
+            return true;
+        }
+
+        rings_.clear();
+        for (std::size_t i = 0; i < crsdkInterface_->cameraList.size(); ++i)
+        {
+            std::unique_ptr<CameraRing> ring(new CameraRing());
+            ring->frames.resize(ringSize_);
+            ring->stats.frameIntervalMs = LIVE_VIEW_POLL_INTERVAL_MS;
+            rings_.push_back(std::move(ring));
+        }
+
+        for (std::size_t i = 0; i < rings_.size(); ++i)
+        {
+            int cameraNumber = static_cast<int>(i);
+            rings_[i]->producer = std::thread([this, cameraNumber]()
+            {
+                producerLoop(cameraNumber);
+            });
+        }
+
+        spdlog::info("Live view started for {} cameras.", rings_.size());
+        return true;
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::error("An error occurred while trying to start the live view: {}", e.what());
+        running_.store(false);
+        return false;
+    }
+}
+
+void LiveView::stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+
+    for (auto &ring : rings_)
+    {
+        {
+            std::lock_guard<std::mutex> lock(ring->mutex);
+        }
+        ring->frameReady.notify_all();
+        ring->demandChanged.notify_all();
+
+        if (ring->producer.joinable())
+        {
+            ring->producer.join();
+        }
+    }
+
+    spdlog::info("Live view stopped.");
+}
+
+LiveViewFramePtr LiveView::getLatestFrame(int cameraNumber) const
+{
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(rings_.size()))
+    {
+        return nullptr;
+    }
+
+    const CameraRing &ring = *rings_[cameraNumber];
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    if (ring.sequence == 0)
+    {
+        return nullptr;
+    }
+
+    return ring.frames[(ring.head + ringSize_ - 1) % ringSize_];
+}
+
+LiveViewFramePtr LiveView::waitForFrame(int cameraNumber, std::uint64_t afterSequence, std::chrono::milliseconds timeout) const
+{
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(rings_.size()))
+    {
+        return nullptr;
+    }
+
+    const CameraRing &ring = *rings_[cameraNumber];
+    std::unique_lock<std::mutex> lock(ring.mutex);
+
+    bool ready = ring.frameReady.wait_for(lock, timeout, [this, &ring, afterSequence]()
+    {
+        return !running_.load() || ring.sequence > afterSequence;
+    });
+
+    if (!ready || ring.sequence <= afterSequence)
+    {
+        return nullptr;
+    }
+
+    return ring.frames[(ring.head + ringSize_ - 1) % ringSize_];
+}
+
+void LiveView::addFrameListener(LiveViewFrameListener listener)
+{
+    std::lock_guard<std::mutex> lock(listenersMutex_);
+    listeners_.push_back(std::move(listener));
+}
+
+void LiveView::publishFrame(int cameraNumber, std::vector<std::uint8_t> &&jpeg, CrInt32u frameNo)
+{
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(rings_.size()))
+    {
+        return;
+    }
+
+    CameraRing &ring = *rings_[cameraNumber];
+
+    std::shared_ptr<LiveViewFrame> frame = std::make_shared<LiveViewFrame>();
+    frame->frameNo = frameNo;
+    frame->timestamp = std::chrono::system_clock::now();
+    frame->jpeg = std::move(jpeg);
+
+    {
+        std::lock_guard<std::mutex> lock(ring.mutex);
+        frame->sequence = ++ring.sequence;
+        ring.frames[ring.head] = frame;
+        ring.head = (ring.head + 1) % ringSize_;
+    }
+    ring.frameReady.notify_all();
+
+    std::vector<LiveViewFrameListener> listeners;
+    {
+        std::lock_guard<std::mutex> lock(listenersMutex_);
+        listeners = listeners_;
+    }
+
+    LiveViewFramePtr publishedFrame = frame;
+    for (auto &listener : listeners)
+    {
+        try
+        {
+            listener(cameraNumber, publishedFrame);
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::error("Error in live view frame listener: {}", e.what());
+        }
+    }
+}
+
+bool LiveView::hasDemand(const CameraRing &ring)
+{
+    return !ring.pushed && (ring.viewers > 0 || std::chrono::steady_clock::now() < ring.demandUntil);
+}
+
+void LiveView::addViewer(int cameraNumber)
+{
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(rings_.size()))
+    {
+        return;
+    }
+
+    CameraRing &ring = *rings_[cameraNumber];
+    {
+        std::lock_guard<std::mutex> lock(ring.mutex);
+        ring.viewers++;
+    }
+    ring.demandChanged.notify_all();
+}
+
+void LiveView::removeViewer(int cameraNumber)
+{
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(rings_.size()))
+    {
+        return;
+    }
+
+    CameraRing &ring = *rings_[cameraNumber];
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    if (ring.viewers > 0)
+    {
+        ring.viewers--;
+    }
+}
+
+void LiveView::requestFrames(int cameraNumber, std::chrono::milliseconds lease)
+{
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(rings_.size()))
+    {
+        return;
+    }
+
+    CameraRing &ring = *rings_[cameraNumber];
+    {
+        std::lock_guard<std::mutex> lock(ring.mutex);
+        ring.demandUntil = std::max(ring.demandUntil, std::chrono::steady_clock::now() + lease);
+    }
+    ring.demandChanged.notify_all();
+}
+
+LiveViewFramePtr LiveView::getFreshFrame(int cameraNumber, std::chrono::milliseconds timeout)
+{
+    requestFrames(cameraNumber);
+
+    LiveViewFramePtr frame = getLatestFrame(cameraNumber);
+    if (frame && std::chrono::system_clock::now() - frame->timestamp < std::chrono::milliseconds(LIVE_VIEW_STALE_FRAME_MS))
+    {
+        return frame;
+    }
+
+    // The producer was idle, wait for the first frame of the new lease
+    return waitForFrame(cameraNumber, frame ? frame->sequence : 0, timeout);
+}
+
+LiveViewStats LiveView::getStats(int cameraNumber) const
+{
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(rings_.size()))
+    {
+        return LiveViewStats();
+    }
+
+    const CameraRing &ring = *rings_[cameraNumber];
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    LiveViewStats stats = ring.stats;
+    stats.viewers = ring.viewers;
+    stats.pulling = hasDemand(ring);
+    stats.pushed = ring.pushed;
+    return stats;
+}
+
+void LiveView::setPushed(int cameraNumber, bool pushed)
+{
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(rings_.size()))
+    {
+        return;
+    }
+
+    CameraRing &ring = *rings_[cameraNumber];
+    {
+        std::lock_guard<std::mutex> lock(ring.mutex);
+        ring.pushed = pushed;
+    }
+    ring.demandChanged.notify_all();
+}
+
+void LiveView::producerLoop(int cameraNumber)
+{
+    CameraRing &ring = *rings_[cameraNumber];
+    std::vector<CrInt8u> image;
+    CrInt32u frameNo = 0;
+    CrInt32u lastFrameNo = 0;
+    std::chrono::steady_clock::time_point lastUpdate;
+    bool pulling = false;
+
+    while (running_.load())
+    {
+        {
+            // No viewer and no request lease: no pulls at all until someone asks for frames
+            std::unique_lock<std::mutex> lock(ring.mutex);
+            if (!hasDemand(ring) && pulling)
+            {
+                spdlog::info("Live view of camera {} stopped pulling ({}).", cameraNumber, ring.pushed ? "frames are pushed" : "no viewers");
+                pulling = false;
+            }
+
+            ring.demandChanged.wait(lock, [this, &ring]()
+            {
+                return !running_.load() || hasDemand(ring);
+            });
+        }
+
+        if (!running_.load())
+        {
+            break;
+        }
+
+        if (!pulling)
+        {
+            spdlog::info("Live view of camera {} started pulling.", cameraNumber);
+            pulling = true;
+
+            // The frame phase of the previous run is meaningless after a pause
+            lastUpdate = std::chrono::steady_clock::time_point();
+        }
+
+        auto nextPull = std::chrono::steady_clock::now() + std::chrono::milliseconds(LIVE_VIEW_DISCONNECTED_POLL_MS);
+
+        try
+        {
+            CameraDevicePtr camera = crsdkInterface_->cameraList.at(cameraNumber);
+
+            if (camera && camera->is_connected())
+            {
+                auto err = camera->get_live_view_image(image, frameNo);
+                auto now = std::chrono::steady_clock::now();
+                bool updated = CR_SUCCEEDED(err) && (frameNo != lastFrameNo || frameNo == 0);
+
+                {
+                    std::lock_guard<std::mutex> lock(ring.mutex);
+                    ring.stats.pulls++;
+                    double interval = ring.stats.frameIntervalMs;
+
+                    if (updated)
+                    {
+                        ring.stats.updates++;
+
+                        // Frames skipped since the last update count as elapsed intervals
+                        if (lastUpdate != std::chrono::steady_clock::time_point())
+                        {
+                            double elapsed = std::chrono::duration<double, std::milli>(now - lastUpdate).count();
+                            double frames = (frameNo > lastFrameNo && lastFrameNo != 0) ? std::min<double>(frameNo - lastFrameNo, 8.0) : 1.0;
+                            double sample = std::max<double>(LIVE_VIEW_MIN_FRAME_INTERVAL_MS, std::min<double>(LIVE_VIEW_MAX_FRAME_INTERVAL_MS, elapsed / frames));
+                            interval += LIVE_VIEW_INTERVAL_SMOOTHING * (sample - interval);
+                            ring.stats.frameIntervalMs = interval;
+                        }
+
+                        // Aim slightly before the expected frame so the phase cannot drift late
+                        nextPull = now + std::chrono::microseconds(static_cast<long long>(interval * LIVE_VIEW_EARLY_PULL_FACTOR * 1000.0));
+                    }
+                    else
+                    {
+                        if (CR_SUCCEEDED(err) || err == SCRSDK::CrWarning_Frame_NotUpdated)
+                        {
+                            ring.stats.notUpdated++;
+                        }
+                        else
+                        {
+                            ring.stats.errors++;
+                        }
+
+                        // Too early (or the camera slowed down): retry in steps that grow with the wait
+                        double waited = lastUpdate != std::chrono::steady_clock::time_point() ? std::chrono::duration<double, std::milli>(now - lastUpdate).count() : interval;
+                        double retry = std::max<double>(LIVE_VIEW_MIN_RETRY_MS, std::min<double>(LIVE_VIEW_MAX_RETRY_MS, std::max(interval, waited) / 10.0));
+                        nextPull = now + std::chrono::microseconds(static_cast<long long>(retry * 1000.0));
+                    }
+                }
+
+                if (updated)
+                {
+                    lastUpdate = now;
+                    lastFrameNo = frameNo;
+                    publishFrame(cameraNumber, std::move(image), frameNo);
+                    image = std::vector<CrInt8u>();
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::error("An error occurred while pulling the live view of camera {}: {}", cameraNumber, e.what());
+        }
+
+        // Sleep until the next pull, stop() wakes the producer up early
+        std::unique_lock<std::mutex> lock(ring.mutex);
+        ring.demandChanged.wait_until(lock, nextPull, [this]()
+        {
+            return !running_.load();
+        });
+    }
+}
+
+LiveViewSubscription::LiveViewSubscription(LiveView *liveView, int cameraNumber)
+    : liveView_(liveView), cameraNumber_(cameraNumber)
+{
+    if (liveView_ != nullptr)
+    {
+        liveView_->addViewer(cameraNumber_);
+    }
+}
+
+LiveViewSubscription::~LiveViewSubscription()
+{
+    if (liveView_ != nullptr)
+    {
+        liveView_->removeViewer(cameraNumber_);
+    }
+}
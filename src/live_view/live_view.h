@@ -0,0 +1,242 @@
+#ifndef LIVE_VIEW_H
+#define LIVE_VIEW_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+#include "../CrSDK_interface/CrSDK_interface.h"
+
+#define LIVE_VIEW_RING_SIZE 8
+#define LIVE_VIEW_POLL_INTERVAL_MS 100          // Initial frame interval estimate
+#define LIVE_VIEW_MIN_FRAME_INTERVAL_MS 16
+#define LIVE_VIEW_MAX_FRAME_INTERVAL_MS 500
+#define LIVE_VIEW_MIN_RETRY_MS 2
+#define LIVE_VIEW_MAX_RETRY_MS 50
+#define LIVE_VIEW_DISCONNECTED_POLL_MS 500
+#define LIVE_VIEW_DEMAND_LEASE_MS 5000
+#define LIVE_VIEW_STALE_FRAME_MS 1000
+
+/**
+ * @brief A single live-view frame as delivered by the camera.
+ */
+struct LiveViewFrame
+{
+    std::uint64_t sequence = 0;                         ///< Server-side sequence number (per camera, starts at 1)
+    CrInt32u frameNo = 0;                               ///< Frame number reported by the camera
+    std::chrono::system_clock::time_point timestamp;    ///< Time the frame was received
+    std::vector<std::uint8_t> jpeg;                     ///< JPEG payload
+};
+
+/**
+ * @brief Pull statistics of the live-view producer of a camera.
+ */
+struct LiveViewStats
+{
+    int viewers = 0;                        ///< Registered viewers (streams, recorders, controllers)
+    bool pulling = false;                   ///< True while the producer pulls frames
+    bool pushed = false;                    ///< True while the camera pushes its frames
+    std::uint64_t pulls = 0;                ///< GetLiveViewImage calls
+    std::uint64_t updates = 0;              ///< Calls that returned a new frame
+    std::uint64_t notUpdated = 0;           ///< Calls that returned the previous frame
+    std::uint64_t errors = 0;               ///< Failed calls
+    double frameIntervalMs = 0.0;           ///< Estimated camera frame interval
+};
+
+typedef std::shared_ptr<const LiveViewFrame> LiveViewFramePtr;
+typedef std::function<void(int cameraNumber, const LiveViewFramePtr &frame)> LiveViewFrameListener;
+
+/**
+ * @brief The LiveView class pulls live-view frames from the connected cameras into a per-camera frame ring.
+ *
+ * One producer thread per camera calls GetLiveViewImage and publishes every new frame into a
+ * small ring of recent frames. Consumers either read the latest frame, wait for the next one,
+ * or register a listener that is called on the producer thread for every published frame.
+ *
+ * Pulling is demand driven: the producer only runs while a viewer is registered or a
+ * one-shot request lease is active, otherwise it makes no calls at all. While pulling, it
+ * estimates the camera frame interval from the successful updates and schedules the next
+ * pull slightly before the expected frame, then retries in short steps until the frame
+ * arrives, instead of busy-polling or sleeping a fixed interval.
+ */
+class LiveView
+{
+public:
+    /**
+     * @brief Constructs a LiveView object.
+     * @param crsdkInterface instance of CrSDKInterface class.
+     * @param ringSize The number of recent frames kept per camera.
+     */
+    LiveView(CrSDKInterface *crsdkInterface, std::size_t ringSize = LIVE_VIEW_RING_SIZE);
+
+    /**
+     * @brief Stops the producer threads.
+     */
+    ~LiveView();
+
+    /**
+     * @brief Starts one producer thread per connected camera.
+     * @return True if the producers were started, false otherwise.
+     */
+    bool start();
+
+    /**
+     * @brief Stops the producer threads and wakes up all waiting consumers.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the most recent frame of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @return The latest frame, or nullptr if no frame was received yet.
+     */
+    LiveViewFramePtr getLatestFrame(int cameraNumber) const;
+
+    /**
+     * @brief Waits for a frame newer than a given sequence number.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param afterSequence The sequence number of the last frame the caller has seen.
+     * @param timeout The maximum time to wait.
+     * @return The new frame, or nullptr on timeout or when the live view is stopped.
+     */
+    LiveViewFramePtr waitForFrame(int cameraNumber, std::uint64_t afterSequence, std::chrono::milliseconds timeout) const;
+
+    /**
+     * @brief Registers a listener that is called for every published frame.
+     *
+     * The listener runs on the producer thread of the camera and must return quickly.
+     *
+     * @param listener The listener to call.
+     */
+    void addFrameListener(LiveViewFrameListener listener);
+
+    /**
+     * @brief Registers a long-lived viewer; frames are pulled while at least one viewer is registered.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    void addViewer(int cameraNumber);
+
+    /**
+     * @brief Unregisters a viewer added with addViewer().
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    void removeViewer(int cameraNumber);
+
+    /**
+     * @brief Keeps the frames of a camera flowing for a while, for one-shot consumers.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param lease How long to keep pulling without another request.
+     */
+    void requestFrames(int cameraNumber, std::chrono::milliseconds lease = std::chrono::milliseconds(LIVE_VIEW_DEMAND_LEASE_MS));
+
+    /**
+     * @brief Returns a recent frame, pulling a new one if the latest is stale.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param timeout The maximum time to wait for a new frame.
+     * @return The frame, or nullptr if none arrived in time.
+     */
+    LiveViewFramePtr getFreshFrame(int cameraNumber, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Returns the pull statistics of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    LiveViewStats getStats(int cameraNumber) const;
+
+    /**
+     * @brief Switches a camera between pulled and pushed frames.
+     *
+     * While the camera pushes its frames (see MonitoringReceiver) the producer stops pulling;
+     * the pushed frames are published with publishFrame().
+     *
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param pushed True while the frames are pushed.
+     */
+    void setPushed(int cameraNumber, bool pushed);
+
+    /**
+     * @brief Publishes a frame into the ring of a camera and notifies consumers.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param jpeg The JPEG payload of the frame.
+     * @param frameNo The frame number reported by the camera.
+     */
+    void publishFrame(int cameraNumber, std::vector<std::uint8_t> &&jpeg, CrInt32u frameNo);
+
+    /**
+     * @brief Returns the number of cameras handled by the live view.
+     */
+    int getCameraCount() const { return static_cast<int>(rings_.size()); }
+
+private:
+    /**
+     * @brief Frame ring and producer state of a single camera.
+     */
+    struct CameraRing
+    {
+        mutable std::mutex mutex;                   ///< Protects the ring
+        mutable std::condition_variable frameReady; ///< Signaled on every published frame
+        std::vector<LiveViewFramePtr> frames;       ///< Ring of recent frames
+        std::size_t head = 0;                       ///< Index of the next slot to write
+        std::uint64_t sequence = 0;                 ///< Sequence number of the latest frame
+        std::thread producer;                       ///< Producer thread
+        std::condition_variable demandChanged;      ///< Signaled when viewers or leases change
+        int viewers = 0;                            ///< Registered viewers
+        std::chrono::steady_clock::time_point demandUntil; ///< End of the one-shot request lease
+        LiveViewStats stats;                        ///< Pull statistics
+        bool pushed = false;                        ///< True while the frames are pushed
+    };
+
+    /**
+     * @brief Returns true if the producer has to pull the frames of a camera (ring mutex held).
+     */
+    static bool hasDemand(const CameraRing &ring);
+
+    /**
+     * @brief Producer loop pulling live-view frames of one camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    void producerLoop(int cameraNumber);
+
+    CrSDKInterface *crsdkInterface_;                        ///< Instance of CrSDKInterface
+    std::size_t ringSize_;                                  ///< Number of recent frames kept per camera
+    std::vector<std::unique_ptr<CameraRing>> rings_;        ///< Per camera frame rings
+    std::atomic<bool> running_;                             ///< True while the producers run
+    std::vector<LiveViewFrameListener> listeners_;          ///< Frame listeners
+    std::mutex listenersMutex_;                             ///< Protects the listeners
+};
+
+/**
+ * @brief RAII registration of a live-view viewer (see LiveView::addViewer).
+ */
+class LiveViewSubscription
+{
+public:
+    /**
+     * @brief Registers a viewer of a camera.
+     * @param liveView The live view, may be nullptr.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    LiveViewSubscription(LiveView *liveView, int cameraNumber);
+
+    /**
+     * @brief Unregisters the viewer.
+     */
+    ~LiveViewSubscription();
+
+    LiveViewSubscription(const LiveViewSubscription &) = delete;
+    LiveViewSubscription &operator=(const LiveViewSubscription &) = delete;
+
+private:
+    LiveView *liveView_;        ///< Live view the viewer is registered with
+    int cameraNumber_;          ///< The camera ID (0-based indexing)
+};
+
+#endif // LIVE_VIEW_H
@@ -0,0 +1,90 @@
+#include "live_view_scaler.h"
+
+#include <algorithm>
+
+LiveViewScaler::LiveViewScaler(LiveView *liveView)
+    : liveView_(liveView)
+{
+    if (liveView_ != nullptr)
+    {
+        for (int i = 0; i < liveView_->getCameraCount(); ++i)
+        {
+            cameras_.emplace_back(new CameraCache());
+        }
+    }
+}
+
+bool LiveViewScaler::isValidRung(int rung)
+{
+    return rung == 1 || rung == 2 || rung == 4 || rung == LIVE_VIEW_MAX_RUNG;
+}
+
+JpegBufferPtr LiveViewScaler::getScaledFrame(int cameraNumber, const LiveViewFramePtr &frame, int rung, int quality)
+{
+    if (!frame || !isValidRung(rung) || cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        return nullptr;
+    }
+
+    // The original frame is shared as is, the buffer lives as long as the frame
+    if (rung == 1)
+    {
+        return JpegBufferPtr(frame, &frame->jpeg);
+    }
+
+    quality = std::max(LIVE_VIEW_MIN_QUALITY, std::min(LIVE_VIEW_MAX_QUALITY, quality));
+
+    CameraCache &cache = *cameras_[cameraNumber];
+    std::lock_guard<std::mutex> lock(cache.mutex);
+
+    // A new frame invalidates everything derived from the previous one
+    if (cache.sequence != frame->sequence)
+    {
+        cache.sequence = frame->sequence;
+        cache.encoded.clear();
+        cache.levels.resize(0);
+    }
+
+    auto it = cache.encoded.find(std::make_pair(rung, quality));
+    if (it != cache.encoded.end())
+    {
+        return it->second;
+    }
+
+    if (cache.levels.empty())
+    {
+        cache.levels.emplace_back();
+        if (!cache.codec.decodeRgbx(frame->jpeg.data(), frame->jpeg.size(), cache.levels[0]))
+        {
+            cache.levels.clear();
+            return nullptr;
+        }
+    }
+
+    // Cascade the 2x2 box filter: 1/2 -> 1/4 -> 1/8, reusing the levels already computed
+    std::size_t level = 0;
+    for (int denominator = rung; denominator > 1; denominator /= 2)
+    {
+        level++;
+    }
+
+    while (cache.levels.size() <= level)
+    {
+        RgbxImage next;
+        if (!ImageScaler::halve(cache.levels.back(), next))
+        {
+            spdlog::warn("Live-view frame of camera {} is too small for rung {}", cameraNumber, rung);
+            return nullptr;
+        }
+        cache.levels.push_back(std::move(next));
+    }
+
+    std::shared_ptr<std::vector<std::uint8_t>> jpeg = std::make_shared<std::vector<std::uint8_t>>();
+    if (!cache.codec.encodeRgbx(cache.levels[level], quality, *jpeg))
+    {
+        return nullptr;
+    }
+
+    cache.encoded[std::make_pair(rung, quality)] = jpeg;
+    return jpeg;
+}
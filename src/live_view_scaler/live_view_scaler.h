@@ -0,0 +1,75 @@
+#ifndef LIVE_VIEW_SCALER_H
+#define LIVE_VIEW_SCALER_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+#include "../live_view/live_view.h"
+#include "../ImageAnalysis/jpeg_codec/jpeg_codec.h"
+#include "../ImageAnalysis/image_scaler/image_scaler.h"
+
+#define LIVE_VIEW_DEFAULT_QUALITY 70
+#define LIVE_VIEW_MIN_QUALITY 10
+#define LIVE_VIEW_MAX_QUALITY 95
+#define LIVE_VIEW_MAX_RUNG 8
+
+typedef std::shared_ptr<const std::vector<std::uint8_t>> JpegBufferPtr;
+
+/**
+ * @brief The LiveViewScaler class serves the live-view frames at reduced sizes for thin links.
+ *
+ * A rung is the scale denominator of the preview (1 = original frame, 2, 4 or 8). The frame
+ * is decoded once, halved with the SIMD box filter as many times as the rung needs and
+ * re-encoded at the requested quality. Decoded levels and encoded previews are cached per
+ * camera for the current frame sequence, so concurrent viewers at the same rung and quality
+ * share one decode and one encode.
+ */
+class LiveViewScaler
+{
+public:
+    /**
+     * @brief Constructs a LiveViewScaler object.
+     * @param liveView instance of LiveView class providing the frames.
+     */
+    explicit LiveViewScaler(LiveView *liveView);
+
+    /**
+     * @brief Returns true if a rung is supported (1, 2, 4 or 8).
+     * @param rung The scale denominator.
+     */
+    static bool isValidRung(int rung);
+
+    /**
+     * @brief Returns a frame at the given rung and quality.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param frame The live-view frame.
+     * @param rung The scale denominator (1, 2, 4 or 8).
+     * @param quality The JPEG quality of the preview (ignored for rung 1).
+     * @return The JPEG data, or nullptr on error.
+     */
+    JpegBufferPtr getScaledFrame(int cameraNumber, const LiveViewFramePtr &frame, int rung, int quality);
+
+private:
+    /**
+     * @brief Decoded levels and encoded previews of the current frame of a camera.
+     */
+    struct CameraCache
+    {
+        std::mutex mutex;                                       ///< Serializes the work on the camera frames
+        std::uint64_t sequence = 0;                             ///< Frame sequence the cache belongs to
+        std::vector<RgbxImage> levels;                          ///< levels[0] = full size, levels[n] = 1/2^n
+        std::map<std::pair<int, int>, JpegBufferPtr> encoded;   ///< Previews by (rung, quality)
+        JpegCodec codec;                                        ///< Decoder / encoder of the camera
+    };
+
+    LiveView *liveView_;                                        ///< Source of the live-view frames
+    std::vector<std::unique_ptr<CameraCache>> cameras_;         ///< Per camera cache
+};
+
+#endif // LIVE_VIEW_SCALER_H
@@ -21,6 +21,23 @@
 #include "CrSDK_interface/CrSDK_interface.h"
 #include "https_server/https_server.h"
 #include "gpioPin/gpioPin.h"
+#include "live_view/live_view.h"
+#include "auto_brightness/auto_brightness.h"
+#include "event_stream/event_stream.h"
+#include "ImageAnalysis/frame_analyzer/frame_analyzer.h"
+#include "ImageAnalysis/focus_verifier/focus_verifier.h"
+#include "live_view_scaler/live_view_scaler.h"
+#include "frame_recorder/frame_recorder.h"
+#include "frame_replay/frame_replay.h"
+#include "monitoring_receiver/monitoring_receiver.h"
+#include "contents_catalog/contents_catalog.h"
+#include "content_transfer/content_transfer.h"
+#include "thumbnail_cache/thumbnail_cache.h"
+#include "media_library/media_library.h"
+#include "settings_cache/settings_cache.h"
+#include "camera_scheduler/camera_scheduler.h"
+#include "state_waiter/state_waiter.h"
+#include "tls_context/tls_context.h"
 
 #define LIVEVIEW_ENB
 #define MSEARCH_ENB
@@ -41,6 +58,11 @@ void signalHandler(int sig)
     spdlog::info("Program stopped...");
     stopRequested.store(true);
   }
+  else if (sig == SIGHUP)
+  {
+    // Only sets a flag, the certificate is reloaded by its watch thread
+    TlsContext::requestReload();
+  }
 }
 
 /**
@@ -311,6 +333,9 @@ int main()
   sigfillset(&sa.sa_mask);
   sigaction(SIGINT, &sa, NULL);
 
+  // Register signal handler for reloading the TLS certificate
+  sigaction(SIGHUP, &sa, NULL);
+
   // Create an instance of the GpioPin class
   GpioPin *gpioPin = new GpioPin(DEFAULT_PIN);
 
@@ -429,6 +454,67 @@ int main()
     return EXIT_FAILURE;
   }
 
+  // Start pulling live-view frames from the connected cameras.
+  LiveView *liveView = new LiveView(crsdk);
+  liveView->start();
+
+  // Events pushed to the clients connected to the "/events" route.
+  EventStream *eventStream = new EventStream();
+
+  // Decode every live-view frame once and compute its luminance statistics.
+  FrameAnalyzer *frameAnalyzer = new FrameAnalyzer(liveView, eventStream);
+  frameAnalyzer->start();
+
+  // Score the sharpness after preset recalls and AF moves.
+  FocusVerifier *focusVerifier = new FocusVerifier(liveView, eventStream);
+
+  // Serve the live view at reduced sizes for the operators on thin links.
+  LiveViewScaler *liveViewScaler = new LiveViewScaler(liveView);
+
+  // Record the live view to disk (idle until enabled per camera).
+  FrameRecorder *frameRecorder = new FrameRecorder(liveView);
+  frameRecorder->start();
+
+  // Serve the recorded frames by time.
+  FrameReplay *frameReplay = new FrameReplay(frameRecorder);
+
+  // Receive the JPEG frames pushed by the cameras (idle until enabled per camera).
+  MonitoringReceiver *monitoringReceiver = new MonitoringReceiver(crsdk, liveView);
+  monitoringReceiver->start();
+
+  // Index the contents of the memory cards, refreshed on every new capture.
+  ContentsCatalog *contentsCatalog = new ContentsCatalog(crsdk);
+  contentsCatalog->start();
+
+  // Queue the commands of each camera by priority, refusing those that would miss their deadline.
+  CameraScheduler *cameraScheduler = new CameraScheduler(crsdk->cameraList.size());
+
+  // Pull batches of contents from the cameras, unfinished batches resume.
+  ContentTransfer *contentTransfer = new ContentTransfer(crsdk, contentsCatalog);
+  contentTransfer->setCameraScheduler(cameraScheduler);
+  contentTransfer->start();
+
+  // Keep the thumbnails of the browsed contents in memory.
+  ThumbnailCache *thumbnailCache = new ThumbnailCache(crsdk, contentsCatalog);
+  thumbnailCache->start();
+
+  // Serve the pulled contents from the transfer directories.
+  MediaLibrary *mediaLibrary = new MediaLibrary(contentTransfer);
+
+  // Keep the downloaded camera-settings files by content.
+  SettingsCache *settingsCache = new SettingsCache(crsdk);
+  settingsCache->setCameraScheduler(cameraScheduler);
+
+  // Answer the requests waiting for a camera state from the property-change callbacks.
+  StateWaiter *stateWaiter = new StateWaiter(crsdk);
+  stateWaiter->setCameraScheduler(cameraScheduler);
+  stateWaiter->start();
+
+  // Start the closed-loop brightness controller (idle until enabled per camera).
+  AutoBrightnessController *autoBrightness = new AutoBrightnessController(crsdk, frameAnalyzer);
+  autoBrightness->setCameraScheduler(cameraScheduler);
+  autoBrightness->start();
+
   // Configure server parameters
   const std::string cert_file = "/jetson_ssl/jeston-server-embedded.crt";
   const std::string key_file = "/jetson_ssl/jeston-server-embedded.key";
@@ -441,6 +527,23 @@ int main()
     server.setGpioPin(gpioPin);
   }
 
+  server.setLiveView(liveView);
+  server.setAutoBrightnessController(autoBrightness);
+  server.setEventStream(eventStream);
+  server.setFrameAnalyzer(frameAnalyzer);
+  server.setFocusVerifier(focusVerifier);
+  server.setLiveViewScaler(liveViewScaler);
+  server.setFrameRecorder(frameRecorder);
+  server.setFrameReplay(frameReplay);
+  server.setMonitoringReceiver(monitoringReceiver);
+  server.setContentsCatalog(contentsCatalog);
+  server.setContentTransfer(contentTransfer);
+  server.setThumbnailCache(thumbnailCache);
+  server.setMediaLibrary(mediaLibrary);
+  server.setSettingsCache(settingsCache);
+  server.setCameraScheduler(cameraScheduler);
+  server.setStateWaiter(stateWaiter);
+
   // Run the server in a separate thread
   std::thread serverThread(&Server::run, &server);
 
@@ -479,12 +582,33 @@ int main()
     i++;
   }
 
+  // Release the open event streams so their connections can be closed
+  eventStream->close();
+
   // Request the server thread to stop gracefully
   server.stopServer(); // Add a stop() method to your Server class
 
   // Wait for the server thread to finish
   serverThread.join(); // Wait for completion before continuing
 
+  // Stop the camera consumers before the cameras are disconnected.
+  autoBrightness->stop();
+  stateWaiter->stop();
+  frameAnalyzer->stop();
+  frameRecorder->stop();
+  monitoringReceiver->stop();
+  thumbnailCache->stop();
+  contentTransfer->stop();
+  contentsCatalog->stop();
+  liveView->stop();
+
+  // Camera calls abandoned at a deadline still use the cameras and hold their camera command
+  bool callsReturned = LaunchedCalls::waitAll(std::chrono::milliseconds(LAUNCHED_CALLS_SHUTDOWN_MS));
+  if (!callsReturned)
+  {
+    spdlog::warn("{} camera calls still running at exit, the camera interface and queues are not freed", LaunchedCalls::running());
+  }
+
   {
     // Ensure thread safety during cleanup
     std::lock_guard<std::mutex> lock(resourceMutex);
@@ -502,9 +626,30 @@ int main()
     crsdk->releaseCameraRemoteSDK();
   }
 
-  delete crsdk;
+  delete autoBrightness;
+  delete frameAnalyzer;
+  delete focusVerifier;
+  delete liveViewScaler;
+  delete monitoringReceiver;
+  delete stateWaiter;
+  delete settingsCache;
+  delete mediaLibrary;
+  delete thumbnailCache;
+  delete contentTransfer;
+  delete contentsCatalog;
+  delete frameReplay;
+  delete frameRecorder;
+  delete liveView;
+  delete eventStream;
   delete gpioPin;
 
+  // Left to the exit while a call may still reach them
+  if (callsReturned)
+  {
+    delete cameraScheduler;
+    delete crsdk;
+  }
+
   spdlog::info("Deleting the instance of the CrSDKInterface class was successful");
 
   // Print a message when the program stops
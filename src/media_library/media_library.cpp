@@ -0,0 +1,239 @@
+#include "media_library.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MediaReader::MediaReader(int fd)
+    : fd_(fd), buffer_(MEDIA_READ_CHUNK_BYTES)
+{
+}
+
+MediaReader::~MediaReader()
+{
+    close(fd_);
+}
+
+std::shared_ptr<MediaReader> MediaReader::open(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        spdlog::warn("Failed to open {}: {}", path, std::strerror(errno));
+        return nullptr;
+    }
+
+    // Downloads read front to back, let the kernel read ahead
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    return std::shared_ptr<MediaReader>(new MediaReader(fd));
+}
+
+const char *MediaReader::read(std::uint64_t offset, std::size_t maxSize, std::size_t &size)
+{
+    size = 0;
+    std::size_t wanted = std::min(maxSize, buffer_.size());
+    while (size < wanted)
+    {
+        ssize_t count = pread(fd_, buffer_.data() + size, wanted - size, static_cast<off_t>(offset + size));
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return nullptr;
+        }
+        if (count == 0)
+        {
+            break;
+        }
+        size += static_cast<std::size_t>(count);
+    }
+    return buffer_.data();
+}
+
+MediaLibrary::MediaLibrary(ContentTransfer *contentTransfer)
+    : contentTransfer_(contentTransfer)
+{
+}
+
+void MediaLibrary::describe(MediaFile &file, std::uint64_t size, std::time_t modified, long modifiedNs)
+{
+    file.size = size;
+    file.modified = modified;
+    file.etag = fmt::format("\"{:x}-{:x}-{:x}\"", size, static_cast<long long>(modified), modifiedNs);
+
+    char date[64];
+    std::tm tm;
+    gmtime_r(&modified, &tm);
+    std::strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    file.lastModified = date;
+}
+
+bool MediaLibrary::find(int cameraNumber, const std::string &relativePath, MediaFile &file) const
+{
+    if (contentTransfer_ == nullptr || relativePath.empty() || relativePath.size() > PATH_MAX)
+    {
+        return false;
+    }
+
+    char root[PATH_MAX];
+    if (realpath(contentTransfer_->getCameraDirectory(cameraNumber).c_str(), root) == nullptr)
+    {
+        return false;
+    }
+
+    // Symbolic links and ".." must not lead out of the camera directory
+    char resolved[PATH_MAX];
+    std::string requested = std::string(root) + "/" + relativePath;
+    if (realpath(requested.c_str(), resolved) == nullptr)
+    {
+        return false;
+    }
+
+    std::string path(resolved);
+    std::string prefix = std::string(root) + "/";
+    if (path.compare(0, prefix.size(), prefix) != 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (stat(path.c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+    {
+        return false;
+    }
+
+    file.path = path;
+    file.relativePath = path.substr(prefix.size());
+    describe(file, static_cast<std::uint64_t>(fileStat.st_size), fileStat.st_mtim.tv_sec, fileStat.st_mtim.tv_nsec);
+    return true;
+}
+
+std::vector<MediaFile> MediaLibrary::list(int cameraNumber) const
+{
+    std::vector<MediaFile> files;
+    if (contentTransfer_ == nullptr)
+    {
+        return files;
+    }
+
+    std::string root = contentTransfer_->getCameraDirectory(cameraNumber);
+    try
+    {
+        for (const auto &item : fs::recursive_directory_iterator(root))
+        {
+            if (files.size() >= MEDIA_LIST_LIMIT)
+            {
+                break;
+            }
+
+            struct stat fileStat;
+            std::string path = item.path().string();
+            if (stat(path.c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+            {
+                continue;
+            }
+
+            MediaFile file;
+            file.path = path;
+            file.relativePath = path.substr(root.size() + 1);
+            describe(file, static_cast<std::uint64_t>(fileStat.st_size), fileStat.st_mtim.tv_sec, fileStat.st_mtim.tv_nsec);
+            files.push_back(file);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::warn("Failed to list {}: {}", root, e.what());
+    }
+
+    std::sort(files.begin(), files.end(), [](const MediaFile &a, const MediaFile &b)
+    {
+        return a.modified != b.modified ? a.modified > b.modified : a.relativePath < b.relativePath;
+    });
+    return files;
+}
+
+MediaRange MediaLibrary::parseRange(const std::string &header, std::uint64_t size, std::uint64_t &offset, std::uint64_t &length)
+{
+    offset = 0;
+    length = size;
+
+    const std::string unit = "bytes=";
+    if (header.compare(0, unit.size(), unit) != 0 || header.find(',') != std::string::npos)
+    {
+        return MediaRange::Full;
+    }
+
+    std::string spec = header.substr(unit.size());
+    std::size_t dash = spec.find('-');
+    if (dash == std::string::npos)
+    {
+        return MediaRange::Full;
+    }
+
+    std::string first = spec.substr(0, dash);
+    std::string last = spec.substr(dash + 1);
+    auto isNumber = [](const std::string &value)
+    {
+        return !value.empty() && value.size() <= 19 && std::all_of(value.begin(), value.end(), [](char c) { return c >= '0' && c <= '9'; });
+    };
+
+    if (first.empty())
+    {
+        // Suffix range: the last N bytes
+        if (!isNumber(last))
+        {
+            return MediaRange::Full;
+        }
+        std::uint64_t suffix = std::stoull(last);
+        if (suffix == 0 || size == 0)
+        {
+            return MediaRange::Unsatisfiable;
+        }
+        length = std::min(suffix, size);
+        offset = size - length;
+        return MediaRange::Partial;
+    }
+
+    if (!isNumber(first) || (!last.empty() && !isNumber(last)))
+    {
+        return MediaRange::Full;
+    }
+
+    std::uint64_t start = std::stoull(first);
+    if (start >= size)
+    {
+        return MediaRange::Unsatisfiable;
+    }
+
+    std::uint64_t end = last.empty() ? size - 1 : std::min<std::uint64_t>(std::stoull(last), size - 1);
+    if (end < start)
+    {
+        return MediaRange::Full;
+    }
+
+    offset = start;
+    length = end - start + 1;
+    return MediaRange::Partial;
+}
+
+bool MediaLibrary::matchesIfRange(const std::string &header, const MediaFile &file)
+{
+    if (header.empty())
+    {
+        return true;
+    }
+
+    // An entity tag must match exactly, a date must be the modification time
+    if (header[0] == '"')
+    {
+        return header == file.etag;
+    }
+    return header == file.lastModified;
+}
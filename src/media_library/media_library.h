@@ -0,0 +1,139 @@
+#ifndef MEDIA_LIBRARY_H
+#define MEDIA_LIBRARY_H
+
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+#include "../content_transfer/content_transfer.h"
+
+#define MEDIA_READ_CHUNK_BYTES (256u * 1024u)       // Bytes read and sent per provider call
+#define MEDIA_LIST_LIMIT 10000
+
+/**
+ * @brief A pulled file on the local disk.
+ */
+struct MediaFile
+{
+    std::string path;                           ///< Absolute path
+    std::string relativePath;                   ///< Path below the camera directory
+    std::uint64_t size = 0;                     ///< File size in bytes
+    std::time_t modified = 0;                   ///< Last modification time
+    std::string etag;                           ///< Strong validator (size and modification time)
+    std::string lastModified;                   ///< Modification time as an HTTP date
+};
+
+/**
+ * @brief Result of parsing a Range header against a file size.
+ */
+enum class MediaRange
+{
+    Full,               ///< No usable range, send the whole file
+    Partial,            ///< A single satisfiable range
+    Unsatisfiable       ///< The range lies beyond the end of the file
+};
+
+/**
+ * @brief Reads a file in fixed-size chunks at given offsets.
+ *
+ * Every read reuses the same buffer, so a download holds one chunk in memory whatever the
+ * size of the file.
+ */
+class MediaReader
+{
+public:
+    /**
+     * @brief Opens a file for sequential reading.
+     * @param path The file to read.
+     * @return The reader, or nullptr on error.
+     */
+    static std::shared_ptr<MediaReader> open(const std::string &path);
+
+    /**
+     * @brief Closes the file.
+     */
+    ~MediaReader();
+
+    MediaReader(const MediaReader &) = delete;
+    MediaReader &operator=(const MediaReader &) = delete;
+
+    /**
+     * @brief Reads up to one chunk at an offset.
+     * @param offset The file offset.
+     * @param maxSize The maximum number of bytes to read.
+     * @param size Receives the number of bytes read.
+     * @return The read bytes, or nullptr on error.
+     */
+    const char *read(std::uint64_t offset, std::size_t maxSize, std::size_t &size);
+
+private:
+    explicit MediaReader(int fd);
+
+    int fd_;                            ///< The open file
+    std::vector<char> buffer_;          ///< Chunk buffer
+};
+
+/**
+ * @brief The MediaLibrary class gives access to the contents pulled from the cameras.
+ *
+ * Files are looked up below the camera directories of the content transfer; paths that
+ * leave them are rejected.
+ */
+class MediaLibrary
+{
+public:
+    /**
+     * @brief Constructs a MediaLibrary object.
+     * @param contentTransfer instance of ContentTransfer class owning the camera directories.
+     */
+    explicit MediaLibrary(ContentTransfer *contentTransfer);
+
+    /**
+     * @brief Resolves a path below the directory of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param relativePath The path below the camera directory.
+     * @param file Receives the file.
+     * @return false if the path is invalid or not a regular file.
+     */
+    bool find(int cameraNumber, const std::string &relativePath, MediaFile &file) const;
+
+    /**
+     * @brief Lists the files of a camera, newest first.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    std::vector<MediaFile> list(int cameraNumber) const;
+
+    /**
+     * @brief Parses a Range header.
+     *
+     * Only single ranges are served; multiple ranges are answered with the whole file.
+     *
+     * @param header The value of the Range header.
+     * @param size The file size.
+     * @param offset Receives the first byte of the range.
+     * @param length Receives the length of the range.
+     */
+    static MediaRange parseRange(const std::string &header, std::uint64_t size, std::uint64_t &offset, std::uint64_t &length);
+
+    /**
+     * @brief Checks an If-Range header against a file.
+     * @param header The value of the If-Range header.
+     * @param file The file.
+     * @return true if the range may be applied.
+     */
+    static bool matchesIfRange(const std::string &header, const MediaFile &file);
+
+private:
+    /**
+     * @brief Fills the validators of a file from its status.
+     */
+    static void describe(MediaFile &file, std::uint64_t size, std::time_t modified, long modifiedNs);
+
+    ContentTransfer *contentTransfer_;      ///< Owner of the camera directories
+};
+
+#endif // MEDIA_LIBRARY_H
@@ -0,0 +1,751 @@
+#include "monitoring_receiver.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <ifaddrs.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * @brief Returns true for the markers without a length field (TEM and RST0-RST7).
+ */
+static bool isStandaloneMarker(std::uint8_t marker)
+{
+    return marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7);
+}
+
+void JpegStreamParser::feed(const std::uint8_t *data, std::size_t size, std::vector<std::vector<std::uint8_t>> &frames)
+{
+    buffer_.insert(buffer_.end(), data, data + size);
+
+    while (true)
+    {
+        std::size_t end = 0;
+
+        if (state_ == State::SeekStart)
+        {
+            std::size_t start = 0;
+            while (start + 1 < buffer_.size() && !(buffer_[start] == 0xFF && buffer_[start + 1] == 0xD8))
+            {
+                start++;
+            }
+
+            if (start + 1 >= buffer_.size())
+            {
+                // Keep a trailing 0xFF, it may be the first half of the next SOI
+                std::size_t keep = (!buffer_.empty() && buffer_.back() == 0xFF) ? 1 : 0;
+                discardedBytes_ += buffer_.size() - keep;
+                buffer_.erase(buffer_.begin(), buffer_.end() - keep);
+                return;
+            }
+
+            discardedBytes_ += start;
+            buffer_.erase(buffer_.begin(), buffer_.begin() + start);
+            position_ = 2;
+            state_ = State::Markers;
+            continue;
+        }
+
+        if (buffer_.size() > MONITORING_MAX_FRAME_BYTES)
+        {
+            spdlog::warn("Pushed JPEG exceeds {} bytes, resynchronizing", MONITORING_MAX_FRAME_BYTES);
+            resync();
+            continue;
+        }
+
+        if (state_ == State::Markers)
+        {
+            if (position_ + 2 > buffer_.size())
+            {
+                return;
+            }
+
+            if (buffer_[position_] != 0xFF)
+            {
+                resync();
+                continue;
+            }
+
+            std::uint8_t marker = buffer_[position_ + 1];
+            if (marker == 0xFF)
+            {
+                // Fill byte before a marker
+                position_++;
+                continue;
+            }
+
+            if (marker == 0xD9)
+            {
+                end = position_ + 2;
+            }
+            else if (marker == 0xD8)
+            {
+                resync();
+                continue;
+            }
+            else if (isStandaloneMarker(marker))
+            {
+                position_ += 2;
+                continue;
+            }
+            else
+            {
+                if (position_ + 4 > buffer_.size())
+                {
+                    return;
+                }
+
+                std::size_t length = (static_cast<std::size_t>(buffer_[position_ + 2]) << 8) | buffer_[position_ + 3];
+                if (length < 2)
+                {
+                    resync();
+                    continue;
+                }
+
+                if (position_ + 2 + length > buffer_.size())
+                {
+                    return;
+                }
+
+                position_ += 2 + length;
+                if (marker == 0xDA)
+                {
+                    state_ = State::EntropyData;
+                }
+                continue;
+            }
+        }
+        else
+        {
+            const std::uint8_t *found = static_cast<const std::uint8_t *>(std::memchr(buffer_.data() + position_, 0xFF, buffer_.size() - position_));
+            if (found == nullptr)
+            {
+                position_ = buffer_.size();
+                return;
+            }
+
+            std::size_t index = found - buffer_.data();
+            if (index + 1 >= buffer_.size())
+            {
+                position_ = index;
+                return;
+            }
+
+            std::uint8_t next = buffer_[index + 1];
+            if (next == 0x00 || (next >= 0xD0 && next <= 0xD7))
+            {
+                // Stuffed byte or restart marker, still compressed data
+                position_ = index + 2;
+                continue;
+            }
+            if (next == 0xFF)
+            {
+                position_ = index + 1;
+                continue;
+            }
+            if (next != 0xD9)
+            {
+                // Tables or the next scan of a progressive image
+                position_ = index;
+                state_ = State::Markers;
+                continue;
+            }
+
+            end = index + 2;
+        }
+
+        frames.emplace_back(buffer_.begin(), buffer_.begin() + end);
+        buffer_.erase(buffer_.begin(), buffer_.begin() + end);
+        position_ = 0;
+        state_ = State::SeekStart;
+    }
+}
+
+void JpegStreamParser::reset()
+{
+    discardedBytes_ += buffer_.size();
+    buffer_.clear();
+    position_ = 0;
+    state_ = State::SeekStart;
+}
+
+void JpegStreamParser::resync()
+{
+    discardedBytes_++;
+    buffer_.erase(buffer_.begin());
+    position_ = 0;
+    state_ = State::SeekStart;
+}
+
+MonitoringReceiver::MonitoringReceiver(CrSDKInterface *crsdkInterface, LiveView *liveView, int basePort)
+    : crsdkInterface_(crsdkInterface), liveView_(liveView), basePort_(basePort), running_(false)
+{
+    if (liveView_ != nullptr)
+    {
+        for (int i = 0; i < liveView_->getCameraCount(); ++i)
+        {
+            cameras_.emplace_back(new CameraSockets());
+            cameras_.back()->status.port = basePort_ + i;
+        }
+    }
+}
+
+MonitoringReceiver::~MonitoringReceiver()
+{
+    stop();
+}
+
+bool MonitoringReceiver::start()
+{
+    if (crsdkInterface_ == nullptr || liveView_ == nullptr)
+    {
+        spdlog::error("Monitoring receiver cannot start without the cameras and the live view.");
+        return false;
+    }
+
+    if (running_.load())
+    {
+        return true;
+    }
+
+    for (std::size_t i = 0; i < cameras_.size(); ++i)
+    {
+        CameraSockets &camera = *cameras_[i];
+
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(static_cast<std::uint16_t>(camera.status.port));
+
+        int reuse = 1;
+        camera.tcpListenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        camera.udpFd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+        if (camera.tcpListenFd < 0 || camera.udpFd < 0 ||
+            setsockopt(camera.tcpListenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+            bind(camera.tcpListenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+            listen(camera.tcpListenFd, 1) != 0 ||
+            bind(camera.udpFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            spdlog::error("Failed to open the monitoring port {} of camera {}: {}", camera.status.port, i, std::strerror(errno));
+            for (auto &opened : cameras_)
+            {
+                if (opened->tcpListenFd >= 0)
+                {
+                    close(opened->tcpListenFd);
+                    opened->tcpListenFd = -1;
+                }
+                if (opened->udpFd >= 0)
+                {
+                    close(opened->udpFd);
+                    opened->udpFd = -1;
+                }
+            }
+            return false;
+        }
+
+        // Leave room for a few frames if the receiver thread is late
+        int receiveBuffer = 4 * 1024 * 1024;
+        setsockopt(camera.udpFd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+    }
+
+    receiveBuffer_.resize(64 * 1024);
+    running_.store(true);
+    receiverThread_ = std::thread([this]()
+    {
+        receiveLoop();
+    });
+
+    spdlog::info("Monitoring receiver listening on ports {}-{} (TCP and UDP).", basePort_, basePort_ + static_cast<int>(cameras_.size()) - 1);
+    return true;
+}
+
+void MonitoringReceiver::stop()
+{
+    if (!running_.load())
+    {
+        return;
+    }
+
+    for (std::size_t i = 0; i < cameras_.size(); ++i)
+    {
+        disable(static_cast<int>(i));
+    }
+
+    running_.store(false);
+    if (receiverThread_.joinable())
+    {
+        receiverThread_.join();
+    }
+
+    for (auto &camera : cameras_)
+    {
+        for (int *fd : {&camera->tcpListenFd, &camera->tcpFd, &camera->udpFd})
+        {
+            if (*fd >= 0)
+            {
+                close(*fd);
+                *fd = -1;
+            }
+        }
+    }
+
+    spdlog::info("Monitoring receiver stopped.");
+}
+
+std::string MonitoringReceiver::enable(int cameraNumber, const std::string &hostIp, bool loopback, bool udp)
+{
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        return "Camera_id out of range.";
+    }
+
+    if (!running_.load())
+    {
+        return "Monitoring receiver is not running";
+    }
+
+    CameraSockets &camera = *cameras_[cameraNumber];
+    disable(cameraNumber);
+
+    if (loopback)
+    {
+        camera.senderAddress.store(htonl(INADDR_LOOPBACK));
+        camera.loopbackRunning.store(true);
+        camera.loopbackThread = std::thread([this, cameraNumber, udp]()
+        {
+            loopbackLoop(cameraNumber, udp);
+        });
+    }
+    else
+    {
+        CameraDevicePtr device = crsdkInterface_->cameraList.at(cameraNumber);
+        if (!device || !device->is_connected())
+        {
+            return "Camera is not connected";
+        }
+
+        // Only the camera may push into its live view
+        in_addr cameraAddress;
+        if (inet_pton(AF_INET, device->ip_address_fmt().c_str(), &cameraAddress) != 1)
+        {
+            return "The camera has no network address, the delivery needs a network connection";
+        }
+        camera.senderAddress.store(cameraAddress.s_addr);
+
+        auto err = device->set_monitoring_delivery(hostIp, static_cast<CrInt32u>(camera.status.port), 0);
+        if (!CR_SUCCEEDED(err))
+        {
+            spdlog::error("Failed to set the monitoring delivery of camera {}: 0x{:X}", cameraNumber, err);
+            camera.senderAddress.store(0);
+            return fmt::format("Failed to set the monitoring delivery (0x{:X})", err);
+        }
+
+        err = device->control_monitoring(true);
+        if (!CR_SUCCEEDED(err))
+        {
+            spdlog::error("Failed to start the monitoring of camera {}: 0x{:X}", cameraNumber, err);
+            camera.senderAddress.store(0);
+            return fmt::format("Failed to start the monitoring (0x{:X})", err);
+        }
+    }
+
+    {
+        // The live view keeps pulling until the first pushed frame arrives
+        std::lock_guard<std::mutex> lock(mutex_);
+        camera.status.enabled = true;
+        camera.status.loopback = loopback;
+        camera.status.receiving = false;
+    }
+
+    spdlog::info("Monitoring delivery of camera {} enabled to {}:{}{}", cameraNumber, loopback ? "127.0.0.1" : hostIp, camera.status.port, loopback ? (udp ? " (loopback, UDP)" : " (loopback, TCP)") : "");
+    return "";
+}
+
+void MonitoringReceiver::disable(int cameraNumber)
+{
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        return;
+    }
+
+    CameraSockets &camera = *cameras_[cameraNumber];
+    bool enabled;
+    bool loopback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        enabled = camera.status.enabled;
+        loopback = camera.status.loopback;
+        camera.status.enabled = false;
+        camera.status.receiving = false;
+    }
+
+    camera.senderAddress.store(0);
+    if (!enabled)
+    {
+        return;
+    }
+
+    if (loopback)
+    {
+        stopLoopback(cameraNumber);
+    }
+    else
+    {
+        CameraDevicePtr device = crsdkInterface_->cameraList.at(cameraNumber);
+        if (device && device->is_connected())
+        {
+            auto err = device->control_monitoring(false);
+            if (!CR_SUCCEEDED(err))
+            {
+                spdlog::warn("Failed to stop the monitoring of camera {}: 0x{:X}", cameraNumber, err);
+            }
+        }
+    }
+
+    liveView_->setPushed(cameraNumber, false);
+    spdlog::info("Monitoring delivery of camera {} disabled", cameraNumber);
+}
+
+MonitoringStatus MonitoringReceiver::getStatus(int cameraNumber) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        return MonitoringStatus();
+    }
+
+    return cameras_[cameraNumber]->status;
+}
+
+bool MonitoringReceiver::isLocalAddress(const std::string &hostIp)
+{
+    in_addr address;
+    if (inet_pton(AF_INET, hostIp.c_str(), &address) != 1)
+    {
+        return false;
+    }
+
+    ifaddrs *interfaces = nullptr;
+    if (getifaddrs(&interfaces) != 0)
+    {
+        spdlog::error("Cannot list the network interfaces: {}", std::strerror(errno));
+        return false;
+    }
+
+    bool found = false;
+    for (ifaddrs *interface = interfaces; interface != nullptr && !found; interface = interface->ifa_next)
+    {
+        if (interface->ifa_addr != nullptr && interface->ifa_addr->sa_family == AF_INET)
+        {
+            const sockaddr_in *interfaceAddress = reinterpret_cast<const sockaddr_in *>(interface->ifa_addr);
+            found = interfaceAddress->sin_addr.s_addr == address.s_addr;
+        }
+    }
+    freeifaddrs(interfaces);
+    return found;
+}
+
+void MonitoringReceiver::receiveLoop()
+{
+    std::vector<pollfd> fds;
+    std::vector<std::pair<int, int>> owners; // (camera, 0 = listener, 1 = TCP, 2 = UDP)
+
+    while (running_.load())
+    {
+        fds.clear();
+        owners.clear();
+        for (std::size_t i = 0; i < cameras_.size(); ++i)
+        {
+            CameraSockets &camera = *cameras_[i];
+            fds.push_back({camera.tcpListenFd, POLLIN, 0});
+            owners.emplace_back(static_cast<int>(i), 0);
+            if (camera.tcpFd >= 0)
+            {
+                fds.push_back({camera.tcpFd, POLLIN, 0});
+                owners.emplace_back(static_cast<int>(i), 1);
+            }
+            fds.push_back({camera.udpFd, POLLIN, 0});
+            owners.emplace_back(static_cast<int>(i), 2);
+        }
+
+        int ready = poll(fds.data(), fds.size(), MONITORING_POLL_MS);
+        if (ready < 0 && errno != EINTR)
+        {
+            spdlog::error("Monitoring receiver poll failed: {}", std::strerror(errno));
+            std::this_thread::sleep_for(std::chrono::milliseconds(MONITORING_POLL_MS));
+        }
+
+        for (std::size_t k = 0; ready > 0 && k < fds.size(); ++k)
+        {
+            if (fds[k].revents == 0)
+            {
+                continue;
+            }
+
+            int cameraNumber = owners[k].first;
+            CameraSockets &camera = *cameras_[cameraNumber];
+
+            if (owners[k].second == 0)
+            {
+                sockaddr_in peer;
+                socklen_t peerLength = sizeof(peer);
+                int fd = accept4(camera.tcpListenFd, reinterpret_cast<sockaddr *>(&peer), &peerLength, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd >= 0 && !acceptSender(cameraNumber, peer))
+                {
+                    close(fd);
+                }
+                else if (fd >= 0)
+                {
+                    // One sender per camera: a new connection replaces the previous one
+                    if (camera.tcpFd >= 0)
+                    {
+                        close(camera.tcpFd);
+                    }
+                    camera.tcpFd = fd;
+                    camera.tcpParser.reset();
+
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    camera.status.tcpConnections++;
+                }
+            }
+            else if (owners[k].second == 1)
+            {
+                if (!receive(cameraNumber, camera.tcpFd, false))
+                {
+                    close(camera.tcpFd);
+                    camera.tcpFd = -1;
+                    camera.tcpParser.reset();
+                }
+            }
+            else
+            {
+                receive(cameraNumber, camera.udpFd, true);
+            }
+        }
+
+        for (std::size_t i = 0; i < cameras_.size(); ++i)
+        {
+            checkStall(static_cast<int>(i));
+        }
+    }
+}
+
+bool MonitoringReceiver::acceptSender(int cameraNumber, const sockaddr_in &address)
+{
+    CameraSockets &camera = *cameras_[cameraNumber];
+    std::uint32_t sender = camera.senderAddress.load();
+    if (address.sin_family == AF_INET && sender != 0 && address.sin_addr.s_addr == sender)
+    {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (camera.status.refused++ == 0)
+    {
+        char text[INET_ADDRSTRLEN] = "";
+        inet_ntop(AF_INET, &address.sin_addr, text, sizeof(text));
+        spdlog::warn("Monitoring delivery of camera {} refused from {}, not the camera", cameraNumber, text);
+    }
+    return false;
+}
+
+bool MonitoringReceiver::receive(int cameraNumber, int fd, bool udp)
+{
+    CameraSockets &camera = *cameras_[cameraNumber];
+    JpegStreamParser &parser = udp ? camera.udpParser : camera.tcpParser;
+    std::vector<std::vector<std::uint8_t>> frames;
+    std::uint64_t bytes = 0;
+    bool open = true;
+
+    while (true)
+    {
+        sockaddr_in source;
+        socklen_t sourceLength = sizeof(source);
+        ssize_t received = udp ? recvfrom(fd, receiveBuffer_.data(), receiveBuffer_.size(), 0, reinterpret_cast<sockaddr *>(&source), &sourceLength)
+                               : recv(fd, receiveBuffer_.data(), receiveBuffer_.size(), 0);
+        if (received < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            open = (errno == EAGAIN || errno == EWOULDBLOCK);
+            break;
+        }
+        if (received == 0 && !udp)
+        {
+            open = false;
+            break;
+        }
+
+        // The TCP peer was checked on accept, every datagram is checked
+        if (udp && !acceptSender(cameraNumber, source))
+        {
+            continue;
+        }
+
+        bytes += static_cast<std::uint64_t>(received);
+        parser.feed(receiveBuffer_.data(), static_cast<std::size_t>(received), frames);
+    }
+
+    bool enabled;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        enabled = camera.status.enabled;
+        camera.status.bytes += bytes;
+        camera.status.discardedBytes = camera.tcpParser.getDiscardedBytes() + camera.udpParser.getDiscardedBytes();
+        if (enabled)
+        {
+            camera.status.frames += frames.size();
+        }
+    }
+
+    // Frames still arriving after the delivery was disabled are dropped
+    if (enabled)
+    {
+        for (auto &frame : frames)
+        {
+            liveView_->publishFrame(cameraNumber, std::move(frame), ++camera.frameNo);
+            camera.lastFrame = std::chrono::steady_clock::now();
+        }
+    }
+
+    return open;
+}
+
+void MonitoringReceiver::checkStall(int cameraNumber)
+{
+    CameraSockets &camera = *cameras_[cameraNumber];
+    bool fresh = std::chrono::steady_clock::now() - camera.lastFrame < std::chrono::milliseconds(MONITORING_STALL_MS);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!camera.status.enabled || camera.status.receiving == fresh)
+        {
+            return;
+        }
+        camera.status.receiving = fresh;
+    }
+
+    liveView_->setPushed(cameraNumber, fresh);
+    if (fresh)
+    {
+        spdlog::info("Camera {} is pushing its frames, live-view pulling paused", cameraNumber);
+    }
+    else
+    {
+        spdlog::warn("No pushed frame of camera {} for {} ms, pulling the live view again", cameraNumber, MONITORING_STALL_MS);
+    }
+}
+
+void MonitoringReceiver::stopLoopback(int cameraNumber)
+{
+    CameraSockets &camera = *cameras_[cameraNumber];
+    camera.loopbackRunning.store(false);
+    if (camera.loopbackThread.joinable())
+    {
+        camera.loopbackThread.join();
+    }
+}
+
+void MonitoringReceiver::loopbackLoop(int cameraNumber, bool udp)
+{
+    CameraSockets &camera = *cameras_[cameraNumber];
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<std::uint16_t>(camera.status.port));
+
+    // Synthetic frames: the SDK live view cannot be pulled here without racing the producer
+    JpegCodec codec;
+    RgbxImage image;
+    image.width = 640;
+    image.height = 480;
+    image.pixels.resize(static_cast<std::size_t>(image.width) * image.height * 4);
+
+    std::vector<std::uint8_t> jpeg;
+    std::vector<std::uint8_t> packet;
+    int fd = -1;
+    std::uint32_t counter = 0;
+
+    while (camera.loopbackRunning.load())
+    {
+        if (fd < 0)
+        {
+            fd = socket(AF_INET, (udp ? SOCK_DGRAM : SOCK_STREAM) | SOCK_CLOEXEC, 0);
+            if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+            {
+                spdlog::warn("Monitoring stand-in sender of camera {} cannot connect: {}", cameraNumber, std::strerror(errno));
+                close(fd);
+                fd = -1;
+            }
+            if (fd < 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(MONITORING_STALL_MS / 3));
+                continue;
+            }
+        }
+
+        // Moving bar over a gradient, so consecutive frames differ
+        int bar = static_cast<int>(counter * 8 % image.width);
+        for (int y = 0; y < image.height; ++y)
+        {
+            std::uint8_t *row = image.pixels.data() + static_cast<std::size_t>(y) * image.width * 4;
+            for (int x = 0; x < image.width; ++x)
+            {
+                std::uint8_t value = (x >= bar && x < bar + 16) ? 255 : static_cast<std::uint8_t>((x + y) * 255 / (image.width + image.height));
+                row[x * 4] = value;
+                row[x * 4 + 1] = value;
+                row[x * 4 + 2] = static_cast<std::uint8_t>(255 - value);
+                row[x * 4 + 3] = 255;
+            }
+        }
+        counter++;
+
+        if (!codec.encodeRgbx(image, 80, jpeg))
+        {
+            break;
+        }
+
+        // A transport header in front of the image, as a real sender may add one
+        packet.assign({'M', 'O', 'N', 'I',
+                       static_cast<std::uint8_t>(jpeg.size() >> 24), static_cast<std::uint8_t>(jpeg.size() >> 16),
+                       static_cast<std::uint8_t>(jpeg.size() >> 8), static_cast<std::uint8_t>(jpeg.size())});
+        packet.insert(packet.end(), jpeg.begin(), jpeg.end());
+
+        bool sent = true;
+        for (std::size_t offset = 0; sent && offset < packet.size();)
+        {
+            std::size_t chunk = udp ? std::min<std::size_t>(MONITORING_DATAGRAM_BYTES, packet.size() - offset) : packet.size() - offset;
+            ssize_t written = send(fd, packet.data() + offset, chunk, MSG_NOSIGNAL);
+            if (written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            sent = written > 0;
+            offset += sent ? static_cast<std::size_t>(written) : 0;
+        }
+
+        if (!sent)
+        {
+            close(fd);
+            fd = -1;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(MONITORING_LOOPBACK_INTERVAL_MS));
+    }
+
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
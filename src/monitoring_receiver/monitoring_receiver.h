@@ -0,0 +1,237 @@
+#ifndef MONITORING_RECEIVER_H
+#define MONITORING_RECEIVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+#include "../CrSDK_interface/CrSDK_interface.h"
+#include "../live_view/live_view.h"
+#include "../ImageAnalysis/jpeg_codec/jpeg_codec.h"
+
+#define MONITORING_BASE_PORT 50100                  // Camera n delivers to MONITORING_BASE_PORT + n
+#define MONITORING_MAX_FRAME_BYTES (8u * 1024u * 1024u)
+#define MONITORING_STALL_MS 3000                    // Fall back to pulling after this long without a pushed frame
+#define MONITORING_POLL_MS 200
+#define MONITORING_DATAGRAM_BYTES 1400
+#define MONITORING_LOOPBACK_INTERVAL_MS 66
+
+/**
+ * @brief Reassembles JPEG images from a byte stream.
+ *
+ * The delivery framing of the camera is not part of the SDK, so the parser does not rely on
+ * it: it looks for the SOI marker, walks the marker segments by their lengths (so embedded
+ * thumbnails are skipped) and scans the entropy-coded data for the EOI marker. Anything
+ * between two images, such as transport headers, is discarded.
+ */
+class JpegStreamParser
+{
+public:
+    /**
+     * @brief Feeds received bytes to the parser.
+     * @param data The received bytes.
+     * @param size The number of bytes.
+     * @param frames Receives the completed images.
+     */
+    void feed(const std::uint8_t *data, std::size_t size, std::vector<std::vector<std::uint8_t>> &frames);
+
+    /**
+     * @brief Drops a partially received image (connection closed or datagram lost).
+     */
+    void reset();
+
+    /**
+     * @brief Returns the number of bytes discarded outside of images.
+     */
+    std::uint64_t getDiscardedBytes() const { return discardedBytes_; }
+
+private:
+    enum class State
+    {
+        SeekStart,      ///< Looking for SOI
+        Markers,        ///< Walking the marker segments
+        EntropyData     ///< Scanning the compressed data for the next marker
+    };
+
+    /**
+     * @brief Drops the first byte of the buffer and looks for the next SOI.
+     */
+    void resync();
+
+    std::vector<std::uint8_t> buffer_;      ///< Bytes of the current image
+    std::size_t position_ = 0;              ///< Parse position in the buffer
+    State state_ = State::SeekStart;        ///< Parser state
+    std::uint64_t discardedBytes_ = 0;      ///< Bytes discarded outside of images
+};
+
+/**
+ * @brief Push delivery state of a camera.
+ */
+struct MonitoringStatus
+{
+    bool enabled = false;                   ///< True while push delivery is requested
+    bool loopback = false;                  ///< True if the local stand-in sender is used
+    bool receiving = false;                 ///< True while pushed frames arrive (false = pull fallback)
+    int port = 0;                           ///< Port the frames are delivered to
+    std::uint64_t frames = 0;               ///< Reassembled frames
+    std::uint64_t bytes = 0;                ///< Received bytes
+    std::uint64_t discardedBytes = 0;       ///< Bytes outside of images
+    std::uint64_t tcpConnections = 0;       ///< Accepted TCP connections
+    std::uint64_t refused = 0;              ///< Connections and datagrams refused for their source
+};
+
+/**
+ * @brief The MonitoringReceiver class receives the JPEG frames pushed by the cameras.
+ *
+ * With push delivery the camera sends its monitoring JPEGs to the server on its own
+ * (SetMonitoringDeliverySetting + ControlMonitoring) instead of answering one
+ * GetLiveViewImage call per frame. Every camera has a port (MONITORING_BASE_PORT + n) with
+ * a TCP listener and a UDP socket; one thread polls all sockets, reassembles the JPEGs and
+ * publishes them into the live-view ring, so every consumer of the live view uses them
+ * unchanged. While frames are pushed the live-view producer stops pulling; if no frame
+ * arrives for MONITORING_STALL_MS it pulls again until the push resumes.
+ *
+ * The ports are open to every interface, but only the camera a port belongs to (or
+ * 127.0.0.1 for the stand-in sender) may deliver to it, and only while the delivery is
+ * enabled; connections and datagrams of any other source are dropped.
+ *
+ * A local stand-in sender (loopback) pushes frames to the receiver for testing without a
+ * camera that supports the delivery.
+ */
+class MonitoringReceiver
+{
+public:
+    /**
+     * @brief Constructs a MonitoringReceiver object.
+     * @param crsdkInterface instance of CrSDKInterface class.
+     * @param liveView instance of LiveView class receiving the frames.
+     * @param basePort The port of the first camera.
+     */
+    MonitoringReceiver(CrSDKInterface *crsdkInterface, LiveView *liveView, int basePort = MONITORING_BASE_PORT);
+
+    /**
+     * @brief Stops push delivery and closes the sockets.
+     */
+    ~MonitoringReceiver();
+
+    /**
+     * @brief Opens the sockets and starts the receiver thread.
+     * @return true on success, false otherwise.
+     */
+    bool start();
+
+    /**
+     * @brief Stops push delivery of all cameras and the receiver thread.
+     */
+    void stop();
+
+    /**
+     * @brief Configures a camera to push its frames to this server and starts the delivery.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param hostIp The address of the server as seen by the camera.
+     * @param loopback True to use the local stand-in sender instead of the camera.
+     * @param udp True for the stand-in sender to use UDP instead of TCP.
+     * @return An error message, or an empty string on success.
+     */
+    std::string enable(int cameraNumber, const std::string &hostIp, bool loopback = false, bool udp = false);
+
+    /**
+     * @brief Stops the push delivery of a camera, the live view pulls again.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    void disable(int cameraNumber);
+
+    /**
+     * @brief Returns the push delivery state of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    MonitoringStatus getStatus(int cameraNumber) const;
+
+    /**
+     * @brief Returns true if an IPv4 address belongs to an interface of this machine.
+     *
+     * The frames are only delivered to the server itself, a camera is never pointed at
+     * another host.
+     *
+     * @param hostIp The address, dotted decimal.
+     */
+    static bool isLocalAddress(const std::string &hostIp);
+
+private:
+    /**
+     * @brief Sockets and parsers of a camera.
+     */
+    struct CameraSockets
+    {
+        int tcpListenFd = -1;                                   ///< TCP listener
+        int tcpFd = -1;                                         ///< Accepted TCP connection
+        int udpFd = -1;                                         ///< UDP socket
+        JpegStreamParser tcpParser;                             ///< Reassembly of the TCP stream
+        JpegStreamParser udpParser;                             ///< Reassembly of the datagrams
+        std::chrono::steady_clock::time_point lastFrame;        ///< Time of the last pushed frame
+        CrInt32u frameNo = 0;                                   ///< Frame number given to the pushed frames
+        MonitoringStatus status;                                ///< State and counters (mutex_)
+        std::thread loopbackThread;                             ///< Stand-in sender
+        std::atomic<bool> loopbackRunning{false};               ///< True while the stand-in sender runs
+        std::atomic<std::uint32_t> senderAddress{0};            ///< IPv4 address allowed to deliver (network order), 0 for none
+    };
+
+    /**
+     * @brief Loop of the receiver thread.
+     */
+    void receiveLoop();
+
+    /**
+     * @brief Returns true if an address may deliver the frames of a camera, counts it otherwise.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param address The source address.
+     */
+    bool acceptSender(int cameraNumber, const sockaddr_in &address);
+
+    /**
+     * @brief Reads what is available on a socket of a camera and publishes the completed frames.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param fd The socket.
+     * @param udp True for the UDP socket.
+     * @return false if the TCP connection was closed.
+     */
+    bool receive(int cameraNumber, int fd, bool udp);
+
+    /**
+     * @brief Switches the live view between pushed and pulled frames when the push stalls or resumes.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    void checkStall(int cameraNumber);
+
+    /**
+     * @brief Loop of the local stand-in sender of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param udp True to send datagrams instead of a TCP stream.
+     */
+    void loopbackLoop(int cameraNumber, bool udp);
+
+    /**
+     * @brief Stops the stand-in sender of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    void stopLoopback(int cameraNumber);
+
+    CrSDKInterface *crsdkInterface_;                            ///< Access to the cameras
+    LiveView *liveView_;                                        ///< Receiver of the pushed frames
+    int basePort_;                                              ///< Port of the first camera
+    std::vector<std::unique_ptr<CameraSockets>> cameras_;       ///< Per camera sockets
+    mutable std::mutex mutex_;                                  ///< Protects the status of the cameras
+    std::thread receiverThread_;                                ///< Receiver thread
+    std::atomic<bool> running_;                                 ///< True while the receiver thread runs
+    std::vector<std::uint8_t> receiveBuffer_;                   ///< Socket read buffer (receiver thread)
+};
+
+#endif // MONITORING_RECEIVER_H
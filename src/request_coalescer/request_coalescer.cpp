@@ -0,0 +1,78 @@
+#include "request_coalescer.h"
+
+bool RequestCoalescer::run(const std::string &key, const Deadline &deadline, httplib::Response &res, const std::function<void()> &call)
+{
+    std::shared_ptr<Flight> flight;
+    bool leader = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = flights_.find(key);
+        if (found == flights_.end())
+        {
+            flight = std::make_shared<Flight>();
+            flights_[key] = flight;
+            stats_.leaders++;
+            leader = true;
+        }
+        else
+        {
+            flight = found->second;
+        }
+    }
+
+    if (leader)
+    {
+        // The followers are released even if the route throws
+        try
+        {
+            call();
+        }
+        catch (...)
+        {
+            finish(key, flight, res);
+            throw;
+        }
+        finish(key, flight, res);
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto done = [&flight]() { return flight->done; };
+    if (!deadline.isSet())
+    {
+        done_.wait(lock, done);
+    }
+    else if (!done_.wait_until(lock, deadline.time(), done))
+    {
+        stats_.expired++;
+        return false;
+    }
+    stats_.shared++;
+
+    res.status = flight->status;
+    res.headers = flight->headers;
+    res.body = flight->body;
+    res.set_header(REQUEST_COALESCED_HEADER, "shared");
+    return true;
+}
+
+void RequestCoalescer::finish(const std::string &key, const std::shared_ptr<Flight> &flight, const httplib::Response &res)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    flight->status = res.status;
+    flight->headers = res.headers;
+    flight->body = res.body;
+    flight->done = true;
+
+    // Later requests run the route again and see the new state
+    flights_.erase(key);
+    done_.notify_all();
+}
+
+RequestCoalescerStats RequestCoalescer::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    RequestCoalescerStats stats = stats_;
+    stats.inFlight = flights_.size();
+    return stats;
+}
@@ -0,0 +1,81 @@
+#ifndef REQUEST_COALESCER_H
+#define REQUEST_COALESCER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#ifndef CPPHTTPLIB_OPENSSL_SUPPORT
+#define CPPHTTPLIB_OPENSSL_SUPPORT
+#endif
+#include <httplib.h>
+
+#include "../deadline/deadline.h"
+
+#define REQUEST_COALESCED_HEADER "X-Coalesced"     // Set on the responses copied from another request
+
+/**
+ * @brief Counters of the request coalescer.
+ */
+struct RequestCoalescerStats
+{
+    std::size_t inFlight = 0;                   ///< Requests being answered with followers possible
+    std::uint64_t leaders = 0;                  ///< Requests that ran the route
+    std::uint64_t shared = 0;                   ///< Requests answered with the response of a leader
+    std::uint64_t expired = 0;                  ///< Followers whose deadline passed first
+};
+
+/**
+ * @brief The RequestCoalescer class answers identical concurrent requests with one call.
+ *
+ * The first request of a key runs the route; requests of the same key arriving while it runs
+ * wait for it and receive a copy of its response. The key must cover everything the response
+ * depends on (route, parameters and negotiated encoding). Only buffered responses can be
+ * shared, not content providers.
+ */
+class RequestCoalescer
+{
+public:
+    /**
+     * @brief Answers a request, sharing the response of an identical one in flight.
+     * @param key Identity of the request.
+     * @param deadline The time by which a follower must have its response.
+     * @param res HTTP response to be sent.
+     * @param call Runs the route and fills res, called only for the first request of a key.
+     * @return false if the deadline of a follower expired first, res is then untouched.
+     */
+    bool run(const std::string &key, const Deadline &deadline, httplib::Response &res, const std::function<void()> &call);
+
+    /**
+     * @brief Returns the counters of the coalescer.
+     */
+    RequestCoalescerStats getStats() const;
+
+private:
+    /**
+     * @brief A request being answered.
+     */
+    struct Flight
+    {
+        bool done = false;                      ///< True once the response is set
+        int status = 0;                         ///< Response status
+        httplib::Headers headers;               ///< Response headers
+        std::string body;                       ///< Response body
+    };
+
+    /**
+     * @brief Publishes the response of a leader and removes its key.
+     */
+    void finish(const std::string &key, const std::shared_ptr<Flight> &flight, const httplib::Response &res);
+
+    std::unordered_map<std::string, std::shared_ptr<Flight>> flights_;  ///< Requests in flight by key
+    RequestCoalescerStats stats_;                                       ///< Counters
+    mutable std::mutex mutex_;                                          ///< Protects the flights and counters
+    std::condition_variable done_;                                      ///< Signaled when a response is published
+};
+
+#endif // REQUEST_COALESCER_H
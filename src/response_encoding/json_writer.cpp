@@ -0,0 +1,137 @@
+#include "json_writer.h"
+
+#include <charconv>
+#include <cstring>
+
+JsonWriter::JsonWriter()
+{
+    reset();
+}
+
+void JsonWriter::reset()
+{
+    size_ = 0;
+    spill_.clear();
+    spilled_ = false;
+    closed_ = false;
+    empty_ = true;
+    append('{');
+}
+
+void JsonWriter::append(const char *text, std::size_t length)
+{
+    if (!spilled_ && size_ + length <= sizeof(buffer_))
+    {
+        std::memcpy(buffer_ + size_, text, length);
+        size_ += length;
+        return;
+    }
+
+    if (!spilled_)
+    {
+        spill_.assign(buffer_, size_);
+        spilled_ = true;
+    }
+    spill_.append(text, length);
+}
+
+void JsonWriter::appendString(const char *text, std::size_t length)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    append('"');
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue;
+        }
+
+        // Copy the plain run, then the escape sequence
+        append(text + start, i - start);
+        start = i + 1;
+        switch (c)
+        {
+        case '"':
+            append("\\\"", 2);
+            break;
+        case '\\':
+            append("\\\\", 2);
+            break;
+        case '\n':
+            append("\\n", 2);
+            break;
+        case '\r':
+            append("\\r", 2);
+            break;
+        case '\t':
+            append("\\t", 2);
+            break;
+        default:
+        {
+            char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0F]};
+            append(escaped, sizeof(escaped));
+            break;
+        }
+        }
+    }
+    append(text + start, length - start);
+    append('"');
+}
+
+void JsonWriter::beginMember(const char *key)
+{
+    if (!empty_)
+    {
+        append(',');
+    }
+    empty_ = false;
+    appendString(key, std::strlen(key));
+    append(':');
+}
+
+JsonWriter &JsonWriter::add(const char *key, const std::string &value)
+{
+    beginMember(key);
+    appendString(value.data(), value.size());
+    return *this;
+}
+
+JsonWriter &JsonWriter::add(const char *key, const char *value)
+{
+    beginMember(key);
+    appendString(value, std::strlen(value));
+    return *this;
+}
+
+JsonWriter &JsonWriter::add(const char *key, std::int64_t value)
+{
+    beginMember(key);
+    char digits[24];
+    std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+    append(digits, static_cast<std::size_t>(result.ptr - digits));
+    return *this;
+}
+
+const char *JsonWriter::data()
+{
+    if (!closed_)
+    {
+        append('}');
+        closed_ = true;
+    }
+    return spilled_ ? spill_.data() : buffer_;
+}
+
+std::size_t JsonWriter::size() const
+{
+    return spilled_ ? spill_.size() : size_;
+}
+
+json JsonWriter::toJson()
+{
+    const char *document = data();
+    return json::parse(document, document + size());
+}
@@ -0,0 +1,88 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <cstdint>
+#include <string>
+#include <nholman_json/json.hpp>
+
+using json = nlohmann::json;
+
+#define JSON_WRITER_CAPACITY 256        // Bytes written in place before spilling to the heap
+
+/**
+ * @brief Writes a flat JSON object into a fixed buffer.
+ *
+ * Meant for the small fixed-shape responses of the frequent read routes: the object is built
+ * in the writer itself (on the stack of the handler) instead of a json DOM and a dump() copy.
+ * A document outgrowing the buffer moves to a heap string and stays correct.
+ */
+class JsonWriter
+{
+public:
+    JsonWriter();
+
+    /**
+     * @brief Adds a string member.
+     * @param key The member name.
+     * @param value The value, escaped as needed.
+     */
+    JsonWriter &add(const char *key, const std::string &value);
+
+    /**
+     * @brief Adds a string member.
+     * @param key The member name.
+     * @param value The null-terminated value, escaped as needed.
+     */
+    JsonWriter &add(const char *key, const char *value);
+
+    /**
+     * @brief Adds an integer member.
+     * @param key The member name.
+     * @param value The value.
+     */
+    JsonWriter &add(const char *key, std::int64_t value);
+
+    /**
+     * @brief Removes all members.
+     */
+    void reset();
+
+    /**
+     * @brief Returns the document, the object is closed on the first call.
+     */
+    const char *data();
+
+    /**
+     * @brief Returns the size of the document returned by data().
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Returns true if the document outgrew the fixed buffer.
+     */
+    bool spilled() const { return spilled_; }
+
+    /**
+     * @brief Parses the document, for the binary response encodings.
+     */
+    json toJson();
+
+private:
+    /**
+     * @brief Starts a member: separator, escaped key and colon.
+     */
+    void beginMember(const char *key);
+
+    void append(const char *text, std::size_t length);
+    void append(char c) { append(&c, 1); }
+    void appendString(const char *text, std::size_t length);
+
+    char buffer_[JSON_WRITER_CAPACITY];     ///< In-place document
+    std::size_t size_ = 0;                  ///< Bytes used in buffer_
+    std::string spill_;                     ///< Document once it outgrew buffer_
+    bool spilled_ = false;                  ///< True if spill_ holds the document
+    bool closed_ = false;                   ///< True once the closing brace was written
+    bool empty_ = true;                     ///< True until the first member
+};
+
+#endif // JSON_WRITER_H
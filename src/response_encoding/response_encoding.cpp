@@ -0,0 +1,120 @@
+#include "response_encoding.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+    std::string trim(const std::string &value)
+    {
+        std::size_t first = value.find_first_not_of(" \t");
+        if (first == std::string::npos)
+        {
+            return "";
+        }
+        std::size_t last = value.find_last_not_of(" \t");
+        return value.substr(first, last - first + 1);
+    }
+
+    bool toEncoding(const std::string &mediaType, ResponseEncoding &encoding)
+    {
+        if (mediaType == "application/json" || mediaType == "application/*" || mediaType == "*/*")
+        {
+            encoding = ResponseEncoding::Json;
+        }
+        else if (mediaType == "application/msgpack" || mediaType == "application/x-msgpack" || mediaType == "application/vnd.msgpack")
+        {
+            encoding = ResponseEncoding::MessagePack;
+        }
+        else if (mediaType == "application/cbor" || mediaType == "application/cbor-seq")
+        {
+            encoding = ResponseEncoding::Cbor;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+}
+
+ResponseEncoding ResponseEncoder::negotiate(const std::string &accept)
+{
+    ResponseEncoding best = ResponseEncoding::Json;
+    double bestWeight = 0.0;
+
+    std::stringstream ranges(accept);
+    std::string range;
+    while (std::getline(ranges, range, ','))
+    {
+        std::stringstream parts(range);
+        std::string part;
+        std::getline(parts, part, ';');
+
+        std::string mediaType = trim(part);
+        std::transform(mediaType.begin(), mediaType.end(), mediaType.begin(), ::tolower);
+
+        double weight = 1.0;
+        while (std::getline(parts, part, ';'))
+        {
+            part = trim(part);
+            if (part.size() > 2 && (part[0] == 'q' || part[0] == 'Q') && part[1] == '=')
+            {
+                weight = std::strtod(part.c_str() + 2, nullptr);
+            }
+        }
+
+        ResponseEncoding encoding;
+        if (weight > bestWeight && toEncoding(mediaType, encoding))
+        {
+            best = encoding;
+            bestWeight = weight;
+        }
+    }
+    return best;
+}
+
+const char *ResponseEncoder::contentType(ResponseEncoding encoding)
+{
+    switch (encoding)
+    {
+    case ResponseEncoding::MessagePack:
+        return "application/msgpack";
+    case ResponseEncoding::Cbor:
+        return "application/cbor";
+    default:
+        return "application/json";
+    }
+}
+
+const char *ResponseEncoder::sequenceContentType(ResponseEncoding encoding)
+{
+    switch (encoding)
+    {
+    case ResponseEncoding::MessagePack:
+        return "application/msgpack";
+    case ResponseEncoding::Cbor:
+        return "application/cbor-seq";
+    default:
+        return "application/json-seq";
+    }
+}
+
+void ResponseEncoder::encode(const json &document, ResponseEncoding encoding, std::string &body)
+{
+    switch (encoding)
+    {
+    case ResponseEncoding::MessagePack:
+        json::to_msgpack(document, nlohmann::detail::output_adapter<char>(body));
+        break;
+    case ResponseEncoding::Cbor:
+        json::to_cbor(document, nlohmann::detail::output_adapter<char>(body));
+        break;
+    default:
+        body += document.dump();
+        break;
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef RESPONSE_ENCODING_H
+#define RESPONSE_ENCODING_H
+
+#include <string>
+#include <nholman_json/json.hpp>
+
+using json = nlohmann::json;
+
+/**
+ * @brief Wire formats of the JSON responses.
+ */
+enum class ResponseEncoding
+{
+    Json,               ///< application/json (default)
+    MessagePack,        ///< application/msgpack
+    Cbor                ///< application/cbor
+};
+
+/**
+ * @brief The ResponseEncoder class picks the response format from the Accept header and encodes
+ * the response documents in it.
+ *
+ * MessagePack and CBOR carry the same document as the JSON text, only smaller and cheaper to
+ * parse on the embedded clients. JSON stays the answer to any client that does not ask for one
+ * of the binary formats.
+ */
+class ResponseEncoder
+{
+public:
+    /**
+     * @brief Chooses the encoding preferred by a client.
+     *
+     * Media ranges are weighed by their "q" parameter; among equal weights the first listed
+     * wins. Anything unsupported, including a missing header, yields JSON.
+     *
+     * @param accept The value of the Accept header.
+     */
+    static ResponseEncoding negotiate(const std::string &accept);
+
+    /**
+     * @brief Returns the Content-Type of an encoding.
+     */
+    static const char *contentType(ResponseEncoding encoding);
+
+    /**
+     * @brief Returns the Content-Type of a stream of documents in an encoding.
+     *
+     * MessagePack and CBOR items are self-delimiting, the stream is their concatenation.
+     */
+    static const char *sequenceContentType(ResponseEncoding encoding);
+
+    /**
+     * @brief Encodes a document.
+     * @param document The document.
+     * @param encoding The encoding.
+     * @param body Receives the encoded bytes (appended).
+     */
+    static void encode(const json &document, ResponseEncoding encoding, std::string &body);
+};
+
+#endif // RESPONSE_ENCODING_H
@@ -0,0 +1,210 @@
+#include "route_table.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fmt/format.h>
+
+int RouteParams::indexOf(const char *name) const
+{
+    if (spec == nullptr)
+    {
+        return -1;
+    }
+
+    for (std::size_t i = 0; i < spec->params.size() && i < ROUTE_MAX_PARAMS; ++i)
+    {
+        if (std::strcmp(spec->params[i].name, name) == 0)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool RouteParams::has(const char *name) const
+{
+    int index = indexOf(name);
+    return index >= 0 && present[index];
+}
+
+std::int64_t RouteParams::getInt(const char *name) const
+{
+    int index = indexOf(name);
+    return index >= 0 && present[index] ? static_cast<std::int64_t>(values[index]) : 0;
+}
+
+double RouteParams::getNumber(const char *name) const
+{
+    int index = indexOf(name);
+    return index >= 0 && present[index] ? values[index] : 0.0;
+}
+
+const char *RouteTable::className(RouteClass routeClass)
+{
+    switch (routeClass)
+    {
+    case RouteClass::Health:
+        return "health";
+    case RouteClass::Read:
+        return "read";
+    case RouteClass::CameraWrite:
+        return "camera_write";
+    case RouteClass::Gpio:
+        return "gpio";
+    case RouteClass::Bulk:
+        return "bulk";
+    case RouteClass::Wait:
+        return "wait";
+    case RouteClass::Stream:
+        return "stream";
+    default:
+        return "unknown";
+    }
+}
+
+bool RouteTable::parseCameraId(const std::string &text, std::size_t cameraCount, int &cameraId)
+{
+    // REVERSE_INDEX sends every ID but 0 to index 0: the ID must be the one its index maps
+    // back to, and the index in range
+    std::int64_t value = 0;
+    if (!parseInteger(text, value))
+    {
+        return false;
+    }
+    cameraId = REVERSE_INDEX(value);
+    return REVERSE_INDEX(cameraId) == value && cameraId < static_cast<int>(cameraCount);
+}
+
+bool RouteTable::parseInteger(const std::string &text, std::int64_t &value)
+{
+    const char *first = text.data();
+    const char *last = first + text.size();
+    std::from_chars_result result = std::from_chars(first, last, value);
+    return !text.empty() && result.ec == std::errc() && result.ptr == last;
+}
+
+bool RouteTable::parseNumber(const std::string &text, double &value)
+{
+    // Floating point std::from_chars is missing from the Jetson toolchain; strtod also reads
+    // hexadecimal, which is not a decimal number
+    if (text.empty() || std::isspace(static_cast<unsigned char>(text[0])) || text.find_first_of("xX") != std::string::npos)
+    {
+        return false;
+    }
+
+    char *end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return end == text.c_str() + text.size() && std::isfinite(value);
+}
+
+bool RouteTable::parse(const RouteSpec &spec, const httplib::Request &req, std::size_t cameraCount, RouteParams &params, std::string &error)
+{
+    params = RouteParams();
+    params.spec = &spec;
+
+    for (std::size_t i = 0; i < spec.params.size() && i < ROUTE_MAX_PARAMS; ++i)
+    {
+        const RouteParamSpec &param = spec.params[i];
+        std::size_t group = param.type == RouteParamType::PathCameraId ? 1 : param.type == RouteParamType::PathInteger ? 2 : 0;
+        std::string text = group > 0 ? (req.matches.size() > group ? req.matches[group].str() : std::string()) :
+                                       (req.has_param(param.name) ? req.get_param_value(param.name) : std::string());
+        if (text.empty())
+        {
+            if (param.required)
+            {
+                error = fmt::format("Missing {} parameter.", param.name);
+                return false;
+            }
+            continue;
+        }
+
+        switch (param.type)
+        {
+        case RouteParamType::CameraId:
+        case RouteParamType::PathCameraId:
+        {
+            int cameraId = -1;
+            if (!parseCameraId(text, cameraCount, cameraId))
+            {
+                error = "Camera_id out of range.";
+                return false;
+            }
+            params.camera_param = REVERSE_INDEX(cameraId);
+            params.camera_id = cameraId;
+            params.values[i] = static_cast<double>(params.camera_param);
+            break;
+        }
+        case RouteParamType::Integer:
+        case RouteParamType::PathInteger:
+        {
+            std::int64_t value = 0;
+            if (!parseInteger(text, value) || value < param.min || value > param.max)
+            {
+                error = fmt::format("Invalid {} parameter, expected an integer from {} to {}.", param.name, param.min, param.max);
+                return false;
+            }
+            params.values[i] = static_cast<double>(value);
+            break;
+        }
+        case RouteParamType::Number:
+        {
+            double value = 0.0;
+            if (!parseNumber(text, value) || value < param.min || value > param.max)
+            {
+                error = fmt::format("Invalid {} parameter, expected a number from {} to {}.", param.name, param.min, param.max);
+                return false;
+            }
+            params.values[i] = value;
+            break;
+        }
+        case RouteParamType::Flag:
+        {
+            if (text == "1" || text == "true")
+            {
+                params.values[i] = 1.0;
+            }
+            else if (text == "0" || text == "false")
+            {
+                params.values[i] = 0.0;
+            }
+            else
+            {
+                error = fmt::format("Invalid {} parameter, expected 0 or 1.", param.name);
+                return false;
+            }
+            break;
+        }
+        case RouteParamType::Choice:
+        {
+            // The choices are short, a linear scan of the '|' separated list
+            const char *choice = param.choices != nullptr ? param.choices : "";
+            int index = 0;
+            bool found = false;
+            while (!found)
+            {
+                const char *end = std::strchr(choice, '|');
+                std::size_t length = end != nullptr ? static_cast<std::size_t>(end - choice) : std::strlen(choice);
+                found = text.size() == length && text.compare(0, length, choice, length) == 0;
+                if (found || end == nullptr)
+                {
+                    break;
+                }
+                choice = end + 1;
+                index++;
+            }
+
+            if (!found)
+            {
+                error = fmt::format("Invalid {} parameter, expected {}.", param.name, param.choices != nullptr ? param.choices : "");
+                return false;
+            }
+            params.values[i] = static_cast<double>(index);
+            break;
+        }
+        }
+        params.present[i] = true;
+    }
+    return true;
+}
@@ -0,0 +1,187 @@
+#ifndef ROUTE_TABLE_H
+#define ROUTE_TABLE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifndef CPPHTTPLIB_OPENSSL_SUPPORT
+#define CPPHTTPLIB_OPENSSL_SUPPORT
+#endif
+#include <httplib.h>
+
+#include "../camera_index/camera_index.h"
+#include "../camera_scheduler/camera_scheduler.h"
+#include "../deadline/deadline.h"
+
+#define ROUTE_MAX_PARAMS 6                  // Typed query parameters per route
+#define ROUTE_MAX_INTEGER 9007199254740991.0  // Largest integer a parameter value holds exactly (2^53 - 1)
+#define ROUTE_MAX_HANDLE 4294967295.0       // Largest content or folder handle of the SDK (32 bits)
+
+// Worker pools of the route classes, adjust as needed
+#define ROUTE_POOL_HEALTH_THREADS 2
+#define ROUTE_POOL_HEALTH_QUEUE 16
+#define ROUTE_POOL_READ_THREADS 4
+#define ROUTE_POOL_READ_QUEUE 16
+#define ROUTE_POOL_CAMERA_WRITE_THREADS 2
+#define ROUTE_POOL_CAMERA_WRITE_QUEUE 4
+#define ROUTE_POOL_GPIO_THREADS 1
+#define ROUTE_POOL_GPIO_QUEUE 1
+#define ROUTE_POOL_BULK_THREADS 2
+#define ROUTE_POOL_BULK_QUEUE 4
+#define ROUTE_POOL_WAIT_THREADS 8           // Parked state waits, one thread each
+#define ROUTE_POOL_WAIT_QUEUE 4
+#define ROUTE_STREAM_CONNECTIONS 8          // Connections kept for the live-view and event streams
+
+// Deadlines of the routes sending commands to a camera, refused with 503 when the camera queue would miss them
+#define ROUTE_COMMAND_DEADLINE_MS 10000     // Setting changes
+#define ROUTE_CAMERA_READ_DEADLINE_MS 3000  // Setting reads
+#define ROUTE_SETTINGS_DEADLINE_MS 35000    // Camera-settings file download
+#define ROUTE_DEADLINE_HEADER "X-Request-Deadline-Ms"  // Replaces the route deadline, from receipt of the request
+#define ROUTE_MAX_DEADLINE_MS 120000        // Longest deadline a client may ask for
+#define ROUTE_PRIORITY_HEADER "X-Command-Priority"  // Priority the camera command ran at
+
+/**
+ * @brief Classes of routes, each served by a worker pool of its own.
+ */
+enum class RouteClass
+{
+    Health,             ///< Indicator, metrics, exit
+    Read,               ///< State read from memory or the cameras
+    CameraWrite,        ///< Commands changing a camera setting
+    Gpio,               ///< Camera power (restart sleeps for seconds)
+    Bulk,               ///< File transfers
+    Wait,               ///< Requests parked until a camera reaches a state
+    Stream,             ///< Long-lived streams, on their connection thread outside the pools (ROUTE_STREAM_CONNECTIONS)
+    Count               ///< Number of classes
+};
+
+/**
+ * @brief Token buckets a route draws from before its handler runs.
+ */
+enum class RouteTokens
+{
+    None,               ///< Not rate limited
+    Request,            ///< The request bucket shared by most routes
+    Frame,              ///< The live-view frame bucket (polled frames and analysis)
+    Catalog             ///< The catalog bucket (contents, thumbnails, media)
+};
+
+/**
+ * @brief Types of the query parameters.
+ */
+enum class RouteParamType
+{
+    CameraId,           ///< "camera_id", checked against the camera list and mapped with REVERSE_INDEX
+    PathCameraId,       ///< As CameraId, from the first group of the path pattern (/cameras/{id}/...)
+    Integer,            ///< Decimal integer within [min, max]
+    PathInteger,        ///< As Integer, from the second group of the path pattern (/cameras/{id}/contents/{handle}/...)
+    Number,             ///< Decimal number within [min, max]
+    Flag,               ///< "0"/"1" or "false"/"true"
+    Choice              ///< One of the choices, the value is its index
+};
+
+/**
+ * @brief Declaration of a query parameter.
+ */
+struct RouteParamSpec
+{
+    const char *name;                       ///< Query parameter name
+    RouteParamType type;                    ///< Expected type
+    bool required;                          ///< False if the parameter may be omitted
+    double min;                             ///< Smallest accepted value (Integer, Number)
+    double max;                             ///< Largest accepted value (Integer, Number)
+    const char *choices = nullptr;          ///< Accepted values separated by '|' (Choice)
+};
+
+/**
+ * @brief Declaration of a route: path and query parameters.
+ */
+struct RouteSpec
+{
+    std::string path;                               ///< Path pattern
+    RouteClass routeClass;                          ///< Pool serving the route
+    std::vector<RouteParamSpec> params;             ///< Query parameters, at most ROUTE_MAX_PARAMS
+    unsigned commandDeadlineMs = 0;                 ///< Deadline of the camera command, 0 if the route sends none
+    CommandPriority priority = CommandPriority::Status;  ///< Priority of the camera command in its queue
+    RouteTokens tokens = RouteTokens::Request;      ///< Bucket of the token taken by the route
+    bool coalesced = false;                         ///< True if identical concurrent requests share one response
+};
+
+/**
+ * @brief Query parameters of a request, parsed and range checked before the handler runs.
+ */
+struct RouteParams
+{
+    const RouteSpec *spec = nullptr;        ///< Declaration the values follow
+    int camera_id = -1;                     ///< Camera index (REVERSE_INDEX applied), -1 without a CameraId parameter
+    int camera_param = -1;                  ///< Camera ID as sent by the client
+    double values[ROUTE_MAX_PARAMS] = {};   ///< Values in declaration order
+    bool present[ROUTE_MAX_PARAMS] = {};    ///< True if the parameter was given
+    Deadline deadline;                      ///< Time by which the camera must have answered (never for other routes)
+
+    /**
+     * @brief Returns true if an optional parameter was given.
+     */
+    bool has(const char *name) const;
+
+    /**
+     * @brief Returns an Integer, Flag or Choice parameter (0 if absent).
+     */
+    std::int64_t getInt(const char *name) const;
+
+    /**
+     * @brief Returns a Number parameter (0 if absent).
+     */
+    double getNumber(const char *name) const;
+
+private:
+    int indexOf(const char *name) const;
+};
+
+/**
+ * @brief The RouteTable class parses the query parameters declared by a route.
+ *
+ * Parsing uses std::from_chars and strtod, never exceptions; a malformed or out of range value
+ * is reported as an error message for a uniform 400 response.
+ */
+class RouteTable
+{
+public:
+    /**
+     * @brief Returns the name of a route class, as reported in the metrics.
+     */
+    static const char *className(RouteClass routeClass);
+
+    /**
+     * @brief Parses and checks the query parameters of a request.
+     * @param spec The route declaration.
+     * @param req HTTP request received.
+     * @param cameraCount The number of cameras, bound of the CameraId parameters.
+     * @param params Receives the values.
+     * @param error Receives the error message.
+     * @return false if a parameter is missing or invalid.
+     */
+    static bool parse(const RouteSpec &spec, const httplib::Request &req, std::size_t cameraCount, RouteParams &params, std::string &error);
+
+    /**
+     * @brief Parses a camera ID sent by a client and maps it with REVERSE_INDEX.
+     * @param text The camera ID as sent.
+     * @param cameraCount The number of cameras.
+     * @param cameraId Receives the camera index.
+     * @return false if the ID is malformed or names no camera.
+     */
+    static bool parseCameraId(const std::string &text, std::size_t cameraCount, int &cameraId);
+
+    /**
+     * @brief Parses a whole string as a decimal integer.
+     */
+    static bool parseInteger(const std::string &text, std::int64_t &value);
+
+    /**
+     * @brief Parses a whole string as a decimal number.
+     */
+    static bool parseNumber(const std::string &text, double &value);
+};
+
+#endif // ROUTE_TABLE_H
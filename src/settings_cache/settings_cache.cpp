@@ -0,0 +1,433 @@
+#include "settings_cache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <utility>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <openssl/evp.h>
+
+std::unique_ptr<SettingsUpload> SettingsUpload::create(const std::string &directory)
+{
+    try
+    {
+        fs::create_directories(directory);
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::error("Failed to create {}: {}", directory, e.what());
+        return nullptr;
+    }
+
+    std::string pattern = directory + "/upload-XXXXXX";
+    std::vector<char> name(pattern.begin(), pattern.end());
+    name.push_back('\0');
+
+    int fd = mkstemp(name.data());
+    if (fd < 0)
+    {
+        spdlog::error("Failed to create an upload file in {}: {}", directory, std::strerror(errno));
+        return nullptr;
+    }
+
+    // The camera SDK expects the extension of a settings file
+    std::string path = std::string(name.data()) + ".DAT";
+    if (std::rename(name.data(), path.c_str()) != 0)
+    {
+        close(fd);
+        std::remove(name.data());
+        return nullptr;
+    }
+    return std::unique_ptr<SettingsUpload>(new SettingsUpload(fd, path));
+}
+
+SettingsUpload::SettingsUpload(int fd, const std::string &path)
+    : fd_(fd), path_(path)
+{
+}
+
+SettingsUpload::~SettingsUpload()
+{
+    if (fd_ >= 0)
+    {
+        close(fd_);
+    }
+    std::remove(path_.c_str());
+}
+
+bool SettingsUpload::write(const char *data, std::size_t size)
+{
+    if (fd_ < 0)
+    {
+        return false;
+    }
+
+    if (size_ + size > CAMERA_SETTINGS_MAX_UPLOAD_BYTES)
+    {
+        tooLarge_ = true;
+        return false;
+    }
+
+    // Written as received, the body is never held in memory
+    while (size > 0)
+    {
+        ssize_t count = ::write(fd_, data, size);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data += count;
+        size -= static_cast<std::size_t>(count);
+        size_ += static_cast<std::uint64_t>(count);
+    }
+    return true;
+}
+
+bool SettingsUpload::finish()
+{
+    if (fd_ < 0)
+    {
+        return false;
+    }
+
+    int result = close(fd_);
+    fd_ = -1;
+    return result == 0;
+}
+
+SettingsCache::SettingsCache(CrSDKInterface *crsdkInterface, const std::string &directory)
+    : crsdkInterface_(crsdkInterface), directory_(directory)
+{
+    std::size_t count = crsdkInterface_ ? crsdkInterface_->cameraList.size() : 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        std::unique_ptr<CameraEntry> camera(new CameraEntry());
+
+        // Files of earlier runs count against the limit, oldest first
+        std::vector<std::pair<std::time_t, std::string>> stored;
+        try
+        {
+            std::string cameraDirectory = getCameraDirectory(static_cast<int>(i));
+            if (fs::exists(cameraDirectory))
+            {
+                for (const auto &item : fs::directory_iterator(cameraDirectory))
+                {
+                    std::string name = item.path().filename().string();
+                    if (name.size() == 64 + 4 && name.compare(64, 4, ".DAT") == 0)
+                    {
+                        stored.emplace_back(fs::file_time_type::clock::to_time_t(fs::last_write_time(item.path())), name.substr(0, 64));
+                    }
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Failed to scan the settings files of camera {}: {}", i + 1, e.what());
+        }
+
+        std::sort(stored.begin(), stored.end());
+        for (const auto &item : stored)
+        {
+            camera->order.push_back(item.second);
+        }
+        cameras_.push_back(std::move(camera));
+    }
+}
+
+std::string SettingsCache::getCameraDirectory(int cameraNumber) const
+{
+    return fmt::format("{}/camera_{}", directory_, cameraNumber);
+}
+
+bool SettingsCache::hashFile(const std::string &path, std::string &hash, std::uint64_t &size)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> context(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
+    if (!context || EVP_DigestInit_ex(context.get(), EVP_sha256(), nullptr) != 1)
+    {
+        return false;
+    }
+
+    char buffer[16384];
+    size = 0;
+    while (file)
+    {
+        file.read(buffer, sizeof(buffer));
+        std::streamsize count = file.gcount();
+        if (count > 0)
+        {
+            if (EVP_DigestUpdate(context.get(), buffer, static_cast<std::size_t>(count)) != 1)
+            {
+                return false;
+            }
+            size += static_cast<std::uint64_t>(count);
+        }
+    }
+    if (file.bad())
+    {
+        return false;
+    }
+
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    if (EVP_DigestFinal_ex(context.get(), digest, &length) != 1)
+    {
+        return false;
+    }
+
+    hash.clear();
+    for (unsigned int i = 0; i < length; ++i)
+    {
+        hash += fmt::format("{:02x}", digest[i]);
+    }
+    return true;
+}
+
+bool SettingsCache::findBlob(int cameraNumber, const std::string &hash, SettingsBlob &blob) const
+{
+    std::string path = fmt::format("{}/{}.DAT", getCameraDirectory(cameraNumber), hash);
+
+    struct stat fileStat;
+    if (stat(path.c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+    {
+        return false;
+    }
+
+    blob.hash = hash;
+    blob.path = path;
+    blob.size = static_cast<std::uint64_t>(fileStat.st_size);
+    return true;
+}
+
+void SettingsCache::touch(int cameraNumber, CameraEntry &camera, const std::string &hash)
+{
+    camera.order.erase(std::remove(camera.order.begin(), camera.order.end(), hash), camera.order.end());
+    camera.order.push_back(hash);
+
+    while (camera.order.size() > CAMERA_SETTINGS_BLOBS_PER_CAMERA)
+    {
+        std::string victim = camera.order.front();
+        camera.order.pop_front();
+
+        for (auto it = camera.byFingerprint.begin(); it != camera.byFingerprint.end();)
+        {
+            it = it->second == victim ? camera.byFingerprint.erase(it) : std::next(it);
+        }
+
+        // A response still streaming the file keeps it open, unlinking is safe
+        std::remove(fmt::format("{}/{}.DAT", getCameraDirectory(cameraNumber), victim).c_str());
+    }
+}
+
+void SettingsCache::setCameraScheduler(CameraScheduler *cameraScheduler)
+{
+    this->cameraScheduler_ = cameraScheduler;
+}
+
+std::string SettingsCache::download(int cameraNumber, SettingsBlob &blob, const Deadline &deadline)
+{
+    blob = SettingsBlob();
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        return "Camera not available";
+    }
+
+    CameraEntry &camera = *cameras_[cameraNumber];
+    std::lock_guard<std::mutex> lock(camera.mutex);
+
+    CameraDevicePtr device = crsdkInterface_->cameraList[cameraNumber];
+    if (!device || !device->is_connected())
+    {
+        return "Camera not connected";
+    }
+
+    // Unchanged settings produce the same file, skip the download
+    std::uint64_t before = 0;
+    bool fingerprinted = CR_SUCCEEDED(device->get_settings_fingerprint(before));
+    if (fingerprinted)
+    {
+        auto known = camera.byFingerprint.find(before);
+        if (known != camera.byFingerprint.end() && findBlob(cameraNumber, known->second, blob))
+        {
+            blob.cached = true;
+            touch(cameraNumber, camera, blob.hash);
+            return "";
+        }
+    }
+
+    std::string cameraDirectory = getCameraDirectory(cameraNumber);
+    fs::create_directories(cameraDirectory);
+
+    std::string downloadPath = cameraDirectory + "/" + CAMERA_SETTINGS_DOWNLOAD_NAME;
+    std::remove(downloadPath.c_str());
+
+    // The camera gets what is left of the request deadline
+    std::int64_t timeoutMs = std::min<std::int64_t>(CAMERA_SETTINGS_TIMEOUT_MS, deadline.remaining().count());
+    if (timeoutMs <= 0)
+    {
+        return "Timed out waiting for the camera-settings file";
+    }
+
+    cli::text written;
+    SCRSDK::CrError err = device->download_setting_file(cameraDirectory, CAMERA_SETTINGS_DOWNLOAD_NAME, static_cast<CrInt32u>(timeoutMs), written);
+    if (err == SCRSDK::CrError_Generic_Abort)
+    {
+        return "Timed out waiting for the camera-settings file";
+    }
+    if (CR_FAILED(err))
+    {
+        return fmt::format("DownloadSettingFile failed (0x{:X})", static_cast<unsigned>(err));
+    }
+
+    // The callback reports the written file, fall back to the requested name
+    struct stat fileStat;
+    if (!written.empty() && stat(written.c_str(), &fileStat) == 0)
+    {
+        downloadPath = written;
+    }
+
+    std::string hash;
+    std::uint64_t size = 0;
+    if (!hashFile(downloadPath, hash, size) || size == 0)
+    {
+        return "Camera-settings file not written";
+    }
+
+    std::string blobPath = fmt::format("{}/{}.DAT", cameraDirectory, hash);
+    if (stat(blobPath.c_str(), &fileStat) == 0)
+    {
+        // Same content as a stored file
+        std::remove(downloadPath.c_str());
+    }
+    else if (std::rename(downloadPath.c_str(), blobPath.c_str()) != 0)
+    {
+        return "Failed to store the camera-settings file";
+    }
+
+    // Settings changed during the download would map the wrong file
+    std::uint64_t after = 0;
+    if (fingerprinted && CR_SUCCEEDED(device->get_settings_fingerprint(after)) && after == before)
+    {
+        camera.byFingerprint[before] = hash;
+    }
+
+    touch(cameraNumber, camera, hash);
+    if (!findBlob(cameraNumber, hash, blob))
+    {
+        return "Camera-settings file not written";
+    }
+
+    spdlog::info("Camera-settings of camera {} downloaded: {} ({} bytes)", cameraNumber + 1, hash, size);
+    return "";
+}
+
+std::unique_ptr<SettingsUpload> SettingsCache::createUpload() const
+{
+    return SettingsUpload::create(directory_ + "/uploads");
+}
+
+SettingsApplyResult SettingsCache::applyTo(const std::string &path, int cameraNumber)
+{
+    SettingsApplyResult result;
+    result.cameraNumber = cameraNumber;
+
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()))
+    {
+        result.error = "Camera not available";
+        return result;
+    }
+
+    // Behind the more urgent commands of the camera, which overtake it while it waits
+    CameraCommandPtr command;
+    if (cameraScheduler_ != nullptr)
+    {
+        std::chrono::milliseconds retryAfter;
+        command = cameraScheduler_->admit(cameraNumber, "/upload_camera_setting", CommandPriority::Bulk, std::chrono::milliseconds(CAMERA_SETTINGS_TIMEOUT_MS), retryAfter);
+        if (!command)
+        {
+            result.error = fmt::format("Camera busy, retry after {} ms", retryAfter.count());
+            return result;
+        }
+        if (!command->wait(Deadline::after(std::chrono::milliseconds(CAMERA_SETTINGS_TIMEOUT_MS))))
+        {
+            result.error = "Timed out waiting for the camera queue";
+            return result;
+        }
+        result.priority = command->getPriority();
+    }
+
+    // Not concurrent with a download of the same camera
+    std::lock_guard<std::mutex> lock(cameras_[cameraNumber]->mutex);
+
+    CameraDevicePtr device = crsdkInterface_->cameraList[cameraNumber];
+    if (!device || !device->is_connected())
+    {
+        result.error = "Camera not connected";
+        return result;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    SCRSDK::CrError err = device->upload_setting_file(path, CAMERA_SETTINGS_TIMEOUT_MS);
+    result.durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (err == SCRSDK::CrError_Generic_Abort)
+    {
+        result.error = "Timed out waiting for the camera to read the file";
+    }
+    else if (CR_FAILED(err))
+    {
+        result.error = fmt::format("UploadSettingFile failed (0x{:X})", static_cast<unsigned>(err));
+    }
+    else
+    {
+        result.succeeded = true;
+    }
+    return result;
+}
+
+std::vector<SettingsApplyResult> SettingsCache::apply(const std::string &path, const std::vector<int> &cameraNumbers)
+{
+    // One thread per camera, the request takes as long as the slowest camera
+    std::vector<std::future<SettingsApplyResult>> futures;
+    for (int cameraNumber : cameraNumbers)
+    {
+        futures.push_back(std::async(std::launch::async, [this, path, cameraNumber]()
+        {
+            return applyTo(path, cameraNumber);
+        }));
+    }
+
+    std::vector<SettingsApplyResult> results;
+    for (auto &future : futures)
+    {
+        results.push_back(future.get());
+    }
+
+    for (const auto &result : results)
+    {
+        if (result.succeeded)
+        {
+            spdlog::info("Camera-settings applied to camera {} in {:.0f} ms", result.cameraNumber + 1, result.durationMs);
+        }
+        else
+        {
+            spdlog::error("Failed to apply the camera-settings to camera {}: {}", result.cameraNumber + 1, result.error);
+        }
+    }
+    return results;
+}
@@ -0,0 +1,191 @@
+#ifndef SETTINGS_CACHE_H
+#define SETTINGS_CACHE_H
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+#include "../CrSDK_interface/CrSDK_interface.h"
+#include "../camera_scheduler/camera_scheduler.h"
+
+#define CAMERA_SETTINGS_DIRECTORY "/lld_sw_v1.0.0/camera_settings"
+#define CAMERA_SETTINGS_TIMEOUT_MS 30000            // Wait for the camera to write the file
+#define CAMERA_SETTINGS_BLOBS_PER_CAMERA 16         // Distinct settings files kept per camera
+#define CAMERA_SETTINGS_DOWNLOAD_NAME "download.DAT"
+#define CAMERA_SETTINGS_MAX_UPLOAD_BYTES (8u * 1024u * 1024u)  // Largest accepted settings file
+
+/**
+ * @brief A camera-settings file stored under its content hash.
+ */
+struct SettingsBlob
+{
+    std::string hash;                           ///< SHA-256 of the file (hex)
+    std::string path;                           ///< Absolute path of the file
+    std::uint64_t size = 0;                     ///< File size in bytes
+    bool cached = false;                        ///< True if served without contacting the camera
+};
+
+/**
+ * @brief Result of applying a settings file to one camera.
+ */
+struct SettingsApplyResult
+{
+    int cameraNumber = 0;                       ///< The camera ID (0-based indexing)
+    bool succeeded = false;                     ///< True if the camera read the file
+    std::string error;                          ///< Error message on failure
+    double durationMs = 0.0;                    ///< Time the camera took
+    CommandPriority priority = CommandPriority::Bulk;   ///< Priority the upload ran at
+};
+
+/**
+ * @brief A settings file received from a client, written to a temporary file as it arrives.
+ *
+ * The file is removed when the object is destroyed.
+ */
+class SettingsUpload
+{
+public:
+    /**
+     * @brief Creates an empty temporary file.
+     * @param directory Directory of the file.
+     * @return The upload, or nullptr on error.
+     */
+    static std::unique_ptr<SettingsUpload> create(const std::string &directory);
+
+    /**
+     * @brief Closes and removes the file.
+     */
+    ~SettingsUpload();
+
+    SettingsUpload(const SettingsUpload &) = delete;
+    SettingsUpload &operator=(const SettingsUpload &) = delete;
+
+    /**
+     * @brief Appends received bytes.
+     * @return false on a write error or when the file exceeds CAMERA_SETTINGS_MAX_UPLOAD_BYTES.
+     */
+    bool write(const char *data, std::size_t size);
+
+    /**
+     * @brief Flushes and closes the file.
+     * @return false on a write error.
+     */
+    bool finish();
+
+    const std::string &getPath() const { return path_; }
+    std::uint64_t getSize() const { return size_; }
+    bool isTooLarge() const { return tooLarge_; }
+
+private:
+    SettingsUpload(int fd, const std::string &path);
+
+    int fd_;                                    ///< The open file, -1 once finished
+    std::string path_;                          ///< Path of the file
+    std::uint64_t size_ = 0;                    ///< Bytes written
+    bool tooLarge_ = false;                     ///< True if the limit was exceeded
+};
+
+/**
+ * @brief The SettingsCache class downloads the camera-settings files and keeps them by content.
+ *
+ * Files are stored as camera_N/<sha256>.DAT. The settable properties of the camera are
+ * fingerprinted before each download; a fingerprint seen before maps to the file it produced,
+ * so unchanged settings are served without the camera round trip. Identical files downloaded
+ * under different fingerprints are stored once.
+ *
+ * Uploaded files are applied to several cameras at once, one thread per camera.
+ */
+class SettingsCache
+{
+public:
+    /**
+     * @brief Constructs a SettingsCache object.
+     * @param crsdkInterface instance of CrSDKInterface class.
+     * @param directory Directory of the settings files.
+     */
+    SettingsCache(CrSDKInterface *crsdkInterface, const std::string &directory = CAMERA_SETTINGS_DIRECTORY);
+
+    /**
+     * @brief Sets the queue of the camera commands, the uploads run in it at bulk priority.
+     * @param cameraScheduler A pointer to the CameraScheduler object.
+     */
+    void setCameraScheduler(CameraScheduler *cameraScheduler);
+
+    /**
+     * @brief Returns the settings file of a camera, downloading it if the settings changed.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param blob Receives the file.
+     * @param deadline The time by which the request must be answered, bounds the wait for the camera.
+     * @return An error message, or an empty string on success.
+     */
+    std::string download(int cameraNumber, SettingsBlob &blob, const Deadline &deadline = Deadline());
+
+    /**
+     * @brief Returns the directory of the settings files of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     */
+    std::string getCameraDirectory(int cameraNumber) const;
+
+    /**
+     * @brief Creates a temporary file for a settings file received from a client.
+     * @return The upload, or nullptr on error.
+     */
+    std::unique_ptr<SettingsUpload> createUpload() const;
+
+    /**
+     * @brief Has cameras read a settings file, concurrently.
+     * @param path The settings file.
+     * @param cameraNumbers The camera IDs (0-based indexing)
+     * @return The result of every camera, in the order of cameraNumbers.
+     */
+    std::vector<SettingsApplyResult> apply(const std::string &path, const std::vector<int> &cameraNumbers);
+
+    /**
+     * @brief Computes the SHA-256 of a file.
+     * @param path The file.
+     * @param hash Receives the hash (hex).
+     * @param size Receives the file size.
+     * @return false if the file cannot be read.
+     */
+    static bool hashFile(const std::string &path, std::string &hash, std::uint64_t &size);
+
+private:
+    /**
+     * @brief Settings files known for a camera.
+     */
+    struct CameraEntry
+    {
+        std::mutex mutex;                                   ///< Serializes the downloads of the camera
+        std::map<std::uint64_t, std::string> byFingerprint; ///< Property fingerprint to file hash
+        std::deque<std::string> order;                      ///< Hashes, least recently used first
+    };
+
+    /**
+     * @brief Marks a file recently used and removes the oldest ones over the limit.
+     */
+    void touch(int cameraNumber, CameraEntry &camera, const std::string &hash);
+
+    /**
+     * @brief Fills a blob from a stored file.
+     * @return false if the file is gone.
+     */
+    bool findBlob(int cameraNumber, const std::string &hash, SettingsBlob &blob) const;
+
+    /**
+     * @brief Has one camera read a settings file.
+     */
+    SettingsApplyResult applyTo(const std::string &path, int cameraNumber);
+
+    CrSDKInterface *crsdkInterface_;                            ///< Access to the cameras
+    CameraScheduler *cameraScheduler_ = nullptr;                ///< Queue of the camera commands
+    std::string directory_;                                     ///< Root of the settings files
+    std::vector<std::unique_ptr<CameraEntry>> cameras_;         ///< Known files per camera
+};
+
+#endif // SETTINGS_CACHE_H
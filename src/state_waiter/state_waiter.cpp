@@ -0,0 +1,332 @@
+#include "state_waiter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+StateWaiter::StateWaiter(CrSDKInterface *crsdkInterface)
+    : crsdkInterface_(crsdkInterface), running_(false)
+{
+    cameras_.resize(crsdkInterface_ ? crsdkInterface_->cameraList.size() : 0);
+}
+
+StateWaiter::~StateWaiter()
+{
+    stop();
+}
+
+void StateWaiter::setCameraScheduler(CameraScheduler *cameraScheduler)
+{
+    this->cameraScheduler_ = cameraScheduler;
+}
+
+void StateWaiter::start()
+{
+    if (running_.exchange(true))
+    {
+        return;
+    }
+
+    refreshThread_ = std::thread(&StateWaiter::refreshLoop, this);
+}
+
+void StateWaiter::stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        refreshReady_.notify_all();
+        stateChanged_.notify_all();
+    }
+
+    if (refreshThread_.joinable())
+    {
+        refreshThread_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t i = 0; i < cameras_.size(); ++i)
+    {
+        CameraEntry &camera = cameras_[i];
+        if (camera.listenerDevice != nullptr && i < crsdkInterface_->cameraList.size() &&
+            crsdkInterface_->cameraList[i].get() == camera.listenerDevice)
+        {
+            camera.listenerDevice->remove_property_change_listener(camera.listenerId);
+        }
+        camera.listenerDevice = nullptr;
+    }
+}
+
+std::string StateWaiter::normalizeFnumber(const std::string &fnumber)
+{
+    std::string normalized = fnumber;
+    normalized.erase(std::remove(normalized.begin(), normalized.end(), ' '), normalized.end());
+    if (!normalized.empty() && (normalized[0] == 'F' || normalized[0] == 'f'))
+    {
+        normalized.erase(0, 1);
+    }
+    return normalized;
+}
+
+bool StateWaiter::matches(const CameraState &state, const CameraStateTarget &target)
+{
+    if (target.hasMode && state.mode != target.mode)
+    {
+        return false;
+    }
+
+    if (target.hasBrightness && state.brightness != target.brightness)
+    {
+        return false;
+    }
+
+    if (target.hasFnumber)
+    {
+        // "F4", "4.0" and "F4.0" are the same aperture
+        std::string current = normalizeFnumber(state.fnumber);
+        if (current != target.fnumber)
+        {
+            char *currentEnd = nullptr;
+            char *targetEnd = nullptr;
+            double currentValue = std::strtod(current.c_str(), &currentEnd);
+            double targetValue = std::strtod(target.fnumber.c_str(), &targetEnd);
+            if (current.empty() || target.fnumber.empty() || *currentEnd != '\0' || *targetEnd != '\0' ||
+                std::fabs(currentValue - targetValue) > 0.001)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool StateWaiter::wait(int cameraNumber, const CameraStateTarget &target, const Deadline &deadline, CameraState &state)
+{
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameras_.size()) || !running_)
+    {
+        state = CameraState();
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    CameraEntry &camera = cameras_[cameraNumber];
+    camera.modeWaiters += target.hasMode ? 1 : 0;
+    camera.brightnessWaiters += target.hasBrightness ? 1 : 0;
+    camera.fnumberWaiters += target.hasFnumber ? 1 : 0;
+    stats_.parked++;
+
+    // The snapshot may be out of date, the camera is read again before comparing
+    camera.changed = true;
+    refreshReady_.notify_all();
+
+    std::uint64_t since = camera.state.version;
+    auto reached = [&]()
+    {
+        return camera.state.version > since && matches(camera.state, target);
+    };
+    auto done = [&]()
+    {
+        return !running_ || reached();
+    };
+
+    if (deadline.isSet())
+    {
+        stateChanged_.wait_until(lock, deadline.time(), done);
+    }
+    else
+    {
+        stateChanged_.wait(lock, done);
+    }
+
+    bool matched = reached();
+    camera.modeWaiters -= target.hasMode ? 1 : 0;
+    camera.brightnessWaiters -= target.hasBrightness ? 1 : 0;
+    camera.fnumberWaiters -= target.hasFnumber ? 1 : 0;
+    stats_.parked--;
+    if (matched)
+    {
+        stats_.matched++;
+    }
+    else
+    {
+        stats_.timedOut++;
+    }
+
+    state = camera.state;
+    return matched;
+}
+
+void StateWaiter::registerListener(int cameraNumber)
+{
+    CameraEntry &camera = cameras_[cameraNumber];
+    if (cameraNumber >= static_cast<int>(crsdkInterface_->cameraList.size()))
+    {
+        camera.listenerDevice = nullptr;
+        return;
+    }
+
+    CameraDevicePtr device = crsdkInterface_->cameraList[cameraNumber];
+    if (!device || device.get() == camera.listenerDevice)
+    {
+        return;
+    }
+
+    camera.listenerId = device->add_property_change_listener([this, cameraNumber](const std::vector<CrInt32u> &)
+    {
+        onPropertyChanged(cameraNumber);
+    });
+    camera.listenerDevice = device.get();
+}
+
+void StateWaiter::onPropertyChanged(int cameraNumber)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    cameras_[cameraNumber].changed = true;
+    stats_.notifications++;
+    refreshReady_.notify_all();
+}
+
+bool StateWaiter::readState(int cameraNumber, bool mode, bool brightness, bool fnumber, CameraState &state)
+{
+    if (cameraNumber >= static_cast<int>(crsdkInterface_->cameraList.size()))
+    {
+        return false;
+    }
+
+    CameraDevicePtr device = crsdkInterface_->cameraList[cameraNumber];
+    if (!device || !device->is_connected())
+    {
+        return false;
+    }
+
+    // The reads take their turn with the other commands of the camera
+    CameraCommandPtr command;
+    Deadline deadline = Deadline::after(std::chrono::milliseconds(STATE_WAIT_READ_MS));
+    if (cameraScheduler_ != nullptr)
+    {
+        std::chrono::milliseconds retryAfter;
+        command = cameraScheduler_->admit(cameraNumber, "/cameras/wait", CommandPriority::Status, std::chrono::milliseconds(STATE_WAIT_READ_MS), retryAfter);
+        if (!command || !command->wait(deadline))
+        {
+            return false;
+        }
+        deadline = deadline.holding(command);
+    }
+
+    if (mode)
+    {
+        if (!crsdkInterface_->readCameraMode(cameraNumber, deadline))
+        {
+            return false;
+        }
+        state.mode = crsdkInterface_->getCameraModeStr(cameraNumber);
+    }
+
+    if (brightness)
+    {
+        // From the settings of the camera, the value last set by the server may be stale
+        if (!crsdkInterface_->readCameraBrightness(cameraNumber, deadline, state.brightness))
+        {
+            return false;
+        }
+    }
+
+    if (fnumber)
+    {
+        cli::text value = crsdkInterface_->getFnumber(cameraNumber, deadline);
+        if (value.empty())
+        {
+            return false;
+        }
+        state.fnumber = value;
+    }
+
+    return true;
+}
+
+void StateWaiter::refreshLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_)
+    {
+        auto now = std::chrono::steady_clock::now();
+        auto wakeAt = now + std::chrono::milliseconds(STATE_WAIT_REFRESH_MS);
+        bool due = false;
+        for (std::size_t i = 0; i < cameras_.size(); ++i)
+        {
+            registerListener(static_cast<int>(i));
+
+            const CameraEntry &camera = cameras_[i];
+            if (camera.modeWaiters + camera.brightnessWaiters + camera.fnumberWaiters == 0)
+            {
+                continue;
+            }
+
+            auto refreshAt = camera.readAt + std::chrono::milliseconds(STATE_WAIT_REFRESH_MS);
+            if (camera.changed || refreshAt <= now)
+            {
+                due = true;
+            }
+            else
+            {
+                wakeAt = std::min(wakeAt, refreshAt);
+            }
+        }
+
+        if (!due)
+        {
+            refreshReady_.wait_until(lock, wakeAt);
+            continue;
+        }
+
+        // A setting change is reported as several property changes, read once after them
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(STATE_WAIT_SETTLE_MS));
+        lock.lock();
+
+        now = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < cameras_.size() && running_; ++i)
+        {
+            CameraEntry &camera = cameras_[i];
+            bool mode = camera.modeWaiters > 0;
+            bool brightness = camera.brightnessWaiters > 0;
+            bool fnumber = camera.fnumberWaiters > 0;
+            if ((!mode && !brightness && !fnumber) ||
+                (!camera.changed && camera.readAt + std::chrono::milliseconds(STATE_WAIT_REFRESH_MS) > now))
+            {
+                continue;
+            }
+
+            camera.changed = false;
+            CameraState state = camera.state;
+            lock.unlock();
+            bool read = readState(static_cast<int>(i), mode, brightness, fnumber, state);
+            lock.lock();
+
+            // A failed read is retried at the next refresh, not in a loop
+            CameraEntry &updated = cameras_[i];
+            updated.readAt = std::chrono::steady_clock::now();
+            if (!read)
+            {
+                spdlog::debug("State read of camera {} failed", i + 1);
+                continue;
+            }
+
+            state.version = updated.state.version + 1;
+            updated.state = state;
+            stats_.reads++;
+            stateChanged_.notify_all();
+        }
+    }
+}
+
+StateWaiterStats StateWaiter::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
@@ -0,0 +1,184 @@
+#ifndef STATE_WAITER_H
+#define STATE_WAITER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+#include "../CrSDK_interface/CrSDK_interface.h"
+#include "../camera_scheduler/camera_scheduler.h"
+#include "../deadline/deadline.h"
+
+#define STATE_WAIT_DEFAULT_TIMEOUT_MS 30000     // Wait when the request gives no timeout
+#define STATE_WAIT_MAX_TIMEOUT_MS 120000
+#define STATE_WAIT_REFRESH_MS 1000              // Re-read while waits are parked, callbacks can be missed
+#define STATE_WAIT_SETTLE_MS 100                // Gathers a burst of property changes into one read
+#define STATE_WAIT_READ_MS 3000                 // Deadline of a state read
+
+/**
+ * @brief The state a wait expects; only the properties that are set are compared.
+ */
+struct CameraStateTarget
+{
+    bool hasMode = false;
+    cli::text mode;                             ///< "p" or "m"
+    bool hasBrightness = false;
+    int brightness = 0;                         ///< Brightness index, 0 to 48
+    bool hasFnumber = false;
+    std::string fnumber;                        ///< F-number without the leading "F"
+
+    /**
+     * @brief Returns true if no property is set.
+     */
+    bool empty() const { return !hasMode && !hasBrightness && !hasFnumber; }
+};
+
+/**
+ * @brief The last state read from a camera.
+ */
+struct CameraState
+{
+    cli::text mode;                             ///< Exposure program mode
+    int brightness = -1;                        ///< Brightness index, -1 if unknown
+    std::string fnumber;                        ///< F-number as reported by the camera
+    std::uint64_t version = 0;                  ///< Incremented by every read
+};
+
+/**
+ * @brief Counters of the state waits.
+ */
+struct StateWaiterStats
+{
+    std::size_t parked = 0;                     ///< Waits in progress
+    std::uint64_t matched = 0;                  ///< Waits answered with the expected state
+    std::uint64_t timedOut = 0;                 ///< Waits answered at their timeout
+    std::uint64_t reads = 0;                    ///< State reads of the refresh thread
+    std::uint64_t notifications = 0;            ///< Property changes reported by the cameras
+};
+
+/**
+ * @brief The StateWaiter class answers requests waiting for a camera to reach a state.
+ *
+ * Waits are parked on a condition variable and compared against a snapshot of the camera
+ * state, never against the camera itself. A single refresh thread re-reads the snapshot of a
+ * camera when it reports a property change, and every STATE_WAIT_REFRESH_MS in case a change
+ * went unreported, but only while waits of that camera are parked and only the properties they
+ * expect. The reads of a camera therefore do not grow with the number of clients waiting on it.
+ */
+class StateWaiter
+{
+public:
+    /**
+     * @brief Constructs a StateWaiter object.
+     * @param crsdkInterface instance of CrSDKInterface class.
+     */
+    explicit StateWaiter(CrSDKInterface *crsdkInterface);
+
+    /**
+     * @brief Stops the refresh thread.
+     */
+    ~StateWaiter();
+
+    /**
+     * @brief Sets the queue the state reads go through, at the status priority.
+     * @param cameraScheduler instance of CameraScheduler class.
+     */
+    void setCameraScheduler(CameraScheduler *cameraScheduler);
+
+    /**
+     * @brief Starts the refresh thread.
+     */
+    void start();
+
+    /**
+     * @brief Stops the refresh thread and answers the parked waits.
+     */
+    void stop();
+
+    /**
+     * @brief Waits until a camera is in a state.
+     *
+     * The state is compared from the first read after the call, a snapshot taken before it
+     * may be out of date.
+     *
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param target The expected state.
+     * @param deadline The time at which the wait gives up.
+     * @param state Receives the last state read.
+     * @return true if the camera reached the state, false at the deadline.
+     */
+    bool wait(int cameraNumber, const CameraStateTarget &target, const Deadline &deadline, CameraState &state);
+
+    /**
+     * @brief Removes the leading "F" of an F-number, for comparisons.
+     */
+    static std::string normalizeFnumber(const std::string &fnumber);
+
+    /**
+     * @brief Returns the counters of the waits.
+     */
+    StateWaiterStats getStats() const;
+
+private:
+    /**
+     * @brief The waits and snapshot of a camera.
+     */
+    struct CameraEntry
+    {
+        CameraState state;                                  ///< Last state read
+        int modeWaiters = 0;                                ///< Parked waits expecting a mode
+        int brightnessWaiters = 0;                          ///< Parked waits expecting a brightness
+        int fnumberWaiters = 0;                             ///< Parked waits expecting an F-number
+        bool changed = false;                               ///< A property changed since the last read
+        std::chrono::steady_clock::time_point readAt;       ///< Time of the last read
+        cli::CameraDevice *listenerDevice = nullptr;        ///< Device the listener is registered on
+        int listenerId = 0;                                 ///< Listener registration
+    };
+
+    /**
+     * @brief Returns true if a state matches the expected one.
+     */
+    static bool matches(const CameraState &state, const CameraStateTarget &target);
+
+    /**
+     * @brief Registers the property listener on the current device of a camera.
+     *
+     * Reconnecting replaces the device, the listener then moves to the new one.
+     */
+    void registerListener(int cameraNumber);
+
+    /**
+     * @brief Called by the SDK thread on a property change; only marks the camera.
+     */
+    void onPropertyChanged(int cameraNumber);
+
+    /**
+     * @brief Reads the expected properties of a camera into a state.
+     * @return false if the camera queue refused the read or the camera did not answer.
+     */
+    bool readState(int cameraNumber, bool mode, bool brightness, bool fnumber, CameraState &state);
+
+    /**
+     * @brief Loop of the refresh thread.
+     */
+    void refreshLoop();
+
+    CrSDKInterface *crsdkInterface_;                    ///< Access to the cameras
+    CameraScheduler *cameraScheduler_ = nullptr;        ///< Queue of the camera commands
+    std::vector<CameraEntry> cameras_;                  ///< Entry of each camera
+    StateWaiterStats stats_;                            ///< Counters
+    mutable std::mutex mutex_;                          ///< Protects the entries and counters
+    std::condition_variable refreshReady_;              ///< Signaled on property changes and new waits
+    std::condition_variable stateChanged_;              ///< Signaled after every read
+    std::thread refreshThread_;                         ///< Refresh thread
+    std::atomic<bool> running_;                         ///< True while the refresh thread runs
+};
+
+#endif // STATE_WAITER_H
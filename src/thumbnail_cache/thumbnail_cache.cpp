@@ -0,0 +1,363 @@
+#include "thumbnail_cache.h"
+
+#include <algorithm>
+#include <cstring>
+
+std::shared_ptr<BufferPool> BufferPool::create(std::size_t maxFreeBytes)
+{
+    return std::shared_ptr<BufferPool>(new BufferPool(maxFreeBytes));
+}
+
+BufferPool::BufferPool(std::size_t maxFreeBytes)
+    : maxFreeBytes_(maxFreeBytes)
+{
+}
+
+std::size_t BufferPool::classSize(std::size_t size)
+{
+    std::size_t capacity = THUMBNAIL_POOL_MIN_BYTES;
+    while (capacity < size)
+    {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+BufferPool::Buffer BufferPool::acquire(std::size_t size)
+{
+    std::size_t capacity = classSize(size);
+    std::unique_ptr<std::vector<std::uint8_t>> buffer;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &freeList = free_[capacity];
+        if (!freeList.empty())
+        {
+            buffer = std::move(freeList.back());
+            freeList.pop_back();
+            freeBytes_ -= capacity;
+            reused_++;
+        }
+        else
+        {
+            allocated_++;
+        }
+    }
+
+    if (!buffer)
+    {
+        buffer.reset(new std::vector<std::uint8_t>());
+        buffer->reserve(capacity);
+    }
+    buffer->resize(size);
+
+    // The buffer finds its way back even if the pool is gone by then
+    std::weak_ptr<BufferPool> pool = shared_from_this();
+    return Buffer(buffer.release(), [pool](std::vector<std::uint8_t> *released)
+    {
+        if (auto owner = pool.lock())
+        {
+            owner->release(released);
+        }
+        else
+        {
+            delete released;
+        }
+    });
+}
+
+void BufferPool::release(std::vector<std::uint8_t> *buffer)
+{
+    std::unique_ptr<std::vector<std::uint8_t>> owned(buffer);
+    std::size_t capacity = owned->capacity();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (freeBytes_ + capacity <= maxFreeBytes_ && capacity == classSize(capacity))
+    {
+        freeBytes_ += capacity;
+        free_[capacity].push_back(std::move(owned));
+    }
+}
+
+void BufferPool::getCounters(std::uint64_t &allocated, std::uint64_t &reused) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    allocated = allocated_;
+    reused = reused_;
+}
+
+ThumbnailCache::ThumbnailCache(CrSDKInterface *crsdkInterface, ContentsCatalog *contentsCatalog, std::size_t budgetBytes)
+    : crsdkInterface_(crsdkInterface), contentsCatalog_(contentsCatalog), budgetBytes_(budgetBytes),
+      pool_(BufferPool::create()), running_(false)
+{
+    std::size_t count = crsdkInterface_ ? crsdkInterface_->cameraList.size() : 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        cameraMutexes_.emplace_back(new std::mutex());
+    }
+    prefetchQueues_.resize(count);
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    stop();
+}
+
+void ThumbnailCache::start()
+{
+    if (running_.exchange(true))
+    {
+        return;
+    }
+
+    prefetchThread_ = std::thread(&ThumbnailCache::prefetchLoop, this);
+}
+
+void ThumbnailCache::stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(prefetchMutex_);
+        prefetchReady_.notify_all();
+    }
+
+    if (prefetchThread_.joinable())
+    {
+        prefetchThread_.join();
+    }
+}
+
+std::uint64_t ThumbnailCache::keyOf(int cameraNumber, SCRSDK::CrContentHandle handle)
+{
+    return (static_cast<std::uint64_t>(cameraNumber) << 32) | static_cast<std::uint64_t>(handle);
+}
+
+bool ThumbnailCache::findContent(int cameraNumber, SCRSDK::CrContentHandle handle, std::string &fileName) const
+{
+    CatalogSnapshotPtr snapshot = contentsCatalog_ ? contentsCatalog_->getSnapshot(cameraNumber) : nullptr;
+    if (!snapshot)
+    {
+        return false;
+    }
+
+    auto position = snapshot->byHandle.find(handle);
+    if (position == snapshot->byHandle.end())
+    {
+        return false;
+    }
+
+    fileName = snapshot->entries[position->second].fileName;
+    return true;
+}
+
+ThumbnailPtr ThumbnailCache::lookup(std::uint64_t key, const std::string &fileName)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end())
+    {
+        return nullptr;
+    }
+
+    if (it->second.thumbnail->fileName != fileName)
+    {
+        // The handle now belongs to another content
+        bytes_ -= it->second.thumbnail->data->capacity();
+        lru_.erase(it->second.position);
+        entries_.erase(it);
+        return nullptr;
+    }
+
+    lru_.splice(lru_.begin(), lru_, it->second.position);
+    return it->second.thumbnail;
+}
+
+std::string ThumbnailCache::get(int cameraNumber, SCRSDK::CrContentHandle handle, ThumbnailPtr &thumbnail, bool *cached)
+{
+    thumbnail = nullptr;
+    if (cached != nullptr)
+    {
+        *cached = false;
+    }
+
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(cameraMutexes_.size()))
+    {
+        return "Camera not available";
+    }
+
+    // Only contents of the catalog are fetched
+    std::string fileName;
+    if (!findContent(cameraNumber, handle, fileName))
+    {
+        return "Unknown content";
+    }
+
+    thumbnail = lookup(keyOf(cameraNumber, handle), fileName);
+    if (thumbnail)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.hits++;
+        if (cached != nullptr)
+        {
+            *cached = true;
+        }
+        return "";
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.misses++;
+    }
+    return fetch(cameraNumber, handle, fileName, thumbnail);
+}
+
+std::string ThumbnailCache::fetch(int cameraNumber, SCRSDK::CrContentHandle handle, const std::string &fileName, ThumbnailPtr &thumbnail)
+{
+    std::lock_guard<std::mutex> cameraLock(*cameraMutexes_[cameraNumber]);
+
+    // Fetched by a concurrent request or the prefetch while waiting
+    std::uint64_t key = keyOf(cameraNumber, handle);
+    thumbnail = lookup(key, fileName);
+    if (thumbnail)
+    {
+        return "";
+    }
+
+    if (cameraNumber >= static_cast<int>(crsdkInterface_->cameraList.size()))
+    {
+        return "Camera not available";
+    }
+
+    CameraDevicePtr device = crsdkInterface_->cameraList[cameraNumber];
+    if (!device || !device->is_connected())
+    {
+        return "Camera not connected";
+    }
+
+    BufferPool::Buffer receive = pool_->acquire(THUMBNAIL_RECEIVE_BYTES);
+    CrInt8u *data = nullptr;
+    CrInt32u size = 0;
+    SCRSDK::CrFileType type = SCRSDK::CrFileType_None;
+    SCRSDK::CrError err = device->get_contents_thumbnail(handle, receive->data(), static_cast<CrInt32u>(receive->size()), data, size, type);
+    if (CR_FAILED(err) || data == nullptr || size > receive->size())
+    {
+        return fmt::format("GetContentsThumbnailImage failed (0x{:X})", static_cast<unsigned>(err));
+    }
+
+    // Keep only the image, in a buffer of its own size class
+    std::shared_ptr<Thumbnail> fetched(new Thumbnail());
+    fetched->data = pool_->acquire(size);
+    std::memcpy(fetched->data->data(), data, size);
+    fetched->heif = type == SCRSDK::CrFileType_Heif;
+    fetched->fileName = fileName;
+    thumbnail = fetched;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto existing = entries_.find(key);
+    if (existing != entries_.end())
+    {
+        bytes_ -= existing->second.thumbnail->data->capacity();
+        lru_.erase(existing->second.position);
+        entries_.erase(existing);
+    }
+
+    lru_.push_front(key);
+    entries_[key] = Entry{thumbnail, lru_.begin()};
+    bytes_ += fetched->data->capacity();
+
+    // Drop the least recently used thumbnails over the budget
+    while (bytes_ > budgetBytes_ && lru_.size() > 1)
+    {
+        auto victim = entries_.find(lru_.back());
+        bytes_ -= victim->second.thumbnail->data->capacity();
+        entries_.erase(victim);
+        lru_.pop_back();
+        stats_.evictions++;
+    }
+
+    return "";
+}
+
+void ThumbnailCache::prefetch(int cameraNumber, const std::vector<SCRSDK::CrContentHandle> &handles)
+{
+    if (cameraNumber < 0 || cameraNumber >= static_cast<int>(prefetchQueues_.size()))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(prefetchMutex_);
+    std::deque<SCRSDK::CrContentHandle> &queue = prefetchQueues_[cameraNumber];
+    queue.assign(handles.begin(), handles.begin() + std::min<std::size_t>(handles.size(), THUMBNAIL_PREFETCH_LIMIT));
+    prefetchReady_.notify_all();
+}
+
+void ThumbnailCache::prefetchLoop()
+{
+    std::size_t nextCamera = 0;
+    while (running_)
+    {
+        int cameraNumber = -1;
+        SCRSDK::CrContentHandle handle = 0;
+        {
+            std::unique_lock<std::mutex> lock(prefetchMutex_);
+            prefetchReady_.wait(lock, [this]()
+            {
+                return !running_ || std::any_of(prefetchQueues_.begin(), prefetchQueues_.end(), [](const std::deque<SCRSDK::CrContentHandle> &queue)
+                {
+                    return !queue.empty();
+                });
+            });
+            if (!running_)
+            {
+                break;
+            }
+
+            // Round robin over the cameras
+            for (std::size_t i = 0; i < prefetchQueues_.size(); ++i)
+            {
+                std::size_t candidate = (nextCamera + i) % prefetchQueues_.size();
+                if (!prefetchQueues_[candidate].empty())
+                {
+                    cameraNumber = static_cast<int>(candidate);
+                    handle = prefetchQueues_[candidate].front();
+                    prefetchQueues_[candidate].pop_front();
+                    nextCamera = candidate + 1;
+                    break;
+                }
+            }
+        }
+
+        std::string fileName;
+        if (!findContent(cameraNumber, handle, fileName) || lookup(keyOf(cameraNumber, handle), fileName))
+        {
+            continue;
+        }
+
+        ThumbnailPtr thumbnail;
+        std::string error = fetch(cameraNumber, handle, fileName, thumbnail);
+        if (!error.empty())
+        {
+            spdlog::debug("Thumbnail prefetch of camera {} failed: {}", cameraNumber + 1, error);
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.prefetched++;
+    }
+}
+
+ThumbnailCacheStats ThumbnailCache::getStats() const
+{
+    ThumbnailCacheStats stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats = stats_;
+        stats.entries = entries_.size();
+        stats.bytes = bytes_;
+    }
+    pool_->getCounters(stats.buffersAllocated, stats.buffersReused);
+    return stats;
+}
@@ -0,0 +1,229 @@
+#ifndef THUMBNAIL_CACHE_H
+#define THUMBNAIL_CACHE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+#include "../CrSDK_interface/CrSDK_interface.h"
+#include "../contents_catalog/contents_catalog.h"
+
+#define THUMBNAIL_CACHE_BUDGET_BYTES (32u * 1024u * 1024u)
+#define THUMBNAIL_RECEIVE_BYTES 0x28000             // Receive buffer of GetContentsThumbnailImage (SDK sample size)
+#define THUMBNAIL_POOL_MIN_BYTES 4096               // Smallest buffer class
+#define THUMBNAIL_POOL_FREE_BYTES (4u * 1024u * 1024u)  // Free buffers kept for reuse
+#define THUMBNAIL_PREFETCH_LIMIT 200                // Queued prefetches per camera
+
+/**
+ * @brief Recycles byte buffers in power-of-two size classes.
+ *
+ * Buffers are handed out as shared pointers that return to the pool when the last owner
+ * drops them, so cache entries and in-flight responses can share a thumbnail without copies.
+ */
+class BufferPool : public std::enable_shared_from_this<BufferPool>
+{
+public:
+    typedef std::shared_ptr<std::vector<std::uint8_t>> Buffer;
+
+    /**
+     * @brief Creates a pool.
+     * @param maxFreeBytes The capacity of the free buffers kept for reuse.
+     */
+    static std::shared_ptr<BufferPool> create(std::size_t maxFreeBytes = THUMBNAIL_POOL_FREE_BYTES);
+
+    /**
+     * @brief Returns a buffer of at least the given size.
+     * @param size The number of bytes needed, the buffer is resized to it.
+     */
+    Buffer acquire(std::size_t size);
+
+    /**
+     * @brief Returns the capacity of the class a size falls in.
+     * @param size The number of bytes.
+     */
+    static std::size_t classSize(std::size_t size);
+
+    /**
+     * @brief Returns the number of buffers allocated and reused.
+     */
+    void getCounters(std::uint64_t &allocated, std::uint64_t &reused) const;
+
+private:
+    explicit BufferPool(std::size_t maxFreeBytes);
+
+    /**
+     * @brief Takes back a buffer, or frees it if the pool is full.
+     */
+    void release(std::vector<std::uint8_t> *buffer);
+
+    std::size_t maxFreeBytes_;                                                          ///< Capacity kept for reuse
+    std::size_t freeBytes_ = 0;                                                         ///< Capacity of the free buffers
+    std::map<std::size_t, std::vector<std::unique_ptr<std::vector<std::uint8_t>>>> free_;  ///< Free buffers by class
+    std::uint64_t allocated_ = 0;                                                       ///< Buffers allocated
+    std::uint64_t reused_ = 0;                                                          ///< Buffers taken from the free lists
+    mutable std::mutex mutex_;                                                          ///< Protects the free lists
+};
+
+/**
+ * @brief A cached thumbnail.
+ */
+struct Thumbnail
+{
+    BufferPool::Buffer data;                    ///< Image bytes
+    bool heif = false;                          ///< True for HEIF, JPEG otherwise
+    std::string fileName;                       ///< Content the thumbnail belongs to
+};
+
+typedef std::shared_ptr<const Thumbnail> ThumbnailPtr;
+
+/**
+ * @brief Counters of the thumbnail cache.
+ */
+struct ThumbnailCacheStats
+{
+    std::size_t entries = 0;                    ///< Cached thumbnails
+    std::size_t bytes = 0;                      ///< Buffer capacity held by the cache
+    std::uint64_t hits = 0;                     ///< Requests served from memory
+    std::uint64_t misses = 0;                   ///< Requests that fetched from the camera
+    std::uint64_t prefetched = 0;               ///< Thumbnails fetched ahead of a request
+    std::uint64_t evictions = 0;                ///< Thumbnails dropped for the budget
+    std::uint64_t buffersAllocated = 0;         ///< Pool allocations
+    std::uint64_t buffersReused = 0;            ///< Pool reuses
+};
+
+/**
+ * @brief The ThumbnailCache class keeps the thumbnails of the contents in memory.
+ *
+ * Thumbnails are kept in a least recently used list, keyed by camera and content handle, up
+ * to a byte budget. The SDK writes into a receive buffer taken from a pool; the image is then
+ * copied into a pooled buffer of its size class, and both return to the pool once unused.
+ * Catalog pages prefetch the thumbnails of the next page on a background thread, so paging
+ * through the contents is served from memory.
+ */
+class ThumbnailCache
+{
+public:
+    /**
+     * @brief Constructs a ThumbnailCache object.
+     * @param crsdkInterface instance of CrSDKInterface class.
+     * @param contentsCatalog instance of ContentsCatalog class validating the handles.
+     * @param budgetBytes The memory the thumbnails may use.
+     */
+    ThumbnailCache(CrSDKInterface *crsdkInterface, ContentsCatalog *contentsCatalog, std::size_t budgetBytes = THUMBNAIL_CACHE_BUDGET_BYTES);
+
+    /**
+     * @brief Stops the prefetch thread.
+     */
+    ~ThumbnailCache();
+
+    /**
+     * @brief Starts the prefetch thread.
+     */
+    void start();
+
+    /**
+     * @brief Stops the prefetch thread.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the thumbnail of a content, from memory or from the camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param handle The content handle.
+     * @param thumbnail Receives the thumbnail.
+     * @param cached Receives true if the thumbnail was in memory (optional).
+     * @return An error message, or an empty string on success.
+     */
+    std::string get(int cameraNumber, SCRSDK::CrContentHandle handle, ThumbnailPtr &thumbnail, bool *cached = nullptr);
+
+    /**
+     * @brief Queues the thumbnails of contents to be fetched in the background.
+     *
+     * A new request of a camera replaces its queued prefetches, the page being viewed changed.
+     *
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param handles The content handles.
+     */
+    void prefetch(int cameraNumber, const std::vector<SCRSDK::CrContentHandle> &handles);
+
+    /**
+     * @brief Returns the counters of the cache.
+     */
+    ThumbnailCacheStats getStats() const;
+
+private:
+    /**
+     * @brief A cache entry and its position in the LRU list.
+     */
+    struct Entry
+    {
+        ThumbnailPtr thumbnail;                         ///< The thumbnail
+        std::list<std::uint64_t>::iterator position;    ///< Position in lru_
+    };
+
+    /**
+     * @brief Returns the cache key of a content.
+     */
+    static std::uint64_t keyOf(int cameraNumber, SCRSDK::CrContentHandle handle);
+
+    /**
+     * @brief Finds a content in the catalog of a camera.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param handle The content handle.
+     * @param fileName Receives the file name of the content.
+     * @return false if the content is not in the catalog.
+     */
+    bool findContent(int cameraNumber, SCRSDK::CrContentHandle handle, std::string &fileName) const;
+
+    /**
+     * @brief Looks a thumbnail up and marks it recently used.
+     * @param key The cache key.
+     * @param fileName The file the content has now (handles can be reassigned).
+     * @return The thumbnail, or nullptr.
+     */
+    ThumbnailPtr lookup(std::uint64_t key, const std::string &fileName);
+
+    /**
+     * @brief Fetches a thumbnail from the camera and caches it.
+     * @param cameraNumber The camera ID (0-based indexing)
+     * @param handle The content handle.
+     * @param fileName The file name of the content.
+     * @param thumbnail Receives the thumbnail.
+     * @return An error message, or an empty string on success.
+     */
+    std::string fetch(int cameraNumber, SCRSDK::CrContentHandle handle, const std::string &fileName, ThumbnailPtr &thumbnail);
+
+    /**
+     * @brief Loop of the prefetch thread.
+     */
+    void prefetchLoop();
+
+    CrSDKInterface *crsdkInterface_;                            ///< Access to the cameras
+    ContentsCatalog *contentsCatalog_;                          ///< Valid handles
+    std::size_t budgetBytes_;                                   ///< Memory budget
+    std::shared_ptr<BufferPool> pool_;                          ///< Buffers of the thumbnails
+    std::list<std::uint64_t> lru_;                              ///< Keys, most recently used first
+    std::unordered_map<std::uint64_t, Entry> entries_;          ///< Entries by key
+    std::size_t bytes_ = 0;                                     ///< Capacity held by the entries
+    ThumbnailCacheStats stats_;                                 ///< Counters
+    mutable std::mutex mutex_;                                  ///< Protects the entries and counters
+    std::vector<std::unique_ptr<std::mutex>> cameraMutexes_;    ///< Serializes the SDK calls of a camera
+    std::vector<std::deque<SCRSDK::CrContentHandle>> prefetchQueues_;   ///< Queued prefetches per camera (prefetchMutex_)
+    std::mutex prefetchMutex_;                                  ///< Protects the prefetch queues
+    std::condition_variable prefetchReady_;                     ///< Signaled when prefetches are queued
+    std::thread prefetchThread_;                                ///< Prefetch thread
+    std::atomic<bool> running_;                                 ///< True while the prefetch thread runs
+};
+
+#endif // THUMBNAIL_CACHE_H
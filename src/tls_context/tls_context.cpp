@@ -0,0 +1,305 @@
+#include "tls_context.h"
+
+#include <cstring>
+#include <sys/stat.h>
+#include <openssl/err.h>
+
+std::atomic<bool> TlsContext::reloadRequested_(false);
+
+TlsContext::Credentials::~Credentials()
+{
+    X509_free(certificate);
+    sk_X509_pop_free(chain, X509_free);
+    EVP_PKEY_free(key);
+}
+
+TlsContext::TlsContext(SSL_CTX *ctx)
+    : ctx_(ctx), running_(false)
+{
+}
+
+TlsContext::~TlsContext()
+{
+    stop();
+}
+
+void TlsContext::requestReload()
+{
+    reloadRequested_.store(true);
+}
+
+bool TlsContext::watchCertificate(const std::string &certFile, const std::string &keyFile)
+{
+    if (ctx_ == nullptr)
+    {
+        spdlog::error("The server has no SSL context, the certificate is not watched");
+        return false;
+    }
+
+    if (running_.exchange(true))
+    {
+        return false;
+    }
+
+    certFile_ = certFile;
+    keyFile_ = keyFile;
+    loadedVersion_ = fileVersion();
+    bool loaded = reload();
+
+    // From now on the handshakes take the certificate of the snapshot
+    SSL_CTX_set_cert_cb(ctx_, &TlsContext::selectCertificate, this);
+    watchThread_ = std::thread(&TlsContext::watchLoop, this);
+    return loaded;
+}
+
+void TlsContext::stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wake_.notify_all();
+    }
+
+    if (watchThread_.joinable())
+    {
+        watchThread_.join();
+    }
+
+    SSL_CTX_set_cert_cb(ctx_, nullptr, nullptr);
+}
+
+std::shared_ptr<TlsContext::Credentials> TlsContext::loadCredentials(const std::string &certFile, const std::string &keyFile, std::string &error)
+{
+    std::shared_ptr<Credentials> credentials(new Credentials());
+
+    BIO *certBio = BIO_new_file(certFile.c_str(), "r");
+    if (certBio == nullptr)
+    {
+        error = fmt::format("cannot open {}", certFile);
+        return nullptr;
+    }
+
+    // The certificate first, then its chain
+    credentials->certificate = PEM_read_bio_X509_AUX(certBio, nullptr, nullptr, nullptr);
+    credentials->chain = sk_X509_new_null();
+    X509 *chainCertificate = nullptr;
+    while (credentials->certificate != nullptr && (chainCertificate = PEM_read_bio_X509(certBio, nullptr, nullptr, nullptr)) != nullptr)
+    {
+        sk_X509_push(credentials->chain, chainCertificate);
+    }
+    BIO_free(certBio);
+    ERR_clear_error();
+
+    if (credentials->certificate == nullptr)
+    {
+        error = fmt::format("no certificate in {}", certFile);
+        return nullptr;
+    }
+
+    BIO *keyBio = BIO_new_file(keyFile.c_str(), "r");
+    if (keyBio == nullptr)
+    {
+        error = fmt::format("cannot open {}", keyFile);
+        return nullptr;
+    }
+    credentials->key = PEM_read_bio_PrivateKey(keyBio, nullptr, nullptr, nullptr);
+    BIO_free(keyBio);
+    ERR_clear_error();
+
+    if (credentials->key == nullptr)
+    {
+        error = fmt::format("no private key in {}", keyFile);
+        return nullptr;
+    }
+
+    // Files replaced one after the other can be out of step for a moment
+    if (X509_check_private_key(credentials->certificate, credentials->key) != 1)
+    {
+        ERR_clear_error();
+        error = "the private key does not match the certificate";
+        return nullptr;
+    }
+
+    if (X509_cmp_current_time(X509_get0_notAfter(credentials->certificate)) < 0)
+    {
+        error = "the certificate has expired";
+        return nullptr;
+    }
+
+    char subject[256];
+    X509_NAME_oneline(X509_get_subject_name(credentials->certificate), subject, sizeof(subject));
+    credentials->subject = subject;
+
+    BIO *timeBio = BIO_new(BIO_s_mem());
+    if (timeBio != nullptr)
+    {
+        char *data = nullptr;
+        ASN1_TIME_print(timeBio, X509_get0_notAfter(credentials->certificate));
+        long size = BIO_get_mem_data(timeBio, &data);
+        credentials->notAfter.assign(data, size > 0 ? static_cast<std::size_t>(size) : 0);
+        BIO_free(timeBio);
+    }
+
+    return credentials;
+}
+
+int TlsContext::selectCertificate(SSL *ssl, void *arg)
+{
+    TlsContext *context = static_cast<TlsContext *>(arg);
+    std::shared_ptr<Credentials> credentials;
+    {
+        std::lock_guard<std::mutex> lock(context->mutex_);
+        credentials = context->credentials_;
+    }
+
+    if (!credentials)
+    {
+        // Nothing loaded yet, the certificate of the context is used
+        return 1;
+    }
+
+    // The connection takes its own references, a later reload does not affect it
+    if (SSL_use_certificate(ssl, credentials->certificate) != 1 ||
+        SSL_use_PrivateKey(ssl, credentials->key) != 1 ||
+        SSL_set1_chain(ssl, credentials->chain) != 1)
+    {
+        return 0;
+    }
+    return 1;
+}
+
+bool TlsContext::reload()
+{
+    std::string error;
+    std::shared_ptr<Credentials> credentials = loadCredentials(certFile_, keyFile_, error);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!credentials)
+    {
+        reloadFailures_++;
+        spdlog::error("TLS certificate not loaded, {}; the previous certificate is kept", error);
+        return false;
+    }
+
+    if (credentials_)
+    {
+        reloads_++;
+    }
+    credentials_ = credentials;
+    spdlog::info("TLS certificate loaded: {} (valid until {})", credentials_->subject, credentials_->notAfter);
+    return true;
+}
+
+std::string TlsContext::fileVersion() const
+{
+    struct stat certStat;
+    struct stat keyStat;
+    if (stat(certFile_.c_str(), &certStat) != 0 || stat(keyFile_.c_str(), &keyStat) != 0)
+    {
+        return "";
+    }
+
+    return fmt::format("{}.{}:{}/{}.{}:{}",
+                       static_cast<long long>(certStat.st_mtim.tv_sec), certStat.st_mtim.tv_nsec, static_cast<long long>(certStat.st_size),
+                       static_cast<long long>(keyStat.st_mtim.tv_sec), keyStat.st_mtim.tv_nsec, static_cast<long long>(keyStat.st_size));
+}
+
+void TlsContext::watchLoop()
+{
+    auto checkedAt = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_)
+    {
+        wake_.wait_for(lock, std::chrono::milliseconds(TLS_RELOAD_SIGNAL_MS));
+        if (!running_)
+        {
+            break;
+        }
+
+        bool requested = reloadRequested_.exchange(false);
+        auto now = std::chrono::steady_clock::now();
+        if (!requested && now - checkedAt < std::chrono::milliseconds(TLS_RELOAD_POLL_MS))
+        {
+            continue;
+        }
+        checkedAt = now;
+
+        // A file being replaced is read again at its next change
+        lock.unlock();
+        std::string version = fileVersion();
+        bool changed = !version.empty() && version != loadedVersion_;
+        if (requested || changed)
+        {
+            if (requested)
+            {
+                spdlog::info("Reloading the TLS certificate on request");
+            }
+            loadedVersion_ = version;
+            reload();
+        }
+        lock.lock();
+    }
+}
+
+bool TlsContext::configureSessions(long lifetimeSeconds, long cacheSize, bool tickets)
+{
+    if (ctx_ == nullptr)
+    {
+        spdlog::error("The server has no SSL context, TLS sessions are not configured");
+        return false;
+    }
+
+    // Sessions are only resumed within the same context ID
+    SSL_CTX_set_session_id_context(ctx_, reinterpret_cast<const unsigned char *>(TLS_SESSION_ID_CONTEXT), std::strlen(TLS_SESSION_ID_CONTEXT));
+    SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(ctx_, cacheSize);
+
+    // The lifetime also bounds the tickets, it is sent to the clients as the ticket lifetime hint
+    SSL_CTX_set_timeout(ctx_, lifetimeSeconds);
+
+    if (tickets)
+    {
+        SSL_CTX_clear_options(ctx_, SSL_OP_NO_TICKET);
+    }
+    else
+    {
+        SSL_CTX_set_options(ctx_, SSL_OP_NO_TICKET);
+    }
+
+    spdlog::info("TLS sessions resumable for {} s ({} cached, tickets {})", lifetimeSeconds, cacheSize, tickets ? "on" : "off");
+    return true;
+}
+
+TlsSessionStats TlsContext::getStats() const
+{
+    TlsSessionStats stats;
+    if (ctx_ == nullptr)
+    {
+        return stats;
+    }
+
+    stats.accepted = SSL_CTX_sess_accept(ctx_);
+    stats.completed = SSL_CTX_sess_accept_good(ctx_);
+    stats.resumed = SSL_CTX_sess_hits(ctx_);
+    stats.full = stats.completed > stats.resumed ? stats.completed - stats.resumed : 0;
+    stats.misses = SSL_CTX_sess_misses(ctx_);
+    stats.timeouts = SSL_CTX_sess_timeouts(ctx_);
+    stats.cached = SSL_CTX_sess_number(ctx_);
+    stats.cacheFull = SSL_CTX_sess_cache_full(ctx_);
+    stats.lifetimeSeconds = SSL_CTX_get_timeout(ctx_);
+    stats.tickets = (SSL_CTX_get_options(ctx_) & SSL_OP_NO_TICKET) == 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.reloads = reloads_;
+    stats.reloadFailures = reloadFailures_;
+    if (credentials_)
+    {
+        stats.subject = credentials_->subject;
+        stats.notAfter = credentials_->notAfter;
+    }
+    return stats;
+}
@@ -0,0 +1,175 @@
+#ifndef TLS_CONTEXT_H
+#define TLS_CONTEXT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+#define TLS_SESSION_LIFETIME_S 7200             // Time a client may resume a session (cache and tickets)
+#define TLS_SESSION_CACHE_SIZE 1024             // Sessions kept by the server cache
+#define TLS_SESSION_ID_CONTEXT "crsdk-https-server"
+
+#define HTTP_KEEP_ALIVE_MAX_REQUESTS 100        // Requests served on a connection before it is closed
+#define HTTP_KEEP_ALIVE_IDLE_S 2                // Idle time after which a connection gives its thread back
+#define HTTP_KEEP_ALIVE_CONNECTIONS 16          // Connection threads kept for idle keep-alive connections
+
+#define TLS_RELOAD_POLL_MS 5000                 // Interval of the certificate file checks
+#define TLS_RELOAD_SIGNAL_MS 500                // Interval of the reload request checks
+
+/**
+ * @brief Handshake counters of the server context.
+ */
+struct TlsSessionStats
+{
+    long accepted = 0;                          ///< Handshakes started
+    long completed = 0;                         ///< Handshakes completed
+    long resumed = 0;                           ///< Completed by resuming a session (cache or ticket)
+    long full = 0;                              ///< Completed with a full key exchange
+    long misses = 0;                            ///< Resumptions asked for and not found
+    long timeouts = 0;                          ///< Resumptions refused for the lifetime
+    long cached = 0;                            ///< Sessions in the cache
+    long cacheFull = 0;                         ///< Sessions dropped because the cache was full
+    long lifetimeSeconds = 0;                   ///< Lifetime of the sessions
+    bool tickets = false;                       ///< True if session tickets are issued
+    std::uint64_t reloads = 0;                  ///< Certificates loaded after the start
+    std::uint64_t reloadFailures = 0;           ///< Certificate loads refused, the previous one kept
+    std::string subject;                        ///< Subject of the certificate served
+    std::string notAfter;                       ///< End of validity of the certificate served
+};
+
+/**
+ * @brief The TlsContext class tunes the SSL context of the HTTPS server.
+ *
+ * Clients reconnecting resume their session instead of a full handshake, either from the
+ * server session cache (session IDs) or from a session ticket they keep, as long as the
+ * session is younger than its lifetime. A resumed handshake skips the key exchange and the
+ * RSA signature, the costly part of a handshake on the Jetson.
+ *
+ * The certificate can be replaced while the server runs: handshakes take it from a snapshot
+ * swapped on reload instead of the context, so rotating it neither restarts the server nor
+ * drops a connection. Sessions established before stay resumable for their lifetime.
+ */
+class TlsContext
+{
+public:
+    /**
+     * @brief Constructs a TlsContext object.
+     * @param ctx The SSL context of the server, owned by the server.
+     */
+    explicit TlsContext(SSL_CTX *ctx);
+
+    /**
+     * @brief Stops the certificate watch.
+     */
+    ~TlsContext();
+
+    TlsContext(const TlsContext &) = delete;
+    TlsContext &operator=(const TlsContext &) = delete;
+
+    /**
+     * @brief Serves the certificate and key of files, and reloads them when they change.
+     *
+     * Each handshake takes the certificate loaded last, so a new certificate applies to the
+     * next connections while the established ones go on with theirs. A certificate that
+     * fails to load, or does not match its key, is refused and the previous one kept. The
+     * files are checked every TLS_RELOAD_POLL_MS and on requestReload().
+     *
+     * @param certFile The certificate file (PEM, chain certificates after the certificate).
+     * @param keyFile The private key file (PEM).
+     * @return false if the files cannot be loaded now; the watch still starts.
+     */
+    bool watchCertificate(const std::string &certFile, const std::string &keyFile);
+
+    /**
+     * @brief Stops the certificate watch.
+     */
+    void stop();
+
+    /**
+     * @brief Asks the watching contexts to reload their certificate.
+     *
+     * Only sets a flag, so it may be called from a signal handler (SIGHUP).
+     */
+    static void requestReload();
+
+    /**
+     * @brief Enables session resumption.
+     * @param lifetimeSeconds The time a session may be resumed.
+     * @param cacheSize The number of sessions kept by the server.
+     * @param tickets True to issue session tickets as well.
+     * @return false if the server has no SSL context.
+     */
+    bool configureSessions(long lifetimeSeconds = TLS_SESSION_LIFETIME_S, long cacheSize = TLS_SESSION_CACHE_SIZE, bool tickets = true);
+
+    /**
+     * @brief Returns the handshake counters.
+     */
+    TlsSessionStats getStats() const;
+
+private:
+    /**
+     * @brief A certificate, its chain and its key, shared by the handshakes using them.
+     */
+    struct Credentials
+    {
+        X509 *certificate = nullptr;
+        STACK_OF(X509) *chain = nullptr;
+        EVP_PKEY *key = nullptr;
+        std::string subject;                    ///< Subject of the certificate
+        std::string notAfter;                   ///< End of validity
+
+        ~Credentials();
+    };
+
+    /**
+     * @brief Loads and checks a certificate and its key.
+     * @return The credentials, or nullptr with an error message.
+     */
+    static std::shared_ptr<Credentials> loadCredentials(const std::string &certFile, const std::string &keyFile, std::string &error);
+
+    /**
+     * @brief Called by OpenSSL at each handshake; sets the current credentials on the connection.
+     */
+    static int selectCertificate(SSL *ssl, void *arg);
+
+    /**
+     * @brief Loads the files and replaces the credentials.
+     * @return false if the files were refused.
+     */
+    bool reload();
+
+    /**
+     * @brief Returns the modification times of the files, to detect a change.
+     */
+    std::string fileVersion() const;
+
+    /**
+     * @brief Loop of the watch thread.
+     */
+    void watchLoop();
+
+    SSL_CTX *ctx_;                                      ///< Context of the server
+    std::string certFile_;                              ///< Watched certificate file
+    std::string keyFile_;                               ///< Watched key file
+    std::shared_ptr<Credentials> credentials_;          ///< Credentials of the new handshakes
+    std::string loadedVersion_;                         ///< fileVersion() of the last load attempt
+    std::uint64_t reloads_ = 0;                         ///< Certificates loaded after the start
+    std::uint64_t reloadFailures_ = 0;                  ///< Loads refused
+    mutable std::mutex mutex_;                          ///< Protects the credentials and counters
+    std::condition_variable wake_;                      ///< Signaled on stop
+    std::thread watchThread_;                           ///< Watch thread
+    std::atomic<bool> running_;                         ///< True while the watch thread runs
+    static std::atomic<bool> reloadRequested_;          ///< Set by requestReload()
+};
+
+#endif // TLS_CONTEXT_H
@@ -0,0 +1,160 @@
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <exception>
+
+WorkerPool::WorkerPool(const std::string &name, std::size_t threads, std::size_t queueLimit)
+    : name_(name), threadCount_(threads > 0 ? threads : 1), queueLimit_(queueLimit), running_(false)
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    stop();
+}
+
+void WorkerPool::start()
+{
+    if (running_.exchange(true))
+    {
+        return;
+    }
+
+    for (std::size_t i = 0; i < threadCount_; ++i)
+    {
+        threads_.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+void WorkerPool::stop()
+{
+    {
+        // Under the lock, so no worker misses the wake-up between its check and its wait
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.exchange(false))
+        {
+            return;
+        }
+        ready_.notify_all();
+    }
+
+    for (std::thread &thread : threads_)
+    {
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+    threads_.clear();
+}
+
+bool WorkerPool::submit(std::function<void()> task)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Every worker busy and queueLimit tasks already waiting
+    if (!running_ || active_ + queue_.size() >= threadCount_ + queueLimit_)
+    {
+        rejected_++;
+        return false;
+    }
+
+    queue_.push_back(std::move(task));
+    maxQueued_ = std::max(maxQueued_, queue_.size());
+    ready_.notify_one();
+    return true;
+}
+
+WorkerPoolResult WorkerPool::run(const std::function<void()> &task)
+{
+    std::mutex doneMutex;
+    std::condition_variable doneCondition;
+    bool done = false;
+    WorkerPoolResult result = WorkerPoolResult::Completed;
+
+    // The caller waits below, the references outlive the task
+    bool queued = submit([&]()
+    {
+        // The caller is released whatever the task does, or it waits forever
+        try
+        {
+            task();
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::error("Worker pool {} task error: {}", name_, e.what());
+            result = WorkerPoolResult::Failed;
+        }
+        catch (...)
+        {
+            spdlog::error("Worker pool {} task error: unknown exception", name_);
+            result = WorkerPoolResult::Failed;
+        }
+
+        std::lock_guard<std::mutex> lock(doneMutex);
+        done = true;
+        doneCondition.notify_one();
+    });
+    if (!queued)
+    {
+        return WorkerPoolResult::Refused;
+    }
+
+    std::unique_lock<std::mutex> lock(doneMutex);
+    doneCondition.wait(lock, [&done]() { return done; });
+    return result;
+}
+
+void WorkerPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this]() { return !running_ || !queue_.empty(); });
+
+            // Queued tasks still run on stop, their callers are waiting for them
+            if (queue_.empty())
+            {
+                break;
+            }
+
+            task = std::move(queue_.front());
+            queue_.pop_front();
+            active_++;
+        }
+
+        try
+        {
+            task();
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::error("Worker pool {} task error: {}", name_, e.what());
+        }
+        catch (...)
+        {
+            spdlog::error("Worker pool {} task error: unknown exception", name_);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_--;
+        completed_++;
+    }
+}
+
+WorkerPoolStats WorkerPool::getStats() const
+{
+    WorkerPoolStats stats;
+    stats.name = name_;
+    stats.threads = threadCount_;
+    stats.queueLimit = queueLimit_;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.active = active_;
+    stats.queued = queue_.size();
+    stats.maxQueued = maxQueued_;
+    stats.completed = completed_;
+    stats.rejected = rejected_;
+    return stats;
+}
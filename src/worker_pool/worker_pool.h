@@ -0,0 +1,119 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+/**
+ * @brief Outcome of a task given to WorkerPool::run.
+ */
+enum class WorkerPoolResult
+{
+    Completed,          ///< The task ran to its end
+    Refused,            ///< The queue was full or the pool stopped, the task did not run
+    Failed              ///< The task threw
+};
+
+/**
+ * @brief Counters of a worker pool.
+ */
+struct WorkerPoolStats
+{
+    std::string name;                           ///< Pool name
+    std::size_t threads = 0;                    ///< Worker threads
+    std::size_t queueLimit = 0;                 ///< Tasks that may wait for a worker
+    std::size_t queued = 0;                     ///< Tasks waiting for a worker
+    std::size_t active = 0;                     ///< Tasks running
+    std::size_t maxQueued = 0;                  ///< Largest queue depth seen
+    std::uint64_t completed = 0;                ///< Tasks run
+    std::uint64_t rejected = 0;                 ///< Tasks refused with a full queue
+};
+
+/**
+ * @brief The WorkerPool class runs tasks on a fixed set of threads with a bounded queue.
+ *
+ * A task submitted while every worker is busy waits in the queue; once the queue holds
+ * queueLimit tasks, further tasks are refused instead of waiting, so the caller can answer
+ * at once. A caller of run() keeps its own thread blocked while a worker runs the task, so
+ * each task run that way occupies two threads.
+ */
+class WorkerPool
+{
+public:
+    /**
+     * @brief Constructs a WorkerPool object.
+     * @param name The name reported in the counters.
+     * @param threads The number of worker threads.
+     * @param queueLimit The number of tasks that may wait for a worker.
+     */
+    WorkerPool(const std::string &name, std::size_t threads, std::size_t queueLimit);
+
+    /**
+     * @brief Stops the worker threads.
+     */
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    /**
+     * @brief Starts the worker threads.
+     */
+    void start();
+
+    /**
+     * @brief Runs the queued tasks and stops the worker threads.
+     */
+    void stop();
+
+    /**
+     * @brief Queues a task.
+     * @param task The task to run on a worker.
+     * @return false if the queue is full or the pool is stopped.
+     */
+    bool submit(std::function<void()> task);
+
+    /**
+     * @brief Runs a task on a worker and waits for it to finish.
+     *
+     * The caller is released on every outcome, a task that throws included.
+     *
+     * @param task The task to run.
+     * @return Whether the task completed, was refused or threw.
+     */
+    WorkerPoolResult run(const std::function<void()> &task);
+
+    /**
+     * @brief Returns the counters of the pool.
+     */
+    WorkerPoolStats getStats() const;
+
+private:
+    /**
+     * @brief Loop of a worker thread.
+     */
+    void workerLoop();
+
+    std::string name_;                                  ///< Pool name
+    std::size_t threadCount_;                           ///< Worker threads to start
+    std::size_t queueLimit_;                            ///< Capacity of the queue
+    std::deque<std::function<void()>> queue_;           ///< Tasks waiting for a worker
+    std::size_t active_ = 0;                            ///< Tasks running
+    std::size_t maxQueued_ = 0;                         ///< Largest queue depth seen
+    std::uint64_t completed_ = 0;                       ///< Tasks run
+    std::uint64_t rejected_ = 0;                        ///< Tasks refused
+    mutable std::mutex mutex_;                          ///< Protects the queue and counters
+    std::condition_variable ready_;                     ///< Signaled when a task is queued
+    std::vector<std::thread> threads_;                  ///< Worker threads
+    std::atomic<bool> running_;                         ///< True while the workers run
+};
+
+#endif // WORKER_POOL_H
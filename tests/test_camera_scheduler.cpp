@@ -0,0 +1,191 @@
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "camera_scheduler/camera_scheduler.h"
+#include "test_check.h"
+
+using std::chrono::milliseconds;
+
+/**
+ * @brief Admits a command with the default budget of a test.
+ */
+static CameraCommandPtr admit(CameraScheduler &scheduler, const char *kind, CommandPriority priority, milliseconds deadline = milliseconds(10000))
+{
+    milliseconds retryAfter;
+    return scheduler.admit(0, kind, priority, deadline, retryAfter);
+}
+
+static void testAdmission()
+{
+    CameraScheduler scheduler(1);
+    milliseconds retryAfter;
+
+    // Unknown cameras are refused without a retry time
+    CHECK(!scheduler.admit(1, "mode", CommandPriority::Interactive, milliseconds(5000), retryAfter));
+    CHECK(!scheduler.admit(-1, "mode", CommandPriority::Interactive, milliseconds(5000), retryAfter));
+
+    // A kind never measured is expected to take CAMERA_COMMAND_INITIAL_MS
+    CameraCommandPtr first = scheduler.admit(0, "transfer", CommandPriority::Bulk, milliseconds(1500), retryAfter);
+    CHECK(first != nullptr);
+    CHECK(first->getPredicted() == milliseconds(1000));
+
+    // Behind it, a command of the same priority misses a deadline and is told when it would fit
+    CHECK(!scheduler.admit(0, "transfer", CommandPriority::Bulk, milliseconds(1500), retryAfter));
+    CHECK(retryAfter == milliseconds(500));
+
+    // A higher priority does not count the queued bulk command
+    CameraCommandPtr second = scheduler.admit(0, "mode", CommandPriority::Interactive, milliseconds(1500), retryAfter);
+    CHECK(second != nullptr);
+    CHECK(retryAfter == milliseconds(0));
+    CHECK(second->getPredicted() == milliseconds(1000));
+    CHECK(scheduler.hasPending(0, CommandPriority::Exposure));
+    CHECK(!scheduler.hasPending(0, CommandPriority::Interactive));
+
+    std::vector<CameraSchedulerStats> stats = scheduler.getStats();
+    CHECK(stats.size() == 1);
+    CHECK(stats[0].admitted == 2);
+    CHECK(stats[0].refused == 1);
+    CHECK(stats[0].pending == 2);
+    CHECK(stats[0].backlogMs == 2000.0);
+
+    // Commands dropped without running leave the queue and the averages untouched
+    first.reset();
+    second.reset();
+    CHECK(scheduler.getStats()[0].pending == 0);
+    CHECK(admit(scheduler, "transfer", CommandPriority::Bulk)->getPredicted() == milliseconds(1000));
+}
+
+static void testMeasuredDuration()
+{
+    CameraScheduler scheduler(1);
+
+    // The first run of a kind replaces the initial guess
+    CameraCommandPtr command = admit(scheduler, "mode", CommandPriority::Interactive);
+    CHECK(command->wait(Deadline::after(milliseconds(100))));
+    CHECK(scheduler.getStats()[0].running);
+    command.reset();
+    CHECK(!scheduler.getStats()[0].running);
+    CHECK(scheduler.getStats()[0].completed == 1);
+
+    milliseconds retryAfter;
+    CHECK(scheduler.admit(0, "mode", CommandPriority::Interactive, milliseconds(100), retryAfter) != nullptr);
+}
+
+static void testPriorityOrder()
+{
+    CameraScheduler scheduler(1);
+    CameraCommandPtr running = admit(scheduler, "read", CommandPriority::Status);
+    CHECK(running->wait(Deadline::after(milliseconds(100))));
+
+    // Queued behind the running command, which is never interrupted
+    CameraCommandPtr bulk = admit(scheduler, "transfer", CommandPriority::Bulk);
+    CameraCommandPtr interactive = admit(scheduler, "mode", CommandPriority::Interactive);
+    CHECK(!interactive->wait(Deadline::after(milliseconds(20))));
+    CHECK(scheduler.getStats()[0].expired == 1);
+
+    // The interactive command overtakes the older bulk one at the next boundary
+    running.reset();
+    CHECK(!bulk->wait(Deadline::after(milliseconds(20))));
+    CHECK(interactive->wait(Deadline::after(milliseconds(100))));
+    CHECK(interactive->getPriority() == CommandPriority::Interactive);
+    CHECK(!bulk->wait(Deadline::after(milliseconds(20))));
+
+    interactive.reset();
+    CHECK(bulk->wait(Deadline::after(milliseconds(100))));
+    CHECK(bulk->getPriority() == CommandPriority::Bulk);
+    CHECK(scheduler.getStats()[0].promoted == 0);
+}
+
+static void testAging()
+{
+    CameraScheduler scheduler(1);
+    CameraCommandPtr running = admit(scheduler, "read", CommandPriority::Status);
+    CHECK(running->wait(Deadline::after(milliseconds(100))));
+
+    // After CAMERA_COMMAND_AGING_MS the exposure command ranks with the interactive ones
+    CameraCommandPtr aged = admit(scheduler, "brightness", CommandPriority::Exposure);
+    std::this_thread::sleep_for(milliseconds(CAMERA_COMMAND_AGING_MS + 100));
+    CameraCommandPtr interactive = admit(scheduler, "mode", CommandPriority::Interactive);
+
+    // Equal after aging, the older command runs first
+    running.reset();
+    CHECK(!interactive->wait(Deadline::after(milliseconds(20))));
+    CHECK(aged->wait(Deadline::after(milliseconds(100))));
+    CHECK(aged->getPriority() == CommandPriority::Interactive);
+    CHECK(scheduler.getStats()[0].promoted == 1);
+
+    aged.reset();
+    CHECK(interactive->wait(Deadline::after(milliseconds(100))));
+    CHECK(scheduler.getStats()[0].promoted == 1);
+}
+
+static void testAgingBoundary()
+{
+    // The running command finishes just before the exposure command ages: the interactive
+    // command is chosen then, the other follows after the boundary, neither waits for a deadline
+    CameraScheduler scheduler(1);
+    CameraCommandPtr running = admit(scheduler, "read", CommandPriority::Status);
+    CHECK(running->wait(Deadline::after(milliseconds(100))));
+
+    CameraCommandPtr aged = admit(scheduler, "brightness", CommandPriority::Exposure);
+    std::this_thread::sleep_for(milliseconds(CAMERA_COMMAND_AGING_MS - 100));
+    CameraCommandPtr interactive = admit(scheduler, "mode", CommandPriority::Interactive);
+
+    bool agedRan = false;
+    bool interactiveRan = false;
+    auto run = [](CameraCommandPtr command, bool &ran)
+    {
+        ran = command->wait(Deadline::after(milliseconds(1000)));
+        std::this_thread::sleep_for(milliseconds(60));
+    };
+    std::thread agedThread(run, std::move(aged), std::ref(agedRan));
+    std::thread interactiveThread(run, std::move(interactive), std::ref(interactiveRan));
+
+    std::this_thread::sleep_for(milliseconds(50));
+    running.reset();
+    agedThread.join();
+    interactiveThread.join();
+
+    CHECK(agedRan);
+    CHECK(interactiveRan);
+    CHECK(scheduler.getStats()[0].expired == 0);
+    CHECK(scheduler.getStats()[0].completed == 3);
+}
+
+static void testAbandonedCall()
+{
+    // A call abandoned at its deadline keeps the camera until it returns, and is waited for on exit
+    CameraScheduler scheduler(1);
+    CameraCommandPtr command = admit(scheduler, "mode", CommandPriority::Interactive);
+    Deadline deadline = Deadline::after(milliseconds(20));
+    CHECK(command->wait(deadline));
+
+    std::future<int> result = launchCall<int>([]()
+    {
+        std::this_thread::sleep_for(milliseconds(200));
+        return 1;
+    }, deadline.holding(command));
+    command.reset();
+
+    int value = 0;
+    CHECK(!deadline.wait(result, value));
+    CHECK(LaunchedCalls::running() == 1);
+    CHECK(scheduler.getStats()[0].running);
+
+    CHECK(LaunchedCalls::waitAll(milliseconds(2000)));
+    CHECK(LaunchedCalls::running() == 0);
+    CHECK(!scheduler.getStats()[0].running);
+}
+
+int main()
+{
+    testAdmission();
+    testMeasuredDuration();
+    testPriorityOrder();
+    testAging();
+    testAgingBoundary();
+    testAbandonedCall();
+    return TEST_RESULT();
+}
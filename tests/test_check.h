@@ -0,0 +1,26 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <cstdio>
+
+/**
+ * @brief Checks of the unit tests.
+ *
+ * A failed check is reported with its location and the test goes on, so one run lists every
+ * failure; the test exits with TEST_RESULT(), non-zero if a check failed.
+ */
+static int testFailures = 0;
+
+#define CHECK(condition)                                                                        \
+    do                                                                                          \
+    {                                                                                           \
+        if (!(condition))                                                                       \
+        {                                                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);  \
+            testFailures++;                                                                     \
+        }                                                                                       \
+    } while (0)
+
+#define TEST_RESULT() (testFailures == 0 ? 0 : 1)
+
+#endif // TEST_CHECK_H
@@ -0,0 +1,111 @@
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "response_encoding/json_writer.h"
+#include "test_check.h"
+
+// Counts the heap allocations of the whole program, to measure those of a response
+static std::size_t allocations = 0;
+
+void *operator new(std::size_t size)
+{
+    allocations++;
+    void *pointer = std::malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+/**
+ * @brief Returns the document of a writer as a string.
+ */
+static std::string document(JsonWriter &writer)
+{
+    const char *data = writer.data();
+    return std::string(data, writer.size());
+}
+
+static void testMembers()
+{
+    JsonWriter writer;
+    CHECK(document(writer) == "{}");
+
+    writer.reset();
+    writer.add("mode", "p").add("brightness", static_cast<std::int64_t>(-12)).add("name", std::string("cam"));
+    CHECK(document(writer) == R"({"mode":"p","brightness":-12,"name":"cam"})");
+
+    // data() closes the object once
+    CHECK(document(writer) == R"({"mode":"p","brightness":-12,"name":"cam"})");
+}
+
+static void testEscaping()
+{
+    std::string value = "quote \" backslash \\ slash / newline \n tab \t return \r bell \x07 escape \x1f end";
+    value.push_back('\0');
+    value += "after nul, caf\xc3\xa9";
+
+    JsonWriter writer;
+    writer.add("k\"ey", value);
+    CHECK(document(writer) == "{\"k\\\"ey\":\"quote \\\" backslash \\\\ slash / newline \\n tab \\t return \\r "
+                              "bell \\u0007 escape \\u001f end\\u0000after nul, caf\xc3\xa9\"}");
+
+    // Whatever the value, the document parses back to it
+    json parsed = writer.toJson();
+    CHECK(parsed.size() == 1);
+    CHECK(parsed["k\"ey"].get<std::string>() == value);
+}
+
+static void testSpill()
+{
+    JsonWriter writer;
+    std::string value(JSON_WRITER_CAPACITY, 'x');
+    writer.add("short", "fits");
+    CHECK(!writer.spilled());
+    writer.add("long", value);
+    CHECK(writer.spilled());
+    CHECK(document(writer) == "{\"short\":\"fits\",\"long\":\"" + value + "\"}");
+
+    // A reset writer is in place again
+    writer.reset();
+    writer.add("short", "fits");
+    CHECK(!writer.spilled());
+    CHECK(document(writer) == R"({"short":"fits"})");
+}
+
+static void testAllocations()
+{
+    // A response in the buffer allocates nothing until it is copied into the body
+    std::size_t before = allocations;
+    JsonWriter writer;
+    writer.add("camera_id", static_cast<std::int64_t>(1)).add("mode", "p").add("fnumber", "F4.0");
+    const char *data = writer.data();
+    std::size_t size = writer.size();
+    CHECK(allocations == before);
+
+    // The body copy, as set_content() does, is the one allocation of the response
+    std::string body;
+    body.assign(data, size);
+    CHECK(allocations == before + 1);
+}
+
+int main()
+{
+    testMembers();
+    testEscaping();
+    testSpill();
+    testAllocations();
+    return TEST_RESULT();
+}
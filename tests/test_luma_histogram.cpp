@@ -0,0 +1,110 @@
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "ImageAnalysis/luma_histogram/luma_histogram.h"
+#include "test_check.h"
+
+/**
+ * @brief Computes the histogram one pixel at a time and compares it with the one of the class.
+ */
+static bool matchesReference(const LumaImage &image, std::uint8_t shadowLevel, std::uint8_t highlightLevel)
+{
+    std::uint32_t bins[LUMA_HISTOGRAM_BINS] = {};
+    std::uint64_t sum = 0;
+    std::uint64_t shadows = 0;
+    std::uint64_t highlights = 0;
+    for (std::uint8_t pixel : image.pixels)
+    {
+        bins[pixel]++;
+        sum += pixel;
+        shadows += pixel <= shadowLevel ? 1 : 0;
+        highlights += pixel >= highlightLevel ? 1 : 0;
+    }
+
+    LumaHistogram histogram;
+    histogram.setClipLevels(shadowLevel, highlightLevel);
+    histogram.compute(image);
+
+    bool same = histogram.getPixelCount() == image.pixels.size() &&
+                histogram.getShadowClipCount() == shadows &&
+                histogram.getHighlightClipCount() == highlights;
+    for (int bin = 0; bin < LUMA_HISTOGRAM_BINS; ++bin)
+    {
+        same = same && histogram.getBins()[bin] == bins[bin];
+    }
+
+    double mean = image.pixels.empty() ? 0.0 : static_cast<double>(sum) / static_cast<double>(image.pixels.size());
+    return same && std::fabs(histogram.getMean() - mean) < 1e-9;
+}
+
+/**
+ * @brief Returns an image of random pixels.
+ */
+static LumaImage randomImage(std::mt19937 &random, int width, int height)
+{
+    std::uniform_int_distribution<int> value(0, 255);
+    LumaImage image;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(static_cast<std::size_t>(width) * height);
+    for (std::uint8_t &pixel : image.pixels)
+    {
+        pixel = static_cast<std::uint8_t>(value(random));
+    }
+    return image;
+}
+
+static void testRandomImages()
+{
+    // Odd sizes leave a tail to the scalar path, large ones cross the counter flushes
+    const int sizes[][2] = {{1, 1}, {3, 5}, {15, 1}, {17, 1}, {33, 7}, {255, 17}, {641, 481}, {1031, 769}};
+    std::mt19937 random(20240607);
+    for (const auto &size : sizes)
+    {
+        LumaImage image = randomImage(random, size[0], size[1]);
+        CHECK(matchesReference(image, LUMA_SHADOW_CLIP_LEVEL, LUMA_HIGHLIGHT_CLIP_LEVEL));
+        CHECK(matchesReference(image, 40, 200));
+    }
+}
+
+static void testUniformImages()
+{
+    // Every lane counts every block, the 8-bit counters must be flushed in time
+    const std::uint8_t values[] = {0, 2, 3, 128, 252, 253, 255};
+    for (std::uint8_t value : values)
+    {
+        LumaImage image;
+        image.width = 257;
+        image.height = 129;
+        image.pixels.assign(static_cast<std::size_t>(image.width) * image.height, value);
+        CHECK(matchesReference(image, LUMA_SHADOW_CLIP_LEVEL, LUMA_HIGHLIGHT_CLIP_LEVEL));
+    }
+
+    // Clip levels at the ends of the range count every pixel
+    LumaImage image;
+    image.width = 100;
+    image.height = 3;
+    image.pixels.assign(300, 255);
+    CHECK(matchesReference(image, 255, 0));
+}
+
+static void testEmptyImage()
+{
+    LumaImage image;
+    LumaHistogram histogram;
+    histogram.compute(image);
+    CHECK(histogram.getPixelCount() == 0);
+    CHECK(histogram.getMean() == 0.0);
+    CHECK(histogram.getShadowClipPercent() == 0.0);
+    CHECK(histogram.getHighlightClipPercent() == 0.0);
+    CHECK(matchesReference(image, LUMA_SHADOW_CLIP_LEVEL, LUMA_HIGHLIGHT_CLIP_LEVEL));
+}
+
+int main()
+{
+    testRandomImages();
+    testUniformImages();
+    testEmptyImage();
+    return TEST_RESULT();
+}
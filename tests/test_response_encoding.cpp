@@ -0,0 +1,84 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "response_encoding/response_encoding.h"
+#include "test_check.h"
+
+static void testNegotiate()
+{
+    // Without a binary format asked for, the answer is JSON
+    CHECK(ResponseEncoder::negotiate("") == ResponseEncoding::Json);
+    CHECK(ResponseEncoder::negotiate("*/*") == ResponseEncoding::Json);
+    CHECK(ResponseEncoder::negotiate("text/html") == ResponseEncoding::Json);
+    CHECK(ResponseEncoder::negotiate("text/html, image/*;q=0.9") == ResponseEncoding::Json);
+    CHECK(ResponseEncoder::negotiate("application/json") == ResponseEncoding::Json);
+
+    CHECK(ResponseEncoder::negotiate("application/msgpack") == ResponseEncoding::MessagePack);
+    CHECK(ResponseEncoder::negotiate("application/x-msgpack") == ResponseEncoding::MessagePack);
+    CHECK(ResponseEncoder::negotiate("application/vnd.msgpack") == ResponseEncoding::MessagePack);
+    CHECK(ResponseEncoder::negotiate("application/cbor") == ResponseEncoding::Cbor);
+    CHECK(ResponseEncoder::negotiate("text/html, application/cbor") == ResponseEncoding::Cbor);
+
+    // Media types are case insensitive, parameters other than q are ignored
+    CHECK(ResponseEncoder::negotiate("Application/MsgPack") == ResponseEncoding::MessagePack);
+    CHECK(ResponseEncoder::negotiate("application/cbor; charset=binary") == ResponseEncoding::Cbor);
+}
+
+static void testWeights()
+{
+    CHECK(ResponseEncoder::negotiate("application/json;q=0.5, application/msgpack") == ResponseEncoding::MessagePack);
+    CHECK(ResponseEncoder::negotiate("application/msgpack;q=0.5, application/json") == ResponseEncoding::Json);
+    CHECK(ResponseEncoder::negotiate("application/cbor;q=0.4, application/msgpack;q=0.9, */*;q=0.1") == ResponseEncoding::MessagePack);
+    CHECK(ResponseEncoder::negotiate("application/msgpack ; Q=0.8 , application/cbor ; q=0.9") == ResponseEncoding::Cbor);
+
+    // Among equal weights the first listed wins
+    CHECK(ResponseEncoder::negotiate("application/cbor, application/msgpack") == ResponseEncoding::Cbor);
+    CHECK(ResponseEncoder::negotiate("application/msgpack;q=0.7, application/cbor;q=0.7") == ResponseEncoding::MessagePack);
+
+    // A zero or unreadable weight refuses the format
+    CHECK(ResponseEncoder::negotiate("application/msgpack;q=0") == ResponseEncoding::Json);
+    CHECK(ResponseEncoder::negotiate("application/cbor;q=none") == ResponseEncoding::Json);
+}
+
+static void testEncode()
+{
+    json document = {{"camera_id", 1}, {"mode", "p"}, {"fnumber", "F4.0"}, {"values", {1, -2, 300000}}, {"ready", true}};
+
+    std::string body;
+    ResponseEncoder::encode(document, ResponseEncoding::Json, body);
+    CHECK(json::parse(body) == document);
+
+    body.clear();
+    ResponseEncoder::encode(document, ResponseEncoding::MessagePack, body);
+    CHECK(json::from_msgpack(std::vector<std::uint8_t>(body.begin(), body.end())) == document);
+    CHECK(body.size() < document.dump().size());
+
+    body.clear();
+    ResponseEncoder::encode(document, ResponseEncoding::Cbor, body);
+    CHECK(json::from_cbor(std::vector<std::uint8_t>(body.begin(), body.end())) == document);
+
+    // Documents are appended, a stream is their concatenation
+    std::string stream;
+    ResponseEncoder::encode(document, ResponseEncoding::Cbor, stream);
+    ResponseEncoder::encode(document, ResponseEncoding::Cbor, stream);
+    CHECK(stream == body + body);
+}
+
+static void testContentTypes()
+{
+    CHECK(std::string(ResponseEncoder::contentType(ResponseEncoding::Json)) == "application/json");
+    CHECK(std::string(ResponseEncoder::contentType(ResponseEncoding::MessagePack)) == "application/msgpack");
+    CHECK(std::string(ResponseEncoder::contentType(ResponseEncoding::Cbor)) == "application/cbor");
+    CHECK(std::string(ResponseEncoder::sequenceContentType(ResponseEncoding::Json)) == "application/json-seq");
+    CHECK(std::string(ResponseEncoder::sequenceContentType(ResponseEncoding::Cbor)) == "application/cbor-seq");
+}
+
+int main()
+{
+    testNegotiate();
+    testWeights();
+    testEncode();
+    testContentTypes();
+    return TEST_RESULT();
+}
@@ -0,0 +1,228 @@
+#include <regex>
+#include <string>
+
+#include "route_table/route_table.h"
+#include "test_check.h"
+
+static const RouteParamSpec CAMERA_ID_PARAM = {"camera_id", RouteParamType::CameraId, true, 0, 0};
+
+/**
+ * @brief Parses a request carrying a single query parameter.
+ */
+static bool parseQuery(const RouteSpec &spec, const char *name, const std::string &value, std::size_t cameraCount, RouteParams &params, std::string &error)
+{
+    httplib::Request req;
+    req.params.emplace(name, value);
+    return RouteTable::parse(spec, req, cameraCount, params, error);
+}
+
+static void testCameraId()
+{
+    RouteSpec spec = {"/get_camera_mode", RouteClass::Read, {CAMERA_ID_PARAM}};
+    RouteParams params;
+    std::string error;
+
+    // The client IDs are mapped with REVERSE_INDEX
+    CHECK(parseQuery(spec, "camera_id", "0", 2, params, error));
+    CHECK(params.camera_id == 1);
+    CHECK(params.camera_param == 0);
+    CHECK(parseQuery(spec, "camera_id", "1", 2, params, error));
+    CHECK(params.camera_id == 0);
+    CHECK(params.camera_param == 1);
+
+    // The mapped index is range checked, not the ID sent
+    CHECK(!parseQuery(spec, "camera_id", "0", 1, params, error));
+    CHECK(error == "Camera_id out of range.");
+    CHECK(parseQuery(spec, "camera_id", "1", 1, params, error));
+    CHECK(params.camera_id == 0);
+
+    // IDs REVERSE_INDEX does not map back are refused, not sent to camera 0
+    CHECK(!parseQuery(spec, "camera_id", "2", 2, params, error));
+    CHECK(error == "Camera_id out of range.");
+    CHECK(!parseQuery(spec, "camera_id", "7", 2, params, error));
+    CHECK(!parseQuery(spec, "camera_id", "-3", 2, params, error));
+    CHECK(!parseQuery(spec, "camera_id", "-1", 2, params, error));
+
+    // Overlong, malformed and missing IDs are refused, never thrown
+    CHECK(!parseQuery(spec, "camera_id", "99999999999999999999", 2, params, error));
+    CHECK(!parseQuery(spec, "camera_id", "4294967297", 2, params, error));
+    CHECK(!parseQuery(spec, "camera_id", "1x", 2, params, error));
+    CHECK(!parseQuery(spec, "camera_id", "abc", 2, params, error));
+    CHECK(!parseQuery(spec, "camera_id", "", 2, params, error));
+    CHECK(error == "Missing camera_id parameter.");
+
+    httplib::Request req;
+    CHECK(!RouteTable::parse(spec, req, 2, params, error));
+    CHECK(error == "Missing camera_id parameter.");
+}
+
+static void testPathCameraId()
+{
+    RouteSpec spec = {R"(/cameras/(\d+)/wait)", RouteClass::Wait, {{"camera_id", RouteParamType::PathCameraId, true, 0, 0}}};
+    RouteParams params;
+    std::string error;
+    std::regex pattern(spec.path);
+
+    httplib::Request req;
+    req.path = "/cameras/0/wait";
+    std::regex_match(req.path, req.matches, pattern);
+    CHECK(RouteTable::parse(spec, req, 2, params, error));
+    CHECK(params.camera_id == 1);
+    CHECK(params.has("camera_id"));
+
+    req.path = "/cameras/1/wait";
+    std::regex_match(req.path, req.matches, pattern);
+    CHECK(RouteTable::parse(spec, req, 2, params, error));
+    CHECK(params.camera_id == 0);
+
+    // An ID the pattern accepts may name no camera
+    httplib::Request unknown;
+    unknown.path = "/cameras/42/wait";
+    std::regex_match(unknown.path, unknown.matches, pattern);
+    CHECK(!RouteTable::parse(spec, unknown, 2, params, error));
+    CHECK(error == "Camera_id out of range.");
+
+    // Or overflow
+    httplib::Request overlong;
+    overlong.path = "/cameras/123456789012345678901234/wait";
+    std::regex_match(overlong.path, overlong.matches, pattern);
+    CHECK(!RouteTable::parse(spec, overlong, 2, params, error));
+    CHECK(error == "Camera_id out of range.");
+}
+
+static void testInteger()
+{
+    RouteSpec spec = {"/change_af_area_position", RouteClass::CameraWrite, {{"x", RouteParamType::Integer, true, 0, 639}}};
+    RouteParams params;
+    std::string error;
+
+    CHECK(parseQuery(spec, "x", "0", 2, params, error));
+    CHECK(params.getInt("x") == 0);
+    CHECK(parseQuery(spec, "x", "639", 2, params, error));
+    CHECK(params.getInt("x") == 639);
+
+    CHECK(!parseQuery(spec, "x", "640", 2, params, error));
+    CHECK(error == "Invalid x parameter, expected an integer from 0 to 639.");
+    CHECK(!parseQuery(spec, "x", "-1", 2, params, error));
+    CHECK(!parseQuery(spec, "x", "+5", 2, params, error));
+    CHECK(!parseQuery(spec, "x", " 5", 2, params, error));
+    CHECK(!parseQuery(spec, "x", "5.0", 2, params, error));
+    CHECK(!parseQuery(spec, "x", "99999999999999999999", 2, params, error));
+}
+
+static void testNumberAndFlag()
+{
+    RouteSpec spec = {"/set_auto_brightness", RouteClass::CameraWrite,
+                      {{"enable", RouteParamType::Flag, true, 0, 1},
+                       {"target", RouteParamType::Number, false, 1, 254}}};
+    RouteParams params;
+    std::string error;
+
+    httplib::Request req;
+    req.params.emplace("enable", "true");
+    req.params.emplace("target", "118.5");
+    CHECK(RouteTable::parse(spec, req, 2, params, error));
+    CHECK(params.getInt("enable") == 1);
+    CHECK(params.getNumber("target") == 118.5);
+
+    // Optional parameters left out read as absent
+    httplib::Request minimal;
+    minimal.params.emplace("enable", "0");
+    CHECK(RouteTable::parse(spec, minimal, 2, params, error));
+    CHECK(params.getInt("enable") == 0);
+    CHECK(!params.has("target"));
+    CHECK(params.getNumber("target") == 0.0);
+
+    const char *invalidTargets[] = {"0.5", "255", "nan", "inf", "1e400", " 3", "3x", "0x10"};
+    for (const char *target : invalidTargets)
+    {
+        httplib::Request invalid;
+        invalid.params.emplace("enable", "1");
+        invalid.params.emplace("target", target);
+        CHECK(!RouteTable::parse(spec, invalid, 2, params, error));
+    }
+
+    httplib::Request invalidFlag;
+    invalidFlag.params.emplace("enable", "yes");
+    CHECK(!RouteTable::parse(spec, invalidFlag, 2, params, error));
+    CHECK(error == "Invalid enable parameter, expected 0 or 1.");
+}
+
+static void testPathInteger()
+{
+    RouteSpec spec = {R"(/cameras/(\d+)/contents/(\d+)/thumb\.jpg)", RouteClass::Read,
+                      {{"camera_id", RouteParamType::PathCameraId, true, 0, 0},
+                       {"handle", RouteParamType::PathInteger, true, 0, ROUTE_MAX_HANDLE}}};
+    RouteParams params;
+    std::string error;
+    std::regex pattern(spec.path);
+
+    httplib::Request req;
+    req.path = "/cameras/1/contents/4294967295/thumb.jpg";
+    std::regex_match(req.path, req.matches, pattern);
+    CHECK(RouteTable::parse(spec, req, 1, params, error));
+    CHECK(params.camera_id == 0);
+    CHECK(params.getInt("handle") == 4294967295LL);
+
+    // Handles past 32 bits are refused, not truncated by a cast
+    httplib::Request wide;
+    wide.path = "/cameras/1/contents/4294967296/thumb.jpg";
+    std::regex_match(wide.path, wide.matches, pattern);
+    CHECK(!RouteTable::parse(spec, wide, 1, params, error));
+    CHECK(error == "Invalid handle parameter, expected an integer from 0 to 4294967295.");
+
+    httplib::Request overlong;
+    overlong.path = "/cameras/1/contents/123456789012345678901234/thumb.jpg";
+    std::regex_match(overlong.path, overlong.matches, pattern);
+    CHECK(!RouteTable::parse(spec, overlong, 1, params, error));
+}
+
+static void testChoice()
+{
+    RouteSpec spec = {R"(/cameras/(\d+)/contents)", RouteClass::Read, {{"order", RouteParamType::Choice, false, 0, 0, "asc|desc"}}};
+    RouteParams params;
+    std::string error;
+
+    CHECK(parseQuery(spec, "order", "asc", 1, params, error));
+    CHECK(params.getInt("order") == 0);
+    CHECK(parseQuery(spec, "order", "desc", 1, params, error));
+    CHECK(params.getInt("order") == 1);
+
+    // Whole choices only
+    const char *invalidOrders[] = {"as", "ascd", "desc|", "asc|desc", "DESC", "|"};
+    for (const char *order : invalidOrders)
+    {
+        CHECK(!parseQuery(spec, "order", order, 1, params, error));
+        CHECK(error == "Invalid order parameter, expected asc|desc.");
+    }
+
+    httplib::Request req;
+    CHECK(RouteTable::parse(spec, req, 1, params, error));
+    CHECK(!params.has("order"));
+}
+
+static void testCameraIdList()
+{
+    // The upload route parses its comma separated list one ID at a time
+    int cameraId = -1;
+    CHECK(RouteTable::parseCameraId("1", 2, cameraId));
+    CHECK(cameraId == 0);
+    CHECK(RouteTable::parseCameraId("0", 2, cameraId));
+    CHECK(cameraId == 1);
+    CHECK(!RouteTable::parseCameraId("0", 1, cameraId));
+    CHECK(!RouteTable::parseCameraId("2", 2, cameraId));
+    CHECK(!RouteTable::parseCameraId("", 2, cameraId));
+    CHECK(!RouteTable::parseCameraId("99999999999999999999", 2, cameraId));
+}
+
+int main()
+{
+    testCameraId();
+    testPathCameraId();
+    testInteger();
+    testNumberAndFlag();
+    testPathInteger();
+    testChoice();
+    testCameraIdList();
+    return TEST_RESULT();
+}